@@ -4,6 +4,7 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
 #include <utility>
@@ -11,7 +12,10 @@
 #include "GlobalSubSystemStack.hpp"
 #include "engine/Scene.hpp"
 #include "engine/SceneLoader.hpp"
+#include "engine/Settings.hpp"
 #include "log/Logger.hpp"
+#include "render/RenderSubSystem.hpp"
+#include "util/FrameLimiter.hpp"
 #include "util/debug.hpp"
 #include "util/string.hpp"
 
@@ -54,11 +58,23 @@ void Application::run() {
   }
 
   auto& subsystems = GlobalSubSystemStack::get();
+  std::optional<util::FrameLimiter> frameLimiter;
+  const std::optional<int> frameRateLimit = getSettings().frameRateLimit;
+  if (frameRateLimit.has_value() && *frameRateLimit > 0) {
+    frameLimiter.emplace(
+        std::chrono::duration_cast<util::FrameLimiter::Clock::duration>(
+            std::chrono::duration<double>{1.0 / *frameRateLimit}));
+  }
+
   std::chrono::microseconds prevFrameTime{0};
   while (!subsystems.window()->shouldClose()) {
     std::chrono::microseconds maxFrameTime{0};
     std::chrono::microseconds minFrameTime{9999999};
     std::chrono::microseconds totalFrameTime{0};
+    std::chrono::microseconds maxLatency{0};
+    std::chrono::microseconds minLatency{9999999};
+    std::chrono::microseconds totalLatency{0};
+    int latencySamples = 0;
 
     for (int i = 0; i < 1000 && !subsystems.window()->shouldClose(); i++) {
       if (hasPendingScene_.load(std::memory_order_acquire)) {
@@ -68,11 +84,25 @@ void Application::run() {
       }
 
       auto start = std::chrono::high_resolution_clock::now();
+      // Limit before sampling input, so the sleep does not add latency
+      if (frameLimiter.has_value()) {
+        frameLimiter->wait();
+      }
       glfwPollEvents();
+      subsystems.renderSystem().markInputSampled();
       update(prevFrameTime);
       drawFrame();
       auto end = std::chrono::high_resolution_clock::now();
 
+      const std::optional<std::chrono::microseconds> latency =
+          subsystems.renderSystem().getLastFrameLatency();
+      if (latency.has_value()) {
+        totalLatency += *latency;
+        maxLatency = std::max(maxLatency, *latency);
+        minLatency = std::min(minLatency, *latency);
+        latencySamples++;
+      }
+
       const auto curFrameTime =
           std::chrono::duration_cast<std::chrono::microseconds>(end - start);
       totalFrameTime += curFrameTime;
@@ -97,6 +127,19 @@ void Application::run() {
     log::LoggerSystem::logToDefault(
         log::LogLevel::INFO,
         util::toString("Min frame time: ", minFrameTime.count(), "us"));
+    if (latencySamples > 0) {
+      log::LoggerSystem::logToDefault(
+          log::LogLevel::INFO,
+          util::toString(
+              "Input latency: avg ",
+              (totalLatency / latencySamples).count(),
+              "us, min ",
+              minLatency.count(),
+              "us, max ",
+              maxLatency.count(),
+              "us"));
+    }
+    subsystems.renderSystem().getGpuProfiler().logStatistics();
   }
 
   subsystems.renderSystem().waitIdle();
@@ -123,6 +166,8 @@ void Application::transitionToScene(std::string sceneName) {
     auto loadStart = std::chrono::high_resolution_clock::now();
 
     mainScene_ = loadSceneFromName(sceneName);
+    // Start the scene's uploads now rather than waiting for the next frame
+    GlobalSubSystemStack::get().renderSystem().getUploadManager().flush();
 
     auto loadEnd = std::chrono::high_resolution_clock::now();
     auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -131,6 +176,11 @@ void Application::transitionToScene(std::string sceneName) {
         log::LogLevel::INFO,
         util::toString(
             "Loaded scene ", sceneName, " in ", loadTime.count(), "ms"));
+    GlobalSubSystemStack::get()
+        .renderSystem()
+        .getGraphicsDevice()
+        .getAllocator()
+        .logStatistics();
 
     if (loadTime < kMinLoadTime) {
       std::this_thread::sleep_for(kMinLoadTime - loadTime);
@@ -1,5 +1,7 @@
 #include "engine/ResourceManager.hpp"
 
+#include <filesystem>
+#include <string_view>
 #include "GlobalSubSystemStack.hpp"
 
 namespace blocks::engine {
@@ -8,4 +10,10 @@ ResourceManager& ResourceManager::get() {
   return GlobalSubSystemStack::get().resourceManager();
 }
 
+std::filesystem::path ResourceManager::getResourcePath(
+    std::string_view resourceName) {
+  return (std::filesystem::path("data") / resourceName)
+      .replace_extension("yaml");
+}
+
 } // namespace blocks::engine
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include "engine/ResourceRef.hpp"
@@ -18,6 +19,7 @@ namespace blocks::engine {
 class ResourceManager {
  public:
   static ResourceManager& get();
+  static std::filesystem::path getResourcePath(std::string_view resourceName);
 
   template <typename T>
   // NOLINTNEXTLINE(bugprone-exception-escape)
@@ -42,9 +44,8 @@ class ResourceManager {
       return ResourceRef<T>{resourcePtr.get<T>()};
     }
 
-    std::vector<char> fileContents = util::readFileChars(
-        (std::filesystem::path("data") / resourceName)
-            .replace_extension("yaml"));
+    std::vector<char> fileContents =
+        util::readFileChars(getResourcePath(resourceName));
     auto resource = serialization::deserialize<
         ResourceWrapper<T>,
         serialization::yaml::YAMLDeserializationProvider>(
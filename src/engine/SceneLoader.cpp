@@ -1,14 +1,24 @@
 #include "engine/SceneLoader.hpp"
 
+#include <filesystem>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 #include "GlobalSubSystemStack.hpp"
 #include "ResourceTypes.hpp"
+#include "engine/ResourceManager.hpp"
 #include "engine/ResourceRef.hpp"
 #include "engine/Scene.hpp"
+#include "engine/TextureResource.hpp"
+#include "render/resource/TextureManager.hpp"
+#include "serialization/yaml/YAMLParser.hpp"
+#include "serialization/yaml/YAMLTokenizer.hpp"
+#include "util/file.hpp"
 #include "util/meta_utils.hpp"
 
 namespace blocks {
@@ -22,6 +32,107 @@ struct SceneDefinition {
       util::TPair<util::TString<"actors">, std::vector<GameObjects>>>;
 };
 
+namespace {
+
+using serialization::yaml::YAMLDocument;
+
+const YAMLDocument* findField(
+    const YAMLDocument& document, std::string_view name) {
+  if (const auto* mapping =
+          std::get_if<YAMLDocument::Mapping>(&document.value_)) {
+    for (const auto& [fieldName, fieldValue] : mapping->entries) {
+      if (fieldName == name) {
+        return &fieldValue;
+      }
+    }
+  }
+  return nullptr;
+}
+
+const std::string* findLeafField(
+    const YAMLDocument& document, std::string_view name) {
+  const YAMLDocument* field = findField(document, name);
+  if (field == nullptr) {
+    return nullptr;
+  }
+  const auto* leaf = std::get_if<YAMLDocument::LeafValue>(&field->value_);
+  return leaf != nullptr ? &leaf->value : nullptr;
+}
+
+class TexturePathCollector {
+ public:
+  void collectResource(const std::string& resourceName, bool isRoot) {
+    if (!visited_.insert(resourceName).second) {
+      return;
+    }
+    const std::filesystem::path resourcePath =
+        engine::ResourceManager::getResourcePath(resourceName);
+    if (!std::filesystem::is_regular_file(resourcePath)) {
+      return;
+    }
+
+    const std::vector<char> contents = util::readFileChars(resourcePath);
+    const YAMLDocument document =
+        serialization::yaml::parseDocument(serialization::yaml::tokenizeYAML(
+            std::string_view{contents.begin(), contents.end()}));
+    const std::string* objectType = findLeafField(document, "objectType");
+    const YAMLDocument* data = findField(document, "data");
+    if (objectType == nullptr || data == nullptr) {
+      return;
+    }
+
+    if (*objectType == util::typeName<engine::TextureResource>) {
+      if (const std::string* path = findLeafField(*data, "path")) {
+        paths_.emplace_back(engine::TextureResource::getImageLocation(*path));
+      }
+    } else if (isRoot || *objectType != util::typeName<SceneDefinition>) {
+      // Other scenes are only named so they can be loaded later
+      collect(*data);
+    }
+  }
+
+  std::vector<std::filesystem::path>& getPaths() { return paths_; }
+
+ private:
+  // Resources refer to each other by name, so any leaf naming a resource is
+  // followed
+  void collect(const YAMLDocument& document) {
+    std::visit(
+        [&](const auto& value) {
+          using T = std::remove_cvref_t<decltype(value)>;
+          if constexpr (std::is_same_v<T, YAMLDocument::LeafValue>) {
+            collectResource(value.value, false);
+          } else if constexpr (std::is_same_v<T, YAMLDocument::Sequence>) {
+            for (const auto& entry : value.entries) {
+              collect(entry);
+            }
+          } else {
+            for (const auto& entry : value.entries) {
+              collect(entry.second);
+            }
+          }
+        },
+        document.value_);
+  }
+
+  std::unordered_set<std::string> visited_;
+  std::vector<std::filesystem::path> paths_;
+};
+
+// Decodes every texture the scene references up front and in parallel,
+// rather than one at a time as the definition is deserialized
+std::vector<render::TextureManager::Lease> preloadSceneTextures(
+    const std::string& sceneName) {
+  TexturePathCollector collector;
+  collector.collectResource(sceneName, true);
+  return GlobalSubSystemStack::get()
+      .renderSystem()
+      .getTextureManager()
+      .preload(collector.getPaths());
+}
+
+} // namespace
+
 std::unique_ptr<Scene> loadSceneFromName(std::string sceneName) {
   return loadSceneFromDefinition(
       loadSceneDefinitionFromName(std::move(sceneName)));
@@ -29,6 +140,10 @@ std::unique_ptr<Scene> loadSceneFromName(std::string sceneName) {
 
 engine::ResourceRef<SceneDefinition> loadSceneDefinitionFromName(
     std::string sceneName) {
+  // Held until the definition's textures have taken their own leases, so none
+  // are unloaded in between
+  std::vector<render::TextureManager::Lease> preloaded =
+      preloadSceneTextures(sceneName);
   return GlobalSubSystemStack::get()
       .resourceManager()
       .loadResource<SceneDefinition>(std::move(sceneName));
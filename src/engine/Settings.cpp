@@ -16,9 +16,7 @@
 
 namespace blocks {
 
-namespace {
-
-std::filesystem::path getSettingsPath() {
+std::filesystem::path getSettingsDirectory() {
   PWSTR path = nullptr;
   const HRESULT result =
       SHGetKnownFolderPath(FOLDERID_RoamingAppData, 0, nullptr, &path);
@@ -29,10 +27,16 @@ std::filesystem::path getSettingsPath() {
     throw std::runtime_error{"Failed to get AppData path for settings"};
   }
 
-  const std::filesystem::path settingsPath =
-      std::filesystem::path{path} / "Blocks" / "engineConfig.yaml";
+  const std::filesystem::path settingsDirectory =
+      std::filesystem::path{path} / "Blocks";
   CoTaskMemFree(path);
-  return settingsPath;
+  return settingsDirectory;
+}
+
+namespace {
+
+std::filesystem::path getSettingsPath() {
+  return getSettingsDirectory() / "engineConfig.yaml";
 }
 
 Settings defaultSettings() {
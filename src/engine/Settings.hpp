@@ -1,5 +1,7 @@
 #pragma once
 
+#include <filesystem>
+#include <optional>
 #include <string>
 #include "math/vec.hpp"
 #include "util/meta_utils.hpp"
@@ -9,10 +11,22 @@ namespace blocks {
 struct Settings {
   std::string localeCode;
   math::Vec<int, 2> resolution;
+  // One of fifo, fifoRelaxed, mailbox or immediate
+  std::optional<std::string> presentMode;
+  std::optional<int> framesInFlight;
+  // Frames per second, unlimited if unset or zero
+  std::optional<int> frameRateLimit;
+  // Megabytes of textures to keep loaded, beyond which those no longer in use
+  // are unloaded
+  std::optional<int> textureMemoryBudget;
 
   using Fields = util::TArray<
       util::TPair<util::TString<"localeCode">, std::string>,
-      util::TPair<util::TString<"resolution">, math::Vec<int, 2>>>;
+      util::TPair<util::TString<"resolution">, math::Vec<int, 2>>,
+      util::TPair<util::TString<"presentMode">, std::optional<std::string>>,
+      util::TPair<util::TString<"framesInFlight">, std::optional<int>>,
+      util::TPair<util::TString<"frameRateLimit">, std::optional<int>>,
+      util::TPair<util::TString<"textureMemoryBudget">, std::optional<int>>>;
 
   template <size_t i>
   [[nodiscard]] const Fields::At<i>::Second& get() const;
@@ -27,6 +41,26 @@ struct Settings {
     return resolution;
   }
 
+  template <>
+  [[nodiscard]] const std::optional<std::string>& get<2>() const {
+    return presentMode;
+  }
+
+  template <>
+  [[nodiscard]] const std::optional<int>& get<3>() const {
+    return framesInFlight;
+  }
+
+  template <>
+  [[nodiscard]] const std::optional<int>& get<4>() const {
+    return frameRateLimit;
+  }
+
+  template <>
+  [[nodiscard]] const std::optional<int>& get<5>() const {
+    return textureMemoryBudget;
+  }
+
   template <typename Fn>
   static void update(Fn&& fn) {
     Settings& settings = getInternal();
@@ -40,5 +74,7 @@ struct Settings {
 };
 
 const Settings& getSettings();
+// Also used for other per-user files such as caches
+std::filesystem::path getSettingsDirectory();
 
 } // namespace blocks
@@ -1,5 +1,6 @@
 #include "engine/TextureResource.hpp"
 
+#include <filesystem>
 #include <string>
 #include "GlobalSubSystemStack.hpp"
 #include "render/renderables/RenderableTex2D.hpp"
@@ -12,6 +13,11 @@ TextureResource::TextureResource(const std::string& path)
           GlobalSubSystemStack::get()
               .renderSystem()
               .createRenderable<render::RenderableTex2D>(
-                  util::toString(RESOURCE_DIR "/", path))) {}
+                  getImageLocation(path))) {}
+
+std::filesystem::path TextureResource::getImageLocation(
+    const std::string& path) {
+  return util::toString(RESOURCE_DIR "/", path);
+}
 
 } // namespace blocks::engine
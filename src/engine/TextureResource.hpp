@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <string>
 #include "render/RenderSubSystem.hpp"
 #include "render/renderables/RenderableTex2D.hpp"
@@ -13,6 +14,9 @@ class TextureResource {
 
   explicit TextureResource(const std::string& path);
 
+  // Where the image for a resource with the given path is loaded from
+  static std::filesystem::path getImageLocation(const std::string& path);
+
   render::RenderableRef<render::RenderableTex2D::InstanceData> get() {
     return renderable_.get();
   }
@@ -19,6 +19,7 @@ TestText::TestText(Scene& scene)
 
 void TestText::draw() {
   font_.drawStringUTF8(
+      GlobalSubSystemStack::get().window(),
       "Hello, world! \xc4\xa9",
       math::Vec2{-1.0f, 0.0f},
       render::Font::Size::Em{0.2f});
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace blocks::loader {
+
+// Values match the corresponding sRGB VkFormat
+enum class CompressedFormat : uint32_t {
+  BC1 = 132,
+  BC3 = 138,
+  BC7 = 146,
+};
+
+// Bytes per 4x4 block
+constexpr size_t getBlockSize(CompressedFormat format) {
+  return format == CompressedFormat::BC1 ? 8 : 16;
+}
+
+constexpr size_t getCompressedSize(
+    CompressedFormat format, size_t width, size_t height) {
+  return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+class CompressedImage {
+ public:
+  struct MipLevel {
+    size_t offset;
+    size_t size;
+  };
+
+  CompressedFormat format;
+  size_t width;
+  size_t height;
+  // Largest first, each a row major grid of blocks within data
+  std::vector<MipLevel> mipLevels;
+  std::vector<std::byte> data;
+};
+
+} // namespace blocks::loader
@@ -0,0 +1,224 @@
+#include "loader/ImageCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "loader/Image.hpp"
+#include "util/file.hpp"
+
+namespace blocks::loader {
+
+namespace {
+
+constexpr uint32_t kCacheFileMagic = 0x43494c42; // "BLIC"
+// Bump whenever a decoder's output changes, to discard stale entries
+constexpr uint32_t kCacheFileVersion = 1;
+
+constexpr uint64_t kMaxDimension = 1 << 16;
+constexpr size_t kPixelAlignment = 64;
+
+// Followed by the source path, then the pixel data at getPixelOffset()
+struct CacheFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sourceSize;
+  int64_t sourceWriteTime;
+  uint64_t sourceHash;
+  uint64_t width;
+  uint64_t height;
+  uint64_t pathSize;
+};
+
+size_t getPixelOffset(size_t pathSize) {
+  const size_t end = sizeof(CacheFileHeader) + pathSize;
+  return (end + kPixelAlignment - 1) / kPixelAlignment * kPixelAlignment;
+}
+
+// Not cryptographic, only needs to notice a source being edited
+uint64_t hashBytes(std::span<const std::byte> data) {
+  constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15;
+  uint64_t hash = data.size();
+  size_t i = 0;
+  for (; i + 8 <= data.size(); i += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, &data[i], 8);
+    hash = (hash ^ word) * kMultiplier;
+    hash ^= hash >> 32;
+  }
+  uint64_t tail = 0;
+  if (i < data.size()) {
+    std::memcpy(&tail, &data[i], data.size() - i);
+  }
+  hash = (hash ^ tail) * kMultiplier;
+  return hash ^ (hash >> 29);
+}
+
+std::span<const std::byte> asBytes(const std::string& value) {
+  return std::as_bytes(std::span{value.data(), value.size()});
+}
+
+std::string getSourceKey(const std::filesystem::path& source) {
+  return std::filesystem::absolute(source).lexically_normal().generic_string();
+}
+
+int64_t getWriteTime(const std::filesystem::path& source) {
+  return static_cast<int64_t>(
+      std::filesystem::last_write_time(source).time_since_epoch().count());
+}
+
+void writeBytes(std::ofstream& stream, std::span<const std::byte> data) {
+  stream.write(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const char*>(data.data()),
+      static_cast<std::streamsize>(data.size()));
+}
+
+bool isSourceUnchanged(
+    const CacheFileHeader& header,
+    const std::filesystem::path& source,
+    int64_t writeTime) {
+  if (std::filesystem::file_size(source) != header.sourceSize) {
+    return false;
+  }
+  if (writeTime == header.sourceWriteTime) {
+    return true;
+  }
+  // Checking out or copying a file touches it without changing it
+  return hashBytes(util::MappedFile{source}.bytes()) == header.sourceHash;
+}
+
+// Records a touched source's new time, so the next lookup need not hash it
+void updateWriteTime(
+    const std::filesystem::path& cachePath, int64_t writeTime) {
+  std::fstream stream{
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      cachePath, std::ios::in | std::ios::out | std::ios::binary};
+  stream.seekp(offsetof(CacheFileHeader, sourceWriteTime));
+  stream.write(
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      reinterpret_cast<const char*>(&writeTime),
+      sizeof(writeTime));
+}
+
+} // namespace
+
+ImageCache::ImageCache(std::filesystem::path cacheDirectory)
+    : cacheDirectory_(std::move(cacheDirectory)) {}
+
+std::optional<CachedImage> ImageCache::find(
+    const std::filesystem::path& source) const {
+  try {
+    const std::filesystem::path cachePath = getCachePath(source);
+    if (!std::filesystem::is_regular_file(cachePath)) {
+      return std::nullopt;
+    }
+
+    util::MappedFile file{cachePath};
+    const std::span<const std::byte> contents = file.bytes();
+    if (contents.size() < sizeof(CacheFileHeader)) {
+      return std::nullopt;
+    }
+    CacheFileHeader header{};
+    std::memcpy(&header, contents.data(), sizeof(CacheFileHeader));
+
+    const std::string sourceKey = getSourceKey(source);
+    if (header.magic != kCacheFileMagic ||
+        header.version != kCacheFileVersion ||
+        header.pathSize != sourceKey.size() || header.width > kMaxDimension ||
+        header.height > kMaxDimension) {
+      return std::nullopt;
+    }
+    const size_t pixelOffset = getPixelOffset(header.pathSize);
+    const size_t pixelSize = header.width * header.height * 4;
+    if (contents.size() != pixelOffset + pixelSize) {
+      return std::nullopt;
+    }
+    const auto storedKey =
+        contents.subspan(sizeof(CacheFileHeader), header.pathSize);
+    const int64_t writeTime = getWriteTime(source);
+    if (!std::equal(
+            storedKey.begin(), storedKey.end(), asBytes(sourceKey).begin()) ||
+        !isSourceUnchanged(header, source, writeTime)) {
+      return std::nullopt;
+    }
+    if (writeTime != header.sourceWriteTime) {
+      updateWriteTime(cachePath, writeTime);
+    }
+
+    return CachedImage{
+        .width = header.width,
+        .height = header.height,
+        .file = std::move(file),
+        .pixelData = contents.subspan(pixelOffset, pixelSize)};
+  } catch (...) {
+    // A missing or unreadable entry is just a miss
+    return std::nullopt;
+  }
+}
+
+void ImageCache::store(
+    const std::filesystem::path& source, const Image& image) const {
+  if (image.width > kMaxDimension || image.height > kMaxDimension ||
+      image.pixelData.size() != image.width * image.height * 4) {
+    throw std::runtime_error{"Image cannot be cached"};
+  }
+
+  const std::string sourceKey = getSourceKey(source);
+  const int64_t writeTime = getWriteTime(source);
+  const util::MappedFile sourceFile{source};
+  const CacheFileHeader header{
+      .magic = kCacheFileMagic,
+      .version = kCacheFileVersion,
+      .sourceSize = sourceFile.bytes().size(),
+      .sourceWriteTime = writeTime,
+      .sourceHash = hashBytes(sourceFile.bytes()),
+      .width = image.width,
+      .height = image.height,
+      .pathSize = sourceKey.size()};
+  const std::array<std::byte, kPixelAlignment> padding{};
+
+  // Write to a temporary file first so a crash never leaves a torn entry
+  const std::filesystem::path cachePath = getCachePath(source);
+  std::filesystem::create_directories(cacheDirectory_);
+  std::filesystem::path tempPath = cachePath;
+  tempPath += ".tmp";
+  {
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    std::ofstream outStream{tempPath, std::ios::binary | std::ios::trunc};
+    writeBytes(outStream, std::as_bytes(std::span{&header, 1}));
+    writeBytes(outStream, asBytes(sourceKey));
+    writeBytes(
+        outStream,
+        std::span{padding}.subspan(
+            0,
+            getPixelOffset(sourceKey.size()) - sizeof(CacheFileHeader) -
+                sourceKey.size()));
+    writeBytes(outStream, image.pixelData);
+    if (!outStream) {
+      throw std::runtime_error{"Failed to write image cache entry"};
+    }
+  }
+  std::filesystem::rename(tempPath, cachePath);
+}
+
+std::filesystem::path ImageCache::getCachePath(
+    const std::filesystem::path& source) const {
+  const uint64_t hash = hashBytes(asBytes(getSourceKey(source)));
+  std::string name(16, '0');
+  for (size_t i = 0; i < name.size(); i++) {
+    name[i] = "0123456789abcdef"[(hash >> (60 - (4 * i))) & 0xf];
+  }
+  return cacheDirectory_ / (name + ".img");
+}
+
+} // namespace blocks::loader
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include "loader/Image.hpp"
+#include "util/file.hpp"
+
+namespace blocks::loader {
+
+// A decoded image read straight out of the cache file
+class CachedImage {
+ public:
+  size_t width;
+  size_t height;
+  util::MappedFile file;
+  // BGRA, within file
+  std::span<const std::byte> pixelData;
+};
+
+// Decoded images persisted to disk between runs, so that loading an unchanged
+// texture is a page in rather than a decode. Entries are keyed by source path
+// and validated against the source's size, modification time and contents.
+class ImageCache {
+ public:
+  explicit ImageCache(std::filesystem::path cacheDirectory);
+
+  // Safe to call from several threads, as long as each source is only
+  // stored by one of them at a time
+  [[nodiscard]] std::optional<CachedImage> find(
+      const std::filesystem::path& source) const;
+  void store(const std::filesystem::path& source, const Image& image) const;
+
+ private:
+  [[nodiscard]] std::filesystem::path getCachePath(
+      const std::filesystem::path& source) const;
+
+  std::filesystem::path cacheDirectory_;
+};
+
+} // namespace blocks::loader
@@ -5,6 +5,7 @@
 #include <string>
 #include "loader/Image.hpp"
 #include "loader/image/Bitmap.hpp"
+#include "loader/image/Ktx2.hpp"
 #include "loader/image/Png.hpp"
 #include "util/string.hpp"
 
@@ -24,4 +25,11 @@ Image loadImage(const std::filesystem::path& path) {
       util::toString("Unknown image format: ", extension.string().c_str())};
 }
 
+TextureData loadTexture(const std::filesystem::path& path) {
+  if (path.extension() == ".ktx2") {
+    return loadKtx2(path);
+  }
+  return loadImage(path);
+}
+
 } // namespace blocks::loader
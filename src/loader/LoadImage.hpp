@@ -1,10 +1,17 @@
 #pragma once
 
 #include <filesystem>
+#include <variant>
+#include "loader/CompressedImage.hpp"
 #include "loader/Image.hpp"
 
 namespace blocks::loader {
 
 Image loadImage(const std::filesystem::path& path);
 
+using TextureData = std::variant<Image, CompressedImage>;
+
+// Block compressed files are loaded as they are, anything else is decoded
+TextureData loadTexture(const std::filesystem::path& path);
+
 }
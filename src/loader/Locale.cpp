@@ -13,7 +13,7 @@
 namespace blocks::loader {
 
 Locale loadLocale(const std::filesystem::path& path) {
-  return loadLocale(util::readFileBytes(path));
+  return loadLocale(util::MappedFile{path}.bytes());
 }
 
 Locale loadLocale(std::span<const std::byte> dataBytes) {
@@ -1,11 +1,13 @@
 #include "loader/font/Font.hpp"
 
+#include <algorithm>
 #include <array>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <span>
 #include <stdexcept>
@@ -22,6 +24,11 @@ namespace blocks::loader {
 
 namespace {
 
+// Outlines parsed lazily share arenas of this size, so a glyph costs a
+// fraction of an allocation rather than several
+constexpr size_t kLazyArenaEndPoints = 1024;
+constexpr size_t kLazyArenaPoints = 16 * 1024;
+
 struct Fixed {
   uint32_t rawValue;
 
@@ -214,64 +221,7 @@ NameTable readNameTable(std::span<const std::byte> data) {
 }
 
 // Two-byte encoding, sparse data
-class Format4Map : public CharToGlyphMap {
- public:
-  Format4Map(
-      uint16_t segCount,
-      std::vector<uint16_t> endCodes,
-      std::vector<uint16_t> startCodes,
-      std::vector<uint16_t> idDelta,
-      std::vector<uint16_t> idRangeOffset,
-      std::vector<uint16_t> glyphIndices)
-      : segCount_(segCount),
-        endCodes_(std::move(endCodes)),
-        startCodes_(std::move(startCodes)),
-        idDelta_(std::move(idDelta)),
-        idRangeOffset_(std::move(idRangeOffset)),
-        glyphIndices_(std::move(glyphIndices)) {
-    DEBUG_ASSERT(endCodes_.size() == segCount_);
-    DEBUG_ASSERT(startCodes_.size() == segCount_);
-    DEBUG_ASSERT(idDelta_.size() == segCount_);
-    DEBUG_ASSERT(idRangeOffset_.size() == segCount_);
-  }
-
-  uint16_t mapChar(uint32_t unicodeChar) final {
-    if (unicodeChar > 0xFFFF) {
-      return 0;
-    }
-    const auto charValue = static_cast<uint16_t>(unicodeChar);
-
-    unsigned int segmentIndex = 0;
-    for (; segmentIndex < segCount_; segmentIndex++) {
-      if (endCodes_[segmentIndex] >= charValue) {
-        break;
-      }
-    }
-
-    if (startCodes_[segmentIndex] > charValue) {
-      return 0;
-    }
-
-    if (idRangeOffset_[segmentIndex] != 0) {
-      const unsigned int glyphIndexArrayIndex =
-          (idRangeOffset_[segmentIndex] / 2) + charValue -
-          startCodes_[segmentIndex] - (segCount_ - segmentIndex);
-      return glyphIndices_[glyphIndexArrayIndex];
-    } else {
-      return idDelta_[segmentIndex] + charValue;
-    }
-  }
-
- private:
-  uint16_t segCount_;
-  std::vector<uint16_t> endCodes_;
-  std::vector<uint16_t> startCodes_;
-  std::vector<uint16_t> idDelta_;
-  std::vector<uint16_t> idRangeOffset_;
-  std::vector<uint16_t> glyphIndices_;
-};
-
-Format4Map readCharMapSubtableFormat4(std::span<const std::byte> data) {
+CharToGlyphMap readCharMapSubtableFormat4(std::span<const std::byte> data) {
   auto length = readBigEndian<uint16_t>(data);
   // We've already read the format and length
   if (length < 14 || data.size() < length - 4) {
@@ -342,17 +292,25 @@ Format4Map readCharMapSubtableFormat4(std::span<const std::byte> data) {
     }
   }
 
-  return {
-      segCount,
-      std::move(endCodes),
-      std::move(startCodes),
-      std::move(idDelta),
-      std::move(idRangeOffset),
-      std::move(glyphIndices)};
+  // Expand the segments up front so lookups don't have to search them
+  CharToGlyphMap result;
+  for (unsigned int i = 0; i < segCount; i++) {
+    for (uint32_t c = startCodes[i]; c <= endCodes[i]; c++) {
+      const auto charValue = static_cast<uint16_t>(c);
+      if (idRangeOffset[i] != 0) {
+        const unsigned int glyphIndexArrayIndex = (idRangeOffset[i] / 2) +
+            charValue - startCodes[i] - (segCount - i);
+        result.set(charValue, glyphIndices[glyphIndexArrayIndex]);
+      } else {
+        result.set(charValue, static_cast<uint16_t>(idDelta[i] + charValue));
+      }
+    }
+  }
+
+  return result;
 }
 
-std::unique_ptr<CharToGlyphMap> readCharMapTable(
-    std::span<const std::byte> data) {
+CharToGlyphMap readCharMapTable(std::span<const std::byte> data) {
   struct SubtableHeader {
     uint16_t platformId;
     uint16_t platformSpecificId;
@@ -400,7 +358,7 @@ std::unique_ptr<CharToGlyphMap> readCharMapTable(
   auto format = readBigEndian<uint16_t>(data);
 
   if (format == 4) {
-    return std::make_unique<Format4Map>(readCharMapSubtableFormat4(data));
+    return readCharMapSubtableFormat4(data);
   } else {
     throw std::runtime_error{"Unsupported font file"};
   }
@@ -486,7 +444,9 @@ GlyphLocations readGlyphLocations(
 }
 
 SimpleGlyphData readSimpleGlyph(
-    int16_t numContours, std::span<const std::byte>& data) {
+    int16_t numContours,
+    std::span<const std::byte>& data,
+    GlyphOutlineArena& arena) {
   struct GlyphFlags {
     uint8_t value;
     [[nodiscard]] bool onCurve() const { return (value & 0x1ull) > 0; }
@@ -502,16 +462,11 @@ SimpleGlyphData readSimpleGlyph(
     throw std::runtime_error{"Corrupt font file"};
   }
 
-  std::vector<uint16_t> endPoints;
-  endPoints.reserve(numContours);
-
-  if (numContours > 0) {
-    endPoints.emplace_back(readBigEndian<uint16_t>(data));
-    for (int i = 1; i < numContours; i++) {
-      endPoints.emplace_back(readBigEndian<uint16_t>(data));
-      if (endPoints[i] < endPoints[i - 1]) {
-        throw std::runtime_error{"Corrupt font file"};
-      }
+  const std::span<uint16_t> endPoints = arena.allocateEndPoints(numContours);
+  for (int i = 0; i < numContours; i++) {
+    endPoints[i] = readBigEndian<uint16_t>(data);
+    if (i > 0 && endPoints[i] < endPoints[i - 1]) {
+      throw std::runtime_error{"Corrupt font file"};
     }
   }
 
@@ -523,8 +478,7 @@ SimpleGlyphData readSimpleGlyph(
   }
   data = data.subspan(instructionLength);
 
-  std::vector<GlyphFlags> flags;
-  flags.reserve(numPoints);
+  const std::span<GlyphPoint> points = arena.allocatePoints(numPoints);
 
   size_t pointBytes = 0;
 
@@ -533,7 +487,7 @@ SimpleGlyphData readSimpleGlyph(
       throw std::runtime_error{"Corrupt font file"};
     }
     const GlyphFlags current{readBigEndian<uint8_t>(data)};
-    flags.emplace_back(current);
+    points[i].flags = current.value;
 
     // NOLINTNEXTLINE(readability-avoid-nested-conditional-operator)
     pointBytes += current.xShort() ? 1 : (current.xSame() ? 0 : 2);
@@ -557,8 +511,8 @@ SimpleGlyphData readSimpleGlyph(
         throw std::runtime_error{"Corrupt font file"};
       }
       for (int j = 0; j < repetitions; j++) {
-        flags.emplace_back(current);
         i++;
+        points[i].flags = current.value;
       }
     }
   }
@@ -568,10 +522,8 @@ SimpleGlyphData readSimpleGlyph(
   }
 
   int16_t baseXCoord = 0;
-  std::vector<int16_t> xCoords;
-  xCoords.reserve(numPoints);
-  for (unsigned int i = 0; i < numPoints; i++) {
-    const GlyphFlags current = flags[i];
+  for (GlyphPoint& point : points) {
+    const GlyphFlags current{point.flags};
     if (current.xShort()) {
       auto curOffset = static_cast<int16_t>(readBigEndian<uint8_t>(data));
       if (!current.xSame()) {
@@ -587,14 +539,12 @@ SimpleGlyphData readSimpleGlyph(
       }
     }
 
-    xCoords.emplace_back(baseXCoord);
+    point.x = baseXCoord;
   }
 
   int16_t baseYCoord = 0;
-  std::vector<int16_t> yCoords;
-  yCoords.reserve(numPoints);
-  for (unsigned int i = 0; i < numPoints; i++) {
-    const GlyphFlags current = flags[i];
+  for (GlyphPoint& point : points) {
+    const GlyphFlags current{point.flags};
     if (current.yShort()) {
       auto curOffset = static_cast<int16_t>(readBigEndian<uint8_t>(data));
       if (!current.ySame()) {
@@ -610,20 +560,10 @@ SimpleGlyphData readSimpleGlyph(
       }
     }
 
-    yCoords.emplace_back(baseYCoord);
-  }
-
-  std::vector<bool> onCurve;
-  onCurve.reserve(numPoints);
-  for (const auto& flag : flags) {
-    onCurve.emplace_back(flag.onCurve());
+    point.y = baseYCoord;
   }
 
-  return {
-      .endPoints = std::move(endPoints),
-      .xCoords = std::move(xCoords),
-      .yCoords = std::move(yCoords),
-      .onCurve = std::move(onCurve)};
+  return {.endPoints = endPoints, .points = points};
 }
 
 std::vector<CompoundGlyphData> readCompoundGlyph(
@@ -734,68 +674,112 @@ std::vector<CompoundGlyphData> readCompoundGlyph(
   return result;
 }
 
-std::vector<GlyphContourData> readGlyphTable(
-    const GlyphLocations& glyphLocations, std::span<const std::byte> data) {
-  std::vector<GlyphContourData> result;
-  result.reserve(glyphLocations.offsets.size());
-
-  for (size_t i = 0; i < glyphLocations.offsets.size() - 1; i++) {
-    const long long curSize = i + 1 < glyphLocations.offsets.size()
-        ? static_cast<long long>(glyphLocations.offsets[i + 1]) -
-            glyphLocations.offsets[i]
-        : static_cast<long long>(data.size()) - glyphLocations.offsets[i];
-    if (curSize < 0) {
-      throw std::runtime_error{"Corrupt font file"};
-    }
-    if (curSize == 0) {
-      result.emplace_back(
-          GlyphContourData{
-              .xMin{0},
-              .yMin{0},
-              .xMax{0},
-              .yMax{0},
-              .data = std::monostate{}});
-      continue;
-    }
+std::span<const std::byte> getGlyphData(
+    std::span<const uint32_t> offsets,
+    std::span<const std::byte> data,
+    size_t glyphIndex) {
+  const long long curSize = static_cast<long long>(offsets[glyphIndex + 1]) -
+      offsets[glyphIndex];
+  if (curSize < 0 || offsets[glyphIndex + 1] > data.size()) {
+    throw std::runtime_error{"Corrupt font file"};
+  }
+  return data.subspan(offsets[glyphIndex], curSize);
+}
 
-    std::span<const std::byte> glyphData =
-        data.subspan(glyphLocations.offsets[i], curSize);
+struct OutlineSize {
+  size_t endPointCount = 0;
+  size_t pointCount = 0;
+};
 
-    if (glyphData.size() < 10) {
-      throw std::runtime_error{"Corrupt font file"};
-    }
-    auto numContours = readBigEndian<int16_t>(glyphData);
-
-    const FWord xMin{readBigEndian<FWord>(glyphData)};
-    const FWord yMin{readBigEndian<FWord>(glyphData)};
-    const FWord xMax{readBigEndian<FWord>(glyphData)};
-    const FWord yMax{readBigEndian<FWord>(glyphData)};
-
-    if (numContours >= 0) {
-      result.emplace_back(
-          GlyphContourData{
-              .xMin = xMin,
-              .yMin = yMin,
-              .xMax = xMax,
-              .yMax = yMax,
-              .data{readSimpleGlyph(numContours, glyphData)}});
-    } else {
-      result.emplace_back(
-          GlyphContourData{
-              .xMin = xMin,
-              .yMin = yMin,
-              .xMax = xMax,
-              .yMax = yMax,
-              .data{readCompoundGlyph(glyphData)}});
-    }
-    if (glyphData.size() >= 2) {
-      throw std::runtime_error{"Corrupt font file"};
-    }
+// Reads just enough of a glyph to know how much arena space it will need
+OutlineSize peekOutlineSize(std::span<const std::byte> glyphData) {
+  if (glyphData.empty()) {
+    return {};
+  }
+  if (glyphData.size() < 10) {
+    throw std::runtime_error{"Corrupt font file"};
+  }
+  auto numContours = readBigEndian<int16_t>(glyphData);
+  if (numContours <= 0) {
+    return {};
   }
 
-  if (result.size() < 2) {
+  glyphData = glyphData.subspan(8);
+  if (glyphData.size() < 2 * static_cast<size_t>(numContours)) {
     throw std::runtime_error{"Corrupt font file"};
   }
+  glyphData = glyphData.subspan(2 * (static_cast<size_t>(numContours) - 1));
+  const auto lastEndPoint = readBigEndian<uint16_t>(glyphData);
+  return OutlineSize{
+      .endPointCount = static_cast<size_t>(numContours),
+      .pointCount = 1 + static_cast<size_t>(lastEndPoint)};
+}
+
+// Only reads the bounds if no arena is given
+GlyphContourData readGlyph(
+    std::span<const std::byte> glyphData, GlyphOutlineArena* arena) {
+  if (glyphData.empty()) {
+    return GlyphContourData{
+        .xMin{0}, .yMin{0}, .xMax{0}, .yMax{0}, .data = std::monostate{}};
+  }
+
+  if (glyphData.size() < 10) {
+    throw std::runtime_error{"Corrupt font file"};
+  }
+  auto numContours = readBigEndian<int16_t>(glyphData);
+
+  GlyphContourData result{
+      .xMin{readBigEndian<FWord>(glyphData)},
+      .yMin{readBigEndian<FWord>(glyphData)},
+      .xMax{readBigEndian<FWord>(glyphData)},
+      .yMax{readBigEndian<FWord>(glyphData)},
+      .data = std::monostate{}};
+  if (arena == nullptr) {
+    return result;
+  }
+
+  if (numContours >= 0) {
+    result.data = readSimpleGlyph(numContours, glyphData, *arena);
+  } else {
+    result.data = readCompoundGlyph(glyphData);
+  }
+  if (glyphData.size() >= 2) {
+    throw std::runtime_error{"Corrupt font file"};
+  }
+
+  return result;
+}
+
+std::vector<GlyphContourData> readGlyphTable(
+    const GlyphLocations& glyphLocations,
+    std::span<const std::byte> data,
+    GlyphLoading loading,
+    GlyphOutlineArena& arena) {
+  const size_t glyphCount = glyphLocations.offsets.size() - 1;
+  if (glyphCount < 2) {
+    throw std::runtime_error{"Corrupt font file"};
+  }
+
+  if (loading == GlyphLoading::EAGER) {
+    // Size the arena exactly so it never has to grow
+    OutlineSize totalSize;
+    for (size_t i = 0; i < glyphCount; i++) {
+      const OutlineSize size =
+          peekOutlineSize(getGlyphData(glyphLocations.offsets, data, i));
+      totalSize.endPointCount += size.endPointCount;
+      totalSize.pointCount += size.pointCount;
+    }
+    arena = GlyphOutlineArena{totalSize.endPointCount, totalSize.pointCount};
+  }
+
+  std::vector<GlyphContourData> result;
+  result.reserve(glyphCount);
+  for (size_t i = 0; i < glyphCount; i++) {
+    result.emplace_back(
+        readGlyph(
+            getGlyphData(glyphLocations.offsets, data, i),
+            loading == GlyphLoading::EAGER ? &arena : nullptr));
+  }
 
   return result;
 }
@@ -1024,7 +1008,7 @@ KerningTable readKerningTable(std::span<const std::byte> data) {
     readKerningSubtable(data, kernValues);
   }
 
-  return KerningTable{std::move(kernValues)};
+  return KerningTable{kernValues};
 }
 
 struct OS2TableData {
@@ -1137,20 +1121,118 @@ const TableDirectoryEntry* lookupTable(
 
 } // namespace
 
-FWord KerningTable::apply(uint16_t leftGlyph, uint16_t rightGlyph) const {
-  if (auto it = data_.find(kerningMapKey(leftGlyph, rightGlyph));
-      it != data_.end()) {
+CharToGlyphMap::CharToGlyphMap() : glyphs_(kPageSize, 0) {}
+
+void CharToGlyphMap::set(uint16_t unicodeChar, uint16_t glyphIndex) {
+  uint16_t& page = pageIndices_[unicodeChar >> kPageBits];
+  if (page == 0) {
+    if (glyphIndex == 0) {
+      return;
+    }
+    page = static_cast<uint16_t>(glyphs_.size() / kPageSize);
+    glyphs_.resize(glyphs_.size() + kPageSize, 0);
+  }
+  glyphs_[(static_cast<size_t>(page) << kPageBits) |
+          (unicodeChar & (kPageSize - 1))] = glyphIndex;
+}
+
+KerningTable::KerningTable(const std::unordered_map<uint32_t, FWord>& data) {
+  if (data.empty()) {
+    return;
+  }
+
+  std::vector<std::pair<uint32_t, FWord>> pairs{data.begin(), data.end()};
+  std::ranges::sort(pairs, [](const auto& lhs, const auto& rhs) {
+    return lhs.first < rhs.first;
+  });
+
+  const uint32_t maxLeft = pairs.back().first >> 16;
+  rowStarts_.resize(static_cast<size_t>(maxLeft) + 2, 0);
+  rightGlyphs_.reserve(pairs.size());
+  values_.reserve(pairs.size());
+  for (const auto& [key, value] : pairs) {
+    rowStarts_[(key >> 16) + 1]++;
+    rightGlyphs_.emplace_back(static_cast<uint16_t>(key & 0xFFFF));
+    values_.emplace_back(value);
+  }
+  for (size_t i = 1; i < rowStarts_.size(); i++) {
+    rowStarts_[i] += rowStarts_[i - 1];
+  }
+}
+
+GlyphOutlineArena::GlyphOutlineArena(
+    size_t endPointCapacity, size_t pointCapacity) {
+  endPoints_.reserve(endPointCapacity);
+  points_.reserve(pointCapacity);
+}
+
+std::span<uint16_t> GlyphOutlineArena::allocateEndPoints(size_t count) {
+  if (!canFit(count, 0)) {
+    throw std::runtime_error{"Glyph outline arena is full"};
+  }
+  const size_t start = endPoints_.size();
+  endPoints_.resize(start + count);
+  return std::span{endPoints_}.subspan(start);
+}
+
+std::span<GlyphPoint> GlyphOutlineArena::allocatePoints(size_t count) {
+  if (!canFit(0, count)) {
+    throw std::runtime_error{"Glyph outline arena is full"};
+  }
+  const size_t start = points_.size();
+  points_.resize(start + count);
+  return std::span{points_}.subspan(start);
+}
+
+LazyGlyphTable::LazyGlyphTable(
+    std::vector<std::byte> glyphTable, std::vector<uint32_t> offsets)
+    : ownedTable_(std::move(glyphTable)),
+      glyphTable_(ownedTable_),
+      offsets_(std::move(offsets)) {}
+
+LazyGlyphTable::LazyGlyphTable(
+    util::MappedFile file,
+    std::span<const std::byte> glyphTable,
+    std::vector<uint32_t> offsets)
+    : file_(std::move(file)),
+      glyphTable_(glyphTable),
+      offsets_(std::move(offsets)) {
+  // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+  file_->advise(util::MappedFile::AccessPattern::RANDOM);
+}
+
+const GlyphContourData& LazyGlyphTable::get(uint16_t glyphIndex) const {
+  const std::lock_guard lock{mutex_};
+  if (auto it = cache_.find(glyphIndex); it != cache_.end()) {
     return it->second;
-  } else {
-    return FWord{0};
   }
+
+  const auto glyphData = getGlyphData(offsets_, glyphTable_, glyphIndex);
+  const OutlineSize size = peekOutlineSize(glyphData);
+  if (arenas_.empty() ||
+      !arenas_.back().canFit(size.endPointCount, size.pointCount)) {
+    arenas_.emplace_back(
+        std::max(size.endPointCount, kLazyArenaEndPoints),
+        std::max(size.pointCount, kLazyArenaPoints));
+  }
+  return cache_.emplace(glyphIndex, readGlyph(glyphData, &arenas_.back()))
+      .first->second;
 }
 
-Font loadFont(const std::filesystem::path& path) {
-  return loadFont(util::readFileBytes(path));
+const GlyphContourData& Font::getContours(uint16_t glyphIndex) const {
+  if (lazyGlyphs != nullptr) {
+    return lazyGlyphs->get(glyphIndex);
+  }
+  return glyphs[glyphIndex].contourData;
 }
 
-Font loadFont(const std::span<const std::byte> data) {
+namespace {
+
+// Lazily loaded glyphs are read straight from file when it is given
+Font readFont(
+    const std::span<const std::byte> data,
+    GlyphLoading loading,
+    std::optional<util::MappedFile> file) {
   const OffsetSubtable offsetSubtable =
       readOffsetSubtable(data.subspan(0, sizeof(OffsetSubtable)));
 
@@ -1206,7 +1288,7 @@ Font loadFont(const std::span<const std::byte> data) {
     return readNameTable(getTableContents(data, *entryPtr));
   }();
 
-  std::unique_ptr<CharToGlyphMap> charMap = [&]() {
+  CharToGlyphMap charMap = [&]() {
     const auto* const entryPtr = lookupTable(tableDirectory, kTagCmap);
     if (entryPtr == nullptr) {
       throw std::runtime_error{"Corrupt font file"};
@@ -1231,12 +1313,29 @@ Font loadFont(const std::span<const std::byte> data) {
         headEntry, maxProfile, getTableContents(data, *entryPtr));
   }();
 
+  GlyphOutlineArena outlines;
   std::vector<GlyphContourData> glyphs = [&]() {
     const auto* const entryPtr = lookupTable(tableDirectory, kTagGlyf);
     if (entryPtr == nullptr) {
       throw std::runtime_error{"Corrupt font file"};
     }
-    return readGlyphTable(glyphLocations, getTableContents(data, *entryPtr));
+    return readGlyphTable(
+        glyphLocations, getTableContents(data, *entryPtr), loading, outlines);
+  }();
+
+  std::unique_ptr<LazyGlyphTable> lazyGlyphs = [&]() {
+    if (loading != GlyphLoading::LAZY) {
+      return std::unique_ptr<LazyGlyphTable>{};
+    }
+    const auto glyphTable =
+        getTableContents(data, *lookupTable(tableDirectory, kTagGlyf));
+    if (file.has_value()) {
+      return std::make_unique<LazyGlyphTable>(
+          std::move(*file), glyphTable, std::move(glyphLocations.offsets));
+    }
+    return std::make_unique<LazyGlyphTable>(
+        std::vector<std::byte>{glyphTable.begin(), glyphTable.end()},
+        std::move(glyphLocations.offsets));
   }();
 
   HorizontalHeader horizontalHeader = [&]() {
@@ -1320,7 +1419,21 @@ Font loadFont(const std::span<const std::byte> data) {
       .descenderHeight =
           os2Data.has_value() ? os2Data->descender : horizontalHeader.descent,
       .lineGap =
-          os2Data.has_value() ? os2Data->lineGap : horizontalHeader.lineGap};
+          os2Data.has_value() ? os2Data->lineGap : horizontalHeader.lineGap,
+      .outlines = std::move(outlines),
+      .lazyGlyphs = std::move(lazyGlyphs)};
+}
+
+} // namespace
+
+Font loadFont(const std::filesystem::path& path, GlyphLoading loading) {
+  util::MappedFile file{path};
+  const std::span<const std::byte> data = file.bytes();
+  return readFont(data, loading, std::move(file));
+}
+
+Font loadFont(const std::span<const std::byte> data, GlyphLoading loading) {
+  return readFont(data, loading, std::nullopt);
 }
 
 } // namespace blocks::loader
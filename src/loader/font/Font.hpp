@@ -1,13 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <span>
 #include <unordered_map>
 #include <variant>
 #include <vector>
+#include "util/file.hpp"
 
 namespace blocks::loader {
 
@@ -35,26 +40,65 @@ struct UFWord {
   uint16_t rawValue = 0;
 };
 
+// Two level page table over the basic multilingual plane, built once at load
+// time. Pages without any glyphs share a single empty page.
 class CharToGlyphMap {
  public:
-  CharToGlyphMap() = default;
+  CharToGlyphMap();
 
-  CharToGlyphMap(const CharToGlyphMap& other) = default;
-  CharToGlyphMap& operator=(const CharToGlyphMap& other) = default;
+  void set(uint16_t unicodeChar, uint16_t glyphIndex);
 
-  CharToGlyphMap(CharToGlyphMap&& other) = default;
-  CharToGlyphMap& operator=(CharToGlyphMap&& other) = default;
+  [[nodiscard]] uint16_t mapChar(uint32_t unicodeChar) const {
+    if (unicodeChar > 0xFFFF) {
+      return 0;
+    }
+    const size_t page = pageIndices_[unicodeChar >> kPageBits];
+    return glyphs_[(page << kPageBits) | (unicodeChar & (kPageSize - 1))];
+  }
+
+ private:
+  static constexpr uint32_t kPageBits = 8;
+  static constexpr uint32_t kPageSize = 1u << kPageBits;
 
-  virtual ~CharToGlyphMap() = default;
+  std::array<uint16_t, kPageSize> pageIndices_{};
+  std::vector<uint16_t> glyphs_;
+};
+
+struct GlyphPoint {
+  int16_t x;
+  int16_t y;
+  // As stored in the glyf table, only the on curve bit is meaningful once the
+  // coordinates have been decoded
+  uint8_t flags;
 
-  virtual uint16_t mapChar(uint32_t unicodeChar) = 0;
+  [[nodiscard]] bool onCurve() const { return (flags & 0x1u) != 0; }
 };
 
+// Views into the GlyphOutlineArena the glyph was parsed into
 struct SimpleGlyphData {
-  std::vector<uint16_t> endPoints;
-  std::vector<int16_t> xCoords;
-  std::vector<int16_t> yCoords;
-  std::vector<bool> onCurve;
+  std::span<const uint16_t> endPoints;
+  std::span<const GlyphPoint> points;
+};
+
+// Backing storage for the outlines of many simple glyphs. Capacity is fixed
+// when the arena is created and never reallocated, so glyphs can hold spans
+// into it.
+class GlyphOutlineArena {
+ public:
+  GlyphOutlineArena() = default;
+  GlyphOutlineArena(size_t endPointCapacity, size_t pointCapacity);
+
+  [[nodiscard]] bool canFit(size_t endPointCount, size_t pointCount) const {
+    return endPoints_.size() + endPointCount <= endPoints_.capacity() &&
+        points_.size() + pointCount <= points_.capacity();
+  }
+
+  std::span<uint16_t> allocateEndPoints(size_t count);
+  std::span<GlyphPoint> allocatePoints(size_t count);
+
+ private:
+  std::vector<uint16_t> endPoints_;
+  std::vector<GlyphPoint> points_;
 };
 
 struct CompoundGlyphData {
@@ -93,31 +137,84 @@ struct GlyphData {
   GlyphVerticalMetrics verticalMetrics;
 };
 
+// Pairs are grouped by left glyph and sorted by right glyph within each group
 // NOLINTNEXTLINE(bugprone-exception-escape)
 class KerningTable {
  public:
   KerningTable() = default;
-  explicit KerningTable(std::unordered_map<uint32_t, FWord> data)
-      : data_(std::move(data)) {}
+  // Keys are the left glyph in the high 16 bits and the right glyph in the low
+  explicit KerningTable(const std::unordered_map<uint32_t, FWord>& data);
+
+  [[nodiscard]] FWord apply(uint16_t leftGlyph, uint16_t rightGlyph) const {
+    if (static_cast<size_t>(leftGlyph) + 1 >= rowStarts_.size()) {
+      return FWord{0};
+    }
+    const auto rowBegin = rightGlyphs_.begin() + rowStarts_[leftGlyph];
+    const auto rowEnd = rightGlyphs_.begin() + rowStarts_[leftGlyph + 1];
+    const auto it = std::lower_bound(rowBegin, rowEnd, rightGlyph);
+    if (it == rowEnd || *it != rightGlyph) {
+      return FWord{0};
+    }
+    return values_[it - rightGlyphs_.begin()];
+  }
+
+ private:
+  std::vector<uint32_t> rowStarts_;
+  std::vector<uint16_t> rightGlyphs_;
+  std::vector<FWord> values_;
+};
+
+enum class GlyphLoading : uint8_t { EAGER, LAZY };
 
-  [[nodiscard]] FWord apply(uint16_t leftGlyph, uint16_t rightGlyph) const;
+// Keeps the raw glyph table and parses outlines the first time they are asked
+// for, so fonts with many glyphs only pay for the ones that get drawn
+class LazyGlyphTable {
+ public:
+  LazyGlyphTable(
+      std::vector<std::byte> glyphTable, std::vector<uint32_t> offsets);
+  // Reads glyphs from glyphTable within the mapped font file
+  LazyGlyphTable(
+      util::MappedFile file,
+      std::span<const std::byte> glyphTable,
+      std::vector<uint32_t> offsets);
+
+  [[nodiscard]] const GlyphContourData& get(uint16_t glyphIndex) const;
 
  private:
-  std::unordered_map<uint32_t, FWord> data_;
+  // Only one of these is used, depending on where the table came from
+  std::vector<std::byte> ownedTable_;
+  std::optional<util::MappedFile> file_;
+  std::span<const std::byte> glyphTable_;
+  std::vector<uint32_t> offsets_;
+  mutable std::mutex mutex_;
+  // Node based, so references handed out stay valid as the cache grows
+  mutable std::unordered_map<uint16_t, GlyphContourData> cache_;
+  mutable std::vector<GlyphOutlineArena> arenas_;
 };
 
 // NOLINTNEXTLINE(bugprone-exception-escape)
 struct Font {
-  std::unique_ptr<CharToGlyphMap> charMap;
+  CharToGlyphMap charMap;
   std::vector<GlyphData> glyphs;
   uint16_t unitsPerEm;
   KerningTable kerning;
   FWord ascenderHeight;
   FWord descenderHeight;
   FWord lineGap;
+  // Holds the outlines of eagerly loaded simple glyphs
+  GlyphOutlineArena outlines;
+  std::unique_ptr<LazyGlyphTable> lazyGlyphs;
+
+  // Lazily loaded fonts only fill in the bounds of each glyph's contourData,
+  // the outline itself comes from here
+  [[nodiscard]] const GlyphContourData& getContours(uint16_t glyphIndex) const;
 };
 
-Font loadFont(const std::filesystem::path& path);
-Font loadFont(std::span<const std::byte> data);
+Font loadFont(
+    const std::filesystem::path& path,
+    GlyphLoading loading = GlyphLoading::EAGER);
+Font loadFont(
+    std::span<const std::byte> data,
+    GlyphLoading loading = GlyphLoading::EAGER);
 
 } // namespace blocks::loader
@@ -0,0 +1,269 @@
+#include "loader/font/GlyphRasterizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <variant>
+#include <vector>
+#include "loader/font/Font.hpp"
+
+namespace blocks::loader {
+
+namespace {
+
+constexpr int kCurveSubdivisions = 8;
+// Guards against malformed fonts with cyclic compound glyphs
+constexpr int kMaxCompoundDepth = 8;
+
+struct Point {
+  float x;
+  float y;
+};
+
+struct Segment {
+  Point a;
+  Point b;
+};
+
+struct Transform {
+  float a = 1.0f;
+  float b = 0.0f;
+  float c = 0.0f;
+  float d = 1.0f;
+  float e = 0.0f;
+  float f = 0.0f;
+
+  [[nodiscard]] Point apply(Point p) const {
+    return Point{(a * p.x) + (c * p.y) + e, (b * p.x) + (d * p.y) + f};
+  }
+
+  [[nodiscard]] Transform then(const Transform& outer) const {
+    return Transform{
+        .a = (outer.a * a) + (outer.c * b),
+        .b = (outer.b * a) + (outer.d * b),
+        .c = (outer.a * c) + (outer.c * d),
+        .d = (outer.b * c) + (outer.d * d),
+        .e = (outer.a * e) + (outer.c * f) + outer.e,
+        .f = (outer.b * e) + (outer.d * f) + outer.f};
+  }
+};
+
+Point midpoint(Point p, Point q) {
+  return Point{(p.x + q.x) / 2, (p.y + q.y) / 2};
+}
+
+void addQuadratic(
+    Point start, Point control, Point end, std::vector<Segment>& segments) {
+  Point previous = start;
+  for (int i = 1; i <= kCurveSubdivisions; i++) {
+    const float t = static_cast<float>(i) / kCurveSubdivisions;
+    const float s = 1.0f - t;
+    const Point current{
+        (s * s * start.x) + (2 * s * t * control.x) + (t * t * end.x),
+        (s * s * start.y) + (2 * s * t * control.y) + (t * t * end.y)};
+    segments.emplace_back(previous, current);
+    previous = current;
+  }
+}
+
+void flattenSimpleGlyph(
+    const SimpleGlyphData& glyph,
+    const Transform& transform,
+    std::vector<Segment>& segments) {
+  size_t contourStart = 0;
+  for (const uint16_t contourEnd : glyph.endPoints) {
+    if (contourEnd < contourStart || contourEnd >= glyph.points.size()) {
+      continue;
+    }
+    const size_t count = contourEnd + 1 - contourStart;
+
+    auto pointAt = [&](size_t i) {
+      const GlyphPoint& point = glyph.points[contourStart + (i % count)];
+      return transform.apply(
+          Point{static_cast<float>(point.x), static_cast<float>(point.y)});
+    };
+    auto onCurveAt = [&](size_t i) {
+      return glyph.points[contourStart + (i % count)].onCurve();
+    };
+
+    // Start from an on curve point, or the implied midpoint if there are none
+    size_t firstOnCurve = 0;
+    while (firstOnCurve < count && !onCurveAt(firstOnCurve)) {
+      firstOnCurve++;
+    }
+    const bool hasOnCurve = firstOnCurve < count;
+    const Point start = hasOnCurve ? pointAt(firstOnCurve)
+                                   : midpoint(pointAt(count - 1), pointAt(0));
+    const size_t begin = hasOnCurve ? firstOnCurve + 1 : 0;
+
+    Point current = start;
+    std::optional<Point> control;
+    for (size_t i = begin; i < begin + count; i++) {
+      const Point point = pointAt(i);
+      if (onCurveAt(i)) {
+        if (control.has_value()) {
+          addQuadratic(current, *control, point, segments);
+        } else {
+          segments.emplace_back(current, point);
+        }
+        current = point;
+        control.reset();
+      } else {
+        if (control.has_value()) {
+          const Point implied = midpoint(*control, point);
+          addQuadratic(current, *control, implied, segments);
+          current = implied;
+        }
+        control = point;
+      }
+    }
+    if (control.has_value()) {
+      addQuadratic(current, *control, start, segments);
+    }
+
+    contourStart = contourEnd + 1;
+  }
+}
+
+void flattenGlyph(
+    const Font& font,
+    uint16_t glyphIndex,
+    const Transform& transform,
+    int depth,
+    std::vector<Segment>& segments) {
+  if (glyphIndex >= font.glyphs.size() || depth > kMaxCompoundDepth) {
+    return;
+  }
+
+  const auto& contourData = font.getContours(glyphIndex).data;
+  if (std::holds_alternative<SimpleGlyphData>(contourData)) {
+    flattenSimpleGlyph(
+        std::get<SimpleGlyphData>(contourData), transform, segments);
+  } else if (std::holds_alternative<std::vector<CompoundGlyphData>>(
+                 contourData)) {
+    for (const auto& component :
+         std::get<std::vector<CompoundGlyphData>>(contourData)) {
+      const Transform componentTransform{
+          .a = component.a,
+          .b = component.b,
+          .c = component.c,
+          .d = component.d,
+          .e = static_cast<float>(component.e),
+          .f = static_cast<float>(component.f)};
+      flattenGlyph(
+          font,
+          component.glpyhIndex,
+          componentTransform.then(transform),
+          depth + 1,
+          segments);
+    }
+  }
+}
+
+float distanceSquared(Point p, const Segment& segment) {
+  const float dx = segment.b.x - segment.a.x;
+  const float dy = segment.b.y - segment.a.y;
+  const float lengthSquared = (dx * dx) + (dy * dy);
+  float t = 0.0f;
+  if (lengthSquared > 0.0f) {
+    t = std::clamp(
+        (((p.x - segment.a.x) * dx) + ((p.y - segment.a.y) * dy)) /
+            lengthSquared,
+        0.0f,
+        1.0f);
+  }
+  const float offsetX = segment.a.x + (t * dx) - p.x;
+  const float offsetY = segment.a.y + (t * dy) - p.y;
+  return (offsetX * offsetX) + (offsetY * offsetY);
+}
+
+// Casts a ray in the +x direction
+int windingContribution(Point p, const Segment& segment) {
+  const bool upwards = segment.a.y <= p.y && segment.b.y > p.y;
+  const bool downwards = segment.b.y <= p.y && segment.a.y > p.y;
+  if (!upwards && !downwards) {
+    return 0;
+  }
+
+  const float xIntercept = segment.a.x +
+      ((p.y - segment.a.y) * (segment.b.x - segment.a.x) /
+       (segment.b.y - segment.a.y));
+  if (xIntercept <= p.x) {
+    return 0;
+  }
+  return upwards ? 1 : -1;
+}
+
+} // namespace
+
+GlyphBitmap renderGlyphSDF(
+    const Font& font,
+    uint16_t glyphIndex,
+    float pixelsPerUnit,
+    uint32_t spread) {
+  std::vector<Segment> segments;
+  flattenGlyph(font, glyphIndex, Transform{}, 0, segments);
+  if (segments.empty()) {
+    return GlyphBitmap{};
+  }
+
+  Point minPoint = segments[0].a;
+  Point maxPoint = segments[0].a;
+  for (const Segment& segment : segments) {
+    for (const Point& point : {segment.a, segment.b}) {
+      minPoint.x = std::min(minPoint.x, point.x);
+      minPoint.y = std::min(minPoint.y, point.y);
+      maxPoint.x = std::max(maxPoint.x, point.x);
+      maxPoint.y = std::max(maxPoint.y, point.y);
+    }
+  }
+
+  const float padding = static_cast<float>(spread) / pixelsPerUnit;
+  GlyphBitmap result{
+      .width = static_cast<uint32_t>(
+                   std::ceil((maxPoint.x - minPoint.x) * pixelsPerUnit)) +
+          (2 * spread),
+      .height = static_cast<uint32_t>(
+                    std::ceil((maxPoint.y - minPoint.y) * pixelsPerUnit)) +
+          (2 * spread),
+      .left = minPoint.x - padding,
+      .bottom = minPoint.y - padding,
+      .pixels = {}};
+  result.pixels.resize(static_cast<size_t>(result.width) * result.height);
+
+  const float valuePerPixel = 127.0f / static_cast<float>(std::max(spread, 1u));
+  for (uint32_t row = 0; row < result.height; row++) {
+    const float y = result.bottom +
+        ((static_cast<float>(result.height - row) - 0.5f) / pixelsPerUnit);
+    for (uint32_t col = 0; col < result.width; col++) {
+      const Point p{
+          result.left + ((static_cast<float>(col) + 0.5f) / pixelsPerUnit), y};
+
+      float minDistanceSquared = std::numeric_limits<float>::max();
+      int winding = 0;
+      for (const Segment& segment : segments) {
+        minDistanceSquared =
+            std::min(minDistanceSquared, distanceSquared(p, segment));
+        winding += windingContribution(p, segment);
+      }
+
+      float distance = std::sqrt(minDistanceSquared) * pixelsPerUnit;
+      if (winding == 0) {
+        distance = -distance;
+      }
+      result.pixels[(static_cast<size_t>(row) * result.width) + col] =
+          static_cast<uint8_t>(
+              std::clamp(
+                  std::round(128.0f + (distance * valuePerPixel)),
+                  0.0f,
+                  255.0f));
+    }
+  }
+
+  return result;
+}
+
+} // namespace blocks::loader
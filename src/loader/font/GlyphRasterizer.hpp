@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "loader/font/Font.hpp"
+
+namespace blocks::loader {
+
+struct GlyphBitmap {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  // Position of the bitmap's bottom left corner, in font units
+  float left = 0.0f;
+  float bottom = 0.0f;
+  // Row major with the top row first
+  std::vector<uint8_t> pixels;
+};
+
+// Renders a signed distance field of the glyph outline, 128 on the outline and
+// increasing inwards, saturating spread pixels either side of it. The bitmap is
+// padded by spread pixels so the field falls off fully before the border.
+GlyphBitmap renderGlyphSDF(
+    const Font& font,
+    uint16_t glyphIndex,
+    float pixelsPerUnit,
+    uint32_t spread);
+
+} // namespace blocks::loader
@@ -1,7 +1,64 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <unordered_map>
 #include "loader/font/Font.hpp"
 
 TEST(FontTest, LoadFont) {
   blocks::loader::loadFont(RESOURCE_DIR "/times.ttf");
 }
+
+TEST(FontTest, LoadFontLazy) {
+  const auto eager = blocks::loader::loadFont(RESOURCE_DIR "/times.ttf");
+  const auto lazy = blocks::loader::loadFont(
+      RESOURCE_DIR "/times.ttf", blocks::loader::GlyphLoading::LAZY);
+
+  ASSERT_EQ(eager.glyphs.size(), lazy.glyphs.size());
+  for (uint16_t i = 0; i < eager.glyphs.size(); i++) {
+    const auto& eagerContours = eager.getContours(i);
+    const auto& lazyContours = lazy.getContours(i);
+    EXPECT_EQ(eagerContours.xMin.rawValue, lazyContours.xMin.rawValue);
+    EXPECT_EQ(eagerContours.yMax.rawValue, lazyContours.yMax.rawValue);
+    EXPECT_EQ(eagerContours.data.index(), lazyContours.data.index());
+    EXPECT_EQ(
+        eager.glyphs[i].contourData.yMin.rawValue,
+        lazy.glyphs[i].contourData.yMin.rawValue);
+  }
+  EXPECT_EQ(&lazy.getContours(1), &lazy.getContours(1));
+}
+
+TEST(FontTest, CharToGlyphMap) {
+  blocks::loader::CharToGlyphMap map;
+  map.set(0x41, 36);
+  map.set(0x42, 37);
+  map.set(0x3B1, 500);
+  map.set(0xFFFF, 0);
+
+  EXPECT_EQ(36, map.mapChar(0x41));
+  EXPECT_EQ(37, map.mapChar(0x42));
+  EXPECT_EQ(0, map.mapChar(0x43));
+  EXPECT_EQ(500, map.mapChar(0x3B1));
+  EXPECT_EQ(0, map.mapChar(0x3B2));
+  EXPECT_EQ(0, map.mapChar(0x4E00));
+  EXPECT_EQ(0, map.mapChar(0xFFFF));
+  EXPECT_EQ(0, map.mapChar(0x1F600));
+}
+
+TEST(FontTest, KerningTable) {
+  auto key = [](uint32_t left, uint32_t right) { return (left << 16) + right; };
+  const blocks::loader::KerningTable kerning{
+      std::unordered_map<uint32_t, blocks::loader::FWord>{
+          {key(3, 7), {-20}},
+          {key(3, 2), {15}},
+          {key(9, 3), {-5}},
+          {key(0xFFFF, 0xFFFF), {1}}}};
+
+  EXPECT_EQ(-20, kerning.apply(3, 7).rawValue);
+  EXPECT_EQ(15, kerning.apply(3, 2).rawValue);
+  EXPECT_EQ(-5, kerning.apply(9, 3).rawValue);
+  EXPECT_EQ(1, kerning.apply(0xFFFF, 0xFFFF).rawValue);
+  EXPECT_EQ(0, kerning.apply(3, 3).rawValue);
+  EXPECT_EQ(0, kerning.apply(7, 3).rawValue);
+  EXPECT_EQ(0, kerning.apply(0, 0).rawValue);
+  EXPECT_EQ(0, blocks::loader::KerningTable{}.apply(3, 7).rawValue);
+}
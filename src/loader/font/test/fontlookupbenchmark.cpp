@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "loader/font/Font.hpp"
+#include "util/unicode.hpp"
+
+namespace {
+
+constexpr size_t kCorpusBytes = 16 * 1024 * 1024;
+
+constexpr std::string_view kSamples[] = {
+    "The quick brown fox jumps over the lazy dog. AVA To We Yo LT. ",
+    "Falsches \xC3\x9C"
+    "ben von Xylophonmusik qu\xC3\xA4lt jeden gr\xC3\xB6\xC3\x9F"
+    "eren Zwerg. ",
+    "\xCE\x93\xCE\xB1\xCE\xB6\xCE\xAD\xCE\xB5\xCF\x82 "
+    "\xCE\xBA\xCE\xB1\xCE\xAF "
+    "\xCE\xBC\xCF\x85\xCF\x81\xCF\x84\xCE\xB9\xCE\xAD\xCF\x82. ",
+    "\xD0\xA1\xD1\x8A\xD0\xB5\xD1\x88\xD1\x8C \xD0\xB6\xD0\xB5 \xD0\xB5\xD1\x89"
+    "\xD1\x91. ",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E"
+    "\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0. ",
+    "\xF0\x9F\x98\x80 \xE2\x82\xAC\xE2\x80\x94\xE2\x80\x9C\xE2\x80\x9D ",
+};
+
+std::string makeCorpus() {
+  std::string corpus;
+  corpus.reserve(kCorpusBytes + 256);
+  for (size_t i = 0; corpus.size() < kCorpusBytes; i++) {
+    // Mostly Latin text, like the strings the game draws
+    corpus += kSamples[i % 4 == 3 ? 1 + ((i / 4) % 5) : 0];
+  }
+  return corpus;
+}
+
+template <typename TFunc>
+double nanosecondsPer(size_t count, TFunc func) {
+  const auto start = std::chrono::steady_clock::now();
+  func();
+  const auto end = std::chrono::steady_clock::now();
+  return static_cast<double>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                 .count()) /
+      static_cast<double>(count);
+}
+
+} // namespace
+
+TEST(FontLookupBenchmark, Utf8Corpus) {
+  const auto font = blocks::loader::loadFont(RESOURCE_DIR "/times.ttf");
+  const std::string corpus = makeCorpus();
+
+  std::vector<uint32_t> chars;
+  const double decodeNs = nanosecondsPer(corpus.size(), [&]() {
+    for (const uint32_t c : util::unicodeDecode(corpus)) {
+      chars.emplace_back(c);
+    }
+  });
+
+  std::vector<uint16_t> glyphs(chars.size());
+  const double cmapNs = nanosecondsPer(chars.size(), [&]() {
+    for (size_t i = 0; i < chars.size(); i++) {
+      glyphs[i] = font.charMap.mapChar(chars[i]);
+    }
+  });
+
+  int64_t totalKerning = 0;
+  const double kerningNs = nanosecondsPer(glyphs.size(), [&]() {
+    for (size_t i = 1; i < glyphs.size(); i++) {
+      totalKerning += font.kerning.apply(glyphs[i - 1], glyphs[i]).rawValue;
+    }
+  });
+
+  int64_t totalAdvance = 0;
+  const double layoutNs = nanosecondsPer(chars.size(), [&]() {
+    std::optional<uint16_t> previousGlyph;
+    for (const uint32_t c : util::unicodeDecode(corpus)) {
+      const uint16_t glyphIndex = font.charMap.mapChar(c);
+      if (previousGlyph.has_value()) {
+        totalAdvance += font.kerning.apply(*previousGlyph, glyphIndex).rawValue;
+      }
+      totalAdvance +=
+          font.glyphs[glyphIndex].horizontalMetrics.advanceWidth.rawValue;
+      previousGlyph = glyphIndex;
+    }
+  });
+
+  EXPECT_NE(0, totalAdvance);
+
+  std::cout << "chars: " << chars.size() << "\n"
+            << "decode: " << decodeNs << " ns/byte\n"
+            << "cmap: " << cmapNs << " ns/char\n"
+            << "kerning: " << kerningNs << " ns/pair (total " << totalKerning
+            << ")\n"
+            << "decode + cmap + kerning + advance: " << layoutNs
+            << " ns/char\n";
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "loader/font/Font.hpp"
+#include "loader/font/GlyphRasterizer.hpp"
+
+namespace {
+
+constexpr std::array<uint16_t, 1> kSquareEndPoints{3};
+constexpr std::array<blocks::loader::GlyphPoint, 4> kSquarePoints{{
+    {.x = 0, .y = 0, .flags = 1},
+    {.x = 0, .y = 100, .flags = 1},
+    {.x = 100, .y = 100, .flags = 1},
+    {.x = 100, .y = 0, .flags = 1},
+}};
+
+blocks::loader::Font makeSquareFont() {
+  blocks::loader::Font font{};
+  font.unitsPerEm = 100;
+
+  blocks::loader::GlyphData square{};
+  square.contourData.data = blocks::loader::SimpleGlyphData{
+      .endPoints = kSquareEndPoints, .points = kSquarePoints};
+  font.glyphs.emplace_back(std::move(square));
+
+  blocks::loader::GlyphData shifted{};
+  shifted.contourData.data = std::vector<blocks::loader::CompoundGlyphData>{
+      {.glpyhIndex = 0, .a = 1.0f, .d = 1.0f, .e = 50, .f = 0}};
+  font.glyphs.emplace_back(std::move(shifted));
+
+  font.glyphs.emplace_back();
+  return font;
+}
+
+uint8_t pixelAt(const blocks::loader::GlyphBitmap& bitmap, float x, float y) {
+  const auto col = static_cast<uint32_t>(x - bitmap.left);
+  const auto row = bitmap.height - 1 - static_cast<uint32_t>(y - bitmap.bottom);
+  return bitmap.pixels[(row * bitmap.width) + col];
+}
+
+} // namespace
+
+TEST(GlyphRasterizerTest, SimpleGlyph) {
+  const auto font = makeSquareFont();
+  const auto bitmap = blocks::loader::renderGlyphSDF(font, 0, 1.0f, 4);
+
+  EXPECT_EQ(108, bitmap.width);
+  EXPECT_EQ(108, bitmap.height);
+  EXPECT_FLOAT_EQ(-4.0f, bitmap.left);
+  EXPECT_FLOAT_EQ(-4.0f, bitmap.bottom);
+
+  EXPECT_EQ(255, pixelAt(bitmap, 50.0f, 50.0f));
+  EXPECT_NEAR(128 - 112, pixelAt(bitmap, -4.0f, 50.0f), 1);
+  EXPECT_NEAR(128 + 16, pixelAt(bitmap, 0.0f, 50.0f), 1);
+  EXPECT_NEAR(128 - 16, pixelAt(bitmap, -1.0f, 50.0f), 1);
+  EXPECT_NEAR(128 + 16, pixelAt(bitmap, 50.0f, 99.0f), 1);
+}
+
+TEST(GlyphRasterizerTest, CompoundGlyph) {
+  const auto font = makeSquareFont();
+  const auto bitmap = blocks::loader::renderGlyphSDF(font, 1, 1.0f, 4);
+
+  EXPECT_EQ(108, bitmap.width);
+  EXPECT_FLOAT_EQ(46.0f, bitmap.left);
+  EXPECT_EQ(255, pixelAt(bitmap, 100.0f, 50.0f));
+}
+
+TEST(GlyphRasterizerTest, EmptyGlyph) {
+  const auto font = makeSquareFont();
+  const auto bitmap = blocks::loader::renderGlyphSDF(font, 2, 1.0f, 4);
+
+  EXPECT_EQ(0, bitmap.width);
+  EXPECT_EQ(0, bitmap.height);
+  EXPECT_TRUE(bitmap.pixels.empty());
+}
@@ -1,12 +1,15 @@
 #include "loader/image/Bitmap.hpp"
 
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
-#include <limits>
+#include <immintrin.h>
+#include <span>
 #include <stdexcept>
-#include <utility>
 #include <vector>
 #include "loader/Image.hpp"
 #include "util/file.hpp"
@@ -32,11 +35,17 @@ static_assert(sizeof(BitmapHeader) == 14);
 #pragma pack(push, 1)
 struct BitmapInfoHeader {
   // NOLINTNEXTLINE(performance-enum-size)
-  enum CompressionInfo : uint32_t { RGB = 0, RLE8 = 1, RLE4 = 2 };
+  enum CompressionInfo : uint32_t {
+    RGB = 0,
+    RLE8 = 1,
+    RLE4 = 2,
+    BITFIELDS = 3
+  };
 
   uint32_t headerSize;
   uint32_t imageWidth;
-  uint32_t imageHeight;
+  // Negative for rows stored top to bottom
+  int32_t imageHeight;
   uint16_t colorPlanes;
   uint16_t bitsPerPixel;
   CompressionInfo compressionInfo;
@@ -49,13 +58,52 @@ struct BitmapInfoHeader {
 #pragma pack(pop)
 static_assert(sizeof(BitmapInfoHeader) == 40);
 
-} // namespace
+// BGRA colours, indexed by palette index
+using Palette = std::array<uint32_t, 256>;
 
-Image loadBitmap(const std::filesystem::path& path) {
-  return loadBitmap(util::readFileBytes(path));
+constexpr uint32_t kOpaque = 0xff000000;
+
+// The later header versions only add fields after the ones above
+constexpr std::array<uint32_t, 5> kInfoHeaderSizes{40, 52, 56, 108, 124};
+
+struct BitmapLayout {
+  size_t width;
+  size_t height;
+  bool isTopDown;
+  uint16_t bitsPerPixel;
+  BitmapInfoHeader::CompressionInfo compression;
+  bool hasAlpha;
+  Palette palette;
+  std::span<const std::byte> pixels;
+};
+
+uint32_t readLittleEndian(std::span<const std::byte> data, size_t offset) {
+  if (offset + 4 > data.size()) {
+    throw std::runtime_error{"Corrupt bitmap"};
+  }
+  uint32_t value = 0;
+  std::memcpy(&value, &data[offset], 4);
+  return value;
 }
 
-Image loadBitmap(const std::vector<std::byte>& data) {
+// Only BGRX and BGRA masks are supported, returns whether there is an alpha
+bool readChannelMasks(
+    std::span<const std::byte> data, uint32_t infoHeaderSize) {
+  constexpr size_t kMaskOffset = sizeof(BitmapHeader) + 40;
+  const uint32_t red = readLittleEndian(data, kMaskOffset);
+  const uint32_t green = readLittleEndian(data, kMaskOffset + 4);
+  const uint32_t blue = readLittleEndian(data, kMaskOffset + 8);
+  const uint32_t alpha =
+      infoHeaderSize >= 56 ? readLittleEndian(data, kMaskOffset + 12) : 0;
+
+  if (red != 0x00ff0000 || green != 0x0000ff00 || blue != 0x000000ff ||
+      (alpha != 0 && alpha != kOpaque)) {
+    throw std::runtime_error{"Unsupported bitmap format"};
+  }
+  return alpha != 0;
+}
+
+BitmapLayout readBitmapLayout(std::span<const std::byte> data) {
   if (data.size() < sizeof(BitmapHeader)) {
     throw std::runtime_error{"Corrupt bitmap"};
   }
@@ -75,81 +123,324 @@ Image loadBitmap(const std::vector<std::byte>& data) {
   }
 
   const uint32_t infoHeaderSize =
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      *reinterpret_cast<const uint32_t*>(data.data() + sizeof(BitmapHeader));
-  if (infoHeaderSize != 40) {
+      readLittleEndian(data, sizeof(BitmapHeader));
+  if (std::find(
+          kInfoHeaderSizes.begin(), kInfoHeaderSizes.end(), infoHeaderSize) ==
+      kInfoHeaderSizes.end()) {
     throw std::runtime_error{"Unsupported bitmap format"};
   }
+  if (data.size() - sizeof(BitmapHeader) < infoHeaderSize) {
+    throw std::runtime_error{"Corrupt bitmap"};
+  }
 
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
   const auto* infoHeader = reinterpret_cast<const BitmapInfoHeader*>(
       // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
       data.data() + sizeof(BitmapHeader));
 
-  const uint32_t imageWidth = infoHeader->imageWidth;
-  const uint32_t imageHeight = infoHeader->imageHeight;
+  BitmapLayout layout{
+      .width = infoHeader->imageWidth,
+      .height = infoHeader->imageHeight < 0
+          ? static_cast<size_t>(-int64_t{infoHeader->imageHeight})
+          : static_cast<size_t>(infoHeader->imageHeight),
+      .isTopDown = infoHeader->imageHeight < 0,
+      .bitsPerPixel = infoHeader->bitsPerPixel,
+      .compression = infoHeader->compressionInfo,
+      .hasAlpha = false,
+      .palette = {},
+      .pixels = {}};
 
-  if (infoHeader->colorPlanes != 1 || infoHeader->bitsPerPixel != 24 ||
-      infoHeader->compressionInfo != BitmapInfoHeader::CompressionInfo::RGB ||
-      infoHeader->paletteSize != 0 || infoHeader->importantColors != 0) {
+  using enum BitmapInfoHeader::CompressionInfo;
+  const uint32_t compression = layout.compression;
+  const bool isSupported = (compression == RGB &&
+                            (layout.bitsPerPixel == 8 ||
+                             layout.bitsPerPixel == 24 ||
+                             layout.bitsPerPixel == 32)) ||
+      (compression == RLE8 && layout.bitsPerPixel == 8) ||
+      (compression == RLE4 && layout.bitsPerPixel == 4) ||
+      (compression == BITFIELDS && layout.bitsPerPixel == 32);
+  if (infoHeader->colorPlanes != 1 || !isSupported ||
+      (layout.isTopDown && (compression == RLE8 || compression == RLE4))) {
     throw std::runtime_error{"Unsupported bitmap format"};
   }
 
-  const uint32_t rowSize = ((imageWidth * 3 + 3) / 4) * 4;
-  const uint32_t bitmapSize = rowSize * imageHeight;
+  size_t tableOffset = sizeof(BitmapHeader) + infoHeaderSize;
+  if (compression == BITFIELDS) {
+    layout.hasAlpha = readChannelMasks(data, infoHeaderSize);
+    // The masks follow the header if it is too old to hold them
+    if (infoHeaderSize == 40) {
+      tableOffset += 12;
+    }
+  }
+
+  if (layout.bitsPerPixel <= 8) {
+    const size_t maxColors = size_t{1} << layout.bitsPerPixel;
+    const size_t paletteSize =
+        infoHeader->paletteSize == 0 ? maxColors : infoHeader->paletteSize;
+    if (paletteSize > maxColors ||
+        tableOffset + (paletteSize * 4) > header->pixelArrayOffset) {
+      throw std::runtime_error{"Corrupt bitmap"};
+    }
+    // Entries are BGRX, and anything past the end stays transparent black
+    for (size_t i = 0; i < paletteSize; i++) {
+      layout.palette[i] =
+          readLittleEndian(data, tableOffset + (i * 4)) | kOpaque;
+    }
+    tableOffset += paletteSize * 4;
+  }
+
+  if (header->pixelArrayOffset < tableOffset ||
+      header->pixelArrayOffset > data.size()) {
+    throw std::runtime_error{"Corrupt bitmap"};
+  }
+  const std::span<const std::byte> pixels =
+      data.subspan(header->pixelArrayOffset);
 
+  if (compression == RLE8 || compression == RLE4) {
+    if (infoHeader->rawBitmapSize > pixels.size()) {
+      throw std::runtime_error{"Corrupt bitmap"};
+    }
+    layout.pixels = infoHeader->rawBitmapSize == 0
+        ? pixels
+        : pixels.subspan(0, infoHeader->rawBitmapSize);
+    return layout;
+  }
+
+  const size_t rowSize = ((layout.width * layout.bitsPerPixel + 31) / 32) * 4;
+  const size_t bitmapSize = rowSize * layout.height;
   if (infoHeader->rawBitmapSize != 0 &&
       infoHeader->rawBitmapSize != bitmapSize) {
     throw std::runtime_error{"Corrupt bitmap"};
   }
-  if (data.size() - sizeof(BitmapHeader) - sizeof(BitmapInfoHeader) <
-      bitmapSize) {
+  if (pixels.size() < bitmapSize) {
     throw std::runtime_error{"Corrupt bitmap"};
   }
+  layout.pixels = pixels.subspan(0, bitmapSize);
+  return layout;
+}
 
-  if (header->pixelArrayOffset !=
-      sizeof(BitmapHeader) + sizeof(BitmapInfoHeader)) {
-    throw std::runtime_error{"Corrupt bitmap"};
+__m128i load16(const void* src) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+void store16(std::byte* dst, __m128i value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+void store32(std::byte* dst, __m256i value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+}
+
+// Rows come out mirrored, so a group of four pixels is reversed by the same
+// pshufb that expands it to BGRA
+template <size_t pixelSize, bool hasAlpha>
+void shuffleRow(std::span<const std::byte> row, std::span<std::byte> out) {
+  constexpr auto kShuffle = []() {
+    std::array<int8_t, 16> shuffle{};
+    shuffle.fill(-1);
+    for (size_t i = 0; i < 4; i++) {
+      const size_t source = (3 - i) * pixelSize;
+      for (size_t c = 0; c < (hasAlpha ? 4 : 3); c++) {
+        shuffle[(i * 4) + c] = static_cast<int8_t>(source + c);
+      }
+    }
+    return shuffle;
+  }();
+
+  const size_t width = out.size() / 4;
+  const __m128i shuffle = load16(kShuffle.data());
+  const __m128i alpha =
+      _mm_set1_epi32(hasAlpha ? 0 : static_cast<int>(kOpaque));
+  size_t x = 0;
+  // Always reads 16 bytes, so stop short of the end of the row
+  for (; x + 4 <= width && (x * pixelSize) + 16 <= row.size(); x += 4) {
+    store16(
+        &out[(width - 4 - x) * 4],
+        _mm_or_si128(
+            _mm_shuffle_epi8(load16(&row[x * pixelSize]), shuffle), alpha));
   }
-  const std::byte* bitmapData =
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      data.data() + sizeof(BitmapHeader) + sizeof(BitmapInfoHeader);
 
-  std::vector<std::byte> outData;
-  outData.resize(static_cast<size_t>(imageWidth) * imageHeight * 4);
+  for (; x < width; x++) {
+    const size_t outX = (width - 1 - x) * 4;
+    std::memcpy(&out[outX], &row[x * pixelSize], hasAlpha ? 4 : 3);
+    if constexpr (!hasAlpha) {
+      out[outX + 3] = std::byte{0xff};
+    }
+  }
+}
 
-  for (uint32_t y = 0; y < imageHeight; y++) {
-    for (uint32_t x = 0; x < imageWidth; x++) {
-      const std::byte* pixel =
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-          bitmapData +
-          ((static_cast<size_t>(y) * rowSize) + (static_cast<size_t>(x) * 3));
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      const std::byte r = pixel[0];
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      const std::byte g = pixel[1];
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      const std::byte b = pixel[2];
+void paletteRow(
+    std::span<const std::byte> indices,
+    const Palette& palette,
+    std::span<std::byte> out) {
+  const size_t width = out.size() / 4;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto* table = reinterpret_cast<const int*>(palette.data());
+  const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const __m256i index =
+        _mm256_cvtepu8_epi32(_mm_loadl_epi64(static_cast<const __m128i*>(
+            static_cast<const void*>(&indices[x]))));
+    store32(
+        &out[(width - 8 - x) * 4],
+        _mm256_permutevar8x32_epi32(
+            _mm256_i32gather_epi32(table, index, 4), reverse));
+  }
+  for (; x < width; x++) {
+    std::memcpy(
+        &out[(width - 1 - x) * 4],
+        &palette[static_cast<uint8_t>(indices[x])],
+        4);
+  }
+}
 
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      std::byte* outPixel = &outData[0] +
-          (4ull * ((imageHeight - 1 - y) * imageWidth + (imageWidth - 1 - x)));
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      outPixel[0] = r;
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      outPixel[1] = g;
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      outPixel[2] = b;
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      outPixel[3] =
-          static_cast<std::byte>(std::numeric_limits<unsigned char>::max());
+// Runs may skip pixels, which are left transparent. Compressed bitmaps are
+// always bottom up, so with the mirroring the output is simply reversed.
+template <size_t bitsPerPixel>
+void decodeRle(
+    std::span<const std::byte> data,
+    const Palette& palette,
+    size_t width,
+    size_t height,
+    std::span<std::byte> out) {
+  std::memset(out.data(), 0, out.size());
+
+  size_t x = 0;
+  size_t y = 0;
+  const auto writePixel = [&](uint8_t index) {
+    if (x >= width || y >= height) {
+      throw std::runtime_error{"Corrupt bitmap"};
+    }
+    std::memcpy(
+        &out[(out.size() / 4 - 1 - ((y * width) + x)) * 4],
+        &palette[index],
+        4);
+    x++;
+  };
+  const auto getIndex = [](uint8_t value, size_t i) -> uint8_t {
+    if constexpr (bitsPerPixel == 4) {
+      return i % 2 == 0 ? value >> 4 : value & 0x0f;
+    } else {
+      return value;
+    }
+  };
+  const auto readByte = [&](size_t offset) {
+    if (offset >= data.size()) {
+      throw std::runtime_error{"Corrupt bitmap"};
+    }
+    return static_cast<uint8_t>(data[offset]);
+  };
+
+  size_t offset = 0;
+  while (true) {
+    const uint8_t count = readByte(offset);
+    const uint8_t value = readByte(offset + 1);
+    offset += 2;
+
+    if (count > 0) {
+      for (size_t i = 0; i < count; i++) {
+        writePixel(getIndex(value, i));
+      }
+      continue;
+    }
+
+    switch (value) {
+      case 0:
+        x = 0;
+        y++;
+        break;
+      case 1:
+        return;
+      case 2:
+        x += readByte(offset);
+        y += readByte(offset + 1);
+        offset += 2;
+        break;
+      default: {
+        // Absolute runs are padded to a whole number of 16 bit words
+        const size_t byteCount = (value * bitsPerPixel + 7) / 8;
+        for (size_t i = 0; i < value; i++) {
+          writePixel(getIndex(readByte(offset + (i * bitsPerPixel / 8)), i));
+        }
+        offset += (byteCount + 1) & ~size_t{1};
+        break;
+      }
     }
   }
+}
 
-  return Image{
-      .width = imageWidth,
-      .height = imageHeight,
-      .pixelData = std::move(outData)};
+} // namespace
+
+Image loadBitmap(const std::filesystem::path& path) {
+  return loadBitmap(util::MappedFile{path}.bytes());
+}
+
+Image loadBitmap(std::span<const std::byte> data) {
+  const BitmapInfo info = readBitmapInfo(data);
+  Image result{
+      .width = info.width,
+      .height = info.height,
+      .pixelData = std::vector<std::byte>(info.width * info.height * 4)};
+  loadBitmap(data, result.pixelData);
+  return result;
+}
+
+BitmapInfo readBitmapInfo(std::span<const std::byte> data) {
+  const BitmapLayout layout = readBitmapLayout(data);
+  return BitmapInfo{.width = layout.width, .height = layout.height};
+}
+
+void loadBitmap(std::span<const std::byte> data, std::span<std::byte> out) {
+  const BitmapLayout layout = readBitmapLayout(data);
+  const size_t width = layout.width;
+  const size_t height = layout.height;
+  if (out.size() != 4ull * width * height) {
+    throw std::runtime_error{"Bitmap output buffer has the wrong size"};
+  }
+
+  using enum BitmapInfoHeader::CompressionInfo;
+  if (layout.compression == RLE8) {
+    decodeRle<8>(layout.pixels, layout.palette, width, height, out);
+    return;
+  }
+  if (layout.compression == RLE4) {
+    decodeRle<4>(layout.pixels, layout.palette, width, height, out);
+    return;
+  }
+
+  if (height == 0) {
+    return;
+  }
+  const size_t rowSize = layout.pixels.size() / height;
+  for (size_t y = 0; y < height; y++) {
+    const std::span<const std::byte> row =
+        layout.pixels.subspan(y * rowSize, rowSize);
+    const size_t outY = layout.isTopDown ? y : height - 1 - y;
+    const std::span<std::byte> outRow =
+        out.subspan(outY * width * 4, width * 4);
+
+    switch (layout.bitsPerPixel) {
+      case 8:
+        paletteRow(row, layout.palette, outRow);
+        break;
+      case 24:
+        shuffleRow<3, false>(row, outRow);
+        break;
+      case 32:
+        if (layout.hasAlpha) {
+          shuffleRow<4, true>(row, outRow);
+        } else {
+          shuffleRow<4, false>(row, outRow);
+        }
+        break;
+      default:
+        throw std::runtime_error{"Unsupported bitmap format"};
+    }
+  }
 }
 
 } // namespace blocks::loader
@@ -2,12 +2,22 @@
 
 #include <cstddef>
 #include <filesystem>
-#include <vector>
+#include <span>
 #include "loader/Image.hpp"
 
 namespace blocks::loader {
 
 Image loadBitmap(const std::filesystem::path& path);
-Image loadBitmap(const std::vector<std::byte>& data);
+Image loadBitmap(std::span<const std::byte> data);
+
+struct BitmapInfo {
+  size_t width;
+  size_t height;
+};
+
+BitmapInfo readBitmapInfo(std::span<const std::byte> data);
+// Decodes into out as BGRA, which must be exactly width * height * 4 bytes.
+// Like loadBitmap, the rows come out top first and each row is mirrored.
+void loadBitmap(std::span<const std::byte> data, std::span<std::byte> out);
 
 } // namespace blocks::loader
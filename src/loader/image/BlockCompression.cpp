@@ -0,0 +1,298 @@
+#include "loader/image/BlockCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+
+static_assert(std::endian::native == std::endian::little);
+
+namespace blocks::loader {
+
+namespace {
+
+using Pixel = std::array<uint8_t, 4>;
+using Block = std::array<Pixel, 16>;
+
+const std::array<float, 256> kSrgbToLinear = []() {
+  std::array<float, 256> result{};
+  for (size_t i = 0; i < result.size(); i++) {
+    const float value = static_cast<float>(i) / 255.0f;
+    result[i] = value <= 0.04045f
+        ? value / 12.92f
+        : std::pow((value + 0.055f) / 1.055f, 2.4f);
+  }
+  return result;
+}();
+
+uint8_t linearToSrgb(float value) {
+  const float srgb = value <= 0.0031308f
+      ? value * 12.92f
+      : (1.055f * std::pow(value, 1.0f / 2.4f)) - 0.055f;
+  return static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+// Box filters in linear space, matching a blit between sRGB images
+Image downsample(const Image& image) {
+  Image result{
+      .width = std::max<size_t>(image.width / 2, 1),
+      .height = std::max<size_t>(image.height / 2, 1),
+      .pixelData = {}};
+  result.pixelData.resize(result.width * result.height * 4);
+
+  for (size_t y = 0; y < result.height; y++) {
+    for (size_t x = 0; x < result.width; x++) {
+      std::array<float, 4> sum{};
+      for (size_t dy = 0; dy < 2; dy++) {
+        for (size_t dx = 0; dx < 2; dx++) {
+          const size_t srcX = std::min((x * 2) + dx, image.width - 1);
+          const size_t srcY = std::min((y * 2) + dy, image.height - 1);
+          const size_t src = ((srcY * image.width) + srcX) * 4;
+          for (size_t c = 0; c < 3; c++) {
+            sum[c] += kSrgbToLinear[static_cast<uint8_t>(
+                image.pixelData[src + c])];
+          }
+          sum[3] += static_cast<float>(image.pixelData[src + 3]);
+        }
+      }
+
+      const size_t dst = ((y * result.width) + x) * 4;
+      for (size_t c = 0; c < 3; c++) {
+        result.pixelData[dst + c] = std::byte{linearToSrgb(sum[c] / 4)};
+      }
+      result.pixelData[dst + 3] =
+          static_cast<std::byte>(std::lround(sum[3] / 4));
+    }
+  }
+  return result;
+}
+
+// Edge blocks repeat the last row and column
+Block readBlock(const Image& image, size_t blockX, size_t blockY) {
+  Block block{};
+  for (size_t y = 0; y < 4; y++) {
+    for (size_t x = 0; x < 4; x++) {
+      const size_t srcX = std::min((blockX * 4) + x, image.width - 1);
+      const size_t srcY = std::min((blockY * 4) + y, image.height - 1);
+      std::memcpy(
+          block[(y * 4) + x].data(),
+          &image.pixelData[((srcY * image.width) + srcX) * 4],
+          4);
+    }
+  }
+  return block;
+}
+
+uint16_t toRgb565(const Pixel& pixel) {
+  const auto quantize = [](uint8_t value, uint32_t maxValue) {
+    return ((value * maxValue) + 127) / 255;
+  };
+  return static_cast<uint16_t>(
+      (quantize(pixel[2], 31) << 11) | (quantize(pixel[1], 63) << 5) |
+      quantize(pixel[0], 31));
+}
+
+std::array<float, 3> fromRgb565(uint16_t color) {
+  const uint32_t r = (color >> 11) & 31;
+  const uint32_t g = (color >> 5) & 63;
+  const uint32_t b = color & 31;
+  return {
+      static_cast<float>((b << 3) | (b >> 2)),
+      static_cast<float>((g << 2) | (g >> 4)),
+      static_cast<float>((r << 3) | (r >> 2))};
+}
+
+float distanceSquared(const Pixel& pixel, const std::array<float, 3>& color) {
+  float result = 0.0f;
+  for (size_t c = 0; c < 3; c++) {
+    const float delta = static_cast<float>(pixel[c]) - color[c];
+    result += delta * delta;
+  }
+  return result;
+}
+
+// Endpoints are the extreme pixels along the principal axis of the block's
+// colours, always in four colour mode
+uint64_t encodeColorBlock(const Block& block) {
+  std::array<float, 3> mean{};
+  for (const Pixel& pixel : block) {
+    for (size_t c = 0; c < 3; c++) {
+      mean[c] += static_cast<float>(pixel[c]) / 16.0f;
+    }
+  }
+  std::array<std::array<float, 3>, 3> covariance{};
+  for (const Pixel& pixel : block) {
+    for (size_t i = 0; i < 3; i++) {
+      for (size_t j = 0; j < 3; j++) {
+        covariance[i][j] += (static_cast<float>(pixel[i]) - mean[i]) *
+            (static_cast<float>(pixel[j]) - mean[j]);
+      }
+    }
+  }
+
+  // Power iteration
+  std::array<float, 3> axis{1.0f, 1.0f, 1.0f};
+  for (int iteration = 0; iteration < 8; iteration++) {
+    std::array<float, 3> next{};
+    for (size_t i = 0; i < 3; i++) {
+      for (size_t j = 0; j < 3; j++) {
+        next[i] += covariance[i][j] * axis[j];
+      }
+    }
+    const float length = std::max({std::abs(next[0]), std::abs(next[1]),
+                                   std::abs(next[2])});
+    if (length == 0.0f) {
+      break;
+    }
+    for (size_t i = 0; i < 3; i++) {
+      axis[i] = next[i] / length;
+    }
+  }
+
+  const Pixel* minPixel = block.data();
+  const Pixel* maxPixel = block.data();
+  float minProjection = std::numeric_limits<float>::max();
+  float maxProjection = std::numeric_limits<float>::lowest();
+  for (const Pixel& pixel : block) {
+    float projection = 0.0f;
+    for (size_t c = 0; c < 3; c++) {
+      projection += static_cast<float>(pixel[c]) * axis[c];
+    }
+    if (projection < minProjection) {
+      minProjection = projection;
+      minPixel = &pixel;
+    }
+    if (projection > maxProjection) {
+      maxProjection = projection;
+      maxPixel = &pixel;
+    }
+  }
+
+  uint16_t color0 = toRgb565(*maxPixel);
+  uint16_t color1 = toRgb565(*minPixel);
+  if (color0 < color1) {
+    std::swap(color0, color1);
+  }
+  uint64_t indices = 0;
+  if (color0 != color1) {
+    const std::array<float, 3> endpoint0 = fromRgb565(color0);
+    const std::array<float, 3> endpoint1 = fromRgb565(color1);
+    std::array<std::array<float, 3>, 4> palette{endpoint0, endpoint1};
+    for (size_t c = 0; c < 3; c++) {
+      palette[2][c] = ((2 * endpoint0[c]) + endpoint1[c]) / 3;
+      palette[3][c] = (endpoint0[c] + (2 * endpoint1[c])) / 3;
+    }
+
+    for (size_t i = 0; i < block.size(); i++) {
+      uint64_t bestIndex = 0;
+      float bestDistance = std::numeric_limits<float>::max();
+      for (uint64_t index = 0; index < palette.size(); index++) {
+        const float distance = distanceSquared(block[i], palette[index]);
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          bestIndex = index;
+        }
+      }
+      indices |= bestIndex << (2 * i);
+    }
+  }
+
+  return color0 | (static_cast<uint64_t>(color1) << 16) | (indices << 32);
+}
+
+// Uses the eight value mode between the block's minimum and maximum alpha
+uint64_t encodeAlphaBlock(const Block& block) {
+  uint8_t alpha0 = 0;
+  uint8_t alpha1 = 255;
+  for (const Pixel& pixel : block) {
+    alpha0 = std::max(alpha0, pixel[3]);
+    alpha1 = std::min(alpha1, pixel[3]);
+  }
+
+  uint64_t indices = 0;
+  if (alpha0 != alpha1) {
+    std::array<int, 8> palette{alpha0, alpha1};
+    for (int i = 1; i < 7; i++) {
+      palette[i + 1] = (((7 - i) * alpha0) + (i * alpha1)) / 7;
+    }
+
+    for (size_t i = 0; i < block.size(); i++) {
+      uint64_t bestIndex = 0;
+      int bestDistance = std::numeric_limits<int>::max();
+      for (uint64_t index = 0; index < palette.size(); index++) {
+        const int distance = std::abs(block[i][3] - palette[index]);
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          bestIndex = index;
+        }
+      }
+      indices |= bestIndex << (3 * i);
+    }
+  }
+
+  return alpha0 | (static_cast<uint64_t>(alpha1) << 8) | (indices << 16);
+}
+
+void compressLevel(
+    const Image& image, CompressedFormat format, std::vector<std::byte>& out) {
+  const size_t blocksX = (image.width + 3) / 4;
+  const size_t blocksY = (image.height + 3) / 4;
+  for (size_t blockY = 0; blockY < blocksY; blockY++) {
+    for (size_t blockX = 0; blockX < blocksX; blockX++) {
+      const Block block = readBlock(image, blockX, blockY);
+      const size_t offset = out.size();
+      if (format == CompressedFormat::BC3) {
+        const uint64_t alpha = encodeAlphaBlock(block);
+        const uint64_t color = encodeColorBlock(block);
+        out.resize(offset + 16);
+        std::memcpy(&out[offset], &alpha, 8);
+        std::memcpy(&out[offset + 8], &color, 8);
+      } else {
+        const uint64_t color = encodeColorBlock(block);
+        out.resize(offset + 8);
+        std::memcpy(&out[offset], &color, 8);
+      }
+    }
+  }
+}
+
+} // namespace
+
+CompressedImage compressImage(const Image& image, CompressedFormat format) {
+  if (format != CompressedFormat::BC1 && format != CompressedFormat::BC3) {
+    throw std::runtime_error{"Unsupported compression format"};
+  }
+  if (image.width == 0 || image.height == 0) {
+    throw std::runtime_error{"Cannot compress an empty image"};
+  }
+
+  CompressedImage result{
+      .format = format,
+      .width = image.width,
+      .height = image.height,
+      .mipLevels = {},
+      .data = {}};
+
+  Image level = image;
+  const size_t levelCount = std::bit_width(std::max(image.width, image.height));
+  for (size_t i = 0; i < levelCount; i++) {
+    if (i > 0) {
+      level = downsample(level);
+    }
+    const size_t offset = result.data.size();
+    compressLevel(level, format, result.data);
+    result.mipLevels.emplace_back(offset, result.data.size() - offset);
+  }
+  return result;
+}
+
+} // namespace blocks::loader
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+
+namespace blocks::loader {
+
+// Builds the full mip chain of a BGRA image and block compresses each level.
+// Only BC1 and BC3 can be encoded.
+CompressedImage compressImage(const Image& image, CompressedFormat format);
+
+} // namespace blocks::loader
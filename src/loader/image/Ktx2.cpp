@@ -0,0 +1,253 @@
+#include "loader/image/Ktx2.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "loader/CompressedImage.hpp"
+#include "util/file.hpp"
+
+static_assert(std::endian::native == std::endian::little);
+
+namespace blocks::loader {
+
+namespace {
+
+constexpr std::array<uint8_t, 12> kIdentifier{
+    0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+#pragma pack(push, 1)
+struct Ktx2Header {
+  std::array<uint8_t, 12> identifier;
+  uint32_t vkFormat;
+  uint32_t typeSize;
+  uint32_t pixelWidth;
+  uint32_t pixelHeight;
+  uint32_t pixelDepth;
+  uint32_t layerCount;
+  uint32_t faceCount;
+  uint32_t levelCount;
+  uint32_t supercompressionScheme;
+  uint32_t dfdByteOffset;
+  uint32_t dfdByteLength;
+  uint32_t kvdByteOffset;
+  uint32_t kvdByteLength;
+  uint64_t sgdByteOffset;
+  uint64_t sgdByteLength;
+};
+#pragma pack(pop)
+static_assert(sizeof(Ktx2Header) == 80);
+
+#pragma pack(push, 1)
+struct Ktx2LevelIndex {
+  uint64_t byteOffset;
+  uint64_t byteLength;
+  uint64_t uncompressedByteLength;
+};
+#pragma pack(pop)
+static_assert(sizeof(Ktx2LevelIndex) == 24);
+
+bool isSupportedFormat(uint32_t vkFormat) {
+  switch (static_cast<CompressedFormat>(vkFormat)) {
+    case CompressedFormat::BC1:
+    case CompressedFormat::BC3:
+    case CompressedFormat::BC7:
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t getMaxMipLevels(size_t width, size_t height) {
+  return std::bit_width(std::max(width, height));
+}
+
+template <typename T>
+void appendValue(std::vector<std::byte>& out, const T& value) {
+  const size_t offset = out.size();
+  out.resize(offset + sizeof(T));
+  std::memcpy(&out[offset], &value, sizeof(T));
+}
+
+// A basic data format descriptor, which KTX2 requires even though the format
+// alone describes the blocks fully
+std::vector<std::byte> makeDataFormatDescriptor(CompressedFormat format) {
+  struct Sample {
+    uint32_t bitLength;
+    uint32_t channel;
+  };
+  uint32_t colorModel = 0;
+  std::vector<Sample> samples;
+  switch (format) {
+    case CompressedFormat::BC1:
+      colorModel = 128;
+      samples = {{.bitLength = 64, .channel = 0}};
+      break;
+    case CompressedFormat::BC3:
+      // The alpha block comes first
+      colorModel = 130;
+      samples = {
+          {.bitLength = 64, .channel = 15}, {.bitLength = 64, .channel = 0}};
+      break;
+    case CompressedFormat::BC7:
+      colorModel = 134;
+      samples = {{.bitLength = 128, .channel = 0}};
+      break;
+  }
+
+  constexpr uint32_t kPrimariesBt709 = 1;
+  constexpr uint32_t kTransferSrgb = 2;
+  const auto blockSize = static_cast<uint32_t>(24 + (16 * samples.size()));
+
+  std::vector<std::byte> result;
+  appendValue(result, blockSize + 4);
+  appendValue(result, uint32_t{0});
+  appendValue(result, 2u | (blockSize << 16));
+  appendValue(
+      result, colorModel | (kPrimariesBt709 << 8) | (kTransferSrgb << 16));
+  // 4x4x1x1 blocks, stored as the dimensions minus one
+  appendValue(result, 3u | (3u << 8));
+  appendValue(result, static_cast<uint32_t>(getBlockSize(format)));
+  appendValue(result, uint32_t{0});
+
+  uint32_t bitOffset = 0;
+  for (const Sample& sample : samples) {
+    appendValue(
+        result,
+        bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+    appendValue(result, uint32_t{0});
+    appendValue(result, uint32_t{0});
+    appendValue(result, uint32_t{0xffffffff});
+    bitOffset += sample.bitLength;
+  }
+  return result;
+}
+
+} // namespace
+
+CompressedImage loadKtx2(const std::filesystem::path& path) {
+  return loadKtx2(util::MappedFile{path}.bytes());
+}
+
+CompressedImage loadKtx2(std::span<const std::byte> data) {
+  if (data.size() < sizeof(Ktx2Header)) {
+    throw std::runtime_error{"Corrupt KTX2"};
+  }
+  Ktx2Header header{};
+  std::memcpy(&header, data.data(), sizeof(Ktx2Header));
+  if (header.identifier != kIdentifier) {
+    throw std::runtime_error{"Corrupt KTX2"};
+  }
+
+  if (!isSupportedFormat(header.vkFormat) || header.typeSize != 1 ||
+      header.pixelWidth == 0 || header.pixelHeight == 0 ||
+      header.pixelDepth != 0 || header.layerCount > 1 ||
+      header.faceCount != 1 || header.supercompressionScheme != 0) {
+    throw std::runtime_error{"Unsupported KTX2 format"};
+  }
+
+  CompressedImage result{
+      .format = static_cast<CompressedFormat>(header.vkFormat),
+      .width = header.pixelWidth,
+      .height = header.pixelHeight,
+      .mipLevels = {},
+      .data = {}};
+  // A level count of zero asks for mips to be generated, which cannot be done
+  // for compressed blocks, so only the base level is used
+  const size_t levelCount = std::max<size_t>(header.levelCount, 1);
+  if (levelCount > getMaxMipLevels(result.width, result.height) ||
+      data.size() - sizeof(Ktx2Header) < levelCount * sizeof(Ktx2LevelIndex)) {
+    throw std::runtime_error{"Corrupt KTX2"};
+  }
+
+  std::vector<Ktx2LevelIndex> levels(levelCount);
+  std::memcpy(
+      levels.data(),
+      &data[sizeof(Ktx2Header)],
+      levelCount * sizeof(Ktx2LevelIndex));
+
+  size_t totalSize = 0;
+  for (size_t i = 0; i < levelCount; i++) {
+    const size_t size = getCompressedSize(
+        result.format,
+        std::max<size_t>(result.width >> i, 1),
+        std::max<size_t>(result.height >> i, 1));
+    if (levels[i].byteLength != size || levels[i].byteOffset > data.size() ||
+        data.size() - levels[i].byteOffset < size) {
+      throw std::runtime_error{"Corrupt KTX2"};
+    }
+    result.mipLevels.emplace_back(totalSize, size);
+    totalSize += size;
+  }
+
+  result.data.resize(totalSize);
+  for (size_t i = 0; i < levelCount; i++) {
+    const auto level = data.subspan(levels[i].byteOffset, levels[i].byteLength);
+    std::ranges::copy(level, result.data.begin() + result.mipLevels[i].offset);
+  }
+
+  return result;
+}
+
+std::vector<std::byte> writeKtx2(const CompressedImage& image) {
+  const size_t levelCount = image.mipLevels.size();
+  const std::vector<std::byte> dataFormatDescriptor =
+      makeDataFormatDescriptor(image.format);
+
+  const size_t dfdOffset =
+      sizeof(Ktx2Header) + (levelCount * sizeof(Ktx2LevelIndex));
+  Ktx2Header header{
+      .identifier = kIdentifier,
+      .vkFormat = static_cast<uint32_t>(image.format),
+      .typeSize = 1,
+      .pixelWidth = static_cast<uint32_t>(image.width),
+      .pixelHeight = static_cast<uint32_t>(image.height),
+      .pixelDepth = 0,
+      .layerCount = 0,
+      .faceCount = 1,
+      .levelCount = static_cast<uint32_t>(levelCount),
+      .supercompressionScheme = 0,
+      .dfdByteOffset = static_cast<uint32_t>(dfdOffset),
+      .dfdByteLength = static_cast<uint32_t>(dataFormatDescriptor.size()),
+      .kvdByteOffset = 0,
+      .kvdByteLength = 0,
+      .sgdByteOffset = 0,
+      .sgdByteLength = 0};
+
+  // Levels are stored smallest first, each aligned to a whole block
+  const size_t blockSize = getBlockSize(image.format);
+  std::vector<Ktx2LevelIndex> levels(levelCount);
+  size_t offset = dfdOffset + dataFormatDescriptor.size();
+  for (size_t i = levelCount; i-- > 0;) {
+    offset = (offset + blockSize - 1) / blockSize * blockSize;
+    levels[i] = Ktx2LevelIndex{
+        .byteOffset = offset,
+        .byteLength = image.mipLevels[i].size,
+        .uncompressedByteLength = image.mipLevels[i].size};
+    offset += image.mipLevels[i].size;
+  }
+
+  std::vector<std::byte> result;
+  result.reserve(offset);
+  appendValue(result, header);
+  for (const Ktx2LevelIndex& level : levels) {
+    appendValue(result, level);
+  }
+  result.insert(
+      result.end(), dataFormatDescriptor.begin(), dataFormatDescriptor.end());
+  for (size_t i = levelCount; i-- > 0;) {
+    result.resize(levels[i].byteOffset);
+    const auto level = std::span{image.data}.subspan(
+        image.mipLevels[i].offset, image.mipLevels[i].size);
+    result.insert(result.end(), level.begin(), level.end());
+  }
+  return result;
+}
+
+} // namespace blocks::loader
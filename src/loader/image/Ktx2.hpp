@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "loader/CompressedImage.hpp"
+
+namespace blocks::loader {
+
+// Only single layer 2D textures of the formats in CompressedFormat, without
+// supercompression
+CompressedImage loadKtx2(const std::filesystem::path& path);
+CompressedImage loadKtx2(std::span<const std::byte> data);
+
+std::vector<std::byte> writeKtx2(const CompressedImage& image);
+
+} // namespace blocks::loader
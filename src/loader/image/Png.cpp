@@ -1,17 +1,19 @@
 #include "loader/image/Png.hpp"
 
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
-#include <limits>
+#include <immintrin.h>
+#include <optional>
 #include <span>
 #include <stdexcept>
-#include <utility>
 #include <vector>
 #include "loader/Image.hpp"
-#include "math/vec.hpp"
+#include "util/Generator.hpp"
 #include "util/debug.hpp"
 #include "util/file.hpp"
 #include "util/zlib.hpp"
@@ -22,8 +24,6 @@ namespace blocks::loader {
 
 namespace {
 
-constexpr unsigned short sZero = static_cast<unsigned short>(0);
-
 using crc_type = uint32_t;
 
 /* Table of CRCs of all 8-bit messages. */
@@ -133,6 +133,22 @@ Chunk readChunk(std::span<const std::byte>& data) {
   return outChunk;
 }
 
+constexpr std::array<std::byte, 4> kHeaderChunk{
+    std::byte{'I'}, std::byte{'H'}, std::byte{'D'}, std::byte{'R'}};
+constexpr std::array<std::byte, 4> kImageDataChunk{
+    std::byte{'I'}, std::byte{'D'}, std::byte{'A'}, std::byte{'T'}};
+
+// Image data is read straight out of the chunks, the rest are only checked
+util::Generator<std::span<const std::byte>> readImageData(
+    std::span<const std::byte> data) {
+  while (!data.empty()) {
+    const Chunk chunk = readChunk(data);
+    if (chunk.type == kImageDataChunk) {
+      co_yield chunk.data;
+    }
+  }
+}
+
 struct PngHeader {
   uint32_t width;
   uint32_t height;
@@ -166,175 +182,740 @@ enum FilterMode : uint8_t {
   PAETH = 4,
 };
 
+enum ColorType : uint8_t {
+  GREYSCALE = 0,
+  TRUECOLOR = 2,
+  INDEXED = 3,
+  GREYSCALE_ALPHA = 4,
+  TRUECOLOR_ALPHA = 6,
+};
+
+size_t getChannelCount(const PngHeader& header) {
+  switch (header.colorType) {
+    case ColorType::GREYSCALE:
+    case ColorType::INDEXED:
+      return 1;
+    case ColorType::GREYSCALE_ALPHA:
+      return 2;
+    case ColorType::TRUECOLOR:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+bool isSupportedBitDepth(const PngHeader& header) {
+  switch (header.colorType) {
+    case ColorType::GREYSCALE:
+      return std::has_single_bit(header.bitDepth) && header.bitDepth <= 16;
+    case ColorType::INDEXED:
+      return std::has_single_bit(header.bitDepth) && header.bitDepth <= 8;
+    case ColorType::TRUECOLOR:
+    case ColorType::GREYSCALE_ALPHA:
+    case ColorType::TRUECOLOR_ALPHA:
+      return header.bitDepth == 8 || header.bitDepth == 16;
+    default:
+      return false;
+  }
+}
+
+size_t getRowSize(const PngHeader& header, size_t width) {
+  return ((width * getChannelCount(header) * header.bitDepth) + 7) / 8;
+}
+
+// The distance filters look back by, a whole pixel or one byte for smaller
+// pixels
+size_t getFilterStride(const PngHeader& header) {
+  return std::max<size_t>(
+      1, getChannelCount(header) * header.bitDepth / 8);
+}
+
+template <size_t byteCount>
+__m128i loadBytes(const std::byte* src) {
+  static_assert(byteCount <= 8);
+  uint64_t value = 0;
+  std::memcpy(&value, src, byteCount);
+  return _mm_cvtsi64_si128(static_cast<long long>(value));
+}
+
+template <size_t byteCount>
+void storeBytes(std::byte* dst, __m128i value) {
+  static_assert(byteCount <= 8);
+  const auto bits = static_cast<uint64_t>(_mm_cvtsi128_si64(value));
+  std::memcpy(dst, &bits, byteCount);
+}
+
+__m128i load16(const void* src) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+void store16(std::byte* dst, __m128i value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+__m256i load32(const std::byte* src) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+}
+
+void store32(std::byte* dst, __m256i value) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), value);
+}
+
+// Sub, Average and Paeth depend on the pixel to the left, so those kernels
+// work a pixel at a time. Up has no such dependency and runs 32 bytes at once.
+
+template <size_t pixelSizeBytes>
+void defilterSub(std::span<std::byte> row) {
+  __m128i left = _mm_setzero_si128();
+  for (size_t i = 0; i < row.size(); i += pixelSizeBytes) {
+    left = _mm_add_epi8(left, loadBytes<pixelSizeBytes>(&row[i]));
+    storeBytes<pixelSizeBytes>(&row[i], left);
+  }
+}
+
+void defilterUp(std::span<std::byte> row, std::span<const std::byte> prior) {
+  size_t i = 0;
+  for (; i + 32 <= row.size(); i += 32) {
+    store32(&row[i], _mm256_add_epi8(load32(&row[i]), load32(&prior[i])));
+  }
+  for (; i < row.size(); i++) {
+    row[i] = static_cast<std::byte>(
+        static_cast<uint8_t>(row[i]) + static_cast<uint8_t>(prior[i]));
+  }
+}
+
+template <size_t pixelSizeBytes>
+void defilterAverage(
+    std::span<std::byte> row, std::span<const std::byte> prior) {
+  const __m128i ones = _mm_set1_epi8(1);
+  __m128i left = _mm_setzero_si128();
+  for (size_t i = 0; i < row.size(); i += pixelSizeBytes) {
+    const __m128i up = loadBytes<pixelSizeBytes>(&prior[i]);
+    // _mm_avg_epu8 rounds up, the filter rounds down
+    const __m128i average = _mm_sub_epi8(
+        _mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), ones));
+    left = _mm_add_epi8(loadBytes<pixelSizeBytes>(&row[i]), average);
+    storeBytes<pixelSizeBytes>(&row[i], left);
+  }
+}
+
 template <size_t pixelSizeBytes>
-std::vector<std::byte> defilter(
-    const PngHeader& header, std::span<const std::byte> decompressedData)
-  requires(pixelSizeBytes == 3 || pixelSizeBytes == 4)
-{
-  using Color = math::Vec<unsigned short, pixelSizeBytes>;
-
-  const size_t outRowSize = 4ull * header.width;
-  size_t rowSize = (pixelSizeBytes * header.width) + 1;
-  std::vector<std::byte> outData;
-  outData.reserve(static_cast<size_t>(header.width) * header.height * 4);
-
-  auto readDecompressed = [&](size_t x, size_t y) {
-    const size_t pixelOffset = 1 + (pixelSizeBytes * x) + (rowSize * y);
-    Color out;
-    for (int i = 0; i < pixelSizeBytes; i++) {
-      out.at(i) =
-          static_cast<unsigned short>(decompressedData[pixelOffset + i]);
+void defilterPaeth(std::span<std::byte> row, std::span<const std::byte> prior) {
+  // Widened to 16 bits so the predictor distances cannot overflow
+  const __m128i zero = _mm_setzero_si128();
+  __m128i left = zero;
+  __m128i upLeft = zero;
+  for (size_t i = 0; i < row.size(); i += pixelSizeBytes) {
+    const __m128i up =
+        _mm_unpacklo_epi8(loadBytes<pixelSizeBytes>(&prior[i]), zero);
+    const __m128i raw =
+        _mm_unpacklo_epi8(loadBytes<pixelSizeBytes>(&row[i]), zero);
+
+    // With p = left + up - upLeft, these are |p - left|, |p - up| and
+    // |p - upLeft|
+    const __m128i upDelta = _mm_sub_epi16(up, upLeft);
+    const __m128i leftDelta = _mm_sub_epi16(left, upLeft);
+    const __m128i distLeft = _mm_abs_epi16(upDelta);
+    const __m128i distUp = _mm_abs_epi16(leftDelta);
+    const __m128i distUpLeft =
+        _mm_abs_epi16(_mm_add_epi16(upDelta, leftDelta));
+
+    // Ties favour left, then up
+    const __m128i smallest =
+        _mm_min_epi16(distUpLeft, _mm_min_epi16(distLeft, distUp));
+    const __m128i predictor = _mm_blendv_epi8(
+        _mm_blendv_epi8(upLeft, up, _mm_cmpeq_epi16(smallest, distUp)),
+        left,
+        _mm_cmpeq_epi16(smallest, distLeft));
+
+    // Adding bytewise wraps within the low byte of each lane
+    left = _mm_add_epi8(raw, predictor);
+    upLeft = up;
+    storeBytes<pixelSizeBytes>(&row[i], _mm_packus_epi16(left, left));
+  }
+}
+
+template <size_t pixelSizeBytes>
+void defilterRow(
+    FilterMode filterMode,
+    std::span<std::byte> row,
+    std::span<const std::byte> prior) {
+  switch (filterMode) {
+    case FilterMode::NONE:
+      break;
+    case FilterMode::SUB:
+      defilterSub<pixelSizeBytes>(row);
+      break;
+    case FilterMode::UP:
+      defilterUp(row, prior);
+      break;
+    case FilterMode::AVERAGE:
+      defilterAverage<pixelSizeBytes>(row, prior);
+      break;
+    case FilterMode::PAETH:
+      defilterPaeth<pixelSizeBytes>(row, prior);
+      break;
+  }
+}
+
+void defilterRow(
+    size_t filterStride,
+    FilterMode filterMode,
+    std::span<std::byte> row,
+    std::span<const std::byte> prior) {
+  switch (filterStride) {
+    case 1:
+      defilterRow<1>(filterMode, row, prior);
+      break;
+    case 2:
+      defilterRow<2>(filterMode, row, prior);
+      break;
+    case 3:
+      defilterRow<3>(filterMode, row, prior);
+      break;
+    case 4:
+      defilterRow<4>(filterMode, row, prior);
+      break;
+    case 6:
+      defilterRow<6>(filterMode, row, prior);
+      break;
+    case 8:
+      defilterRow<8>(filterMode, row, prior);
+      break;
+    default:
+      DEBUG_ASSERT(false);
+  }
+}
+
+// Where each BGRA output channel is taken from within a source pixel, with -1
+// for an opaque alpha. 16 bit samples are big endian, so taking their first
+// byte truncates them to 8 bits.
+struct ByteLayout {
+  size_t pixelSize;
+  std::array<int, 4> sources;
+};
+
+constexpr ByteLayout kGrey8{.pixelSize = 1, .sources = {0, 0, 0, -1}};
+constexpr ByteLayout kGreyAlpha8{.pixelSize = 2, .sources = {0, 0, 0, 1}};
+constexpr ByteLayout kRgb8{.pixelSize = 3, .sources = {2, 1, 0, -1}};
+constexpr ByteLayout kRgba8{.pixelSize = 4, .sources = {2, 1, 0, 3}};
+constexpr ByteLayout kGrey16{.pixelSize = 2, .sources = {0, 0, 0, -1}};
+constexpr ByteLayout kGreyAlpha16{.pixelSize = 4, .sources = {0, 0, 0, 2}};
+constexpr ByteLayout kRgb16{.pixelSize = 6, .sources = {4, 2, 0, -1}};
+constexpr ByteLayout kRgba16{.pixelSize = 8, .sources = {4, 2, 0, 6}};
+
+// Expands up to four pixels per pshufb, with the alpha filled in afterwards
+template <ByteLayout layout>
+void shuffleRow(std::span<const std::byte> row, std::span<std::byte> out) {
+  constexpr size_t kPixelsPerStep = std::min<size_t>(4, 16 / layout.pixelSize);
+  constexpr auto kShuffle = []() {
+    std::array<int8_t, 16> shuffle{};
+    shuffle.fill(-1);
+    for (size_t i = 0; i < kPixelsPerStep; i++) {
+      for (size_t c = 0; c < 4; c++) {
+        if (layout.sources[c] >= 0) {
+          shuffle[(i * 4) + c] = static_cast<int8_t>(
+              (i * layout.pixelSize) + layout.sources[c]);
+        }
+      }
     }
-    return out;
-  };
-  auto readOut = [&](size_t x, size_t y) {
-    const size_t pixelOffset = (4 * x) + (y * outRowSize);
-    Color out;
-    for (int i = 0; i < pixelSizeBytes; i++) {
-      out.at(i) = static_cast<unsigned short>(outData[pixelOffset + i]);
+    return shuffle;
+  }();
+  constexpr auto kAlpha = []() {
+    std::array<int8_t, 16> alpha{};
+    for (size_t i = 0; i < kPixelsPerStep; i++) {
+      for (size_t c = 0; c < 4; c++) {
+        alpha[(i * 4) + c] = layout.sources[c] < 0 ? int8_t{-1} : int8_t{0};
+      }
     }
-    return out;
-  };
-
-  auto writeOut = [&](Color col) {
-    outData.emplace_back(static_cast<std::byte>(col.at(0)));
-    outData.emplace_back(static_cast<std::byte>(col.at(1)));
-    outData.emplace_back(static_cast<std::byte>(col.at(2)));
-    if constexpr (pixelSizeBytes == 4) {
-      outData.emplace_back(static_cast<std::byte>(col.at(3)));
+    return alpha;
+  }();
+
+  const __m128i shuffle = load16(kShuffle.data());
+  const __m128i alpha = load16(kAlpha.data());
+  size_t x = 0;
+  // Always reads 16 bytes, so stop short of the end of the row
+  for (; (x * layout.pixelSize) + 16 <= row.size(); x += kPixelsPerStep) {
+    const __m128i pixels = _mm_or_si128(
+        _mm_shuffle_epi8(load16(&row[x * layout.pixelSize]), shuffle), alpha);
+    if constexpr (kPixelsPerStep == 4) {
+      store16(&out[x * 4], pixels);
     } else {
-      outData.emplace_back(
-          static_cast<std::byte>(std::numeric_limits<unsigned char>::max()));
+      storeBytes<kPixelsPerStep * 4>(&out[x * 4], pixels);
     }
-  };
+  }
 
-  for (size_t y = 0; y < header.height; y++) {
-    const auto rawFilterMode =
-        static_cast<unsigned char>(decompressedData[rowSize * y]);
-    if (rawFilterMode > 4) {
-      throw std::runtime_error{"Corrupt PNG"};
+  for (; x * layout.pixelSize < row.size(); x++) {
+    for (size_t c = 0; c < 4; c++) {
+      const int source = layout.sources[c];
+      out[(x * 4) + c] = source < 0
+          ? std::byte{0xff}
+          : row[(x * layout.pixelSize) + static_cast<size_t>(source)];
     }
-    const auto filterMode = static_cast<FilterMode>(rawFilterMode);
-
-    for (size_t x = 0; x < header.width; x++) {
-      if (filterMode == FilterMode::NONE) {
-        const Color col = readDecompressed(x, y);
-        writeOut(col);
-      } else if (filterMode == FilterMode::SUB) {
-        const Color prev =
-            x != 0 ? readOut(x - 1, y) : Color{sZero, sZero, sZero};
-        const Color raw = readDecompressed(x, y);
-        writeOut(raw + prev);
-      } else if (filterMode == FilterMode::UP) {
-        const Color prev =
-            y != 0 ? readOut(x, y - 1) : Color{sZero, sZero, sZero};
-        const Color raw = readDecompressed(x, y);
-        writeOut(raw + prev);
-      } else if (filterMode == FilterMode::AVERAGE) {
-        const Color prevX =
-            x != 0 ? readOut(x - 1, y) : Color{sZero, sZero, sZero};
-        const Color prevY =
-            y != 0 ? readOut(x, y - 1) : Color{sZero, sZero, sZero};
-        const Color raw = readDecompressed(x, y);
-        writeOut(raw + ((prevX + prevY) / static_cast<unsigned short>(2)));
-      } else if (filterMode == FilterMode::PAETH) {
-        const Color prevX =
-            x != 0 ? readOut(x - 1, y) : Color{sZero, sZero, sZero};
-        const Color prevY =
-            y != 0 ? readOut(x, y - 1) : Color{sZero, sZero, sZero};
-        const Color prevXY = x != 0 && y != 0
-            ? readOut(x - 1, y - 1)
-            : Color{sZero, sZero, sZero};
-        const Color raw = readDecompressed(x, y);
-        Color predictor;
-
-        for (size_t i = 0; i < pixelSizeBytes; i++) {
-          const int a = prevX.at(i);
-          const int b = prevY.at(i);
-          const int c = prevXY.at(i);
-
-          const int thresh = (c * 3) - (a + b);
-          const int lo = a < b ? a : b;
-          const int hi = a < b ? b : a;
-          const int t0 = (hi <= thresh) ? lo : c;
-          const int t1 = (thresh <= lo) ? hi : t0;
-          const int presult = t1;
-
-          predictor.at(i) = static_cast<unsigned short>(presult);
-        }
+  }
+}
 
-        writeOut(raw + predictor);
-      } else {
-        DEBUG_ASSERT(false);
+// BGRA colours, indexed by palette index or greyscale value
+using Palette = std::array<uint32_t, 256>;
+
+constexpr uint32_t kOpaque = 0xff000000;
+
+// Sub-byte samples are split out to a byte each with a table per byte value
+template <size_t bitDepth>
+void unpackSamples(std::span<const std::byte> row, std::span<std::byte> out) {
+  constexpr size_t kSamplesPerByte = 8 / bitDepth;
+  constexpr auto kTable = []() {
+    std::array<uint64_t, 256> table{};
+    for (size_t value = 0; value < 256; value++) {
+      for (size_t i = 0; i < kSamplesPerByte; i++) {
+        const uint64_t sample =
+            (value >> (8 - (bitDepth * (i + 1)))) & ((1u << bitDepth) - 1);
+        table[value] |= sample << (8 * i);
       }
     }
+    return table;
+  }();
+
+  for (size_t i = 0; i * kSamplesPerByte < out.size(); i++) {
+    const size_t count =
+        std::min(kSamplesPerByte, out.size() - (i * kSamplesPerByte));
+    std::memcpy(
+        &out[i * kSamplesPerByte],
+        &kTable[static_cast<uint8_t>(row[i])],
+        count);
   }
+}
 
-  return outData;
+void paletteRow(
+    std::span<const std::byte> indices,
+    const Palette& palette,
+    std::span<std::byte> out) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto* table = reinterpret_cast<const int*>(palette.data());
+  size_t x = 0;
+  for (; x + 8 <= indices.size(); x += 8) {
+    const __m256i index =
+        _mm256_cvtepu8_epi32(_mm_loadl_epi64(static_cast<const __m128i*>(
+            static_cast<const void*>(&indices[x]))));
+    store32(&out[x * 4], _mm256_i32gather_epi32(table, index, 4));
+  }
+  for (; x < indices.size(); x++) {
+    std::memcpy(
+        &out[x * 4], &palette[static_cast<uint8_t>(indices[x])], 4);
+  }
 }
 
-} // namespace
+// Clears the alpha of 8 bit truecolor pixels matching the tRNS colour, once
+// they have been expanded to opaque BGRA
+void applyColorKey(std::span<std::byte> out, uint32_t key) {
+  const __m128i keyVec = _mm_set1_epi32(static_cast<int>(key));
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(kOpaque));
+  size_t i = 0;
+  for (; i + 16 <= out.size(); i += 16) {
+    const __m128i pixels = load16(&out[i]);
+    const __m128i transparent =
+        _mm_and_si128(_mm_cmpeq_epi32(pixels, keyVec), alpha);
+    store16(&out[i], _mm_andnot_si128(transparent, pixels));
+  }
+  for (; i < out.size(); i += 4) {
+    uint32_t pixel = 0;
+    std::memcpy(&pixel, &out[i], 4);
+    if (pixel == key) {
+      out[i + 3] = std::byte{0};
+    }
+  }
+}
 
-Image loadPng(const std::filesystem::path& path) {
-  return loadPng(util::readFileBytes(path));
+// 16 bit samples have to be compared before they are truncated
+void applyColorKey16(
+    std::span<const std::byte> row,
+    size_t channels,
+    const std::array<uint16_t, 3>& key,
+    std::span<std::byte> out) {
+  const size_t pixelSize = channels * 2;
+  for (size_t x = 0; x * pixelSize < row.size(); x++) {
+    bool matches = true;
+    for (size_t c = 0; c < channels; c++) {
+      const size_t offset = (x * pixelSize) + (c * 2);
+      const auto sample = static_cast<uint16_t>(
+          (static_cast<uint16_t>(row[offset]) << 8) |
+          static_cast<uint16_t>(row[offset + 1]));
+      matches = matches && sample == key[c];
+    }
+    if (matches) {
+      out[(x * 4) + 3] = std::byte{0};
+    }
+  }
 }
 
-Image loadPng(std::span<const std::byte> data) {
-  if (!checkSignature(data)) {
+enum class RowKernel : uint8_t {
+  GREY8,
+  GREY_ALPHA8,
+  RGB8,
+  RGBA8,
+  GREY16,
+  GREY_ALPHA16,
+  RGB16,
+  RGBA16,
+  // Indexed, as well as greyscale below 16 bits with a tRNS chunk or below
+  // 8 bits, which are turned into a palette of greys
+  PALETTE,
+};
+
+struct PixelFormat {
+  RowKernel kernel;
+  Palette palette;
+  // From tRNS, for truecolor and 16 bit greyscale
+  std::optional<std::array<uint16_t, 3>> colorKey;
+};
+
+constexpr std::array<std::byte, 4> kPaletteChunk{
+    std::byte{'P'}, std::byte{'L'}, std::byte{'T'}, std::byte{'E'}};
+constexpr std::array<std::byte, 4> kTransparencyChunk{
+    std::byte{'t'}, std::byte{'R'}, std::byte{'N'}, std::byte{'S'}};
+
+uint16_t readBigEndian16(std::span<const std::byte> data) {
+  return static_cast<uint16_t>(
+      (static_cast<uint16_t>(data[0]) << 8) | static_cast<uint16_t>(data[1]));
+}
+
+Palette makeIndexedPalette(
+    std::span<const std::byte> paletteData,
+    std::span<const std::byte> transparency) {
+  if (paletteData.empty() || paletteData.size() % 3 != 0 ||
+      paletteData.size() > 3 * 256 ||
+      transparency.size() > paletteData.size() / 3) {
     throw std::runtime_error{"Corrupt PNG"};
   }
 
-  const Chunk headerChunk = readChunk(data);
-  const PngHeader header = readPngHeader(headerChunk.data);
+  // Out of range indices come out as opaque black
+  Palette palette;
+  palette.fill(kOpaque);
+  for (size_t i = 0; i < paletteData.size() / 3; i++) {
+    const uint32_t alpha = i < transparency.size()
+        ? static_cast<uint32_t>(transparency[i])
+        : 0xff;
+    palette[i] = static_cast<uint32_t>(paletteData[(i * 3) + 2]) |
+        (static_cast<uint32_t>(paletteData[(i * 3) + 1]) << 8) |
+        (static_cast<uint32_t>(paletteData[i * 3]) << 16) | (alpha << 24);
+  }
+  return palette;
+}
 
-  if (header.bitDepth != 8 ||
-      (header.colorType != 2 && header.colorType != 6) ||
-      header.compression != 0) {
-    throw std::runtime_error{"Unsupported PNG format"};
+Palette makeGreyPalette(
+    uint8_t bitDepth, std::optional<uint16_t> transparentValue) {
+  const uint32_t maxValue = (1u << bitDepth) - 1;
+  Palette palette{};
+  for (uint32_t value = 0; value <= maxValue; value++) {
+    const uint32_t grey = value * (255 / maxValue);
+    palette[value] = grey | (grey << 8) | (grey << 16) |
+        (value == transparentValue ? 0 : kOpaque);
+  }
+  return palette;
+}
+
+// Reads the chunks up to the image data, leaving data at the first IDAT
+PixelFormat readPixelFormat(
+    const PngHeader& header, std::span<const std::byte>& data) {
+  std::span<const std::byte> paletteData;
+  std::optional<std::span<const std::byte>> transparency;
+  while (!data.empty()) {
+    std::span<const std::byte> rest = data;
+    const Chunk chunk = readChunk(rest);
+    if (chunk.type == kImageDataChunk) {
+      break;
+    }
+    if (chunk.type == kPaletteChunk) {
+      paletteData = chunk.data;
+    } else if (chunk.type == kTransparencyChunk) {
+      transparency = chunk.data;
+    }
+    data = rest;
   }
 
-  const bool hasAlpha = header.colorType == 6;
+  PixelFormat format{.kernel = RowKernel::RGBA8, .palette = {}, .colorKey = {}};
+  const bool is16Bit = header.bitDepth == 16;
+  switch (header.colorType) {
+    case ColorType::INDEXED:
+      format.kernel = RowKernel::PALETTE;
+      format.palette =
+          makeIndexedPalette(
+          paletteData,
+          transparency.value_or(std::span<const std::byte>{}));
+      break;
+
+    case ColorType::GREYSCALE:
+      if (transparency.has_value() && transparency->size() != 2) {
+        throw std::runtime_error{"Corrupt PNG"};
+      }
+      if (is16Bit) {
+        format.kernel = RowKernel::GREY16;
+        if (transparency.has_value()) {
+          const uint16_t value = readBigEndian16(*transparency);
+          format.colorKey = std::array<uint16_t, 3>{value, 0, 0};
+        }
+      } else if (header.bitDepth < 8 || transparency.has_value()) {
+        format.kernel = RowKernel::PALETTE;
+        format.palette = makeGreyPalette(
+            header.bitDepth,
+            transparency.has_value()
+                ? std::optional{readBigEndian16(*transparency)}
+                : std::nullopt);
+      } else {
+        format.kernel = RowKernel::GREY8;
+      }
+      break;
 
-  std::vector<std::byte> imgData;
+    case ColorType::TRUECOLOR:
+      format.kernel = is16Bit ? RowKernel::RGB16 : RowKernel::RGB8;
+      if (transparency.has_value()) {
+        if (transparency->size() != 6) {
+          throw std::runtime_error{"Corrupt PNG"};
+        }
+        const std::array<uint16_t, 3> key{
+            readBigEndian16(transparency->subspan(0)),
+            readBigEndian16(transparency->subspan(2)),
+            readBigEndian16(transparency->subspan(4))};
+        // An out of range key cannot match any 8 bit pixel
+        if (is16Bit || std::ranges::all_of(key, [](uint16_t v) {
+              return v <= 0xff;
+            })) {
+          format.colorKey = key;
+        }
+      }
+      break;
 
-  while (!data.empty()) {
-    const Chunk chunk = readChunk(data);
-    if (chunk.type ==
-        std::array<std::byte, 4>{
-            std::byte{'I'}, std::byte{'D'}, std::byte{'A'}, std::byte{'T'}}) {
-      for (auto c : chunk.data) {
-        imgData.push_back(c);
+    case ColorType::GREYSCALE_ALPHA:
+      format.kernel =
+          is16Bit ? RowKernel::GREY_ALPHA16 : RowKernel::GREY_ALPHA8;
+      break;
+
+    default:
+      format.kernel = is16Bit ? RowKernel::RGBA16 : RowKernel::RGBA8;
+      break;
+  }
+  return format;
+}
+
+// Writes a defiltered row out as BGRA. scratch holds the unpacked samples of
+// sub-byte formats.
+void expandRow(
+    const PngHeader& header,
+    const PixelFormat& format,
+    std::span<const std::byte> row,
+    std::span<std::byte> scratch,
+    std::span<std::byte> out) {
+  switch (format.kernel) {
+    case RowKernel::GREY8:
+      shuffleRow<kGrey8>(row, out);
+      break;
+    case RowKernel::GREY_ALPHA8:
+      shuffleRow<kGreyAlpha8>(row, out);
+      break;
+    case RowKernel::RGB8:
+      shuffleRow<kRgb8>(row, out);
+      break;
+    case RowKernel::RGBA8:
+      shuffleRow<kRgba8>(row, out);
+      break;
+    case RowKernel::GREY16:
+      shuffleRow<kGrey16>(row, out);
+      break;
+    case RowKernel::GREY_ALPHA16:
+      shuffleRow<kGreyAlpha16>(row, out);
+      break;
+    case RowKernel::RGB16:
+      shuffleRow<kRgb16>(row, out);
+      break;
+    case RowKernel::RGBA16:
+      shuffleRow<kRgba16>(row, out);
+      break;
+    case RowKernel::PALETTE: {
+      const std::span<std::byte> indices = scratch.subspan(0, out.size() / 4);
+      switch (header.bitDepth) {
+        case 1:
+          unpackSamples<1>(row, indices);
+          break;
+        case 2:
+          unpackSamples<2>(row, indices);
+          break;
+        case 4:
+          unpackSamples<4>(row, indices);
+          break;
+        default:
+          std::memcpy(indices.data(), row.data(), indices.size());
+          break;
       }
+      paletteRow(indices, format.palette, out);
+      break;
+    }
+  }
+
+  if (format.colorKey.has_value()) {
+    const auto& key = *format.colorKey;
+    if (header.bitDepth == 16) {
+      applyColorKey16(row, getChannelCount(header), key, out);
+    } else {
+      applyColorKey(
+          out,
+          static_cast<uint32_t>(key[2]) | (static_cast<uint32_t>(key[1]) << 8) |
+              (static_cast<uint32_t>(key[0]) << 16) | kOpaque);
     }
   }
+}
+
+struct InterlacePass {
+  size_t xStart;
+  size_t yStart;
+  size_t xStep;
+  size_t yStep;
 
-  std::vector<std::byte> decompressedData =
-      util::zlibDecompress(std::span(imgData.begin(), imgData.end()));
+  [[nodiscard]] size_t getWidth(size_t imageWidth) const {
+    return imageWidth > xStart ? (imageWidth - xStart + xStep - 1) / xStep : 0;
+  }
+  [[nodiscard]] size_t getHeight(size_t imageHeight) const {
+    return imageHeight > yStart ? (imageHeight - yStart + yStep - 1) / yStep
+                                : 0;
+  }
+};
 
-  const size_t pixelSizeBytes = hasAlpha ? 4 : 3;
+constexpr std::array<InterlacePass, 1> kNoInterlacing{{{0, 0, 1, 1}}};
+constexpr std::array<InterlacePass, 7> kAdam7Passes{
+    {{0, 0, 8, 8},
+     {4, 0, 8, 8},
+     {0, 4, 4, 8},
+     {2, 0, 4, 4},
+     {0, 2, 2, 4},
+     {1, 0, 2, 2},
+     {0, 1, 1, 2}}};
+
+PngHeader readSupportedHeader(std::span<const std::byte>& data) {
+  if (!checkSignature(data)) {
+    throw std::runtime_error{"Corrupt PNG"};
+  }
 
-  const size_t rowSize = (pixelSizeBytes * header.width) + 1;
-  if (decompressedData.size() != rowSize * header.height) {
+  const Chunk headerChunk = readChunk(data);
+  if (headerChunk.type != kHeaderChunk || headerChunk.data.size() != 13) {
     throw std::runtime_error{"Corrupt PNG"};
   }
+  const PngHeader header = readPngHeader(headerChunk.data);
+
+  if (!isSupportedBitDepth(header) || header.compression != 0 ||
+      header.filter != 0 || header.interlace > 1) {
+    throw std::runtime_error{"Unsupported PNG format"};
+  }
+  return header;
+}
+
+} // namespace
+
+Image loadPng(const std::filesystem::path& path) {
+  return loadPng(util::MappedFile{path}.bytes());
+}
+
+Image loadPng(std::span<const std::byte> data) {
+  const PngInfo info = readPngInfo(data);
+  Image result{
+      .width = info.width,
+      .height = info.height,
+      .pixelData = std::vector<std::byte>(info.width * info.height * 4)};
+  loadPng(data, result.pixelData);
+  return result;
+}
 
-  const size_t outRowSize = 4ull * header.width;
-  std::vector<std::byte> outData = hasAlpha
-      ? defilter<4>(header, decompressedData)
-      : defilter<3>(header, decompressedData);
+PngInfo readPngInfo(std::span<const std::byte> data) {
+  const PngHeader header = readSupportedHeader(data);
+  return PngInfo{.width = header.width, .height = header.height};
+}
 
-  // Adjust to the expected BGR format
-  for (size_t y = 0; y < header.height; y++) {
-    for (size_t x = 0; x < header.width; x++) {
-      const size_t pixelOffset = (4ull * x) + (y * outRowSize);
-      std::swap(outData[pixelOffset], outData[pixelOffset + 2]);
+void loadPng(std::span<const std::byte> data, std::span<std::byte> out) {
+  const PngHeader header = readSupportedHeader(data);
+  const size_t width = header.width;
+  if (out.size() != 4ull * width * header.height) {
+    throw std::runtime_error{"PNG output buffer has the wrong size"};
+  }
+  const PixelFormat format = readPixelFormat(header, data);
+
+  const bool isInterlaced = header.interlace == 1;
+  const std::span<const InterlacePass> passes = isInterlaced
+      ? std::span<const InterlacePass>{kAdam7Passes}
+      : std::span<const InterlacePass>{kNoInterlacing};
+
+  // Each row of each non-empty pass starts with its filter type
+  size_t decompressedSize = 0;
+  for (const InterlacePass& pass : passes) {
+    const size_t passWidth = pass.getWidth(width);
+    if (passWidth > 0) {
+      decompressedSize +=
+          pass.getHeight(header.height) * (getRowSize(header, passWidth) + 1);
     }
   }
 
-  return Image{
-      .width = header.width,
-      .height = header.height,
-      .pixelData = std::move(outData)};
+  std::vector<std::byte> decompressedData(decompressedSize);
+  util::Generator<std::span<const std::byte>> imageData = readImageData(data);
+  if (util::zlibDecompress(imageData, decompressedData) !=
+      decompressedData.size()) {
+    throw std::runtime_error{"Corrupt PNG"};
+  }
+  // Still check the chunks after the end of the image data
+  while (imageData) {
+    imageData();
+  }
+
+  const size_t filterStride = getFilterStride(header);
+  const std::vector<std::byte> zeroRow(getRowSize(header, width));
+  std::vector<std::byte> scratch(
+      format.kernel == RowKernel::PALETTE ? width : 0);
+  // Interlaced passes are expanded here, then scattered into the output
+  std::vector<std::byte> passRow(isInterlaced ? 4 * width : 0);
+
+  std::span<std::byte> remaining = decompressedData;
+  for (const InterlacePass& pass : passes) {
+    const size_t passWidth = pass.getWidth(width);
+    const size_t passHeight = pass.getHeight(header.height);
+    if (passWidth == 0) {
+      continue;
+    }
+
+    const size_t rowSize = getRowSize(header, passWidth);
+    std::span<const std::byte> prior =
+        std::span{zeroRow}.subspan(0, rowSize);
+    for (size_t y = 0; y < passHeight; y++) {
+      const auto rawFilterMode = static_cast<unsigned char>(remaining[0]);
+      if (rawFilterMode > 4) {
+        throw std::runtime_error{"Corrupt PNG"};
+      }
+      const std::span<std::byte> row = remaining.subspan(1, rowSize);
+      remaining = remaining.subspan(rowSize + 1);
+
+      defilterRow(
+          filterStride, static_cast<FilterMode>(rawFilterMode), row, prior);
+      prior = row;
+
+      if (!isInterlaced) {
+        expandRow(
+            header,
+            format,
+            row,
+            scratch,
+            out.subspan(4 * width * y, 4 * width));
+        continue;
+      }
+
+      const std::span<std::byte> expanded =
+          std::span{passRow}.subspan(0, 4 * passWidth);
+      expandRow(header, format, row, scratch, expanded);
+      const size_t outY = pass.yStart + (y * pass.yStep);
+      for (size_t x = 0; x < passWidth; x++) {
+        const size_t outX = pass.xStart + (x * pass.xStep);
+        std::memcpy(&out[4 * ((outY * width) + outX)], &expanded[4 * x], 4);
+      }
+    }
+  }
 }
 
 } // namespace blocks::loader
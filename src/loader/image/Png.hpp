@@ -10,4 +10,14 @@ namespace blocks::loader {
 Image loadPng(const std::filesystem::path& path);
 Image loadPng(std::span<const std::byte> data);
 
+struct PngInfo {
+  size_t width;
+  size_t height;
+};
+
+PngInfo readPngInfo(std::span<const std::byte> data);
+// Decodes into out as BGRA, which must be exactly width * height * 4 bytes,
+// e.g. a mapped staging buffer
+void loadPng(std::span<const std::byte> data, std::span<std::byte> out);
+
 } // namespace blocks::loader
@@ -1,9 +1,327 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
 #include "loader/Image.hpp"
 #include "loader/image/Bitmap.hpp"
 
+namespace {
+
+void appendLittleEndian(
+    std::vector<std::byte>& out, uint32_t value, size_t size = 4) {
+  for (size_t i = 0; i < size; i++) {
+    out.emplace_back(static_cast<std::byte>(value >> (8 * i)));
+  }
+}
+
+struct BitmapFormat {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint16_t bitsPerPixel = 24;
+  uint32_t compression = 0;
+  uint32_t headerSize = 40;
+  bool isTopDown = false;
+  uint32_t alphaMask = 0;
+  std::vector<uint32_t> palette = {};
+};
+
+// pixels is the raw pixel array, already padded or compressed
+std::vector<std::byte> makeBitmap(
+    const BitmapFormat& format, const std::vector<std::byte>& pixels) {
+  std::vector<std::byte> infoHeader;
+  appendLittleEndian(infoHeader, format.headerSize);
+  appendLittleEndian(infoHeader, format.width);
+  appendLittleEndian(
+      infoHeader,
+      format.isTopDown ? static_cast<uint32_t>(-int64_t{format.height})
+                       : format.height);
+  appendLittleEndian(infoHeader, 1, 2);
+  appendLittleEndian(infoHeader, format.bitsPerPixel, 2);
+  appendLittleEndian(infoHeader, format.compression);
+  appendLittleEndian(infoHeader, static_cast<uint32_t>(pixels.size()));
+  appendLittleEndian(infoHeader, 2835);
+  appendLittleEndian(infoHeader, 2835);
+  appendLittleEndian(infoHeader, static_cast<uint32_t>(format.palette.size()));
+  appendLittleEndian(infoHeader, 0);
+  if (format.compression == 3) {
+    for (const uint32_t mask : {0x00ff0000u, 0x0000ff00u, 0x000000ffu}) {
+      appendLittleEndian(infoHeader, mask);
+    }
+    if (format.headerSize >= 56) {
+      appendLittleEndian(infoHeader, format.alphaMask);
+    }
+  }
+  infoHeader.resize(std::max<size_t>(infoHeader.size(), format.headerSize));
+  for (const uint32_t color : format.palette) {
+    appendLittleEndian(infoHeader, color);
+  }
+
+  const size_t pixelOffset = 14 + infoHeader.size();
+  std::vector<std::byte> result{std::byte{'B'}, std::byte{'M'}};
+  appendLittleEndian(
+      result, static_cast<uint32_t>(pixelOffset + pixels.size()));
+  appendLittleEndian(result, 0);
+  appendLittleEndian(result, static_cast<uint32_t>(pixelOffset));
+  result.insert(result.end(), infoHeader.begin(), infoHeader.end());
+  result.insert(result.end(), pixels.begin(), pixels.end());
+  return result;
+}
+
+uint8_t sampleValue(size_t x, size_t y, size_t c) {
+  return static_cast<uint8_t>((x * 37) + (y * 101) + (c * 59) + 11);
+}
+
+// Rows of samples, bottom first as the file stores them
+std::vector<std::byte> makePixels(
+    size_t width, size_t height, size_t bytesPerPixel) {
+  const size_t rowSize = ((width * bytesPerPixel + 3) / 4) * 4;
+  std::vector<std::byte> result(rowSize * height);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      for (size_t c = 0; c < bytesPerPixel; c++) {
+        result[(y * rowSize) + (x * bytesPerPixel) + c] =
+            static_cast<std::byte>(sampleValue(x, y, c));
+      }
+    }
+  }
+  return result;
+}
+
+// The output is top first with every row mirrored
+std::array<uint8_t, 4> getOutputPixel(
+    const blocks::loader::Image& image, size_t fileX, size_t fileY) {
+  const size_t x = image.width - 1 - fileX;
+  const size_t y = image.height - 1 - fileY;
+  std::array<uint8_t, 4> result{};
+  for (size_t c = 0; c < 4; c++) {
+    result[c] = static_cast<uint8_t>(
+        image.pixelData[(((y * image.width) + x) * 4) + c]);
+  }
+  return result;
+}
+
+void expectTruecolor(const BitmapFormat& format, bool hasAlpha) {
+  const size_t bytesPerPixel = format.bitsPerPixel / 8;
+  const blocks::loader::Image image = blocks::loader::loadBitmap(makeBitmap(
+      format, makePixels(format.width, format.height, bytesPerPixel)));
+  ASSERT_EQ(format.width, image.width);
+  ASSERT_EQ(format.height, image.height);
+
+  for (size_t y = 0; y < format.height; y++) {
+    const size_t fileY = format.isTopDown ? format.height - 1 - y : y;
+    for (size_t x = 0; x < format.width; x++) {
+      const std::array<uint8_t, 4> expected{
+          sampleValue(x, y, 0),
+          sampleValue(x, y, 1),
+          sampleValue(x, y, 2),
+          hasAlpha ? sampleValue(x, y, 3) : uint8_t{0xff}};
+      EXPECT_EQ(expected, getOutputPixel(image, x, fileY))
+          << "at " << x << ", " << y;
+    }
+  }
+}
+
+std::vector<uint32_t> makePalette(size_t size) {
+  std::vector<uint32_t> palette;
+  for (size_t i = 0; i < size; i++) {
+    palette.emplace_back(static_cast<uint32_t>(i * 0x010305));
+  }
+  return palette;
+}
+
+std::array<uint8_t, 4> getPaletteColor(
+    const std::vector<uint32_t>& palette, size_t index) {
+  const uint32_t color = palette[index];
+  return {
+      static_cast<uint8_t>(color),
+      static_cast<uint8_t>(color >> 8),
+      static_cast<uint8_t>(color >> 16),
+      0xff};
+}
+
+std::vector<std::byte> toBytes(std::initializer_list<uint8_t> values) {
+  std::vector<std::byte> result;
+  for (const uint8_t value : values) {
+    result.emplace_back(static_cast<std::byte>(value));
+  }
+  return result;
+}
+
+} // namespace
+
 TEST(BitmapTest, HeaderLoad) {
   const blocks::loader::Image result =
       blocks::loader::loadBitmap(RESOURCE_DIR "/test_image.bmp");
 }
+
+TEST(BitmapTest, Bgr24) {
+  for (const uint32_t width : {1u, 3u, 4u, 5u, 8u, 13u, 34u}) {
+    expectTruecolor(
+        BitmapFormat{.width = width, .height = 3, .bitsPerPixel = 24}, false);
+  }
+}
+
+TEST(BitmapTest, Bgrx32) {
+  expectTruecolor(
+      BitmapFormat{.width = 11, .height = 4, .bitsPerPixel = 32}, false);
+  expectTruecolor(
+      BitmapFormat{
+          .width = 11,
+          .height = 4,
+          .bitsPerPixel = 32,
+          .compression = 3},
+      false);
+}
+
+TEST(BitmapTest, Bgra32) {
+  for (const uint32_t headerSize : {56u, 108u, 124u}) {
+    expectTruecolor(
+        BitmapFormat{
+            .width = 11,
+            .height = 4,
+            .bitsPerPixel = 32,
+            .compression = 3,
+            .headerSize = headerSize,
+            .alphaMask = 0xff000000},
+        true);
+  }
+}
+
+TEST(BitmapTest, TopDown) {
+  expectTruecolor(
+      BitmapFormat{
+          .width = 9, .height = 5, .bitsPerPixel = 24, .isTopDown = true},
+      false);
+}
+
+TEST(BitmapTest, Palette8) {
+  const BitmapFormat format{
+      .width = 19,
+      .height = 3,
+      .bitsPerPixel = 8,
+      .palette = makePalette(256)};
+  const blocks::loader::Image image =
+      blocks::loader::loadBitmap(makeBitmap(format, makePixels(19, 3, 1)));
+
+  for (size_t y = 0; y < 3; y++) {
+    for (size_t x = 0; x < 19; x++) {
+      EXPECT_EQ(
+          getPaletteColor(format.palette, sampleValue(x, y, 0)),
+          getOutputPixel(image, x, y))
+          << "at " << x << ", " << y;
+    }
+  }
+}
+
+TEST(BitmapTest, Rle8) {
+  const BitmapFormat format{
+      .width = 8,
+      .height = 3,
+      .bitsPerPixel = 8,
+      .compression = 1,
+      .palette = makePalette(8)};
+  const auto image = blocks::loader::loadBitmap(makeBitmap(
+      format,
+      toBytes(
+          {// A run of 4, then 3 absolute pixels padded to 4 bytes
+           4, 1, 0, 3, 5, 6, 7, 0,
+           // End of the row, then skip 2 along and one up
+           0, 0, 0, 2, 2, 1,
+           // A run of 2, then the end of the bitmap
+           2, 3, 0, 1})));
+
+  // Skipped pixels are left transparent
+  const std::array<uint8_t, 4> transparent{};
+  const std::array<std::array<int, 8>, 3> expected{{
+      {1, 1, 1, 1, 5, 6, 7, -1},
+      {-1, -1, -1, -1, -1, -1, -1, -1},
+      {-1, -1, 3, 3, -1, -1, -1, -1},
+  }};
+  for (size_t y = 0; y < 3; y++) {
+    for (size_t x = 0; x < 8; x++) {
+      const int index = expected[y][x];
+      EXPECT_EQ(
+          index < 0 ? transparent : getPaletteColor(format.palette, index),
+          getOutputPixel(image, x, y))
+          << "at " << x << ", " << y;
+    }
+  }
+}
+
+TEST(BitmapTest, Rle4) {
+  const BitmapFormat format{
+      .width = 5,
+      .height = 2,
+      .bitsPerPixel = 4,
+      .compression = 2,
+      .palette = makePalette(16)};
+  const auto image = blocks::loader::loadBitmap(makeBitmap(
+      format,
+      toBytes(
+          {// A run of 2 alternating 1 and 2, then 3 absolute pixels
+           2, 0x12, 0, 3, 0x13, 0x40,
+           // The next row is 5 absolute pixels, padded to 4 bytes
+           0, 0, 0, 5, 0x56, 0x78, 0x90, 0,
+           // End of the bitmap
+           0, 1})));
+
+  const std::array<std::array<int, 5>, 2> expected{{
+      {1, 2, 1, 3, 4},
+      {5, 6, 7, 8, 9},
+  }};
+  for (size_t y = 0; y < 2; y++) {
+    for (size_t x = 0; x < 5; x++) {
+      EXPECT_EQ(
+          getPaletteColor(format.palette, expected[y][x]),
+          getOutputPixel(image, x, y))
+          << "at " << x << ", " << y;
+    }
+  }
+}
+
+TEST(BitmapTest, LoadIntoBuffer) {
+  const auto bitmap = makeBitmap(
+      BitmapFormat{.width = 7, .height = 5}, makePixels(7, 5, 3));
+
+  const blocks::loader::BitmapInfo info =
+      blocks::loader::readBitmapInfo(bitmap);
+  EXPECT_EQ(7, info.width);
+  EXPECT_EQ(5, info.height);
+
+  std::vector<std::byte> buffer(info.width * info.height * 4);
+  blocks::loader::loadBitmap(bitmap, buffer);
+  EXPECT_EQ(blocks::loader::loadBitmap(bitmap).pixelData, buffer);
+
+  buffer.resize(buffer.size() - 1);
+  EXPECT_THROW(blocks::loader::loadBitmap(bitmap, buffer), std::runtime_error);
+}
+
+TEST(BitmapTest, RejectsInvalidFiles) {
+  auto truncated = makeBitmap(
+      BitmapFormat{.width = 7, .height = 5}, makePixels(7, 5, 3));
+  truncated.resize(truncated.size() - 1);
+  EXPECT_THROW(blocks::loader::loadBitmap(truncated), std::runtime_error);
+
+  EXPECT_THROW(
+      blocks::loader::loadBitmap(makeBitmap(
+          BitmapFormat{.width = 4, .height = 4, .bitsPerPixel = 16},
+          makePixels(4, 4, 2))),
+      std::runtime_error);
+
+  // Runs past the end of a row
+  EXPECT_THROW(
+      blocks::loader::loadBitmap(makeBitmap(
+          BitmapFormat{
+              .width = 2,
+              .height = 1,
+              .bitsPerPixel = 8,
+              .compression = 1,
+              .palette = makePalette(2)},
+          toBytes({3, 1, 0, 1}))),
+      std::runtime_error);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "loader/image/Bitmap.hpp"
+
+namespace {
+
+constexpr uint32_t kWidth = 3840;
+constexpr uint32_t kHeight = 2160;
+constexpr int kIterations = 20;
+
+void appendLittleEndian(
+    std::vector<std::byte>& out, uint32_t value, size_t size = 4) {
+  for (size_t i = 0; i < size; i++) {
+    out.emplace_back(static_cast<std::byte>(value >> (8 * i)));
+  }
+}
+
+// A bottom up 4K bitmap with a full palette when it is indexed
+std::vector<std::byte> makeBitmap(uint16_t bitsPerPixel) {
+  const size_t paletteSize = bitsPerPixel == 8 ? 256 : 0;
+  const size_t rowSize = ((kWidth * bitsPerPixel + 31) / 32) * 4;
+  const size_t pixelOffset = 14 + 40 + (paletteSize * 4);
+  const size_t fileSize = pixelOffset + (rowSize * kHeight);
+
+  std::vector<std::byte> result{std::byte{'B'}, std::byte{'M'}};
+  result.reserve(fileSize);
+  appendLittleEndian(result, static_cast<uint32_t>(fileSize));
+  appendLittleEndian(result, 0);
+  appendLittleEndian(result, static_cast<uint32_t>(pixelOffset));
+  appendLittleEndian(result, 40);
+  appendLittleEndian(result, kWidth);
+  appendLittleEndian(result, kHeight);
+  appendLittleEndian(result, 1, 2);
+  appendLittleEndian(result, bitsPerPixel, 2);
+  for (int i = 0; i < 6; i++) {
+    appendLittleEndian(result, 0);
+  }
+  for (size_t i = 0; i < paletteSize; i++) {
+    appendLittleEndian(result, static_cast<uint32_t>(i * 0x010305));
+  }
+  for (size_t i = pixelOffset; i < fileSize; i++) {
+    result.emplace_back(static_cast<std::byte>((i * 37) ^ (i >> 11)));
+  }
+  return result;
+}
+
+void runBenchmark(std::string_view name, uint16_t bitsPerPixel) {
+  const std::vector<std::byte> bitmap = makeBitmap(bitsPerPixel);
+  std::vector<std::byte> output(4ull * kWidth * kHeight);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    blocks::loader::loadBitmap(bitmap, output);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  const double megapixels =
+      static_cast<double>(kWidth) * kHeight * kIterations / 1e6;
+  std::cout << name << ": " << elapsed.count() * 1000.0 / kIterations
+            << " ms per image, " << megapixels / elapsed.count()
+            << " megapixels/s\n";
+}
+
+} // namespace
+
+TEST(BitmapBenchmark, Bgr24) {
+  runBenchmark("24 bit", 24);
+}
+
+TEST(BitmapBenchmark, Bgrx32) {
+  runBenchmark("32 bit", 32);
+}
+
+TEST(BitmapBenchmark, Palette8) {
+  runBenchmark("8 bit palette", 8);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+#include "loader/image/BlockCompression.hpp"
+
+namespace {
+
+using blocks::loader::CompressedFormat;
+
+using Pixel = std::array<int, 4>;
+
+Pixel fromRgb565(uint16_t color) {
+  const int r = (color >> 11) & 31;
+  const int g = (color >> 5) & 63;
+  const int b = color & 31;
+  return {(b << 3) | (b >> 2), (g << 2) | (g >> 4), (r << 3) | (r >> 2), 255};
+}
+
+// Reference decoder, for four colour mode blocks only
+Pixel decodeColor(std::span<const std::byte> block, size_t index) {
+  uint64_t bits = 0;
+  std::memcpy(&bits, block.data(), 8);
+  const auto color0 = static_cast<uint16_t>(bits);
+  const auto color1 = static_cast<uint16_t>(bits >> 16);
+  const Pixel endpoint0 = fromRgb565(color0);
+  const Pixel endpoint1 = fromRgb565(color1);
+  const auto selector = (bits >> (32 + (2 * index))) & 3;
+
+  Pixel result = endpoint0;
+  for (size_t c = 0; c < 3; c++) {
+    switch (selector) {
+      case 1:
+        result[c] = endpoint1[c];
+        break;
+      case 2:
+        result[c] = ((2 * endpoint0[c]) + endpoint1[c]) / 3;
+        break;
+      case 3:
+        result[c] = (endpoint0[c] + (2 * endpoint1[c])) / 3;
+        break;
+      default:
+        break;
+    }
+  }
+  return result;
+}
+
+int decodeAlpha(std::span<const std::byte> block, size_t index) {
+  uint64_t bits = 0;
+  std::memcpy(&bits, block.data(), 8);
+  const int alpha0 = static_cast<int>(bits & 0xff);
+  const int alpha1 = static_cast<int>((bits >> 8) & 0xff);
+  const auto selector = static_cast<int>((bits >> (16 + (3 * index))) & 7);
+  if (selector <= 1) {
+    return selector == 0 ? alpha0 : alpha1;
+  }
+  if (alpha0 > alpha1) {
+    return (((8 - selector) * alpha0) + ((selector - 1) * alpha1)) / 7;
+  }
+  return (((6 - selector) * alpha0) + ((selector - 1) * alpha1)) / 5;
+}
+
+// Each block's colours lie on a line, which BC1 can represent closely
+blocks::loader::Image makeGradient(size_t width, size_t height) {
+  blocks::loader::Image image{
+      .width = width, .height = height, .pixelData = {}};
+  image.pixelData.resize(width * height * 4);
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      const size_t offset = ((y * width) + x) * 4;
+      image.pixelData[offset] = static_cast<std::byte>((x + y) * 8);
+      image.pixelData[offset + 1] = static_cast<std::byte>(250 - ((x + y) * 6));
+      image.pixelData[offset + 2] = static_cast<std::byte>(128);
+      image.pixelData[offset + 3] = static_cast<std::byte>((x + y) * 6);
+    }
+  }
+  return image;
+}
+
+void expectCloseToSource(
+    const blocks::loader::Image& image,
+    const blocks::loader::CompressedImage& compressed,
+    int tolerance) {
+  const size_t blockSize = blocks::loader::getBlockSize(compressed.format);
+  const size_t blocksX = (image.width + 3) / 4;
+  for (size_t y = 0; y < image.height; y++) {
+    for (size_t x = 0; x < image.width; x++) {
+      const auto block = std::span{compressed.data}.subspan(
+          (((y / 4) * blocksX) + (x / 4)) * blockSize, blockSize);
+      const size_t index = ((y % 4) * 4) + (x % 4);
+      const bool hasAlpha = compressed.format == CompressedFormat::BC3;
+      const Pixel decoded =
+          decodeColor(hasAlpha ? block.subspan(8) : block, index);
+      const auto* source = &image.pixelData[((y * image.width) + x) * 4];
+      for (size_t c = 0; c < 3; c++) {
+        EXPECT_NEAR(static_cast<int>(source[c]), decoded[c], tolerance);
+      }
+      if (hasAlpha) {
+        EXPECT_NEAR(
+            static_cast<int>(source[3]), decodeAlpha(block, index), tolerance);
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST(BlockCompressionTest, MipChain) {
+  const auto image = makeGradient(13, 10);
+  const auto compressed =
+      blocks::loader::compressImage(image, CompressedFormat::BC1);
+  EXPECT_EQ(CompressedFormat::BC1, compressed.format);
+  EXPECT_EQ(13, compressed.width);
+  EXPECT_EQ(10, compressed.height);
+
+  // 13x10, 6x5, 3x2, 1x1
+  const std::array<size_t, 4> expectedBlocks{12, 4, 1, 1};
+  ASSERT_EQ(expectedBlocks.size(), compressed.mipLevels.size());
+  size_t offset = 0;
+  for (size_t i = 0; i < expectedBlocks.size(); i++) {
+    EXPECT_EQ(offset, compressed.mipLevels[i].offset);
+    EXPECT_EQ(expectedBlocks[i] * 8, compressed.mipLevels[i].size);
+    offset += compressed.mipLevels[i].size;
+  }
+  EXPECT_EQ(offset, compressed.data.size());
+}
+
+TEST(BlockCompressionTest, Bc1) {
+  const auto image = makeGradient(16, 12);
+  expectCloseToSource(
+      image, blocks::loader::compressImage(image, CompressedFormat::BC1), 10);
+}
+
+TEST(BlockCompressionTest, Bc3) {
+  const auto image = makeGradient(13, 10);
+  expectCloseToSource(
+      image, blocks::loader::compressImage(image, CompressedFormat::BC3), 10);
+}
+
+TEST(BlockCompressionTest, SolidColor) {
+  blocks::loader::Image image{.width = 4, .height = 4, .pixelData = {}};
+  for (size_t i = 0; i < 16; i++) {
+    for (const int value : {40, 200, 120, 255}) {
+      image.pixelData.emplace_back(static_cast<std::byte>(value));
+    }
+  }
+  expectCloseToSource(
+      image, blocks::loader::compressImage(image, CompressedFormat::BC3), 4);
+}
+
+TEST(BlockCompressionTest, UnsupportedFormat) {
+  EXPECT_THROW(
+      blocks::loader::compressImage(makeGradient(4, 4), CompressedFormat::BC7),
+      std::runtime_error);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "loader/CompressedImage.hpp"
+#include "loader/image/Ktx2.hpp"
+
+namespace {
+
+using blocks::loader::CompressedFormat;
+using blocks::loader::CompressedImage;
+
+CompressedImage makeImage(
+    CompressedFormat format, size_t width, size_t height) {
+  CompressedImage result{
+      .format = format,
+      .width = width,
+      .height = height,
+      .mipLevels = {},
+      .data = {}};
+  for (size_t level = 0; (width >> level) > 0 || (height >> level) > 0;
+       level++) {
+    const size_t size = blocks::loader::getCompressedSize(
+        format,
+        std::max<size_t>(width >> level, 1),
+        std::max<size_t>(height >> level, 1));
+    result.mipLevels.emplace_back(result.data.size(), size);
+    for (size_t i = 0; i < size; i++) {
+      result.data.emplace_back(static_cast<std::byte>((i * 31) + level));
+    }
+  }
+  return result;
+}
+
+uint32_t readUint32(const std::vector<std::byte>& data, size_t offset) {
+  uint32_t result = 0;
+  std::memcpy(&result, &data[offset], sizeof(result));
+  return result;
+}
+
+void writeUint32(std::vector<std::byte>& data, size_t offset, uint32_t value) {
+  std::memcpy(&data[offset], &value, sizeof(value));
+}
+
+} // namespace
+
+TEST(Ktx2Test, RoundTrip) {
+  for (const auto format :
+       {CompressedFormat::BC1, CompressedFormat::BC3, CompressedFormat::BC7}) {
+    const CompressedImage image = makeImage(format, 13, 10);
+    ASSERT_EQ(4, image.mipLevels.size());
+
+    const auto file = blocks::loader::writeKtx2(image);
+    const CompressedImage result = blocks::loader::loadKtx2(file);
+    EXPECT_EQ(format, result.format);
+    EXPECT_EQ(13, result.width);
+    EXPECT_EQ(10, result.height);
+    ASSERT_EQ(image.mipLevels.size(), result.mipLevels.size());
+    for (size_t i = 0; i < image.mipLevels.size(); i++) {
+      EXPECT_EQ(image.mipLevels[i].size, result.mipLevels[i].size);
+    }
+    EXPECT_EQ(image.data, result.data);
+
+    // Level data in the file is aligned to whole blocks
+    for (size_t i = 0; i < image.mipLevels.size(); i++) {
+      EXPECT_EQ(
+          0,
+          readUint32(file, 80 + (i * 24)) %
+              blocks::loader::getBlockSize(format));
+    }
+  }
+}
+
+TEST(Ktx2Test, RejectsInvalidFiles) {
+  const auto file =
+      blocks::loader::writeKtx2(makeImage(CompressedFormat::BC1, 8, 8));
+
+  auto badIdentifier = file;
+  badIdentifier[1] = std::byte{'X'};
+  EXPECT_THROW(blocks::loader::loadKtx2(badIdentifier), std::runtime_error);
+
+  auto truncated = file;
+  truncated.resize(truncated.size() - 1);
+  EXPECT_THROW(blocks::loader::loadKtx2(truncated), std::runtime_error);
+
+  // R8G8B8A8_SRGB
+  auto uncompressed = file;
+  writeUint32(uncompressed, 12, 43);
+  EXPECT_THROW(blocks::loader::loadKtx2(uncompressed), std::runtime_error);
+
+  auto zeroWidth = file;
+  writeUint32(zeroWidth, 20, 0);
+  EXPECT_THROW(blocks::loader::loadKtx2(zeroWidth), std::runtime_error);
+
+  auto supercompressed = file;
+  writeUint32(supercompressed, 44, 2);
+  EXPECT_THROW(blocks::loader::loadKtx2(supercompressed), std::runtime_error);
+
+  auto tooManyLevels = file;
+  writeUint32(tooManyLevels, 40, 5);
+  EXPECT_THROW(blocks::loader::loadKtx2(tooManyLevels), std::runtime_error);
+}
@@ -1,10 +1,454 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <filesystem>
+#include <initializer_list>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include "loader/Image.hpp"
 #include "loader/image/Png.hpp"
 
+namespace {
+
+uint32_t crc32(std::span<const std::byte> data) {
+  uint32_t crc = 0xffffffff;
+  for (const std::byte b : data) {
+    crc ^= static_cast<uint32_t>(b);
+    for (int k = 0; k < 8; k++) {
+      crc = (crc & 1) != 0 ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+    }
+  }
+  return crc ^ 0xffffffff;
+}
+
+void appendBigEndian(std::vector<std::byte>& out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.emplace_back(static_cast<std::byte>(value >> shift));
+  }
+}
+
+void appendChunk(
+    std::vector<std::byte>& out,
+    std::string_view type,
+    std::span<const std::byte> data) {
+  appendBigEndian(out, static_cast<uint32_t>(data.size()));
+  const size_t typeStart = out.size();
+  for (const char c : type) {
+    out.emplace_back(static_cast<std::byte>(c));
+  }
+  out.insert(out.end(), data.begin(), data.end());
+  appendBigEndian(
+      out, crc32(std::span{out}.subspan(typeStart, data.size() + 4)));
+}
+
+// A zlib stream of stored blocks, so the test needs no compressor
+std::vector<std::byte> zlibStore(std::span<const std::byte> data) {
+  std::vector<std::byte> result{std::byte{0x78}, std::byte{0x01}};
+  size_t offset = 0;
+  do {
+    const size_t length = std::min<size_t>(data.size() - offset, 0xffff);
+    const bool isFinal = offset + length == data.size();
+    result.emplace_back(static_cast<std::byte>(isFinal ? 1 : 0));
+    for (const size_t value : {length, ~length}) {
+      result.emplace_back(static_cast<std::byte>(value & 0xff));
+      result.emplace_back(static_cast<std::byte>((value >> 8) & 0xff));
+    }
+    const auto block = data.subspan(offset, length);
+    result.insert(result.end(), block.begin(), block.end());
+    offset += length;
+  } while (offset < data.size());
+  return result;
+}
+
+uint8_t paethPredictor(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return static_cast<uint8_t>(a);
+  }
+  return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+struct PngFormat {
+  uint32_t width;
+  uint32_t height;
+  uint8_t colorType;
+  uint8_t bitDepth;
+  bool interlaced = false;
+  // Raw PLTE and tRNS chunk contents, left out when empty
+  std::vector<std::byte> palette = {};
+  std::vector<std::byte> transparency = {};
+};
+
+size_t channelCount(uint8_t colorType) {
+  constexpr std::array<size_t, 7> kChannels{1, 0, 3, 1, 2, 0, 4};
+  return kChannels[colorType];
+}
+
+struct Pass {
+  size_t xStart;
+  size_t yStart;
+  size_t xStep;
+  size_t yStep;
+};
+
+constexpr std::array<Pass, 7> kAdam7Passes{
+    {{0, 0, 8, 8},
+     {4, 0, 8, 8},
+     {0, 4, 4, 8},
+     {2, 0, 4, 4},
+     {0, 2, 2, 4},
+     {1, 0, 2, 2},
+     {0, 1, 1, 2}}};
+
+// Packs and filters one (sub)image, with row y filtered with type y % 5
+void appendFilteredImage(
+    const PngFormat& format,
+    std::span<const uint16_t> samples,
+    const Pass& pass,
+    std::vector<std::byte>& out) {
+  const size_t channels = channelCount(format.colorType);
+  const size_t width = format.width > pass.xStart
+      ? (format.width - pass.xStart + pass.xStep - 1) / pass.xStep
+      : 0;
+  const size_t height = format.height > pass.yStart
+      ? (format.height - pass.yStart + pass.yStep - 1) / pass.yStep
+      : 0;
+  if (width == 0) {
+    return;
+  }
+
+  const size_t rowSize = ((width * channels * format.bitDepth) + 7) / 8;
+  const size_t pixelSize =
+      std::max<size_t>(1, channels * format.bitDepth / 8);
+  std::vector<uint8_t> prior(rowSize);
+  for (size_t y = 0; y < height; y++) {
+    std::vector<uint8_t> row(rowSize);
+    size_t bit = 0;
+    for (size_t x = 0; x < width; x++) {
+      const size_t imageX = pass.xStart + (x * pass.xStep);
+      const size_t imageY = pass.yStart + (y * pass.yStep);
+      for (size_t c = 0; c < channels; c++) {
+        const uint16_t sample =
+            samples[(((imageY * format.width) + imageX) * channels) + c];
+        if (format.bitDepth == 16) {
+          row[bit / 8] = static_cast<uint8_t>(sample >> 8);
+          row[(bit / 8) + 1] = static_cast<uint8_t>(sample);
+        } else {
+          row[bit / 8] |= static_cast<uint8_t>(
+              sample << (8 - format.bitDepth - (bit % 8)));
+        }
+        bit += format.bitDepth;
+      }
+    }
+
+    const uint8_t filter = y % 5;
+    out.emplace_back(static_cast<std::byte>(filter));
+    for (size_t i = 0; i < rowSize; i++) {
+      const int a = i >= pixelSize ? row[i - pixelSize] : 0;
+      const int b = prior[i];
+      const int c = i >= pixelSize ? prior[i - pixelSize] : 0;
+      const std::array<int, 5> predictors{
+          0, a, b, (a + b) / 2, paethPredictor(a, b, c)};
+      out.emplace_back(static_cast<std::byte>(row[i] - predictors[filter]));
+    }
+    prior = std::move(row);
+  }
+}
+
+std::vector<std::byte> makePng(
+    const PngFormat& format, std::span<const uint16_t> samples) {
+  std::vector<std::byte> filtered;
+  if (format.interlaced) {
+    for (const Pass& pass : kAdam7Passes) {
+      appendFilteredImage(format, samples, pass, filtered);
+    }
+  } else {
+    appendFilteredImage(format, samples, Pass{0, 0, 1, 1}, filtered);
+  }
+
+  std::vector<std::byte> header;
+  appendBigEndian(header, format.width);
+  appendBigEndian(header, format.height);
+  header.emplace_back(static_cast<std::byte>(format.bitDepth));
+  header.emplace_back(static_cast<std::byte>(format.colorType));
+  header.resize(header.size() + 2);
+  header.emplace_back(static_cast<std::byte>(format.interlaced ? 1 : 0));
+
+  std::vector<std::byte> result{
+      std::byte{137},
+      std::byte{80},
+      std::byte{78},
+      std::byte{71},
+      std::byte{13},
+      std::byte{10},
+      std::byte{26},
+      std::byte{10}};
+  appendChunk(result, "IHDR", header);
+  if (!format.palette.empty()) {
+    appendChunk(result, "PLTE", format.palette);
+  }
+  if (!format.transparency.empty()) {
+    appendChunk(result, "tRNS", format.transparency);
+  }
+  // Split the image data across two chunks
+  const auto compressed = zlibStore(filtered);
+  const auto split = std::span{compressed}.subspan(0, compressed.size() / 2);
+  appendChunk(result, "IDAT", split);
+  appendChunk(
+      result, "IDAT", std::span{compressed}.subspan(compressed.size() / 2));
+  appendChunk(result, "IEND", {});
+  return result;
+}
+
+std::vector<uint16_t> makeSamples(size_t count, uint8_t bitDepth) {
+  std::vector<uint16_t> result(count);
+  uint32_t state = 12345;
+  for (auto& value : result) {
+    state = (state * 1103515245) + 12345;
+    value = static_cast<uint16_t>((state >> 8) & ((1u << bitDepth) - 1));
+  }
+  return result;
+}
+
+uint8_t toByte(uint16_t sample, uint8_t bitDepth) {
+  if (bitDepth == 16) {
+    return static_cast<uint8_t>(sample >> 8);
+  }
+  return static_cast<uint8_t>(sample * 255 / ((1 << bitDepth) - 1));
+}
+
+uint16_t readTransparency(const PngFormat& format, size_t channel) {
+  return static_cast<uint16_t>(
+      (static_cast<uint16_t>(format.transparency[channel * 2]) << 8) |
+      static_cast<uint16_t>(format.transparency[(channel * 2) + 1]));
+}
+
+// The BGRA pixel the decoder should produce
+std::array<uint8_t, 4> expectedPixel(
+    const PngFormat& format, std::span<const uint16_t> pixel) {
+  const uint8_t depth = format.bitDepth;
+  switch (format.colorType) {
+    case 0: {
+      const uint8_t grey = toByte(pixel[0], depth);
+      const bool transparent = !format.transparency.empty() &&
+          pixel[0] == readTransparency(format, 0);
+      return {grey, grey, grey, static_cast<uint8_t>(transparent ? 0 : 255)};
+    }
+    case 2: {
+      const bool transparent = !format.transparency.empty() &&
+          pixel[0] == readTransparency(format, 0) &&
+          pixel[1] == readTransparency(format, 1) &&
+          pixel[2] == readTransparency(format, 2);
+      return {
+          toByte(pixel[2], depth),
+          toByte(pixel[1], depth),
+          toByte(pixel[0], depth),
+          static_cast<uint8_t>(transparent ? 0 : 255)};
+    }
+    case 3: {
+      const size_t index = pixel[0];
+      if (index * 3 >= format.palette.size()) {
+        return {0, 0, 0, 255};
+      }
+      return {
+          static_cast<uint8_t>(format.palette[(index * 3) + 2]),
+          static_cast<uint8_t>(format.palette[(index * 3) + 1]),
+          static_cast<uint8_t>(format.palette[index * 3]),
+          index < format.transparency.size()
+              ? static_cast<uint8_t>(format.transparency[index])
+              : uint8_t{255}};
+    }
+    case 4: {
+      const uint8_t grey = toByte(pixel[0], depth);
+      return {grey, grey, grey, toByte(pixel[1], depth)};
+    }
+    default:
+      return {
+          toByte(pixel[2], depth),
+          toByte(pixel[1], depth),
+          toByte(pixel[0], depth),
+          toByte(pixel[3], depth)};
+  }
+}
+
+void expectDecodes(const PngFormat& format) {
+  const size_t channels = channelCount(format.colorType);
+  const size_t pixelCount = static_cast<size_t>(format.width) * format.height;
+  const auto samples = makeSamples(pixelCount * channels, format.bitDepth);
+  const auto png = makePng(format, samples);
+  const blocks::loader::Image image = blocks::loader::loadPng(png);
+
+  ASSERT_EQ(format.width, image.width);
+  ASSERT_EQ(format.height, image.height);
+  ASSERT_EQ(pixelCount * 4, image.pixelData.size());
+  for (size_t i = 0; i < pixelCount; i++) {
+    const auto expected = expectedPixel(
+        format, std::span{samples}.subspan(i * channels, channels));
+    for (size_t c = 0; c < 4; c++) {
+      EXPECT_EQ(
+          expected[c], static_cast<uint8_t>(image.pixelData[(i * 4) + c]))
+          << "pixel " << i << " channel " << c;
+    }
+  }
+}
+
+void expectDecodes(uint8_t colorType, uint8_t bitDepth) {
+  expectDecodes(PngFormat{13, 10, colorType, bitDepth});
+  expectDecodes(PngFormat{1, 5, colorType, bitDepth});
+}
+
+std::vector<std::byte> makeBytes(std::initializer_list<int> values) {
+  std::vector<std::byte> result;
+  for (const int value : values) {
+    result.emplace_back(static_cast<std::byte>(value));
+  }
+  return result;
+}
+
+// A palette with fewer entries than the bit depth allows, so some indices
+// are out of range
+std::vector<std::byte> makePalette(size_t entries) {
+  std::vector<std::byte> result;
+  for (size_t i = 0; i < entries * 3; i++) {
+    result.emplace_back(static_cast<std::byte>((i * 37) + 11));
+  }
+  return result;
+}
+
+} // namespace
+
 TEST(PngTest, HeaderLoad) {
   const blocks::loader::Image result = blocks::loader::loadPng(
       std::filesystem::path(RESOURCE_DIR "/mandelbrot set.png"));
 }
+
+TEST(PngTest, FiltersRgb) {
+  expectDecodes(2, 8);
+}
+
+TEST(PngTest, FiltersRgba) {
+  expectDecodes(6, 8);
+}
+
+TEST(PngTest, Greyscale) {
+  for (const uint8_t bitDepth : {1, 2, 4, 8, 16}) {
+    expectDecodes(0, bitDepth);
+  }
+}
+
+TEST(PngTest, GreyscaleAlpha) {
+  expectDecodes(4, 8);
+  expectDecodes(4, 16);
+}
+
+TEST(PngTest, Truecolor16) {
+  expectDecodes(2, 16);
+  expectDecodes(6, 16);
+}
+
+TEST(PngTest, Indexed) {
+  for (const uint8_t bitDepth : {1, 2, 4, 8}) {
+    const size_t entries =
+        std::clamp<size_t>((1u << bitDepth) - 1, 2, 200);
+    expectDecodes(
+        PngFormat{
+            .width = 13,
+            .height = 10,
+            .colorType = 3,
+            .bitDepth = bitDepth,
+            .palette = makePalette(entries),
+            .transparency = makeBytes({0, 128})});
+  }
+}
+
+TEST(PngTest, ColorKey) {
+  // Keys are taken from the generated samples so some pixels match
+  for (const uint8_t bitDepth : {2, 8, 16}) {
+    const uint16_t key = makeSamples(13 * 10, bitDepth)[3];
+    expectDecodes(
+        PngFormat{
+            .width = 13,
+            .height = 10,
+            .colorType = 0,
+            .bitDepth = bitDepth,
+            .transparency = makeBytes({key >> 8, key & 0xff})});
+  }
+
+  // A truecolor key has to match every channel
+  for (const uint8_t bitDepth : {8, 16}) {
+    const auto samples = makeSamples(13 * 10 * 3, bitDepth);
+    std::vector<std::byte> key;
+    for (const uint16_t sample : std::span{samples}.subspan(30, 3)) {
+      key.emplace_back(static_cast<std::byte>(sample >> 8));
+      key.emplace_back(static_cast<std::byte>(sample & 0xff));
+    }
+    expectDecodes(
+        PngFormat{
+            .width = 13,
+            .height = 10,
+            .colorType = 2,
+            .bitDepth = bitDepth,
+            .transparency = std::move(key)});
+  }
+}
+
+TEST(PngTest, Interlaced) {
+  for (const auto& [width, height] :
+       {std::pair{1u, 1u}, std::pair{3u, 2u}, std::pair{13u, 10u}}) {
+    expectDecodes(
+        PngFormat{
+            .width = width,
+            .height = height,
+            .colorType = 6,
+            .bitDepth = 8,
+            .interlaced = true});
+    expectDecodes(
+        PngFormat{
+            .width = width,
+            .height = height,
+            .colorType = 0,
+            .bitDepth = 4,
+            .interlaced = true});
+    expectDecodes(
+        PngFormat{
+            .width = width,
+            .height = height,
+            .colorType = 2,
+            .bitDepth = 16,
+            .interlaced = true});
+  }
+}
+
+TEST(PngTest, LoadIntoBuffer) {
+  const PngFormat format{
+      .width = 7, .height = 5, .colorType = 6, .bitDepth = 8};
+  const auto png = makePng(format, makeSamples(7 * 5 * 4, 8));
+
+  const blocks::loader::PngInfo info = blocks::loader::readPngInfo(png);
+  EXPECT_EQ(7, info.width);
+  EXPECT_EQ(5, info.height);
+
+  std::vector<std::byte> buffer(info.width * info.height * 4);
+  blocks::loader::loadPng(png, buffer);
+  EXPECT_EQ(blocks::loader::loadPng(png).pixelData, buffer);
+
+  buffer.resize(buffer.size() - 1);
+  EXPECT_THROW(blocks::loader::loadPng(png, buffer), std::runtime_error);
+}
+
+TEST(PngTest, IndexedRequiresPalette) {
+  const PngFormat format{
+      .width = 4, .height = 4, .colorType = 3, .bitDepth = 8};
+  const auto png = makePng(format, makeSamples(16, 8));
+  EXPECT_THROW(blocks::loader::loadPng(png), std::runtime_error);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <string>
+#include <vector>
+#include "loader/Image.hpp"
+#include "loader/ImageCache.hpp"
+
+namespace {
+
+class ImageCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+    writeSource("source image");
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  void writeSource(const std::string& contents) {
+    std::ofstream out{source_, std::ios::binary | std::ios::trunc};
+    out << contents;
+  }
+
+  static blocks::loader::Image makeImage() {
+    blocks::loader::Image image{
+        .width = 5, .height = 3, .pixelData = std::vector<std::byte>(60)};
+    for (size_t i = 0; i < image.pixelData.size(); i++) {
+      image.pixelData[i] = static_cast<std::byte>(i * 13);
+    }
+    return image;
+  }
+
+  static bool matches(
+      const blocks::loader::CachedImage& cached,
+      const blocks::loader::Image& image) {
+    return cached.width == image.width && cached.height == image.height &&
+        std::equal(
+               image.pixelData.begin(),
+               image.pixelData.end(),
+               cached.pixelData.begin(),
+               cached.pixelData.end());
+  }
+
+  std::filesystem::path directory_ =
+      std::filesystem::temp_directory_path() / "loader_test_image_cache";
+  std::filesystem::path source_ = directory_ / "source.png";
+  blocks::loader::ImageCache cache_{directory_ / "cache"};
+};
+
+} // namespace
+
+TEST_F(ImageCacheTest, RoundTrip) {
+  EXPECT_FALSE(cache_.find(source_).has_value());
+
+  const blocks::loader::Image image = makeImage();
+  cache_.store(source_, image);
+
+  const std::optional<blocks::loader::CachedImage> cached =
+      cache_.find(source_);
+  ASSERT_TRUE(cached.has_value());
+  // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+  EXPECT_TRUE(matches(*cached, image));
+
+  // Another cache over the same directory sees the entry
+  const blocks::loader::ImageCache otherCache{directory_ / "cache"};
+  EXPECT_TRUE(otherCache.find(source_).has_value());
+}
+
+TEST_F(ImageCacheTest, TouchedSourceStillHits) {
+  const blocks::loader::Image image = makeImage();
+  cache_.store(source_, image);
+
+  std::filesystem::last_write_time(
+      source_,
+      std::filesystem::last_write_time(source_) + std::chrono::hours{1});
+
+  const std::optional<blocks::loader::CachedImage> cached =
+      cache_.find(source_);
+  ASSERT_TRUE(cached.has_value());
+  // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+  EXPECT_TRUE(matches(*cached, image));
+}
+
+TEST_F(ImageCacheTest, TouchedSourceIsOnlyHashedOnce) {
+  const blocks::loader::Image image = makeImage();
+  cache_.store(source_, image);
+
+  const auto touchedTime =
+      std::filesystem::last_write_time(source_) + std::chrono::hours{1};
+  std::filesystem::last_write_time(source_, touchedTime);
+  ASSERT_TRUE(cache_.find(source_).has_value());
+
+  // Edit the source but keep its size and time, which only a hash would notice
+  writeSource("source imagf");
+  std::filesystem::last_write_time(source_, touchedTime);
+  const std::optional<blocks::loader::CachedImage> cached =
+      cache_.find(source_);
+  ASSERT_TRUE(cached.has_value());
+  // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+  EXPECT_TRUE(matches(*cached, image));
+}
+
+TEST_F(ImageCacheTest, EditedSourceMisses) {
+  cache_.store(source_, makeImage());
+
+  // The same size, so only the hash can tell
+  writeSource("source imagf");
+  std::filesystem::last_write_time(
+      source_,
+      std::filesystem::last_write_time(source_) + std::chrono::hours{1});
+  EXPECT_FALSE(cache_.find(source_).has_value());
+
+  writeSource("a different source image");
+  EXPECT_FALSE(cache_.find(source_).has_value());
+}
+
+TEST_F(ImageCacheTest, CorruptEntryMisses) {
+  cache_.store(source_, makeImage());
+
+  for (const auto& entry :
+       std::filesystem::directory_iterator{directory_ / "cache"}) {
+    std::filesystem::resize_file(entry.path(), 100);
+  }
+  EXPECT_FALSE(cache_.find(source_).has_value());
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace blocks::render {
+
+// Hands out the slots of a bindless array which has a copy for each frame in
+// flight. Writes are queued for every copy and taken as each frame begins.
+// Freeing a slot drops its queued writes, as whatever they refer to may be
+// destroyed before they would have been applied.
+template <typename TValue>
+class BindlessSlots {
+ public:
+  struct Write {
+    uint32_t index;
+    TValue value;
+  };
+
+  BindlessSlots(uint32_t capacity, int framesInFlight)
+      : capacity_(capacity), pendingWrites_(framesInFlight) {}
+
+  // Freed slots are handed out again before any new ones
+  uint32_t allocate() {
+    if (!freeIndices_.empty()) {
+      const uint32_t index = freeIndices_.back();
+      freeIndices_.pop_back();
+      return index;
+    }
+    if (size_ < capacity_) {
+      return size_++;
+    }
+    throw std::runtime_error{"Bindless array is full"};
+  }
+
+  void write(uint32_t index, const TValue& value) {
+    for (auto& writes : pendingWrites_) {
+      // Only the latest write to a slot matters
+      auto it = std::find_if(
+          writes.begin(), writes.end(), [&](const Write& existing) {
+            return existing.index == index;
+          });
+      if (it != writes.end()) {
+        it->value = value;
+      } else {
+        writes.emplace_back(index, value);
+      }
+    }
+  }
+
+  void free(uint32_t index) {
+    for (auto& writes : pendingWrites_) {
+      std::erase_if(
+          writes, [&](const Write& write) { return write.index == index; });
+    }
+    freeIndices_.emplace_back(index);
+  }
+
+  // The writes still to be applied to the frame's copy, which are then
+  // considered applied
+  std::vector<Write> takeWrites(uint32_t frame) {
+    return std::exchange(pendingWrites_[frame], {});
+  }
+
+ private:
+  uint32_t capacity_;
+  uint32_t size_ = 0;
+  std::vector<uint32_t> freeIndices_;
+  // Indexed by frame in flight
+  std::vector<std::vector<Write>> pendingWrites_;
+};
+
+} // namespace blocks::render
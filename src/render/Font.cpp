@@ -1,24 +1,30 @@
 #include "render/Font.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
+#include <numeric>
 #include <optional>
-#include <span>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
 #include <vulkan/vulkan_core.h>
-#include "GlobalSubSystemStack.hpp"
 #include "loader/font/Font.hpp"
 #include "math/vec.hpp"
+#include "render/GlyphAtlas.hpp"
+#include "render/GlyphOutlines.hpp"
 #include "render/RenderSubSystem.hpp"
 #include "render/Simple2DCamera.hpp"
-#include "render/VulkanBuffer.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanTexture.hpp"
+#include "render/VulkanUploadManager.hpp"
 #include "render/renderables/RenderableFont.hpp"
+#include "render/renderables/RenderableFontAtlas.hpp"
 #include "util/Generator.hpp"
 #include "util/debug.hpp"
 #include "util/unicode.hpp"
@@ -27,126 +33,35 @@ namespace blocks::render {
 
 namespace {
 
-struct GlyphPoint {
-  math::Vec<int32_t, 2> point;
-  uint32_t onCurve;
-  uint32_t contourEnd;
-};
-
-util::Generator<std::pair<size_t, size_t>> contourRanges(
-    std::span<const uint16_t> endPoints) {
-  co_yield std::pair<size_t, size_t>{0, endPoints[0]};
-  for (size_t i = 1; i < endPoints.size(); i++) {
-    co_yield std::pair<size_t, size_t>{endPoints[i - 1] + 1, endPoints[i]};
-  }
-}
-
-VulkanBuffer makeFontBuffer(
-    VulkanGraphicsDevice& device,
-    const loader::Font& font,
-    std::vector<std::pair<int32_t, int32_t>>& glyphRanges) {
-  std::vector<GlyphPoint> pointData;
-  glyphRanges.clear();
+constexpr float kAtlasPixelsPerEm = 48.0f;
+constexpr uint32_t kAtlasSpread = 6;
 
-  for (const auto& glyph : font.glyphs) {
-    const auto glyphStart = static_cast<int32_t>(pointData.size());
-
-    if (std::holds_alternative<loader::SimpleGlyphData>(
-            glyph.contourData.data)) {
-      const auto& glyphData =
-          std::get<loader::SimpleGlyphData>(glyph.contourData.data);
-      DEBUG_ASSERT(
-          glyphData.onCurve.size() == glyphData.xCoords.size() &&
-          glyphData.xCoords.size() == glyphData.yCoords.size());
+constexpr size_t kLayoutCacheCapacity = 256;
 
-      if (glyphData.endPoints.empty()) {
-        continue;
-      }
-
-      for (auto [contourStart, contourEnd] :
-           contourRanges(glyphData.endPoints)) {
-        // Ensure the first point is on curve
-        if (!glyphData.onCurve[contourStart]) {
-          if (!glyphData.onCurve[contourEnd]) {
-            // Insert virtual point
-            pointData.emplace_back(
-                math::Vec<int32_t, 2>{
-                    (glyphData.xCoords[contourStart] +
-                     glyphData.xCoords[contourEnd]) /
-                        2,
-                    (glyphData.yCoords[contourStart] +
-                     glyphData.yCoords[contourEnd]) /
-                        2},
-                true,
-                false);
-          } else {
-            // Make the last point the first
-            contourEnd--;
-
-            pointData.emplace_back(
-                math::Vec<int32_t, 2>{
-                    glyphData.xCoords[contourEnd],
-                    glyphData.yCoords[contourEnd]},
-                true,
-                false);
-          }
-        }
-
-        bool lastOnCurve = true;
-        for (size_t pointIndex = contourStart; pointIndex <= contourEnd;
-             pointIndex++) {
-          if (!lastOnCurve && !glyphData.onCurve[pointIndex]) {
-            // Make virtual point explicit
-            pointData.emplace_back(
-                math::Vec<int32_t, 2>{
-                    (glyphData.xCoords[pointIndex - 1] +
-                     glyphData.xCoords[pointIndex]) /
-                        2,
-                    (glyphData.yCoords[pointIndex - 1] +
-                     glyphData.yCoords[pointIndex]) /
-                        2},
-                true,
-                false);
-          }
-
-          pointData.emplace_back(
-              math::Vec<int32_t, 2>{
-                  glyphData.xCoords[pointIndex], glyphData.yCoords[pointIndex]},
-              glyphData.onCurve[pointIndex],
-              pointIndex == contourEnd);
-
-          lastOnCurve = glyphData.onCurve[pointIndex];
-        }
-      }
+// Latin-1, which covers all the text the game draws
+std::vector<uint16_t> getAtlasGlyphs(const loader::Font& font) {
+  std::vector<uint16_t> result;
+  for (uint32_t c = 0x20; c <= 0xFF; c++) {
+    if (c < 0x7F || c >= 0xA0) {
+      result.emplace_back(font.charMap.mapChar(c));
     }
-
-    glyphRanges.emplace_back(
-        glyphStart, static_cast<int32_t>(pointData.size()));
   }
-
-  return VulkanBuffer{
-      device,
-      std::span<std::byte>{
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-          reinterpret_cast<std::byte*>(pointData.data()),
-          pointData.size() * sizeof(GlyphPoint)},
-      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+  return result;
 }
 
-float drawChar(
-    RenderSubSystem& render,
+float layoutChar(
     const loader::Font& fontData,
-    const std::vector<std::pair<int32_t, int32_t>>& glyphRanges,
-    RenderableRef<RenderableFont::InstanceData> renderableObject,
-    WindowRef window,
+    const GlyphOutlines& outlines,
+    const GlyphAtlas* atlas,
     uint32_t c,
     math::Vec2 pos,
     float fontScale,
-    int zDepth,
-    Simple2DCamera* camera,
-    std::optional<uint16_t>& previousGlyph) {
-  auto glyphIndex = fontData.charMap->mapChar(c);
+    std::optional<uint16_t>& previousGlyph,
+    std::vector<std::vector<RenderableFont::InstanceData>>& outlineGlyphs,
+    std::vector<RenderableFontAtlas::InstanceData>& atlasGlyphs) {
+  auto glyphIndex = fontData.charMap.mapChar(c);
   const auto& glyph = fontData.glyphs[glyphIndex];
+  const auto& contourData = fontData.getContours(glyphIndex);
 
   int16_t kerning = 0;
   if (previousGlyph.has_value()) {
@@ -154,12 +69,32 @@ float drawChar(
   }
   previousGlyph = glyphIndex;
 
-  if (std::holds_alternative<loader::SimpleGlyphData>(glyph.contourData.data)) {
-    render.drawObject(
-        window,
-        camera,
-        zDepth,
-        renderableObject,
+  const float advance = (static_cast<float>(kerning) * fontScale) +
+      (static_cast<float>(glyph.horizontalMetrics.advanceWidth.rawValue) *
+       fontScale);
+
+  const GlyphAtlas::Entry* atlasEntry =
+      atlas != nullptr ? atlas->find(glyphIndex) : nullptr;
+  if (atlasEntry != nullptr) {
+    atlasGlyphs.emplace_back(
+        RenderableFontAtlas::InstanceData{
+            math::Mat3::translate(
+                pos +
+                math::Vec2{
+                    (atlasEntry->left + static_cast<float>(kerning)) *
+                        fontScale,
+                    -atlasEntry->top * fontScale}) *
+                math::Mat3::scale(
+                    math::Vec2{
+                        atlasEntry->width * fontScale,
+                        atlasEntry->height * fontScale}),
+            math::Mat3::translate(atlasEntry->uvOffset) *
+                math::Mat3::scale(atlasEntry->uvSize)});
+  } else if (const auto* location = outlines.find(glyphIndex);
+             location != nullptr && location->bandCount > 0 &&
+             std::holds_alternative<loader::SimpleGlyphData>(
+                 contourData.data)) {
+    outlineGlyphs[location->page].emplace_back(
         RenderableFont::InstanceData{
             math::Mat3::translate(
                 pos +
@@ -180,8 +115,8 @@ float drawChar(
                             glyph.contourData.yMax.rawValue -
                             glyph.contourData.yMin.rawValue) *
                             fontScale}),
-            glyphRanges[glyphIndex].first,
-            glyphRanges[glyphIndex].second,
+            location->bandStart,
+            location->bandCount,
             math::Mat3::translate(
                 math::Vec2{
                     static_cast<float>(glyph.contourData.xMin.rawValue),
@@ -195,14 +130,17 @@ float drawChar(
                             glyph.contourData.yMax.rawValue -
                             glyph.contourData.yMin.rawValue)})});
   } else if (std::holds_alternative<std::vector<loader::CompoundGlyphData>>(
-                 glyph.contourData.data)) {
+                 contourData.data)) {
     for (const auto& subGlyphDetails :
-         std::get<std::vector<loader::CompoundGlyphData>>(
-             glyph.contourData.data)) {
+         std::get<std::vector<loader::CompoundGlyphData>>(contourData.data)) {
       const auto& subGlyph = fontData.glyphs[subGlyphDetails.glpyhIndex];
       DEBUG_ASSERT(
           std::holds_alternative<loader::SimpleGlyphData>(
-              subGlyph.contourData.data));
+              fontData.getContours(subGlyphDetails.glpyhIndex).data));
+      const auto* subLocation = outlines.find(subGlyphDetails.glpyhIndex);
+      if (subLocation == nullptr || subLocation->bandCount == 0) {
+        continue;
+      }
 
       auto transformPos = [&](math::Vec2 pos) {
         const float m0 =
@@ -230,11 +168,7 @@ float drawChar(
                 (static_cast<float>(subGlyphDetails.f) * fontScale)};
       };
 
-      render.drawObject(
-          window,
-          camera,
-          zDepth,
-          renderableObject,
+      outlineGlyphs[subLocation->page].emplace_back(
           RenderableFont::InstanceData{
               math::Mat3::translate(
                   pos +
@@ -257,8 +191,8 @@ float drawChar(
                               subGlyph.contourData.yMax.rawValue -
                               subGlyph.contourData.yMin.rawValue) *
                               fontScale}),
-              glyphRanges[subGlyphDetails.glpyhIndex].first,
-              glyphRanges[subGlyphDetails.glpyhIndex].second,
+              subLocation->bandStart,
+              subLocation->bandCount,
               math::Mat3::translate(
                   math::Vec2{
                       static_cast<float>(subGlyph.contourData.xMin.rawValue),
@@ -274,9 +208,29 @@ float drawChar(
     }
   }
 
-  return (static_cast<float>(kerning) * fontScale) +
-      (static_cast<float>(glyph.horizontalMetrics.advanceWidth.rawValue) *
-       fontScale);
+  return advance;
+}
+
+template <typename TFunc>
+void forEachChar(Font::Encoding encoding, std::string_view str, TFunc func) {
+  if (encoding == Font::Encoding::ASCII) {
+    for (const unsigned char c : str) {
+      func(c);
+    }
+  } else if (encoding == Font::Encoding::UTF8) {
+    for (const uint32_t c : util::unicodeDecode(str)) {
+      func(c);
+    }
+  } else {
+    DEBUG_ASSERT(false);
+  }
+}
+
+// Cached layouts are relative to the origin, so drawing one only has to move
+// each glyph rather than rebuild its transform
+void translateInstance(math::Mat3& modelMatrix, math::Vec2 offset) {
+  modelMatrix.at(2, 0) += offset.x();
+  modelMatrix.at(2, 1) += offset.y();
 }
 
 loader::FWord getBaselineOffset(
@@ -310,14 +264,36 @@ float Font::Size::Line::getEmHeight(const Font& font) const {
   return lineHeight_ * unitsPerEm / unitsPerLine;
 }
 
-Font::Font(RenderSubSystem& renderSystem, loader::Font font)
+Font::Font(
+    RenderSubSystem& renderSystem,
+    loader::Font font,
+    float maxAtlasPixelEmHeight)
     : render_(&renderSystem),
       fontData_(std::move(font)),
-      renderableObject_(
-          renderSystem.createRenderable<RenderableFont>(makeFontBuffer(
-              renderSystem.getGraphicsDevice(), fontData_, glyphRanges_))) {}
+      outlines_(renderSystem),
+      maxAtlasPixelEmHeight_(maxAtlasPixelEmHeight),
+      glyphAtlas_(
+          fontData_,
+          getAtlasGlyphs(fontData_),
+          kAtlasPixelsPerEm,
+          kAtlasSpread),
+      atlasRenderableObject_(
+          renderSystem.createRenderable<RenderableFontAtlas>(VulkanTexture{
+              renderSystem.getGraphicsDevice(),
+              renderSystem.getUploadManager(),
+              glyphAtlas_.getImage()})),
+      layoutCache_(kLayoutCacheCapacity) {
+  glyphAtlas_.releaseImage();
+  // Lazily loaded fonts upload outlines as text first needs them instead
+  if (fontData_.lazyGlyphs == nullptr) {
+    std::vector<uint16_t> glyphIndices(fontData_.glyphs.size());
+    std::iota(glyphIndices.begin(), glyphIndices.end(), uint16_t{0});
+    outlines_.upload(fontData_, glyphIndices);
+  }
+}
 
 void Font::drawStringASCII(
+    WindowRef target,
     std::string_view str,
     math::Vec2 pos,
     Size fontSize,
@@ -325,46 +301,20 @@ void Font::drawStringASCII(
     VAlign valign,
     int zDepth,
     Simple2DCamera* camera) const {
-  switch (align) {
-    case Align::LEFT:
-      break;
-    case Align::CENTER:
-      pos.x() -= stringWidth(Encoding::ASCII, str, fontSize) / 2;
-      break;
-    case Align::RIGHT:
-      pos.x() -= stringWidth(Encoding::ASCII, str, fontSize);
-      break;
-  }
-
-  const float fontScale = getSizeScale(fontSize);
-  pos.y() +=
-      fontScale *
-      static_cast<float>(
-          getBaselineOffset(
-              fontData_.ascenderHeight, fontData_.descenderHeight, valign)
-              .rawValue);
-
-  auto window = GlobalSubSystemStack::get().window();
-  std::optional<uint16_t> previousGlyph;
-  for (const unsigned char c : str) {
-    const float advance = drawChar(
-        *render_,
-        fontData_,
-        glyphRanges_,
-        *renderableObject_,
-        window,
-        c,
-        pos,
-        fontScale,
-        zDepth,
-        camera,
-        previousGlyph);
-
-    pos.x() += advance;
-  }
+  drawString(
+      target,
+      Encoding::ASCII,
+      str,
+      pos,
+      fontSize,
+      align,
+      valign,
+      zDepth,
+      camera);
 }
 
 void Font::drawStringUTF8(
+    WindowRef target,
     std::string_view str,
     math::Vec2 pos,
     Size fontSize,
@@ -372,43 +322,16 @@ void Font::drawStringUTF8(
     VAlign valign,
     int zDepth,
     Simple2DCamera* camera) const {
-  switch (align) {
-    case Align::LEFT:
-      break;
-    case Align::CENTER:
-      pos.x() -= stringWidth(Encoding::UTF8, str, fontSize) / 2;
-      break;
-    case Align::RIGHT:
-      pos.x() -= stringWidth(Encoding::UTF8, str, fontSize);
-      break;
-  }
-
-  const float fontScale = getSizeScale(fontSize);
-  pos.y() +=
-      fontScale *
-      static_cast<float>(
-          getBaselineOffset(
-              fontData_.ascenderHeight, fontData_.descenderHeight, valign)
-              .rawValue);
-
-  auto window = GlobalSubSystemStack::get().window();
-  std::optional<uint16_t> previousGlyph;
-  for (const uint32_t c : util::unicodeDecode(str)) {
-    const float advance = drawChar(
-        *render_,
-        fontData_,
-        glyphRanges_,
-        *renderableObject_,
-        window,
-        c,
-        pos,
-        fontScale,
-        zDepth,
-        camera,
-        previousGlyph);
-
-    pos.x() += advance;
-  }
+  drawString(
+      target,
+      Encoding::UTF8,
+      str,
+      pos,
+      fontSize,
+      align,
+      valign,
+      zDepth,
+      camera);
 }
 
 float Font::stringWidth(
@@ -418,12 +341,18 @@ float Font::stringWidth(
   }
 
   float fontScale = getSizeScale(fontSize);
-  float width = 0.0f;
+  for (const bool useAtlas : {true, false}) {
+    if (const TextLayout* layout = layoutCache_.find(
+            LayoutKeyView{str, encoding, fontScale, useAtlas});
+        layout != nullptr) {
+      return layout->width;
+    }
+  }
 
+  float width = 0.0f;
   std::optional<uint16_t> previousGlyph;
-
-  auto processChar = [&](uint32_t c) {
-    auto glyphIndex = fontData_.charMap->mapChar(c);
+  forEachChar(encoding, str, [&](uint32_t c) {
+    auto glyphIndex = fontData_.charMap.mapChar(c);
 
     int16_t kerning = 0;
     if (previousGlyph.has_value()) {
@@ -435,19 +364,7 @@ float Font::stringWidth(
     width += static_cast<float>(fontData_.glyphs[glyphIndex]
                                     .horizontalMetrics.advanceWidth.rawValue) *
         fontScale;
-  };
-
-  if (encoding == Encoding::ASCII) {
-    for (const unsigned char c : str) {
-      processChar(c);
-    }
-  } else if (encoding == Encoding::UTF8) {
-    for (const uint32_t c : util::unicodeDecode(str)) {
-      processChar(c);
-    }
-  } else {
-    DEBUG_ASSERT(false);
-  }
+  });
 
   return width;
 }
@@ -463,4 +380,126 @@ float Font::getSizeScale(const Font::Size& size) const {
   return size.getEmHeight(*this) / static_cast<float>(fontData_.unitsPerEm);
 }
 
+size_t Font::LayoutKeyHash::operator()(const LayoutKeyView& key) const {
+  size_t hash = std::hash<std::string_view>{}(key.text);
+  hash = (hash * 31) + std::hash<float>{}(key.fontScale);
+  hash = (hash * 31) + static_cast<size_t>(key.encoding);
+  return (hash * 2) + (key.useAtlas ? 1 : 0);
+}
+
+void Font::drawString(
+    WindowRef target,
+    Encoding encoding,
+    std::string_view str,
+    math::Vec2 pos,
+    Size fontSize,
+    Align align,
+    VAlign valign,
+    int zDepth,
+    Simple2DCamera* camera) const {
+  const float fontScale = getSizeScale(fontSize);
+  const TextLayout& layout = getLayout(
+      encoding, str, fontScale, selectAtlas(fontSize, target, camera));
+
+  switch (align) {
+    case Align::LEFT:
+      break;
+    case Align::CENTER:
+      pos.x() -= layout.width / 2;
+      break;
+    case Align::RIGHT:
+      pos.x() -= layout.width;
+      break;
+  }
+
+  pos.y() +=
+      fontScale *
+      static_cast<float>(
+          getBaselineOffset(
+              fontData_.ascenderHeight, fontData_.descenderHeight, valign)
+              .rawValue);
+
+  atlasScratch_.assign(layout.atlasGlyphs.begin(), layout.atlasGlyphs.end());
+  for (RenderableFontAtlas::InstanceData& instance : atlasScratch_) {
+    translateInstance(instance.modelMatrix, pos);
+  }
+  render_->drawObjects<RenderableFontAtlas::InstanceData>(
+      target, camera, zDepth, *atlasRenderableObject_, atlasScratch_);
+
+  for (size_t page = 0; page < layout.outlineGlyphs.size(); page++) {
+    const auto& pageGlyphs = layout.outlineGlyphs[page];
+    if (pageGlyphs.empty()) {
+      continue;
+    }
+    outlineScratch_.assign(pageGlyphs.begin(), pageGlyphs.end());
+    for (RenderableFont::InstanceData& instance : outlineScratch_) {
+      translateInstance(instance.modelMatrix, pos);
+    }
+    render_->drawObjects<RenderableFont::InstanceData>(
+        target, camera, zDepth, outlines_.getPage(page), outlineScratch_);
+  }
+}
+
+const GlyphAtlas* Font::selectAtlas(
+    const Size& size, WindowRef window, Simple2DCamera* camera) const {
+  const Simple2DCamera& viewCamera =
+      camera != nullptr ? *camera : render_->getDefaultCamera();
+  const VkExtent2D extent = render_->getTargetExtent(window);
+  const float pixelsPerWorldUnit =
+      std::abs(viewCamera.getViewMatrix(extent).at(1, 1)) *
+      static_cast<float>(extent.height) / 2;
+  return size.getEmHeight(*this) * pixelsPerWorldUnit <= maxAtlasPixelEmHeight_
+      ? &glyphAtlas_
+      : nullptr;
+}
+
+const Font::TextLayout& Font::getLayout(
+    Encoding encoding,
+    std::string_view str,
+    float fontScale,
+    const GlyphAtlas* atlas) const {
+  const bool useAtlas = atlas != nullptr;
+  if (const TextLayout* layout = layoutCache_.find(
+          LayoutKeyView{str, encoding, fontScale, useAtlas});
+      layout != nullptr) {
+    return *layout;
+  }
+
+  std::vector<uint16_t> missingOutlines;
+  forEachChar(encoding, str, [&](uint32_t c) {
+    const uint16_t glyphIndex = fontData_.charMap.mapChar(c);
+    if ((atlas == nullptr || atlas->find(glyphIndex) == nullptr) &&
+        outlines_.find(glyphIndex) == nullptr) {
+      missingOutlines.emplace_back(glyphIndex);
+    }
+  });
+  outlines_.upload(fontData_, missingOutlines);
+
+  TextLayout layout{.width = 0.0f, .outlineGlyphs = {}, .atlasGlyphs = {}};
+  layout.outlineGlyphs.resize(outlines_.getPageCount());
+  math::Vec2 pen{0.0f, 0.0f};
+  std::optional<uint16_t> previousGlyph;
+  forEachChar(encoding, str, [&](uint32_t c) {
+    pen.x() += layoutChar(
+        fontData_,
+        outlines_,
+        atlas,
+        c,
+        pen,
+        fontScale,
+        previousGlyph,
+        layout.outlineGlyphs,
+        layout.atlasGlyphs);
+  });
+  layout.width = pen.x();
+
+  return layoutCache_.insert(
+      LayoutKey{
+          .text = std::string{str},
+          .encoding = encoding,
+          .fontScale = fontScale,
+          .useAtlas = useAtlas},
+      std::move(layout));
+}
+
 } // namespace blocks::render
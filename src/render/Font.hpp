@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
 #include "loader/font/Font.hpp"
 #include "math/vec.hpp"
+#include "render/GlyphAtlas.hpp"
+#include "render/GlyphOutlines.hpp"
 #include "render/RenderSubSystem.hpp"
 #include "render/Simple2DCamera.hpp"
 #include "render/renderables/RenderableFont.hpp"
+#include "render/renderables/RenderableFontAtlas.hpp"
+#include "util/LRUCache.hpp"
 
 namespace blocks::render {
 
@@ -52,9 +58,17 @@ class Font {
   enum class Align : uint8_t { LEFT, CENTER, RIGHT };
   enum class VAlign : uint8_t { BASELINE, BOTTOM, CENTER, TOP };
 
-  Font(RenderSubSystem& renderSystem, loader::Font font);
+  // Text up to maxAtlasPixelEmHeight on screen is drawn from a prerasterized
+  // glyph atlas, larger text is drawn from the outlines directly
+  static constexpr float kDefaultMaxAtlasPixelEmHeight = 128.0f;
+
+  Font(
+      RenderSubSystem& renderSystem,
+      loader::Font font,
+      float maxAtlasPixelEmHeight = kDefaultMaxAtlasPixelEmHeight);
 
   void drawStringASCII(
+      WindowRef target,
       std::string_view str,
       math::Vec2 pos,
       Size fontSize,
@@ -63,6 +77,7 @@ class Font {
       int zDepth = 10,
       Simple2DCamera* camera = nullptr) const;
   void drawStringUTF8(
+      WindowRef target,
       std::string_view str,
       math::Vec2 pos,
       Size fontSize,
@@ -76,13 +91,90 @@ class Font {
   [[nodiscard]] float stringHeight(Size fontSize) const;
 
  private:
+  struct LayoutKeyView {
+    bool operator==(const LayoutKeyView& other) const = default;
+
+    std::string_view text;
+    Encoding encoding;
+    float fontScale;
+    bool useAtlas;
+  };
+
+  struct LayoutKey {
+    [[nodiscard]] LayoutKeyView view() const {
+      return LayoutKeyView{text, encoding, fontScale, useAtlas};
+    }
+
+    std::string text;
+    Encoding encoding;
+    float fontScale;
+    bool useAtlas;
+  };
+
+  struct LayoutKeyHash {
+    using is_transparent = void;
+
+    size_t operator()(const LayoutKeyView& key) const;
+    size_t operator()(const LayoutKey& key) const {
+      return (*this)(key.view());
+    }
+  };
+
+  struct LayoutKeyEqual {
+    using is_transparent = void;
+
+    static LayoutKeyView toView(const LayoutKeyView& key) { return key; }
+    static LayoutKeyView toView(const LayoutKey& key) { return key.view(); }
+
+    template <typename TLhs, typename TRhs>
+    bool operator()(const TLhs& lhs, const TRhs& rhs) const {
+      return toView(lhs) == toView(rhs);
+    }
+  };
+
+  // Glyph instances positioned relative to the pen's start on the baseline
+  struct TextLayout {
+    float width;
+    // Indexed by outline page
+    std::vector<std::vector<RenderableFont::InstanceData>> outlineGlyphs;
+    std::vector<RenderableFontAtlas::InstanceData> atlasGlyphs;
+  };
+
+  void drawString(
+      WindowRef target,
+      Encoding encoding,
+      std::string_view str,
+      math::Vec2 pos,
+      Size fontSize,
+      Align align,
+      VAlign valign,
+      int zDepth,
+      Simple2DCamera* camera) const;
+
   [[nodiscard]] float getSizeScale(const Size& size) const;
+  [[nodiscard]] const GlyphAtlas* selectAtlas(
+      const Size& size, WindowRef window, Simple2DCamera* camera) const;
+  const TextLayout& getLayout(
+      Encoding encoding,
+      std::string_view str,
+      float fontScale,
+      const GlyphAtlas* atlas) const;
 
   RenderSubSystem* render_;
   loader::Font fontData_;
-  std::vector<std::pair<int32_t, int32_t>> glyphRanges_;
-  UniqueRenderableHandle<render::RenderableFont::InstanceData>
-      renderableObject_;
+  // Grows as layouts need glyphs that have not been uploaded yet
+  mutable GlyphOutlines outlines_;
+  float maxAtlasPixelEmHeight_;
+  GlyphAtlas glyphAtlas_;
+  UniqueRenderableHandle<render::RenderableFontAtlas::InstanceData>
+      atlasRenderableObject_;
+  // UI text is mostly the same strings every frame, so laying it out again
+  // each time is wasted work
+  mutable util::LRUCache<LayoutKey, TextLayout, LayoutKeyHash, LayoutKeyEqual>
+      layoutCache_;
+  // Reused between draws so translating a cached layout does not allocate
+  mutable std::vector<RenderableFont::InstanceData> outlineScratch_;
+  mutable std::vector<RenderableFontAtlas::InstanceData> atlasScratch_;
 };
 
 } // namespace blocks::render
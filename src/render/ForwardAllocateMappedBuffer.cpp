@@ -5,19 +5,21 @@
 #include <vector>
 #include <vulkan/vulkan_core.h>
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 
 namespace blocks::render {
 
 namespace {
 
-constexpr size_t kChunkSize = 16ull * 1024;
+constexpr size_t kChunkSize = 256ull * 1024;
 
 }
 
 ForwardAllocateMappedBuffer::ForwardAllocateMappedBuffer(
     VulkanGraphicsDevice& device, VkBufferUsageFlags usageFlags)
     : device_(&device), usageFlags_(usageFlags) {
-  buffers_.emplace_back(*device_, kChunkSize, usageFlags_);
+  buffers_.emplace_back(
+      *device_, kChunkSize, usageFlags_, MemoryPool::PER_FRAME);
 }
 
 ForwardAllocateMappedBuffer::Allocation ForwardAllocateMappedBuffer::alloc(
@@ -30,7 +32,8 @@ ForwardAllocateMappedBuffer::Allocation ForwardAllocateMappedBuffer::alloc(
     bufferOffset_ = 0;
     curBuffer_++;
     if (curBuffer_ == buffers_.size()) {
-      buffers_.emplace_back(*device_, kChunkSize, usageFlags_);
+      buffers_.emplace_back(
+          *device_, kChunkSize, usageFlags_, MemoryPool::PER_FRAME);
     }
   }
 
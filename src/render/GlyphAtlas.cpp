@@ -0,0 +1,122 @@
+#include "render/GlyphAtlas.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+#include "loader/Image.hpp"
+#include "loader/font/Font.hpp"
+#include "loader/font/GlyphRasterizer.hpp"
+#include "math/vec.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr uint32_t kAtlasWidth = 1024;
+// Keeps linear filtering from bleeding between neighbouring glyphs
+constexpr uint32_t kGlyphPadding = 1;
+
+struct PackedGlyph {
+  uint16_t glyphIndex;
+  loader::GlyphBitmap bitmap;
+  uint32_t x = 0;
+  uint32_t y = 0;
+};
+
+} // namespace
+
+GlyphAtlas::GlyphAtlas(
+    const loader::Font& font,
+    std::span<const uint16_t> glyphIndices,
+    float pixelsPerEm,
+    uint32_t spread) {
+  const float pixelsPerUnit =
+      pixelsPerEm / static_cast<float>(font.unitsPerEm);
+
+  std::vector<PackedGlyph> glyphs;
+  glyphs.reserve(glyphIndices.size());
+  for (const uint16_t glyphIndex : glyphIndices) {
+    if (entries_.contains(glyphIndex)) {
+      continue;
+    }
+    auto bitmap =
+        loader::renderGlyphSDF(font, glyphIndex, pixelsPerUnit, spread);
+    if (bitmap.width == 0 || bitmap.width + kGlyphPadding > kAtlasWidth) {
+      continue;
+    }
+    entries_.emplace(glyphIndex, Entry{});
+    glyphs.emplace_back(glyphIndex, std::move(bitmap));
+  }
+
+  // Shelf packing, tallest first so each shelf wastes little height
+  std::ranges::sort(glyphs, [](const auto& lhs, const auto& rhs) {
+    return lhs.bitmap.height > rhs.bitmap.height;
+  });
+  uint32_t shelfX = 0;
+  uint32_t shelfY = 0;
+  uint32_t shelfHeight = 0;
+  for (auto& glyph : glyphs) {
+    if (shelfX + glyph.bitmap.width + kGlyphPadding > kAtlasWidth) {
+      shelfX = 0;
+      shelfY += shelfHeight;
+      shelfHeight = 0;
+    }
+    glyph.x = shelfX;
+    glyph.y = shelfY;
+    shelfX += glyph.bitmap.width + kGlyphPadding;
+    shelfHeight = std::max(shelfHeight, glyph.bitmap.height + kGlyphPadding);
+  }
+
+  image_.width = kAtlasWidth;
+  image_.height = std::max(shelfY + shelfHeight, 1u);
+  image_.pixelData.resize(image_.width * image_.height * 4);
+  // White with the distance in alpha, so the shader output matches the
+  // analytic path
+  for (size_t i = 0; i < image_.pixelData.size(); i += 4) {
+    image_.pixelData[i] = std::byte{255};
+    image_.pixelData[i + 1] = std::byte{255};
+    image_.pixelData[i + 2] = std::byte{255};
+    image_.pixelData[i + 3] = std::byte{0};
+  }
+
+  const auto atlasWidth = static_cast<float>(image_.width);
+  const auto atlasHeight = static_cast<float>(image_.height);
+  for (const auto& glyph : glyphs) {
+    const auto& bitmap = glyph.bitmap;
+    for (uint32_t row = 0; row < bitmap.height; row++) {
+      for (uint32_t col = 0; col < bitmap.width; col++) {
+        const size_t dst =
+            (((static_cast<size_t>(glyph.y) + row) * image_.width) + glyph.x +
+             col) *
+            4;
+        image_.pixelData[dst + 3] =
+            std::byte{bitmap.pixels[(row * bitmap.width) + col]};
+      }
+    }
+
+    const auto width = static_cast<float>(bitmap.width);
+    const auto height = static_cast<float>(bitmap.height);
+    entries_[glyph.glyphIndex] = Entry{
+        .uvOffset =
+            math::Vec2{
+                static_cast<float>(glyph.x) / atlasWidth,
+                static_cast<float>(glyph.y) / atlasHeight},
+        .uvSize = math::Vec2{width / atlasWidth, height / atlasHeight},
+        .left = bitmap.left,
+        .top = bitmap.bottom + (height / pixelsPerUnit),
+        .width = width / pixelsPerUnit,
+        .height = height / pixelsPerUnit};
+  }
+}
+
+const GlyphAtlas::Entry* GlyphAtlas::find(uint16_t glyphIndex) const {
+  if (auto it = entries_.find(glyphIndex); it != entries_.end()) {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+} // namespace blocks::render
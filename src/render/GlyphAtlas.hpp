@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include "loader/Image.hpp"
+#include "loader/font/Font.hpp"
+#include "math/vec.hpp"
+
+namespace blocks::render {
+
+// Signed distance fields of a set of glyphs, packed into a single image
+class GlyphAtlas {
+ public:
+  struct Entry {
+    // Region of the atlas, in uv coordinates with the top left as the origin
+    math::Vec2 uvOffset;
+    math::Vec2 uvSize;
+    // Bounds covered by the region, in font units
+    float left;
+    float top;
+    float width;
+    float height;
+  };
+
+  GlyphAtlas(
+      const loader::Font& font,
+      std::span<const uint16_t> glyphIndices,
+      float pixelsPerEm,
+      uint32_t spread);
+
+  [[nodiscard]] const Entry* find(uint16_t glyphIndex) const;
+
+  [[nodiscard]] const loader::Image& getImage() const { return image_; }
+  void releaseImage() { image_ = loader::Image{}; }
+
+ private:
+  std::unordered_map<uint16_t, Entry> entries_;
+  loader::Image image_;
+};
+
+} // namespace blocks::render
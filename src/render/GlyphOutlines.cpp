@@ -0,0 +1,306 @@
+#include "render/GlyphOutlines.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "loader/font/Font.hpp"
+#include "math/vec.hpp"
+#include "render/RenderSubSystem.hpp"
+#include "render/VulkanBuffer.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanUploadManager.hpp"
+#include "render/renderables/RenderableFont.hpp"
+#include "util/Generator.hpp"
+#include "util/debug.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr size_t kCurvesPerBand = 4;
+constexpr size_t kMaxBands = 16;
+// Enough for a few hundred typical glyphs, a glyph larger than this gets a
+// page sized to fit it
+constexpr size_t kPageCurveCapacity = 16384;
+constexpr size_t kPageBandCapacity = 65536;
+
+using GlyphCurve = GlyphOutlines::Curve;
+
+util::Generator<std::pair<size_t, size_t>> contourRanges(
+    std::span<const uint16_t> endPoints) {
+  co_yield std::pair<size_t, size_t>{0, endPoints[0]};
+  for (size_t i = 1; i < endPoints.size(); i++) {
+    co_yield std::pair<size_t, size_t>{endPoints[i - 1] + 1, endPoints[i]};
+  }
+}
+
+math::Vec<int32_t, 2> midpoint(
+    math::Vec<int32_t, 2> a, math::Vec<int32_t, 2> b) {
+  return math::Vec<int32_t, 2>{(a.x() + b.x()) / 2, (a.y() + b.y()) / 2};
+}
+
+void appendContourCurves(
+    const loader::SimpleGlyphData& glyphData,
+    size_t contourStart,
+    size_t contourEnd,
+    std::vector<GlyphCurve>& curves) {
+  const size_t count = contourEnd + 1 - contourStart;
+  auto pointAt = [&](size_t i) {
+    const loader::GlyphPoint& point =
+        glyphData.points[contourStart + (i % count)];
+    return math::Vec<int32_t, 2>{point.x, point.y};
+  };
+  auto onCurveAt = [&](size_t i) {
+    return glyphData.points[contourStart + (i % count)].onCurve();
+  };
+
+  // Start from an on curve point, or the implied midpoint if there are none
+  size_t firstOnCurve = 0;
+  while (firstOnCurve < count && !onCurveAt(firstOnCurve)) {
+    firstOnCurve++;
+  }
+  const bool hasOnCurve = firstOnCurve < count;
+  const math::Vec<int32_t, 2> start = hasOnCurve
+      ? pointAt(firstOnCurve)
+      : midpoint(pointAt(count - 1), pointAt(0));
+  const size_t begin = hasOnCurve ? firstOnCurve + 1 : 0;
+
+  math::Vec<int32_t, 2> current = start;
+  std::optional<math::Vec<int32_t, 2>> control;
+  for (size_t i = begin; i < begin + count; i++) {
+    const math::Vec<int32_t, 2> point = pointAt(i);
+    if (onCurveAt(i)) {
+      if (control.has_value()) {
+        curves.emplace_back(current, *control, point, false, 0);
+      } else {
+        curves.emplace_back(current, current, point, true, 0);
+      }
+      current = point;
+      control.reset();
+    } else {
+      if (control.has_value()) {
+        const math::Vec<int32_t, 2> implied = midpoint(*control, point);
+        curves.emplace_back(current, *control, implied, false, 0);
+        current = implied;
+      }
+      control = point;
+    }
+  }
+  if (control.has_value()) {
+    curves.emplace_back(current, *control, start, false, 0);
+  }
+}
+
+// Splits the glyph's height into bands, each listing the curves that cross it
+// sorted by decreasing max x, so the fragment shader only has to test the
+// curves in its own band and can stop once they are all to its left
+std::pair<int32_t, int32_t> appendBands(
+    const loader::GlyphContourData& contourData,
+    const std::vector<GlyphCurve>& curves,
+    size_t firstCurve,
+    std::vector<uint32_t>& bandData) {
+  const size_t curveCount = curves.size() - firstCurve;
+  const int32_t yMin = contourData.yMin.rawValue;
+  const int32_t yMax = contourData.yMax.rawValue;
+  const size_t bandCount = yMax > yMin
+      ? std::clamp(curveCount / kCurvesPerBand, size_t{1}, kMaxBands)
+      : 1;
+  const float bandHeight =
+      static_cast<float>(yMax - yMin) / static_cast<float>(bandCount);
+
+  auto bandAt = [&](int32_t y) {
+    if (bandHeight <= 0.0f) {
+      return size_t{0};
+    }
+    const float band = std::floor(static_cast<float>(y - yMin) / bandHeight);
+    return static_cast<size_t>(
+        std::clamp(band, 0.0f, static_cast<float>(bandCount - 1)));
+  };
+  auto maxX = [&](uint32_t curveIndex) {
+    const GlyphCurve& curve = curves[curveIndex];
+    return std::max({curve.start.x(), curve.control.x(), curve.end.x()});
+  };
+
+  std::vector<std::vector<uint32_t>> bands(bandCount);
+  for (size_t i = firstCurve; i < curves.size(); i++) {
+    const GlyphCurve& curve = curves[i];
+    // Pad by a unit so rounding in the shader never misses a boundary curve
+    const size_t firstBand =
+        bandAt(std::min({curve.start.y(), curve.control.y(), curve.end.y()}) -
+               1);
+    const size_t lastBand =
+        bandAt(std::max({curve.start.y(), curve.control.y(), curve.end.y()}) +
+               1);
+    for (size_t band = firstBand; band <= lastBand; band++) {
+      bands[band].emplace_back(static_cast<uint32_t>(i));
+    }
+  }
+
+  const size_t bandStart = bandData.size();
+  bandData.resize(bandStart + (2 * bandCount));
+  for (size_t band = 0; band < bandCount; band++) {
+    std::ranges::sort(bands[band], [&](uint32_t lhs, uint32_t rhs) {
+      return maxX(lhs) > maxX(rhs);
+    });
+    bandData[bandStart + (2 * band)] = static_cast<uint32_t>(bandData.size());
+    bandData[bandStart + (2 * band) + 1] =
+        static_cast<uint32_t>(bands[band].size());
+    bandData.insert(bandData.end(), bands[band].begin(), bands[band].end());
+  }
+
+  return {static_cast<int32_t>(bandStart), static_cast<int32_t>(bandCount)};
+}
+
+// Copies whatever was appended to data since the last call
+template <typename T>
+void uploadAppended(
+    VulkanUploadManager& uploadManager,
+    const std::vector<T>& data,
+    size_t& uploadedCount,
+    VkBuffer buffer) {
+  uploadManager.uploadToBuffer(
+      std::as_bytes(std::span{data}.subspan(uploadedCount)),
+      buffer,
+      uploadedCount * sizeof(T));
+  uploadedCount = data.size();
+}
+
+} // namespace
+
+GlyphOutlines::GlyphOutlines(RenderSubSystem& renderSystem)
+    : render_(&renderSystem) {}
+
+void GlyphOutlines::upload(
+    const loader::Font& font, std::span<const uint16_t> glyphIndices) {
+  auto addGlyph = [&](uint16_t glyphIndex) {
+    if (glyphIndex >= font.glyphs.size() || locations_.contains(glyphIndex)) {
+      return;
+    }
+
+    const auto& contourData = font.getContours(glyphIndex);
+    const auto* glyphData =
+        std::get_if<loader::SimpleGlyphData>(&contourData.data);
+    if (glyphData == nullptr || glyphData->endPoints.empty()) {
+      locations_.emplace(glyphIndex, Location{0, 0, 0});
+      return;
+    }
+    DEBUG_ASSERT(glyphData->endPoints.back() < glyphData->points.size());
+
+    const size_t firstCurve = openPage_.curves.size();
+    const size_t firstBandData = openPage_.bandData.size();
+    std::optional<Location> location = appendGlyph(contourData, *glyphData);
+    // Move it to a new page rather than overflow this one, unless it is all
+    // the page holds
+    if (location.has_value() && firstCurve > 0 && !openPageFits()) {
+      openPage_.curves.resize(firstCurve);
+      openPage_.bandData.resize(firstBandData);
+      flushOpenPage();
+      openPage_ = OpenPage{};
+      openPage_.page = static_cast<uint32_t>(pages_.size());
+      location = appendGlyph(contourData, *glyphData);
+    }
+    locations_.emplace(glyphIndex, location.value_or(Location{0, 0, 0}));
+  };
+
+  for (const uint16_t glyphIndex : glyphIndices) {
+    addGlyph(glyphIndex);
+    if (glyphIndex >= font.glyphs.size()) {
+      continue;
+    }
+    if (const auto* components =
+            std::get_if<std::vector<loader::CompoundGlyphData>>(
+                &font.getContours(glyphIndex).data);
+        components != nullptr) {
+      for (const auto& component : *components) {
+        addGlyph(component.glpyhIndex);
+      }
+    }
+  }
+
+  flushOpenPage();
+}
+
+const GlyphOutlines::Location* GlyphOutlines::find(uint16_t glyphIndex) const {
+  if (auto it = locations_.find(glyphIndex); it != locations_.end()) {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+std::optional<GlyphOutlines::Location> GlyphOutlines::appendGlyph(
+    const loader::GlyphContourData& contourData,
+    const loader::SimpleGlyphData& glyphData) {
+  const size_t firstCurve = openPage_.curves.size();
+  for (auto [contourStart, contourEnd] : contourRanges(glyphData.endPoints)) {
+    if (contourEnd >= contourStart) {
+      appendContourCurves(
+          glyphData, contourStart, contourEnd, openPage_.curves);
+    }
+  }
+  if (openPage_.curves.size() == firstCurve) {
+    return std::nullopt;
+  }
+  const auto [bandStart, bandCount] = appendBands(
+      contourData, openPage_.curves, firstCurve, openPage_.bandData);
+  return Location{openPage_.page, bandStart, bandCount};
+}
+
+bool GlyphOutlines::openPageFits() const {
+  const size_t curveCapacity = openPage_.curveCapacity > 0
+      ? openPage_.curveCapacity
+      : kPageCurveCapacity;
+  const size_t bandCapacity =
+      openPage_.bandCapacity > 0 ? openPage_.bandCapacity : kPageBandCapacity;
+  return openPage_.curves.size() <= curveCapacity &&
+      openPage_.bandData.size() <= bandCapacity;
+}
+
+void GlyphOutlines::flushOpenPage() {
+  // Band data only grows along with the curves
+  if (openPage_.curves.size() == openPage_.uploadedCurves) {
+    return;
+  }
+
+  VulkanGraphicsDevice& device = render_->getGraphicsDevice();
+  VulkanUploadManager& uploadManager = render_->getUploadManager();
+  if (openPage_.curveCapacity == 0) {
+    openPage_.curveCapacity =
+        std::max(kPageCurveCapacity, openPage_.curves.size());
+    openPage_.bandCapacity =
+        std::max(kPageBandCapacity, openPage_.bandData.size());
+    VulkanBuffer curveBuffer{
+        device,
+        openPage_.curveCapacity * sizeof(GlyphCurve),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+    VulkanBuffer bandBuffer{
+        device,
+        openPage_.bandCapacity * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
+    openPage_.curveBuffer = curveBuffer.getRawBuffer();
+    openPage_.bandBuffer = bandBuffer.getRawBuffer();
+    DEBUG_ASSERT(openPage_.page == pages_.size());
+    pages_.emplace_back(
+        render_->createRenderable<RenderableFont>(
+            std::move(curveBuffer), std::move(bandBuffer)));
+  }
+
+  uploadAppended(
+      uploadManager,
+      openPage_.curves,
+      openPage_.uploadedCurves,
+      openPage_.curveBuffer);
+  uploadAppended(
+      uploadManager,
+      openPage_.bandData,
+      openPage_.uploadedBandData,
+      openPage_.bandBuffer);
+}
+
+} // namespace blocks::render
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "loader/font/Font.hpp"
+#include "math/vec.hpp"
+#include "render/RenderSubSystem.hpp"
+#include "render/renderables/RenderableFont.hpp"
+
+namespace blocks::render {
+
+// Curves and bands of glyph outlines for the analytic font shader. Glyphs are
+// uploaded in batches as they are first needed, appended to the last page
+// until it is full. A page's buffers are never reallocated and new glyphs are
+// only written past those in use, so instances already queued stay valid.
+class GlyphOutlines {
+ public:
+  struct Location {
+    uint32_t page;
+    int32_t bandStart;
+    int32_t bandCount;
+  };
+
+  // As laid out in the curve buffer
+  struct Curve {
+    math::Vec<int32_t, 2> start;
+    math::Vec<int32_t, 2> control;
+    math::Vec<int32_t, 2> end;
+    int32_t isLine;
+    int32_t padding;
+  };
+
+  explicit GlyphOutlines(RenderSubSystem& renderSystem);
+
+  // Also uploads the components of any compound glyphs
+  void upload(
+      const loader::Font& font, std::span<const uint16_t> glyphIndices);
+
+  [[nodiscard]] const Location* find(uint16_t glyphIndex) const;
+
+  [[nodiscard]] size_t getPageCount() const { return pages_.size(); }
+  [[nodiscard]] RenderableRef<RenderableFont::InstanceData> getPage(
+      size_t page) const {
+    return pages_[page].get();
+  }
+
+ private:
+  // The page glyphs are currently added to, with a copy of its contents so
+  // bands can be built against it. Its buffers are only created on the first
+  // upload, until then the capacities are zero.
+  struct OpenPage {
+    uint32_t page = 0;
+    std::vector<Curve> curves;
+    std::vector<uint32_t> bandData;
+    size_t uploadedCurves = 0;
+    size_t uploadedBandData = 0;
+    size_t curveCapacity = 0;
+    size_t bandCapacity = 0;
+    VkBuffer curveBuffer = nullptr;
+    VkBuffer bandBuffer = nullptr;
+  };
+
+  std::optional<Location> appendGlyph(
+      const loader::GlyphContourData& contourData,
+      const loader::SimpleGlyphData& glyphData);
+  [[nodiscard]] bool openPageFits() const;
+  void flushOpenPage();
+
+  RenderSubSystem* render_;
+  std::unordered_map<uint16_t, Location> locations_;
+  std::vector<UniqueRenderableHandle<RenderableFont::InstanceData>> pages_;
+  OpenPage openPage_;
+};
+
+} // namespace blocks::render
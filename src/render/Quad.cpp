@@ -1,12 +1,8 @@
 #include "render/Quad.hpp"
 
 #include <array>
-#include <cstddef>
 #include <span>
-#include <vulkan/vulkan_core.h>
 #include "math/vec.hpp"
-#include "render/VulkanBuffer.hpp"
-#include "render/VulkanGraphicsDevice.hpp"
 #include "render/shaders/UVVertex.hpp"
 
 namespace blocks::render {
@@ -23,14 +19,8 @@ constexpr std::array<UVVertex, 6> vertices{
 
 } // namespace
 
-VulkanBuffer getQuadVertexAttributesBuffer(VulkanGraphicsDevice& device) {
-  return VulkanBuffer{
-      device,
-      std::span{
-          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-          reinterpret_cast<const std::byte*>(vertices.data()),
-          sizeof(UVVertex) * vertices.size()},
-      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT};
+std::span<const UVVertex> UVQuad::getVertices() {
+  return vertices;
 }
 
 } // namespace blocks::render
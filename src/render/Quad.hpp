@@ -1,10 +1,17 @@
 #pragma once
 
-#include "render/VulkanBuffer.hpp"
-#include "render/VulkanGraphicsDevice.hpp"
+#include <span>
+#include "render/shaders/UVVertex.hpp"
 
 namespace blocks::render {
 
-VulkanBuffer getQuadVertexAttributesBuffer(VulkanGraphicsDevice& device);
+class UVQuad {
+ public:
+  UVQuad() = delete;
+
+  using Vertex = UVVertex;
+
+  static std::span<const UVVertex> getVertices();
+};
 
 } // namespace blocks::render
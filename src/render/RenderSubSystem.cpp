@@ -1,33 +1,48 @@
 #include "render/RenderSubSystem.hpp"
 
 #include <algorithm>
-#include <array>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <span>
 #include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_core.h>
 #include "engine/Settings.hpp"
+#include "loader/Image.hpp"
 #include "log/Logger.hpp"
 #include "math/vec.hpp"
 #include "render/ForwardAllocateMappedBuffer.hpp"
 #include "render/RenderableObject.hpp"
 #include "render/Simple2DCamera.hpp"
 #include "render/VulkanCommandBuffer.hpp"
+#include "render/VulkanGpuProfiler.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanOffscreenTarget.hpp"
+#include "render/VulkanPipelineCache.hpp"
 #include "render/VulkanPresentStack.hpp"
+#include "render/VulkanShaderProgram.hpp"
+#include "render/VulkanSwapChain.hpp"
+#include "render/VulkanUploadManager.hpp"
 #include "render/Window.hpp"
+#include "render/shaders/Col2DShader.hpp"
+#include "render/shaders/FontAtlasShader.hpp"
+#include "render/shaders/FontShader.hpp"
+#include "render/shaders/Tex2DBindlessShader.hpp"
+#include "render/shaders/Tex2DShader.hpp"
 #include "render/vulkan/FenceBuilder.hpp"
 #include "render/vulkan/RenderPassBuilder.hpp"
 #include "render/vulkan/SemaphoreBuilder.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
 #include "util/Generator.hpp"
 #include "util/debug.hpp"
+#include "util/string.hpp"
 #include "util/vec_generators.hpp"
 
 namespace blocks::render {
@@ -45,7 +60,45 @@ RenderSubSystem::PipelineSynchronisationSet makeSynchronisationSet(
           device.getRawDevice())};
 }
 
-vulkan::UniqueHandle<VkRenderPass> makeMainRenderPass(VkDevice device) {
+constexpr int kMaxFramesInFlight = 4;
+constexpr int kDefaultTextureMemoryBudget = 256;
+
+int getFramesInFlight(const Settings& settings) {
+  return std::clamp(
+      settings.framesInFlight.value_or(kDefaultFramesInFlight),
+      1,
+      kMaxFramesInFlight);
+}
+
+VkDeviceSize getTextureMemoryBudget(const Settings& settings) {
+  const int megabytes = std::max(
+      settings.textureMemoryBudget.value_or(kDefaultTextureMemoryBudget), 0);
+  return static_cast<VkDeviceSize>(megabytes) * 1024 * 1024;
+}
+
+PresentMode getPresentMode(const Settings& settings) {
+  const std::string& presentMode =
+      settings.presentMode.value_or("fifoRelaxed");
+  if (presentMode == "fifo") {
+    return PresentMode::FIFO;
+  } else if (presentMode == "fifoRelaxed") {
+    return PresentMode::FIFO_RELAXED;
+  } else if (presentMode == "mailbox") {
+    return PresentMode::MAILBOX;
+  } else if (presentMode == "immediate") {
+    return PresentMode::IMMEDIATE;
+  }
+
+  log::LoggerSystem::logToDefault(
+      log::LogLevel::WARNING,
+      util::toString("Unknown present mode ", presentMode));
+  return PresentMode::FIFO_RELAXED;
+}
+
+// Render passes differing only in final layout are compatible, so pipelines
+// built against one can be used with the other
+vulkan::UniqueHandle<VkRenderPass> makeMainRenderPass(
+    VkDevice device, VkImageLayout finalLayout) {
   vulkan::RenderPassBuilder builder{};
 
   VkAttachmentReference colorAttachmentRef =
@@ -57,7 +110,7 @@ vulkan::UniqueHandle<VkRenderPass> makeMainRenderPass(VkDevice device) {
            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-           .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR},
+           .finalLayout = finalLayout},
           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 
   const uint32_t mainSubpassIndex = builder.addSubpassGetIndex(
@@ -99,21 +152,40 @@ UniqueWindowHandle::~UniqueWindowHandle() {
   }
 }
 
-RenderSubSystem::RenderSubSystem()
-    :
+RenderSubSystem::RenderSubSystem(bool headless)
+    : headless_(headless),
+      framesInFlight_(getFramesInFlight(getSettings())),
+      presentMode_(getPresentMode(getSettings())),
+      lifetimeScope_(!headless),
+      instance_(headless),
 #ifndef NDEBUG
       debugMessenger_(instance_),
 #endif
-      graphics_(VulkanGraphicsDevice::make(instance_)),
+      graphics_(VulkanGraphicsDevice::make(instance_, headless)),
       commandPool_(graphics_, false),
-      loadingCommandPool_(graphics_, true),
-      mainRenderPass_(makeMainRenderPass(graphics_.getRawDevice())),
-      shaderProgramManager_(graphics_, mainRenderPass_.get()),
-      textureManager_(graphics_, {graphics_, true}),
+      uploadManager_(graphics_, {graphics_, true}),
+      mainRenderPass_(makeMainRenderPass(
+          graphics_.getRawDevice(),
+          headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                   : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)),
+      offscreenRenderPass_(makeMainRenderPass(
+          graphics_.getRawDevice(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)),
+      pipelineCache_(graphics_, getSettingsDirectory() / "pipelineCache.bin"),
+      shaderProgramManager_(
+          graphics_, mainRenderPass_.get(), pipelineCache_.getRawCache()),
+      textureManager_(
+          graphics_,
+          uploadManager_,
+          getSettingsDirectory() / "textureCache",
+          getTextureMemoryBudget(getSettings()),
+          framesInFlight_),
+      geometryManager_(graphics_),
+      gpuProfiler_(graphics_, framesInFlight_),
+      renderablesPendingDestruction_(framesInFlight_),
       instanceDataBuffers_([&]() {
         std::vector<ForwardAllocateMappedBuffer> result;
-        result.reserve(kMaxFramesInFlight);
-        for (int i = 0; i < kMaxFramesInFlight; i++) {
+        result.reserve(framesInFlight_);
+        for (int i = 0; i < framesInFlight_; i++) {
           result.emplace_back(graphics_, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
         }
         return result;
@@ -121,10 +193,25 @@ RenderSubSystem::RenderSubSystem()
       defaultCamera_(
           math::Vec2{-1.0f, -1.0f},
           math::Vec2{1.0f, 1.0f},
-          Simple2DCamera::AspectRatioHandling::FIT) {
+          Simple2DCamera::AspectRatioHandling::FIT),
+      frameInputTimes_(framesInFlight_) {
+  // Build every pipeline up front so none are compiled in the middle of a frame
+  shaderProgramManager_.getOrCreate<Col2DShader>();
+  shaderProgramManager_.getOrCreate<FontAtlasShader>();
+  shaderProgramManager_.getOrCreate<FontShader>();
+  shaderProgramManager_.getOrCreate<Tex2DShader>();
+  if (textureManager_.supportsBindless()) {
+    shaderProgramManager_.getOrCreate<Tex2DBindlessShader>();
+  }
+  pipelineCache_.save();
 }
 
-RenderSubSystem::GLFWLifetimeScope::GLFWLifetimeScope() {
+RenderSubSystem::GLFWLifetimeScope::GLFWLifetimeScope(bool enabled)
+    : enabled_(enabled) {
+  if (!enabled_) {
+    return;
+  }
+
   const int result = glfwInit();
   if (result == GLFW_FALSE) {
     throw std::runtime_error{"Failed to initialise GLFW"};
@@ -134,10 +221,13 @@ RenderSubSystem::GLFWLifetimeScope::GLFWLifetimeScope() {
 }
 
 RenderSubSystem::GLFWLifetimeScope::~GLFWLifetimeScope() {
-  glfwTerminate();
+  if (enabled_) {
+    glfwTerminate();
+  }
 }
 
 UniqueWindowHandle RenderSubSystem::createWindow() {
+  DEBUG_ASSERT(!headless_);
   const Settings& settings = getSettings();
   const size_t id = windows_.size();
   windows_.emplace_back(
@@ -147,24 +237,81 @@ UniqueWindowHandle RenderSubSystem::createWindow() {
           VkRenderPass{mainRenderPass_.get()},
           settings.resolution.x(),
           settings.resolution.y(),
-          "Vulkan"));
+          "Vulkan",
+          presentMode_));
+  offscreenTargets_.emplace_back(nullptr);
+  addFrameResources();
+
+  return UniqueWindowHandle{WindowRef{id, *this}};
+}
+
+UniqueWindowHandle RenderSubSystem::createOffscreenTarget(
+    uint32_t width, uint32_t height) {
+  const size_t id = windows_.size();
+  windows_.emplace_back(nullptr);
+  offscreenTargets_.emplace_back(
+      std::make_unique<VulkanOffscreenTarget>(
+          graphics_, offscreenRenderPass_.get(), width, height));
+  addFrameResources();
 
-  for (size_t i = 0; i < kMaxFramesInFlight; i++) {
+  return UniqueWindowHandle{WindowRef{id, *this}};
+}
+
+void RenderSubSystem::addFrameResources() {
+  for (int i = 0; i < framesInFlight_; i++) {
     synchronisationSets_.emplace_back(makeSynchronisationSet(graphics_));
     commandBuffers_.emplace_back(graphics_, commandPool_);
   }
-
-  return UniqueWindowHandle{WindowRef{id, *this}};
 }
 
 void RenderSubSystem::destroyWindow(WindowRef ref) {
-  DEBUG_ASSERT(ref.id < windows_.size() && windows_[ref.id] != nullptr);
+  DEBUG_ASSERT(
+      ref.id < windows_.size() &&
+      (windows_[ref.id] != nullptr || offscreenTargets_[ref.id] != nullptr));
+  if (offscreenTargets_[ref.id] != nullptr) {
+    // Unlike a swap chain, nothing else keeps the image alive while in use
+    waitForTarget(ref.id);
+  }
   windows_[ref.id].reset();
+  offscreenTargets_[ref.id].reset();
 }
 
 Window* RenderSubSystem::getWindow(WindowRef ref) {
-  DEBUG_ASSERT(ref.id < windows_.size() && windows_[ref.id] != nullptr);
-  return &*windows_[ref.id];
+  DEBUG_ASSERT(ref.id < windows_.size());
+  return windows_[ref.id].get();
+}
+
+VkExtent2D RenderSubSystem::getTargetExtent(WindowRef ref) {
+  DEBUG_ASSERT(ref.id < windows_.size());
+  if (offscreenTargets_[ref.id] != nullptr) {
+    return offscreenTargets_[ref.id]->extent();
+  }
+  DEBUG_ASSERT(windows_[ref.id] != nullptr);
+  return windows_[ref.id]->getCurrentWindowExtent();
+}
+
+loader::Image RenderSubSystem::readOffscreenTarget(WindowRef ref) {
+  DEBUG_ASSERT(
+      ref.id < offscreenTargets_.size() &&
+      offscreenTargets_[ref.id] != nullptr);
+  waitForTarget(ref.id);
+  return offscreenTargets_[ref.id]->readback();
+}
+
+void RenderSubSystem::waitForTarget(size_t id) {
+  std::vector<VkFence> fences;
+  fences.reserve(framesInFlight_);
+  for (int i = 0; i < framesInFlight_; i++) {
+    fences.emplace_back(synchronisationSets_[(id * framesInFlight_) + i]
+                            .inFlightFence.get());
+  }
+
+  vkWaitForFences(
+      graphics_.getRawDevice(),
+      static_cast<uint32_t>(fences.size()),
+      fences.data(),
+      VK_TRUE,
+      UINT64_MAX);
 }
 
 RenderableObject* RenderSubSystem::getRenderable(GenericRenderableRef ref) {
@@ -180,7 +327,11 @@ void RenderSubSystem::destroyRenderable(GenericRenderableRef ref) {
       renderables_.get();
   DEBUG_ASSERT(
       ref.id < renderablesVec.size() && renderablesVec[ref.id].has_value());
-  renderablesPendingDestruction_.emplace_back(
+  // The last frame which may have drawn it is the one before this, so it is
+  // kept until that frame's slot is next waited on
+  const uint32_t lastFrame =
+      (currentFrame_.load() + framesInFlight_ - 1) % framesInFlight_;
+  (*renderablesPendingDestruction_.wlock())[lastFrame].emplace_back(
       std::move(*renderablesVec[ref.id]));
   renderablesVec[ref.id].reset();
 }
@@ -190,8 +341,39 @@ void RenderSubSystem::drawObjectRaw(
     Simple2DCamera* camera,
     long z,
     GenericRenderableRef ref,
-    void* instanceData) {
-  commands_.emplace_back(target, z, ref, camera, instanceData);
+    void* instanceData,
+    uint32_t instanceCount) {
+  commands_.emplace_back(target, z, ref, camera, instanceData, instanceCount);
+}
+
+void RenderSubSystem::markInputSampled() {
+  pendingInputTime_ = std::chrono::steady_clock::now();
+}
+
+void RenderSubSystem::recordFrameLatencies() {
+  const auto now = std::chrono::steady_clock::now();
+  lastFrameLatency_.reset();
+  for (int frame = 0; frame < framesInFlight_; frame++) {
+    std::optional<std::chrono::steady_clock::time_point>& inputTime =
+        frameInputTimes_[frame];
+    if (!inputTime.has_value()) {
+      continue;
+    }
+
+    bool complete = true;
+    for (size_t i = 0; i < windows_.size() && complete; i++) {
+      complete = vkGetFenceStatus(
+                     graphics_.getRawDevice(),
+                     synchronisationSets_[(i * framesInFlight_) + frame]
+                         .inFlightFence.get()) == VK_SUCCESS;
+    }
+    if (complete) {
+      lastFrameLatency_ =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              now - *inputTime);
+      inputTime.reset();
+    }
+  }
 }
 
 void RenderSubSystem::commitFrame() {
@@ -199,7 +381,7 @@ void RenderSubSystem::commitFrame() {
   fences.reserve(windows_.size());
   for (size_t i = 0; i < windows_.size(); i++) {
     fences.emplace_back(
-        synchronisationSets_[(i * kMaxFramesInFlight) + currentFrame_]
+        synchronisationSets_[(i * framesInFlight_) + currentFrame_]
             .inFlightFence.get());
   }
 
@@ -210,7 +392,30 @@ void RenderSubSystem::commitFrame() {
       VK_TRUE,
       UINT64_MAX);
 
+  recordFrameLatencies();
+  frameInputTimes_[currentFrame_] =
+      std::exchange(pendingInputTime_, std::nullopt);
+
   instanceDataBuffers_[currentFrame_].reset();
+  gpuProfiler_.beginFrame(currentFrame_);
+  (*renderablesPendingDestruction_.wlock())[currentFrame_].clear();
+  textureManager_.beginFrame(currentFrame_);
+
+  // Anything drawn this frame was created before now, so this flush covers
+  // all of the uploads it depends on
+  const uint64_t uploadValue = uploadManager_.flush();
+  std::optional<VulkanCommandBuffer::TimelineWait> uploadWait;
+  if (!uploadManager_.hasTimelineSemaphore()) {
+    uploadManager_.wait(uploadValue);
+  } else if (uploadValue > 0) {
+    uploadWait = VulkanCommandBuffer::TimelineWait{
+        .semaphore = uploadManager_.getTimelineSemaphore(),
+        .value = uploadValue,
+        // NOLINTNEXTLINE(hicpp-signed-bitwise)
+        .stage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+            VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+  }
 
   std::vector<std::optional<RenderableObject>>& renderablesVec =
       renderables_.get();
@@ -230,7 +435,7 @@ void RenderSubSystem::commitFrame() {
       });
 
   for (size_t i = 0; i < windows_.size() && !windowGroups.isDone(); i++) {
-    if (windows_[i] != nullptr) {
+    if (windows_[i] != nullptr || offscreenTargets_[i] != nullptr) {
       // We may have draw commands for null windows, so need to find the right
       // windowGroup
       std::span<DrawCommand> curGroup;
@@ -241,51 +446,69 @@ void RenderSubSystem::commitFrame() {
       if (curGroup[0].target_.id != i) {
         curGroup = {};
       }
-      drawWindow(i, curGroup, renderablesVec);
+      drawWindow(i, curGroup, renderablesVec, uploadWait);
     }
   }
 
   commands_.clear();
   instanceDataCPUBuffer_.reset();
 
-  currentFrame_ = (currentFrame_ + 1) % kMaxFramesInFlight;
+  currentFrame_.store((currentFrame_.load() + 1) % framesInFlight_);
 }
 
 void RenderSubSystem::drawWindow(
     size_t windowId,
     std::span<DrawCommand> windowCommands,
-    std::vector<std::optional<RenderableObject>>& renderablesVec) {
-  DEBUG_ASSERT(windowId < windows_.size() && windows_[windowId] != nullptr);
-  Window& window = *windows_[windowId];
+    std::vector<std::optional<RenderableObject>>& renderablesVec,
+    std::optional<VulkanCommandBuffer::TimelineWait> uploadWait) {
+  DEBUG_ASSERT(
+      windowId < windows_.size() &&
+      (windows_[windowId] != nullptr ||
+       offscreenTargets_[windowId] != nullptr));
   const PipelineSynchronisationSet& synchronisationSet =
-      synchronisationSets_[(windowId * kMaxFramesInFlight) + currentFrame_];
+      synchronisationSets_[(windowId * framesInFlight_) + currentFrame_];
   ForwardAllocateMappedBuffer& instanceDataAllocator =
       instanceDataBuffers_[currentFrame_];
 
-  if (window.requiresReset()) {
-    window.resetSwapChain();
-  }
-  if (!window.isDrawable()) {
-    // Presume the window will only become drawable after an event
-    glfwWaitEvents();
-  }
+  VulkanOffscreenTarget* offscreenTarget = offscreenTargets_[windowId].get();
+  std::optional<VulkanPresentStack::FrameData> presentFrame;
+  VkRenderPass renderPass = nullptr;
+  VkFramebuffer frameBuffer = nullptr;
+  VkExtent2D extent{};
+
+  if (offscreenTarget != nullptr) {
+    renderPass = offscreenRenderPass_.get();
+    frameBuffer = offscreenTarget->getFrameBuffer();
+    extent = offscreenTarget->extent();
+  } else {
+    Window& window = *windows_[windowId];
+    if (window.requiresReset()) {
+      window.resetSwapChain();
+    }
+    if (!window.isDrawable()) {
+      // Presume the window will only become drawable after an event
+      glfwWaitEvents();
+    }
 
-  const VulkanPresentStack::FrameData presentFrame =
-      window.getPresentStack().getNextImageIndex(
-          synchronisationSet.imageAvailableSemaphore.get(), nullptr);
+    presentFrame.emplace(
+        window.getPresentStack().getNextImageIndex(
+            synchronisationSet.imageAvailableSemaphore.get(), nullptr));
 
-  if (presentFrame.refreshRequired()) {
-    window.resetSwapChain();
-    return;
-  }
+    if (presentFrame->refreshRequired()) {
+      window.resetSwapChain();
+      return;
+    }
 
-  const VkExtent2D extent = window.getCurrentWindowExtent();
+    renderPass = mainRenderPass_.get();
+    frameBuffer = presentFrame->getFrameBuffer();
+    extent = window.getCurrentWindowExtent();
+  }
 
   vkResetFences(
       graphics_.getRawDevice(), 1, &synchronisationSet.inFlightFence.get());
 
   VkCommandBuffer commandBuffer =
-      commandBuffers_[(windowId * kMaxFramesInFlight) + currentFrame_]
+      commandBuffers_[(windowId * framesInFlight_) + currentFrame_]
           .getRawBuffer();
   vkResetCommandBuffer(commandBuffer, 0);
 
@@ -298,10 +521,18 @@ void RenderSubSystem::drawWindow(
     throw std::runtime_error{"Failed to begin recording command buffer"};
   }
 
+  gpuProfiler_.recordCommandBufferStart(commandBuffer);
+  if (offscreenTarget != nullptr) {
+    offscreenTarget->recordBeginFrame(commandBuffer);
+  }
+
+  const VulkanGpuProfiler::ScopeId renderPassScope =
+      gpuProfiler_.beginScope(commandBuffer, "Render pass");
+
   VkRenderPassBeginInfo renderPassInfo{};
   renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassInfo.renderPass = mainRenderPass_.get();
-  renderPassInfo.framebuffer = presentFrame.getFrameBuffer();
+  renderPassInfo.renderPass = renderPass;
+  renderPassInfo.framebuffer = frameBuffer;
   renderPassInfo.renderArea.offset = {.x = 0, .y = 0};
   renderPassInfo.renderArea.extent = extent;
 
@@ -327,6 +558,7 @@ void RenderSubSystem::drawWindow(
   vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
   Simple2DCamera* lastCamera = nullptr;
+  VkBuffer lastMeshBuffer = nullptr;
 
   for ([[maybe_unused]] const auto& command : windowCommands) {
     DEBUG_ASSERT(
@@ -335,17 +567,36 @@ void RenderSubSystem::drawWindow(
         renderablesVec[command.obj_.id].has_value());
   }
 
+  // Objects sharing a descriptor set and vertex buffer can be drawn together.
+  // Bindless sprites all share one set, so they are only split where their
+  // meshes differ, which they do not while every sprite is the same quad.
+  const auto getBatchKey = [this](RenderableObject& obj) {
+    return std::make_pair(
+        obj.getDescriptorSet(currentFrame_),
+        obj.mesh_->getRawBuffer());
+  };
+
   std::sort(
       windowCommands.begin(),
       windowCommands.end(),
-      [&renderablesVec](const auto& a, const auto& b) {
+      [&renderablesVec, &getBatchKey](const auto& a, const auto& b) {
         if (a.z_ != b.z_) {
           return a.z_ < b.z_;
         }
-        const auto* aShader = renderablesVec[a.obj_.id]->shaderProgram_;
-        const auto* bShader = renderablesVec[b.obj_.id]->shaderProgram_;
-        if (aShader != bShader) {
-          return aShader < bShader;
+        RenderableObject& aObj = *renderablesVec[a.obj_.id];
+        RenderableObject& bObj = *renderablesVec[b.obj_.id];
+        if (aObj.shaderProgram_ != bObj.shaderProgram_) {
+          return aObj.shaderProgram_ < bObj.shaderProgram_;
+        }
+        // Batches may span several z values, so camera changes within them
+        // must already be in z order
+        if (a.camera_ != b.camera_) {
+          return std::less<>{}(a.camera_, b.camera_);
+        }
+        const auto aBatch = getBatchKey(aObj);
+        const auto bBatch = getBatchKey(bObj);
+        if (aBatch != bBatch) {
+          return aBatch < bBatch;
         }
         return a.obj_.id < b.obj_.id;
       });
@@ -358,23 +609,32 @@ void RenderSubSystem::drawWindow(
       });
 
   for (const auto& shaderGroup : shaderGroups) {
-    util::Generator<std::span<DrawCommand>> objGroups = util::vec::genGroups(
-        shaderGroup, [](const DrawCommand& a, const DrawCommand& b) {
-          return a.obj_.id == b.obj_.id;
+    util::Generator<std::span<DrawCommand>> batchGroups = util::vec::genGroups(
+        shaderGroup,
+        [&renderablesVec, &getBatchKey](
+            const DrawCommand& a, const DrawCommand& b) {
+          return getBatchKey(*renderablesVec[a.obj_.id]) ==
+              getBatchKey(*renderablesVec[b.obj_.id]);
         });
 
     // All commands have the same shader, so we can pick the first
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    VulkanShaderProgram& shaderProgram =
+        *renderablesVec[shaderGroup[0].obj_.id]->shaderProgram_;
+    const VulkanGpuProfiler::ScopeId shaderScope =
+        gpuProfiler_.beginScope(commandBuffer, shaderProgram.getName());
     vkCmdBindPipeline(
         commandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
-        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-        renderablesVec[shaderGroup[0].obj_.id]
-            ->shaderProgram_->pipeline_.getRawPipeline());
+        shaderProgram.pipeline_.getRawPipeline());
 
-    for (const auto& curGroup : objGroups) {
-      // All commands in the group have the same renderable object,
+    for (const auto& curGroup : batchGroups) {
+      // All commands in the group share a shader, descriptor set and vertex
+      // buffer, so any of the renderables can stand in for the rest
       RenderableObject& renderable = *renderablesVec[curGroup[0].obj_.id];
 
+      VkDescriptorSet descriptorSet =
+          renderable.getDescriptorSet(currentFrame_);
       vkCmdBindDescriptorSets(
           commandBuffer,
           VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -382,14 +642,12 @@ void RenderSubSystem::drawWindow(
               .getRawLayout(),
           0,
           1,
-          &renderable.descriptorPool_.getDescriptorSets()[currentFrame_],
+          &descriptorSet,
           0,
           nullptr);
 
-      std::sort(
-          curGroup.begin(), curGroup.end(), [](const auto& a, const auto& b) {
-            return a.camera_ < b.camera_;
-          });
+      // Sorting here would reorder draws across z, and there is no depth
+      // buffer, so only adjacent commands share a camera group
       util::Generator<std::span<DrawCommand>> cameraGroups =
           util::vec::genGroups(
               curGroup, [](const DrawCommand& a, const DrawCommand& b) {
@@ -403,8 +661,7 @@ void RenderSubSystem::drawWindow(
 
         if (&camera != lastCamera) {
           lastCamera = &camera;
-          math::Mat3 viewMatrix =
-              camera.getViewMatrix(window.getCurrentWindowExtent());
+          math::Mat3 viewMatrix = camera.getViewMatrix(extent);
 
           vkCmdPushConstants(
               commandBuffer,
@@ -416,42 +673,94 @@ void RenderSubSystem::drawWindow(
               &viewMatrix);
         }
 
+        size_t instanceCount = 0;
+        for (const DrawCommand& command : cameraGroup) {
+          instanceCount += command.instanceCount_;
+        }
+
+        const size_t instanceStride = renderable.instanceStride_;
         const ForwardAllocateMappedBuffer::Allocation instanceAlloc =
-            instanceDataAllocator.alloc(
-                renderable.instanceDataSize_ * cameraGroup.size());
-        for (size_t i = 0; i < cameraGroup.size(); i++) {
-          std::memcpy(
-              // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-              reinterpret_cast<char*>(instanceAlloc.ptr) +
-                  (i * renderable.instanceDataSize_),
-              cameraGroup[i].instanceData_,
-              renderable.instanceDataSize_);
+            instanceDataAllocator.alloc(instanceStride * instanceCount);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        char* dst = reinterpret_cast<char*>(instanceAlloc.ptr);
+        for (const DrawCommand& command : cameraGroup) {
+          const RenderableObject& cur = *renderablesVec[command.obj_.id];
+          const char* src = static_cast<const char*>(command.instanceData_);
+          if (cur.constantInstanceData_.empty() &&
+              cur.instanceDataSize_ == instanceStride) {
+            // Runs are already laid out as the shader expects them
+            const size_t runSize = instanceStride * command.instanceCount_;
+            std::memcpy(dst, src, runSize);
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            dst += runSize;
+            continue;
+          }
+
+          for (uint32_t i = 0; i < command.instanceCount_; i++) {
+            std::memcpy(dst, src, cur.instanceDataSize_);
+            if (!cur.constantInstanceData_.empty()) {
+              std::memcpy(
+                  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                  dst + cur.instanceDataSize_,
+                  cur.constantInstanceData_.data(),
+                  cur.constantInstanceData_.size());
+            }
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            dst += instanceStride;
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            src += cur.instanceDataSize_;
+          }
         }
 
-        VkBuffer vertexBuffer = renderable.vertexAttributes_.getRawBuffer();
-        std::array<VkBuffer, 2> vertexBuffers{
-            vertexBuffer, instanceAlloc.buffer};
-        std::array<VkDeviceSize, 2> offsets{0, instanceAlloc.bufferOffset};
+        // Meshes are shared between renderables, so only rebind the vertex
+        // binding when it actually changes
+        VkBuffer meshBuffer = renderable.mesh_->getRawBuffer();
+        if (meshBuffer != lastMeshBuffer) {
+          lastMeshBuffer = meshBuffer;
+          const VkDeviceSize meshOffset = 0;
+          vkCmdBindVertexBuffers(commandBuffer, 0, 1, &meshBuffer, &meshOffset);
+        }
+        const VkDeviceSize instanceOffset = instanceAlloc.bufferOffset;
         vkCmdBindVertexBuffers(
-            commandBuffer, 0, 2, vertexBuffers.data(), offsets.data());
+            commandBuffer, 1, 1, &instanceAlloc.buffer, &instanceOffset);
         vkCmdDraw(
-            commandBuffer, 6, static_cast<uint32_t>(cameraGroup.size()), 0, 0);
+            commandBuffer,
+            renderable.mesh_->getVertexCount(),
+            static_cast<uint32_t>(instanceCount),
+            0,
+            0);
       }
     }
+
+    gpuProfiler_.endScope(commandBuffer, shaderScope);
   }
 
   vkCmdEndRenderPass(commandBuffer);
+  gpuProfiler_.endScope(commandBuffer, renderPassScope);
+
+  if (offscreenTarget != nullptr) {
+    offscreenTarget->recordReadback(commandBuffer);
+  }
 
   if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to record command buffer"};
   }
 
-  commandBuffers_[(windowId * kMaxFramesInFlight) + currentFrame_].submit(
+  VulkanCommandBuffer& submitBuffer =
+      commandBuffers_[(windowId * framesInFlight_) + currentFrame_];
+  if (!presentFrame.has_value()) {
+    submitBuffer.submit(
+        {}, {}, synchronisationSet.inFlightFence.get(), uploadWait);
+    return;
+  }
+
+  submitBuffer.submit(
       {synchronisationSet.imageAvailableSemaphore.get()},
       {synchronisationSet.renderFinishedSemaphore.get()},
-      synchronisationSet.inFlightFence.get());
+      synchronisationSet.inFlightFence.get(),
+      uploadWait);
 
-  presentFrame.present(synchronisationSet.renderFinishedSemaphore.get());
+  presentFrame->present(synchronisationSet.renderFinishedSemaphore.get());
 }
 
 void RenderSubSystem::waitIdle() {
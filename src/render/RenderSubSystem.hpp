@@ -1,27 +1,40 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <span>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <vulkan/vulkan_core.h>
+#include "loader/Image.hpp"
 #include "render/ForwardAllocateMappedBuffer.hpp"
 #include "render/RenderableObject.hpp"
 #include "render/Simple2DCamera.hpp"
 #include "render/VulkanCommandBuffer.hpp"
 #include "render/VulkanCommandPool.hpp"
+#include "render/VulkanGpuProfiler.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
 #include "render/VulkanInstance.hpp"
+#include "render/VulkanOffscreenTarget.hpp"
+#include "render/VulkanPipelineCache.hpp"
+#include "render/VulkanSwapChain.hpp"
+#include "render/VulkanUploadManager.hpp"
 #include "render/Window.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
 #include "util/BlockForwardAllocatedArena.hpp"
 #include "util/IndexedResourceStorage.hpp"
+#include "util/Synchronized.hpp"
 #include "util/debug.hpp"
-#include "util/portability.hpp"
 
 #ifndef NDEBUG
 #include "render/VulkanDebugMessenger.hpp"
@@ -29,7 +42,7 @@
 
 namespace blocks::render {
 
-constexpr int kMaxFramesInFlight = 2;
+constexpr int kDefaultFramesInFlight = 2;
 
 class RenderSubSystem;
 
@@ -165,23 +178,29 @@ class RenderSubSystem {
         long z,
         GenericRenderableRef obj,
         Simple2DCamera* camera,
-        void* instanceData)
+        void* instanceData,
+        uint32_t instanceCount)
         : target_(target),
           z_(z),
           obj_(obj),
           camera_(camera),
-          instanceData_(instanceData) {}
+          instanceData_(instanceData),
+          instanceCount_(instanceCount) {}
 
     WindowRef target_;
     long z_;
     GenericRenderableRef obj_;
     Simple2DCamera* camera_;
 
+    // instanceCount_ contiguous instances
     void* instanceData_;
+    uint32_t instanceCount_;
   };
 
  public:
-  RenderSubSystem();
+  // A headless render system never touches GLFW, so it can only draw to
+  // offscreen targets
+  explicit RenderSubSystem(bool headless = false);
 
   struct PipelineSynchronisationSet {
     vulkan::UniqueHandle<VkSemaphore> imageAvailableSemaphore;
@@ -190,12 +209,22 @@ class RenderSubSystem {
   };
 
   VulkanGraphicsDevice& getGraphicsDevice() { return graphics_; }
+  VulkanUploadManager& getUploadManager() { return uploadManager_; }
+  TextureManager& getTextureManager() { return textureManager_; }
+  VulkanGpuProfiler& getGpuProfiler() { return gpuProfiler_; }
   Simple2DCamera& getDefaultCamera() { return defaultCamera_; }
 
   UniqueWindowHandle createWindow();
+  // Offscreen targets share the window id space, so they can be drawn to with
+  // the same WindowRef, but get() returns nullptr for them
+  UniqueWindowHandle createOffscreenTarget(uint32_t width, uint32_t height);
   void destroyWindow(WindowRef ref);
 
+  // Blocks until the last frame drawn to the target has been rendered
+  loader::Image readOffscreenTarget(WindowRef ref);
+
   Window* getWindow(WindowRef ref);
+  [[nodiscard]] VkExtent2D getTargetExtent(WindowRef ref);
 
   template <typename TConcreteRenderable, typename... TArgs>
   UniqueRenderableHandle<typename TConcreteRenderable::InstanceData>
@@ -206,7 +235,8 @@ class RenderSubSystem {
             graphics_,
             shaderProgramManager_,
             textureManager_,
-            kMaxFramesInFlight));
+            geometryManager_,
+            framesInFlight_));
     return UniqueRenderableHandle{
         RenderableRef<typename TConcreteRenderable::InstanceData>{id, *this}};
   }
@@ -247,8 +277,52 @@ class RenderSubSystem {
         instanceDataCPUBuffer_.allocate<TInstanceData>(instanceData));
   }
 
+  // Records the whole run as one command, so it is sorted and copied as a unit
+  // rather than per instance
+  template <typename TInstanceData>
+  void drawObjects(
+      WindowRef target,
+      Simple2DCamera* camera,
+      long z,
+      RenderableRef<TInstanceData> ref,
+      std::span<const TInstanceData> instanceData) {
+    static_assert(std::is_trivially_copyable_v<TInstanceData>);
+    static_assert(
+        sizeof(TInstanceData) <=
+        util::BlockForwardAllocatedArena::kMaxAllocationSize);
+    constexpr size_t kMaxRunLength =
+        util::BlockForwardAllocatedArena::kMaxAllocationSize /
+        sizeof(TInstanceData);
+
+    while (!instanceData.empty()) {
+      const size_t count = std::min(instanceData.size(), kMaxRunLength);
+      void* runData = instanceDataCPUBuffer_.allocateRaw(
+          count * sizeof(TInstanceData), alignof(TInstanceData));
+      std::memcpy(runData, instanceData.data(), count * sizeof(TInstanceData));
+      drawObjectRaw(
+          target,
+          camera,
+          z,
+          ref.rawRef_,
+          runData,
+          static_cast<uint32_t>(count));
+      instanceData = instanceData.subspan(count);
+    }
+  }
+
+  // Marks the point input for the next committed frame was read, from which
+  // its latency is measured
+  void markInputSampled();
   void commitFrame();
 
+  // Time from the input being sampled to the GPU finishing a frame, if one was
+  // seen to complete during the last commitFrame. This excludes any wait for
+  // scan out, which the present mode controls.
+  [[nodiscard]] std::optional<std::chrono::microseconds> getLastFrameLatency()
+      const {
+    return lastFrameLatency_;
+  }
+
   void waitIdle();
 
  private:
@@ -257,15 +331,17 @@ class RenderSubSystem {
       Simple2DCamera* camera,
       long z,
       GenericRenderableRef ref,
-      void* instanceData);
+      void* instanceData,
+      uint32_t instanceCount = 1);
 
   void drawWindow(
       size_t windowId,
       std::span<DrawCommand> windowCommands,
-      std::vector<std::optional<RenderableObject>>& renderablesVec);
+      std::vector<std::optional<RenderableObject>>& renderablesVec,
+      std::optional<VulkanCommandBuffer::TimelineWait> uploadWait);
 
   struct GLFWLifetimeScope {
-    GLFWLifetimeScope();
+    explicit GLFWLifetimeScope(bool enabled);
     ~GLFWLifetimeScope();
 
     GLFWLifetimeScope(const GLFWLifetimeScope& other) = delete;
@@ -273,31 +349,56 @@ class RenderSubSystem {
 
     GLFWLifetimeScope(GLFWLifetimeScope&& other) = delete;
     GLFWLifetimeScope& operator=(GLFWLifetimeScope&& other) = delete;
+
+    bool enabled_;
   };
 
-  NO_UNIQUE_ADDRESS GLFWLifetimeScope lifetimeScope_;
+  void addFrameResources();
+  void recordFrameLatencies();
+  void waitForTarget(size_t id);
+
+  bool headless_;
+  int framesInFlight_;
+  PresentMode presentMode_;
+  GLFWLifetimeScope lifetimeScope_;
   VulkanInstance instance_;
 #ifndef NDEBUG
   VulkanDebugMessenger debugMessenger_;
 #endif
   VulkanGraphicsDevice graphics_;
   VulkanCommandPool commandPool_;
-  VulkanCommandPool loadingCommandPool_;
+  VulkanUploadManager uploadManager_;
   std::vector<VulkanCommandBuffer> commandBuffers_;
   vulkan::UniqueHandle<VkRenderPass> mainRenderPass_;
+  vulkan::UniqueHandle<VkRenderPass> offscreenRenderPass_;
+  VulkanPipelineCache pipelineCache_;
   ShaderProgramManager shaderProgramManager_;
   TextureManager textureManager_;
+  GeometryManager geometryManager_;
+  VulkanGpuProfiler gpuProfiler_;
   std::vector<PipelineSynchronisationSet> synchronisationSets_;
   std::vector<std::unique_ptr<Window>> windows_;
+  // Indexed in parallel with windows_, at most one of the two is non-null
+  std::vector<std::unique_ptr<VulkanOffscreenTarget>> offscreenTargets_;
   util::IndexedResourceStorage<RenderableObject> renderables_;
-  std::vector<RenderableObject> renderablesPendingDestruction_;
+  // Indexed by frame in flight, cleared once that frame has finished. Scenes
+  // are destroyed on the loading thread, so this is locked.
+  util::Synchronized<std::vector<std::vector<RenderableObject>>>
+      renderablesPendingDestruction_;
   std::vector<ForwardAllocateMappedBuffer> instanceDataBuffers_;
   util::BlockForwardAllocatedArena instanceDataCPUBuffer_;
   Simple2DCamera defaultCamera_;
 
   std::vector<DrawCommand> commands_;
 
-  uint32_t currentFrame_ = 0;
+  // Only advanced by the render thread, but read by destroyRenderable from
+  // any thread
+  std::atomic<uint32_t> currentFrame_ = 0;
+
+  std::optional<std::chrono::steady_clock::time_point> pendingInputTime_;
+  std::vector<std::optional<std::chrono::steady_clock::time_point>>
+      frameInputTimes_;
+  std::optional<std::chrono::microseconds> lastFrameLatency_;
 };
 
 } // namespace blocks::render
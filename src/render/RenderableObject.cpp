@@ -1,24 +1,55 @@
 #include "render/RenderableObject.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
-#include "render/VulkanBuffer.hpp"
+#include <vector>
+#include <vulkan/vulkan_core.h>
 #include "render/VulkanDescriptorPool.hpp"
+#include "render/VulkanMesh.hpp"
 #include "render/VulkanShaderProgram.hpp"
+#include "util/debug.hpp"
 
 namespace blocks::render {
 
 RenderableObject::RenderableObject(
     VulkanShaderProgram* shaderProgram,
     VulkanDescriptorPool descriptorPool,
-    VulkanBuffer vertexAttributes,
+    VulkanMesh* mesh,
     size_t instanceDataSize,
     std::unique_ptr<ResourceHolder> extraResources)
     : shaderProgram_(shaderProgram),
       descriptorPool_(std::move(descriptorPool)),
-      vertexAttributes_(std::move(vertexAttributes)),
+      mesh_(mesh),
       instanceDataSize_(instanceDataSize),
+      instanceStride_(instanceDataSize),
       extraResources_(std::move(extraResources)) {}
 
+RenderableObject::RenderableObject(
+    VulkanShaderProgram* shaderProgram,
+    std::vector<VkDescriptorSet> sharedDescriptorSets,
+    VulkanMesh* mesh,
+    size_t instanceDataSize,
+    size_t instanceStride,
+    std::vector<std::byte> constantInstanceData,
+    std::unique_ptr<ResourceHolder> extraResources)
+    : shaderProgram_(shaderProgram),
+      sharedDescriptorSets_(std::move(sharedDescriptorSets)),
+      mesh_(mesh),
+      instanceDataSize_(instanceDataSize),
+      instanceStride_(instanceStride),
+      constantInstanceData_(std::move(constantInstanceData)),
+      extraResources_(std::move(extraResources)) {
+  DEBUG_ASSERT(
+      instanceDataSize_ + constantInstanceData_.size() <= instanceStride_);
+}
+
+VkDescriptorSet RenderableObject::getDescriptorSet(uint32_t frame) const {
+  if (descriptorPool_.has_value()) {
+    return descriptorPool_->getDescriptorSets()[frame];
+  }
+  return sharedDescriptorSets_[frame];
+}
+
 } // namespace blocks::render
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include "render/VulkanBuffer.hpp"
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
 #include "render/VulkanDescriptorPool.hpp"
+#include "render/VulkanMesh.hpp"
 #include "render/VulkanShaderProgram.hpp"
 
 namespace blocks::render {
@@ -26,17 +31,34 @@ class RenderableObject {
   RenderableObject(
       VulkanShaderProgram* shaderProgram,
       VulkanDescriptorPool descriptorPool,
-      VulkanBuffer vertexAttributes,
+      VulkanMesh* mesh,
       size_t instanceDataSize,
       std::unique_ptr<ResourceHolder> extraResources = nullptr);
 
+  // Binds descriptor sets shared with other renderables, one per frame in
+  // flight, so draws of different objects can be batched together. The
+  // constant data is appended to every instance to let the shader tell the
+  // objects apart.
+  RenderableObject(
+      VulkanShaderProgram* shaderProgram,
+      std::vector<VkDescriptorSet> sharedDescriptorSets,
+      VulkanMesh* mesh,
+      size_t instanceDataSize,
+      size_t instanceStride,
+      std::vector<std::byte> constantInstanceData,
+      std::unique_ptr<ResourceHolder> extraResources = nullptr);
+
   [[nodiscard]] size_t getInstanceDataSize() const { return instanceDataSize_; }
+  [[nodiscard]] VkDescriptorSet getDescriptorSet(uint32_t frame) const;
 
  private:
   VulkanShaderProgram* shaderProgram_;
-  VulkanDescriptorPool descriptorPool_;
-  VulkanBuffer vertexAttributes_;
+  std::optional<VulkanDescriptorPool> descriptorPool_;
+  std::vector<VkDescriptorSet> sharedDescriptorSets_;
+  VulkanMesh* mesh_;
   size_t instanceDataSize_;
+  size_t instanceStride_;
+  std::vector<std::byte> constantInstanceData_;
   std::unique_ptr<ResourceHolder> extraResources_;
 
  public:
@@ -0,0 +1,143 @@
+#include "render/VulkanBindlessTextureArray.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "render/BindlessSlots.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanTexture.hpp"
+#include "render/vulkan/DescriptorSetLayoutBuilder.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr uint32_t kMaxBindlessTextures = 4096;
+
+} // namespace
+
+VulkanBindlessTextureArray::VulkanBindlessTextureArray(
+    VulkanGraphicsDevice& device, int framesInFlight)
+    : device_(&device),
+      capacity_(getCapacity(device)),
+      slots_(capacity_, framesInFlight),
+      layout_(makeDescriptorSetLayout(device)),
+      pool_(nullptr, nullptr),
+      descriptorSets_(framesInFlight) {
+  VkDescriptorPoolSize poolSize{};
+  poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  poolSize.descriptorCount = capacity_ * static_cast<uint32_t>(framesInFlight);
+
+  VkDescriptorPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes = &poolSize;
+  poolInfo.maxSets = static_cast<uint32_t>(framesInFlight);
+
+  VkDescriptorPool pool = nullptr;
+  if (vkCreateDescriptorPool(
+          device.getRawDevice(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create bindless descriptor pool"};
+  }
+  pool_ = vulkan::UniqueHandle<VkDescriptorPool>(pool, device.getRawDevice());
+
+  const std::vector<VkDescriptorSetLayout> layouts(
+      framesInFlight, layout_.get());
+  VkDescriptorSetAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.descriptorPool = pool;
+  allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+  allocInfo.pSetLayouts = layouts.data();
+
+  if (vkAllocateDescriptorSets(
+          device.getRawDevice(), &allocInfo, descriptorSets_.data()) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create bindless descriptor sets"};
+  }
+}
+
+bool VulkanBindlessTextureArray::isSupported(VulkanGraphicsDevice& device) {
+  return device.physicalInfo().optionalFeatures.bindlessTextures;
+}
+
+uint32_t VulkanBindlessTextureArray::getCapacity(VulkanGraphicsDevice& device) {
+  return std::min(
+      kMaxBindlessTextures,
+      device.physicalInfo().optionalFeatures.maxBindlessTextures);
+}
+
+vulkan::UniqueHandle<VkDescriptorSetLayout>
+VulkanBindlessTextureArray::makeDescriptorSetLayout(
+    VulkanGraphicsDevice& device) {
+  return vulkan::DescriptorSetLayoutBuilder()
+      .addBinding(
+          0,
+          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          getCapacity(device),
+          VK_SHADER_STAGE_FRAGMENT_BIT,
+          // NOLINTNEXTLINE(hicpp-signed-bitwise)
+          VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+              VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+      .setFlags(VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT)
+      .build(device.getRawDevice());
+}
+
+uint32_t VulkanBindlessTextureArray::add(const VulkanTexture& texture) {
+  const uint32_t index = slots_.allocate();
+  replace(index, texture);
+  return index;
+}
+
+void VulkanBindlessTextureArray::replace(
+    uint32_t index, const VulkanTexture& texture) {
+  slots_.write(
+      index,
+      Descriptor{
+          .imageView = texture.getImageView(),
+          .sampler = texture.getSampler()});
+}
+
+void VulkanBindlessTextureArray::remove(uint32_t index) {
+  slots_.free(index);
+}
+
+void VulkanBindlessTextureArray::beginFrame(uint32_t frame) {
+  const std::vector<BindlessSlots<Descriptor>::Write> writes =
+      slots_.takeWrites(frame);
+  if (writes.empty()) {
+    return;
+  }
+
+  std::vector<VkDescriptorImageInfo> imageInfos;
+  imageInfos.reserve(writes.size());
+  std::vector<VkWriteDescriptorSet> descriptorWrites;
+  descriptorWrites.reserve(writes.size());
+  for (const auto& pending : writes) {
+    VkDescriptorImageInfo& imageInfo = imageInfos.emplace_back();
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = pending.value.imageView;
+    imageInfo.sampler = pending.value.sampler;
+
+    VkWriteDescriptorSet& write = descriptorWrites.emplace_back();
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSets_[frame];
+    write.dstBinding = 0;
+    write.dstArrayElement = pending.index;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+  }
+
+  vkUpdateDescriptorSets(
+      device_->getRawDevice(),
+      static_cast<uint32_t>(descriptorWrites.size()),
+      descriptorWrites.data(),
+      0,
+      nullptr);
+}
+
+} // namespace blocks::render
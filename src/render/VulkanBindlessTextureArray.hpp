@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "render/BindlessSlots.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanTexture.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+
+namespace blocks::render {
+
+// Every texture in one array, indexed from instance data. Requires descriptor
+// indexing support on the device. There is a copy of the set for each frame in
+// flight, so a slot can be rewritten without touching a set the GPU may still
+// be reading.
+class VulkanBindlessTextureArray {
+ public:
+  VulkanBindlessTextureArray(VulkanGraphicsDevice& device, int framesInFlight);
+
+  static bool isSupported(VulkanGraphicsDevice& device);
+  static uint32_t getCapacity(VulkanGraphicsDevice& device);
+  static vulkan::UniqueHandle<VkDescriptorSetLayout> makeDescriptorSetLayout(
+      VulkanGraphicsDevice& device);
+
+  uint32_t add(const VulkanTexture& texture);
+  // Points an existing slot at a different texture
+  void replace(uint32_t index, const VulkanTexture& texture);
+  // The slot may be handed out again, so must no longer be drawn with
+  void remove(uint32_t index);
+
+  // Applies the writes made since the frame's set was last used, which must
+  // have finished rendering
+  void beginFrame(uint32_t frame);
+
+  [[nodiscard]] const std::vector<VkDescriptorSet>& getDescriptorSets() const {
+    return descriptorSets_;
+  }
+
+ private:
+  struct Descriptor {
+    VkImageView imageView;
+    VkSampler sampler;
+  };
+
+  VulkanGraphicsDevice* device_;
+  uint32_t capacity_;
+  // Its frames are indexed in parallel with descriptorSets_
+  BindlessSlots<Descriptor> slots_;
+  vulkan::UniqueHandle<VkDescriptorSetLayout> layout_;
+  vulkan::UniqueHandle<VkDescriptorPool> pool_;
+  std::vector<VkDescriptorSet> descriptorSets_;
+};
+
+} // namespace blocks::render
@@ -5,32 +5,59 @@
 #include <span>
 #include <vulkan/vulkan_core.h>
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
+#include "render/VulkanUploadManager.hpp"
 
 namespace blocks::render {
 
 VulkanBuffer::VulkanBuffer(
     VulkanGraphicsDevice& device,
     std::span<const std::byte> data,
-    VkBufferUsageFlags usageFlags)
+    VkBufferUsageFlags usageFlags,
+    MemoryPool pool)
     : rawBuffer_(device, data.size(), usageFlags),
-      memory_(device, rawBuffer_),
+      memory_(
+          device,
+          rawBuffer_,
+          // NOLINTNEXTLINE(hicpp-signed-bitwise)
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+          pool),
       size_(data.size()) {
-  vkBindBufferMemory(
-      device.getRawDevice(),
-      rawBuffer_.getRawBuffer(),
-      memory_.getRawMemory(),
-      0);
+  memcpy(memory_.getMappedPtr(), data.data(), data.size());
+}
 
-  void* buffData = nullptr;
-  vkMapMemory(
-      device.getRawDevice(),
-      memory_.getRawMemory(),
-      0,
-      data.size(),
-      0,
-      &buffData);
-  memcpy(buffData, data.data(), data.size());
-  vkUnmapMemory(device.getRawDevice(), memory_.getRawMemory());
+VulkanBuffer::VulkanBuffer(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    std::span<const std::byte> data,
+    VkBufferUsageFlags usageFlags)
+    : rawBuffer_(
+          device,
+          data.size(),
+          // NOLINTNEXTLINE(hicpp-signed-bitwise)
+          usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+      memory_(
+          device,
+          rawBuffer_,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+          MemoryPool::GENERAL),
+      size_(data.size()) {
+  uploadManager.uploadToBuffer(data, rawBuffer_.getRawBuffer());
 }
 
+VulkanBuffer::VulkanBuffer(
+    VulkanGraphicsDevice& device, size_t size, VkBufferUsageFlags usageFlags)
+    : rawBuffer_(
+          device,
+          size,
+          // NOLINTNEXTLINE(hicpp-signed-bitwise)
+          usageFlags | VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+      memory_(
+          device,
+          rawBuffer_,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+          MemoryPool::GENERAL),
+      size_(size) {}
+
 } // namespace blocks::render
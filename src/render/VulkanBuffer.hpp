@@ -5,7 +5,9 @@
 #include <vulkan/vulkan_core.h>
 #include "render/VulkanDeviceMemory.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 #include "render/VulkanRawBuffer.hpp"
+#include "render/VulkanUploadManager.hpp"
 
 namespace blocks::render {
 
@@ -14,6 +16,19 @@ class VulkanBuffer {
   VulkanBuffer(
       VulkanGraphicsDevice& device,
       std::span<const std::byte> data,
+      VkBufferUsageFlags usageFlags,
+      MemoryPool pool = MemoryPool::GENERAL);
+  // Device local, the data is copied in by the next upload batch
+  VulkanBuffer(
+      VulkanGraphicsDevice& device,
+      VulkanUploadManager& uploadManager,
+      std::span<const std::byte> data,
+      VkBufferUsageFlags usageFlags);
+  // Device local with undefined contents, filled in a part at a time with
+  // VulkanUploadManager::uploadToBuffer
+  VulkanBuffer(
+      VulkanGraphicsDevice& device,
+      size_t size,
       VkBufferUsageFlags usageFlags);
 
   VkBuffer getRawBuffer() { return rawBuffer_.getRawBuffer(); }
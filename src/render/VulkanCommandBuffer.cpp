@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 #include <vulkan/vulkan_core.h>
@@ -13,7 +14,8 @@ namespace blocks::render {
 
 VulkanCommandBuffer::VulkanCommandBuffer(
     VulkanGraphicsDevice& device, VulkanCommandPool& commandPool)
-    : commandBuffer_(
+    : device_(&device),
+      commandBuffer_(
           vulkan::CommandBufferBuilder{
               commandPool.getRawCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY}
               .build(device.getRawDevice())),
@@ -22,18 +24,38 @@ VulkanCommandBuffer::VulkanCommandBuffer(
 void VulkanCommandBuffer::submit(
     const std::vector<VkSemaphore>& waitSemaphores,
     const std::vector<VkSemaphore>& signalSemaphores,
-    VkFence signalFence) {
+    VkFence signalFence,
+    std::optional<TimelineWait> timelineWait) {
+  std::vector<VkSemaphore> allWaitSemaphores = waitSemaphores;
   std::vector<VkPipelineStageFlags> waitStages;
-  waitStages.reserve(waitSemaphores.size());
+  std::vector<uint64_t> waitValues;
+  waitStages.reserve(waitSemaphores.size() + 1);
+  waitValues.reserve(waitSemaphores.size() + 1);
   for (size_t i = 0; i < waitSemaphores.size(); i++) {
     waitStages.emplace_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    // Ignored for binary semaphores
+    waitValues.emplace_back(0);
   }
 
   VkSubmitInfo submitInfo{};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
-  submitInfo.pWaitSemaphores = waitSemaphores.data();
+  VkTimelineSemaphoreSubmitInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  if (timelineWait.has_value()) {
+    allWaitSemaphores.emplace_back(timelineWait->semaphore);
+    waitStages.emplace_back(timelineWait->stage);
+    waitValues.emplace_back(timelineWait->value);
+
+    timelineInfo.waitSemaphoreValueCount =
+        static_cast<uint32_t>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    submitInfo.pNext = &timelineInfo;
+  }
+
+  submitInfo.waitSemaphoreCount =
+      static_cast<uint32_t>(allWaitSemaphores.size());
+  submitInfo.pWaitSemaphores = allWaitSemaphores.data();
   submitInfo.pWaitDstStageMask = waitStages.data();
 
   submitInfo.commandBufferCount = 1;
@@ -43,6 +65,7 @@ void VulkanCommandBuffer::submit(
       static_cast<uint32_t>(signalSemaphores.size());
   submitInfo.pSignalSemaphores = signalSemaphores.data();
 
+  const auto queueLock = device_->lockQueues();
   if (vkQueueSubmit(queue_, 1, &submitInfo, signalFence) != VK_SUCCESS) {
     throw std::runtime_error{"Failed to submit draw command buffer"};
   }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -11,17 +13,25 @@ namespace blocks::render {
 
 class VulkanCommandBuffer {
  public:
+  struct TimelineWait {
+    VkSemaphore semaphore;
+    uint64_t value;
+    VkPipelineStageFlags stage;
+  };
+
   VulkanCommandBuffer(
       VulkanGraphicsDevice& device, VulkanCommandPool& commandPool);
 
   void submit(
       const std::vector<VkSemaphore>& waitSemaphores,
       const std::vector<VkSemaphore>& signalSemaphores,
-      VkFence signalFence);
+      VkFence signalFence,
+      std::optional<TimelineWait> timelineWait = std::nullopt);
 
   VkCommandBuffer getRawBuffer() { return commandBuffer_.get(); }
 
  private:
+  VulkanGraphicsDevice* device_;
   vulkan::UniqueHandle<VkCommandBuffer> commandBuffer_;
   VkQueue queue_;
 };
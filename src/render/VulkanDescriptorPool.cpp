@@ -15,13 +15,17 @@ VulkanDescriptorPool::VulkanDescriptorPool(
     VkDescriptorSetLayout layout,
     int maxFramesInFlight)
     : pool_(nullptr, nullptr) {
-  std::array<VkDescriptorPoolSize, 2> poolSizes{};
+  std::array<VkDescriptorPoolSize, 3> poolSizes{};
   poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
   poolSizes[0].descriptorCount = static_cast<uint32_t>(maxFramesInFlight);
 
   poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
   poolSizes[1].descriptorCount = static_cast<uint32_t>(maxFramesInFlight);
 
+  // The font shader binds its curve and band buffers separately
+  poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  poolSizes[2].descriptorCount = static_cast<uint32_t>(maxFramesInFlight) * 2;
+
   VkDescriptorPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
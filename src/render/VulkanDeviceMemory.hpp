@@ -2,26 +2,34 @@
 
 #include <vulkan/vulkan_core.h>
 
-#include <cstdint>
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 #include "render/VulkanRawBuffer.hpp"
-#include "render/vulkan/UniqueHandle.hpp"
 
 namespace blocks::render {
 
-uint32_t findMemoryType(
-    const VkMemoryRequirements& requirements,
-    const VkPhysicalDeviceMemoryProperties& memProperties,
-    VkMemoryPropertyFlags properties);
-
 class VulkanDeviceMemory {
  public:
-  VulkanDeviceMemory(VulkanGraphicsDevice& device, VulkanRawBuffer& rawBuffer);
-
-  VkDeviceMemory getRawMemory() { return memory_.get(); }
+  VulkanDeviceMemory(
+      VulkanGraphicsDevice& device,
+      VulkanRawBuffer& rawBuffer,
+      VkMemoryPropertyFlags properties,
+      MemoryPool pool);
+  VulkanDeviceMemory(
+      VulkanGraphicsDevice& device,
+      VkImage image,
+      VkMemoryPropertyFlags properties,
+      MemoryPool pool);
+
+  VkDeviceMemory getRawMemory() { return allocation_.getRawMemory(); }
+  [[nodiscard]] VkDeviceSize getOffset() const {
+    return allocation_.getOffset();
+  }
+  [[nodiscard]] VkDeviceSize getSize() const { return allocation_.size(); }
+  void* getMappedPtr() { return allocation_.getMappedPtr(); }
 
  private:
-  vulkan::UniqueHandle<VkDeviceMemory> memory_;
+  VulkanMemoryAllocator::Allocation allocation_;
 };
 
 } // namespace blocks::render
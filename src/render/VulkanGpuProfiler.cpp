@@ -0,0 +1,224 @@
+#include "render/VulkanGpuProfiler.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "log/Logger.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+#include "util/debug.hpp"
+#include "util/string.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+// Two queries per scope
+constexpr uint32_t kQueriesPerFrame = 256;
+
+vulkan::UniqueHandle<VkQueryPool> makeQueryPool(VulkanGraphicsDevice& device) {
+  VkQueryPoolCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  createInfo.queryCount = kQueriesPerFrame;
+
+  VkQueryPool queryPool = nullptr;
+  if (vkCreateQueryPool(
+          device.getRawDevice(), &createInfo, nullptr, &queryPool) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create query pool"};
+  }
+  return vulkan::UniqueHandle<VkQueryPool>{queryPool, device.getRawDevice()};
+}
+
+uint64_t getTimestampMask(uint32_t validBits) {
+  return validBits >= 64 ? UINT64_MAX : (uint64_t{1} << validBits) - 1;
+}
+
+} // namespace
+
+VulkanGpuProfiler::VulkanGpuProfiler(
+    VulkanGraphicsDevice& device, size_t framesInFlight)
+    : device_(&device),
+      nsPerTick_(device.physicalInfo().properties.limits.timestampPeriod),
+      timestampMask_(getTimestampMask(
+          device.physicalInfo().queueFamilies.graphicsTimestampValidBits)) {
+  if (device.physicalInfo().queueFamilies.graphicsTimestampValidBits == 0 ||
+      nsPerTick_ <= 0.0) {
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::WARNING,
+        "Timestamp queries not supported, GPU profiling is disabled");
+    return;
+  }
+
+  frames_.reserve(framesInFlight);
+  for (size_t i = 0; i < framesInFlight; i++) {
+    frames_.emplace_back(FrameQueries{.queryPool = makeQueryPool(device)});
+  }
+}
+
+void VulkanGpuProfiler::beginFrame(size_t frameIndex) {
+  if (!isSupported()) {
+    return;
+  }
+
+  DEBUG_ASSERT(frameIndex < frames_.size());
+  currentFrame_ = frameIndex;
+  FrameQueries& frame = frames_[currentFrame_];
+  collectResults(frame);
+  frame.scopes.clear();
+  frame.queryCount = 0;
+  frame.resetRecorded = false;
+}
+
+void VulkanGpuProfiler::recordCommandBufferStart(
+    VkCommandBuffer commandBuffer) {
+  if (!isSupported()) {
+    return;
+  }
+
+  // Queries are executed in submission order, so resetting the pool in the
+  // first command buffer of the frame covers every later one
+  FrameQueries& frame = frames_[currentFrame_];
+  if (!frame.resetRecorded) {
+    vkCmdResetQueryPool(
+        commandBuffer, frame.queryPool.get(), 0, kQueriesPerFrame);
+    frame.resetRecorded = true;
+  }
+}
+
+VulkanGpuProfiler::ScopeId VulkanGpuProfiler::beginScope(
+    VkCommandBuffer commandBuffer, std::string_view label) {
+  if (!isSupported()) {
+    return kInvalidScope;
+  }
+
+  FrameQueries& frame = frames_[currentFrame_];
+  DEBUG_ASSERT(frame.resetRecorded);
+  if (frame.queryCount + 2 > kQueriesPerFrame) {
+    return kInvalidScope;
+  }
+
+  auto it = labelIndices_.find(label);
+  if (it == labelIndices_.end()) {
+    it = labelIndices_.emplace(std::string{label}, histories_.size()).first;
+    histories_.emplace_back(History{.label = std::string{label}});
+  }
+
+  const ScopeId scope = frame.queryCount;
+  frame.queryCount += 2;
+  frame.scopes.emplace_back(
+      PendingScope{.labelIndex = it->second, .firstQuery = scope});
+
+  vkCmdWriteTimestamp(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      frame.queryPool.get(),
+      scope);
+  return scope;
+}
+
+void VulkanGpuProfiler::endScope(
+    VkCommandBuffer commandBuffer, ScopeId scope) {
+  if (scope == kInvalidScope) {
+    return;
+  }
+
+  vkCmdWriteTimestamp(
+      commandBuffer,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      frames_[currentFrame_].queryPool.get(),
+      scope + 1);
+}
+
+std::vector<VulkanGpuProfiler::Statistics> VulkanGpuProfiler::getStatistics()
+    const {
+  std::vector<Statistics> result;
+  result.reserve(histories_.size());
+  for (const History& history : histories_) {
+    const size_t count = std::min(history.sampleCount, kHistoryLength);
+    if (count == 0) {
+      continue;
+    }
+
+    double minMs = history.samplesMs[0];
+    double maxMs = history.samplesMs[0];
+    double totalMs = 0.0;
+    for (size_t i = 0; i < count; i++) {
+      minMs = std::min(minMs, history.samplesMs[i]);
+      maxMs = std::max(maxMs, history.samplesMs[i]);
+      totalMs += history.samplesMs[i];
+    }
+
+    result.emplace_back(
+        Statistics{
+            .label = history.label,
+            .sampleCount = count,
+            .minMs = minMs,
+            .avgMs = totalMs / static_cast<double>(count),
+            .maxMs = maxMs});
+  }
+  return result;
+}
+
+void VulkanGpuProfiler::logStatistics() const {
+  for (const Statistics& stats : getStatistics()) {
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::INFO,
+        util::toString(
+            "GPU time for ",
+            stats.label,
+            ": avg ",
+            stats.avgMs,
+            "ms, min ",
+            stats.minMs,
+            "ms, max ",
+            stats.maxMs,
+            "ms over ",
+            stats.sampleCount,
+            " samples"));
+  }
+}
+
+void VulkanGpuProfiler::collectResults(FrameQueries& frame) {
+  if (frame.queryCount == 0) {
+    return;
+  }
+
+  std::vector<uint64_t> timestamps(frame.queryCount);
+  const VkResult result = vkGetQueryPoolResults(
+      device_->getRawDevice(),
+      frame.queryPool.get(),
+      0,
+      frame.queryCount,
+      timestamps.size() * sizeof(uint64_t),
+      timestamps.data(),
+      sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS) {
+    // Only possible if a command buffer was recorded but never submitted
+    return;
+  }
+
+  for (const PendingScope& scope : frame.scopes) {
+    const uint64_t ticks = (timestamps[scope.firstQuery + 1] -
+                            timestamps[scope.firstQuery]) &
+        timestampMask_;
+    addSample(
+        scope.labelIndex, static_cast<double>(ticks) * nsPerTick_ / 1000000.0);
+  }
+}
+
+void VulkanGpuProfiler::addSample(size_t labelIndex, double sampleMs) {
+  History& history = histories_[labelIndex];
+  history.samplesMs[history.next] = sampleMs;
+  history.next = (history.next + 1) % kHistoryLength;
+  history.sampleCount++;
+}
+
+} // namespace blocks::render
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+
+namespace blocks::render {
+
+// Measures GPU time for labelled scopes of command buffers using timestamp
+// queries. Each frame in flight has its own query pool, whose results are
+// collected the next time that frame is started, by which point the caller
+// has already waited for them, so reading them back never stalls.
+class VulkanGpuProfiler {
+ public:
+  using ScopeId = uint32_t;
+  static constexpr ScopeId kInvalidScope = UINT32_MAX;
+
+  struct Statistics {
+    std::string label;
+    size_t sampleCount;
+    double minMs;
+    double avgMs;
+    double maxMs;
+  };
+
+  VulkanGpuProfiler(VulkanGraphicsDevice& device, size_t framesInFlight);
+
+  [[nodiscard]] bool isSupported() const { return !frames_.empty(); }
+
+  // All command buffers previously submitted for this frame must have
+  // completed
+  void beginFrame(size_t frameIndex);
+  // Must be recorded outside of a render pass, before any scopes in the
+  // command buffer
+  void recordCommandBufferStart(VkCommandBuffer commandBuffer);
+
+  ScopeId beginScope(VkCommandBuffer commandBuffer, std::string_view label);
+  void endScope(VkCommandBuffer commandBuffer, ScopeId scope);
+
+  // Rolling statistics over the most recent kHistoryLength samples of each
+  // label
+  [[nodiscard]] std::vector<Statistics> getStatistics() const;
+  void logStatistics() const;
+
+ private:
+  static constexpr size_t kHistoryLength = 128;
+
+  struct PendingScope {
+    size_t labelIndex;
+    uint32_t firstQuery;
+  };
+
+  struct FrameQueries {
+    vulkan::UniqueHandle<VkQueryPool> queryPool;
+    std::vector<PendingScope> scopes;
+    uint32_t queryCount = 0;
+    bool resetRecorded = false;
+  };
+
+  struct History {
+    std::string label;
+    std::array<double, kHistoryLength> samplesMs{};
+    size_t sampleCount = 0;
+    size_t next = 0;
+  };
+
+  void collectResults(FrameQueries& frame);
+  void addSample(size_t labelIndex, double sampleMs);
+
+  VulkanGraphicsDevice* device_;
+  double nsPerTick_;
+  uint64_t timestampMask_;
+  std::vector<FrameQueries> frames_;
+  size_t currentFrame_ = 0;
+  std::map<std::string, size_t, std::less<>> labelIndices_;
+  std::vector<History> histories_;
+};
+
+} // namespace blocks::render
@@ -5,7 +5,9 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -16,6 +18,7 @@
 #include <vulkan/vulkan_core.h>
 #include "log/Logger.hpp"
 #include "render/VulkanInstance.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 #include "render/validationLayers.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
 #include "util/debug.hpp"
@@ -29,7 +32,7 @@ constexpr std::array<const char*, 1> requiredDeviceExtensions{
     VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
 VulkanGraphicsDevice::QueueFamilyIndices findQueueFamilies(
-    VkInstance instance, VkPhysicalDevice device) {
+    VkInstance instance, VkPhysicalDevice device, bool headless) {
   VulkanGraphicsDevice::QueueFamilyIndices indices;
 
   uint32_t queueFamilyCount = 0;
@@ -43,6 +46,12 @@ VulkanGraphicsDevice::QueueFamilyIndices findQueueFamilies(
     // NOLINTNEXTLINE(hicpp-signed-bitwise)
     if ((queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) > 0) {
       indices.graphicsFamily = i;
+      indices.graphicsQueueCount = queueFamilies[i].queueCount;
+      indices.graphicsTimestampValidBits =
+          queueFamilies[i].timestampValidBits;
+    }
+    if (headless) {
+      continue;
     }
     VkBool32 presentSupport = VK_FALSE;
     presentSupport =
@@ -69,7 +78,15 @@ std::vector<VkPhysicalDevice> enumerateDevices(VulkanInstance& instance) {
   return physicalDevices;
 }
 
-bool deviceHasRequiredExtensionSupport(VkPhysicalDevice device) {
+std::span<const char* const> getRequiredDeviceExtensions(bool headless) {
+  if (headless) {
+    return {};
+  }
+  return requiredDeviceExtensions;
+}
+
+bool deviceHasRequiredExtensionSupport(
+    VkPhysicalDevice device, bool headless) {
   uint32_t extensionCount = 0;
   vkEnumerateDeviceExtensionProperties(
       device, nullptr, &extensionCount, nullptr);
@@ -78,7 +95,7 @@ bool deviceHasRequiredExtensionSupport(VkPhysicalDevice device) {
   vkEnumerateDeviceExtensionProperties(
       device, nullptr, &extensionCount, availableExtensions.data());
 
-  for (const auto& required : requiredDeviceExtensions) {
+  for (const auto& required : getRequiredDeviceExtensions(headless)) {
     bool found = false;
     for (const auto& available : availableExtensions) {
       if (strcmp(required, static_cast<const char*>(available.extensionName)) ==
@@ -96,17 +113,15 @@ bool deviceHasRequiredExtensionSupport(VkPhysicalDevice device) {
   return true;
 }
 
-bool isDeviceSuitable(const VulkanGraphicsDevice::PhysicalDeviceInfo& device) {
-  if (device.features.geometryShader == VK_FALSE) {
-    return false;
-  }
+bool isDeviceSuitable(
+    const VulkanGraphicsDevice::PhysicalDeviceInfo& device, bool headless) {
   if (!device.queueFamilies.graphicsFamily.has_value()) {
     return false;
   }
-  if (!device.queueFamilies.presentFamily.has_value()) {
+  if (!headless && !device.queueFamilies.presentFamily.has_value()) {
     return false;
   }
-  if (!deviceHasRequiredExtensionSupport(device.device)) {
+  if (!deviceHasRequiredExtensionSupport(device.device, headless)) {
     return false;
   }
 
@@ -114,8 +129,8 @@ bool isDeviceSuitable(const VulkanGraphicsDevice::PhysicalDeviceInfo& device) {
 }
 
 unsigned int deviceSuitabilityHeuristic(
-    const VulkanGraphicsDevice::PhysicalDeviceInfo& device) {
-  if (!isDeviceSuitable(device)) {
+    const VulkanGraphicsDevice::PhysicalDeviceInfo& device, bool headless) {
+  if (!isDeviceSuitable(device, headless)) {
     return 0;
   }
 
@@ -133,7 +148,7 @@ unsigned int deviceSuitabilityHeuristic(
 }
 
 std::unique_ptr<VulkanGraphicsDevice::PhysicalDeviceInfo> choosePhysicalDevice(
-    VulkanInstance& instance) {
+    VulkanInstance& instance, bool headless) {
   const std::vector<VkPhysicalDevice> devices = enumerateDevices(instance);
 
   std::vector<std::pair<
@@ -144,9 +159,9 @@ std::unique_ptr<VulkanGraphicsDevice::PhysicalDeviceInfo> choosePhysicalDevice(
   for (const auto& device : devices) {
     auto deviceInfo =
         std::make_unique<VulkanGraphicsDevice::PhysicalDeviceInfo>(
-            instance.getRawInstance(), device);
+            instance.getRawInstance(), device, headless);
     const unsigned int suitabilityHeuristic =
-        deviceSuitabilityHeuristic(*deviceInfo);
+        deviceSuitabilityHeuristic(*deviceInfo, headless);
     if (suitabilityHeuristic > 0) {
       rankedDevices.emplace_back(std::move(deviceInfo), suitabilityHeuristic);
     }
@@ -175,6 +190,41 @@ std::unique_ptr<VulkanGraphicsDevice::PhysicalDeviceInfo> choosePhysicalDevice(
   return std::move(rankedDevices[0].first);
 }
 
+VulkanGraphicsDevice::OptionalFeatures findOptionalFeatures(
+    VkPhysicalDevice device, const VkPhysicalDeviceProperties& properties) {
+  VulkanGraphicsDevice::OptionalFeatures result;
+  if (properties.apiVersion < VK_API_VERSION_1_2) {
+    return result;
+  }
+
+  VkPhysicalDeviceVulkan12Features features12{};
+  features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &features12;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  VkPhysicalDeviceVulkan12Properties properties12{};
+  properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+  VkPhysicalDeviceProperties2 properties2{};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &properties12;
+  vkGetPhysicalDeviceProperties2(device, &properties2);
+
+  result.bindlessTextures = features12.runtimeDescriptorArray == VK_TRUE &&
+      features12.shaderSampledImageArrayNonUniformIndexing == VK_TRUE &&
+      features12.descriptorBindingPartiallyBound == VK_TRUE &&
+      features12.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE;
+  result.maxBindlessTextures = std::min(
+      {properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+       properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+       properties12.maxDescriptorSetUpdateAfterBindSamplers,
+       properties12.maxDescriptorSetUpdateAfterBindSampledImages});
+  result.timelineSemaphores = features12.timelineSemaphore == VK_TRUE;
+
+  return result;
+}
+
 struct VkDeviceQueueCreateInfoWrapper {
   VkDeviceQueueCreateInfoWrapper() = default;
   ~VkDeviceQueueCreateInfoWrapper() = default;
@@ -196,9 +246,10 @@ void makeQueueCreateInfo(
     const VulkanGraphicsDevice::QueueFamilyIndices& indices) {
   DEBUG_ASSERT(result.createInfo.size() == 0);
   DEBUG_ASSERT(indices.graphicsFamily.has_value());
-  DEBUG_ASSERT(indices.presentFamily.has_value());
-  const std::unordered_set<uint32_t> uniqueIndices{
-      *indices.graphicsFamily, *indices.presentFamily};
+  std::unordered_set<uint32_t> uniqueIndices{*indices.graphicsFamily};
+  if (indices.presentFamily.has_value()) {
+    uniqueIndices.insert(*indices.presentFamily);
+  }
 
   result.createInfo.reserve(uniqueIndices.size());
 
@@ -206,7 +257,10 @@ void makeQueueCreateInfo(
     VkDeviceQueueCreateInfo& queueCreateInfo = result.createInfo.emplace_back();
     queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueCreateInfo.queueFamilyIndex = queueFamily;
-    queueCreateInfo.queueCount = queueFamily == *indices.graphicsFamily ? 2 : 1;
+    // A second graphics queue is used for loading where available
+    queueCreateInfo.queueCount = queueFamily == *indices.graphicsFamily
+        ? std::min(indices.graphicsQueueCount, 2u)
+        : 1;
     queueCreateInfo.pQueuePriorities = &result.queuePriority;
   }
 }
@@ -214,11 +268,12 @@ void makeQueueCreateInfo(
 } // namespace
 
 VulkanGraphicsDevice::PhysicalDeviceInfo::PhysicalDeviceInfo(
-    VkInstance instance, VkPhysicalDevice device)
+    VkInstance instance, VkPhysicalDevice device, bool headless)
     : device(device), properties(0), features(0) {
   vkGetPhysicalDeviceProperties(device, &properties);
   vkGetPhysicalDeviceFeatures(device, &features);
-  queueFamilies = findQueueFamilies(instance, device);
+  queueFamilies = findQueueFamilies(instance, device, headless);
+  optionalFeatures = findOptionalFeatures(device, properties);
 }
 
 VulkanGraphicsDevice::VulkanGraphicsDevice(
@@ -226,16 +281,20 @@ VulkanGraphicsDevice::VulkanGraphicsDevice(
     VkQueue graphicsQueue,
     VkQueue graphicsLoadingQueue,
     VkQueue presentQueue,
-    std::unique_ptr<PhysicalDeviceInfo> physicalInfo)
+    std::unique_ptr<PhysicalDeviceInfo> physicalInfo,
+    std::unique_ptr<VulkanMemoryAllocator> allocator)
     : device_(std::move(device)),
+      allocator_(std::move(allocator)),
       graphicsQueue_(graphicsQueue),
       graphicsLoadingQueue_(graphicsLoadingQueue),
       presentQueue_(presentQueue),
-      physicalInfo_(std::move(physicalInfo)) {}
+      physicalInfo_(std::move(physicalInfo)),
+      queueMutex_(std::make_unique<std::mutex>()) {}
 
-VulkanGraphicsDevice VulkanGraphicsDevice::make(VulkanInstance& instance) {
+VulkanGraphicsDevice VulkanGraphicsDevice::make(
+    VulkanInstance& instance, bool headless) {
   std::unique_ptr<PhysicalDeviceInfo> physicalDevice =
-      choosePhysicalDevice(instance);
+      choosePhysicalDevice(instance, headless);
   DEBUG_ASSERT(physicalDevice != nullptr);
   log::LoggerSystem::logToDefault(
       log::LogLevel::INFO,
@@ -246,18 +305,39 @@ VulkanGraphicsDevice VulkanGraphicsDevice::make(VulkanInstance& instance) {
   VkDeviceQueueCreateInfoWrapper queueCreateInfo{};
   makeQueueCreateInfo(queueCreateInfo, physicalDevice->queueFamilies);
 
-  const VkPhysicalDeviceFeatures deviceFeatures{};
+  VkPhysicalDeviceFeatures deviceFeatures{};
+  // For pre-compressed textures, which also check format support on load
+  deviceFeatures.textureCompressionBC =
+      physicalDevice->features.textureCompressionBC;
+
+  const OptionalFeatures& optionalFeatures = physicalDevice->optionalFeatures;
+  VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+  deviceFeatures12.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+  if (optionalFeatures.bindlessTextures) {
+    deviceFeatures12.runtimeDescriptorArray = VK_TRUE;
+    deviceFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    deviceFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+    deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  }
+  if (optionalFeatures.timelineSemaphores) {
+    deviceFeatures12.timelineSemaphore = VK_TRUE;
+  }
 
   VkDeviceCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  if (physicalDevice->properties.apiVersion >= VK_API_VERSION_1_2) {
+    createInfo.pNext = &deviceFeatures12;
+  }
   createInfo.pQueueCreateInfos = queueCreateInfo.createInfo.data();
   createInfo.queueCreateInfoCount =
       static_cast<uint32_t>(queueCreateInfo.createInfo.size());
   createInfo.pEnabledFeatures = &deviceFeatures;
 
-  createInfo.enabledExtensionCount =
-      static_cast<uint32_t>(requiredDeviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
+  const std::span<const char* const> extensions =
+      getRequiredDeviceExtensions(headless);
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+  createInfo.ppEnabledExtensionNames = extensions.data();
 
   if (kEnableValidationLayers) {
     createInfo.enabledLayerCount =
@@ -282,28 +362,37 @@ VulkanGraphicsDevice VulkanGraphicsDevice::make(VulkanInstance& instance) {
       0,
       &graphicsQueue);
 
-  VkQueue graphicsLoadingQueue = nullptr;
-  vkGetDeviceQueue(
-      device,
-      // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-      physicalDevice->queueFamilies.graphicsFamily.value(),
-      1,
-      &graphicsLoadingQueue);
+  // Software rasterisers typically only expose a single graphics queue
+  VkQueue graphicsLoadingQueue = graphicsQueue;
+  if (physicalDevice->queueFamilies.graphicsQueueCount > 1) {
+    vkGetDeviceQueue(
+        device,
+        // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+        physicalDevice->queueFamilies.graphicsFamily.value(),
+        1,
+        &graphicsLoadingQueue);
+  }
 
   VkQueue presentQueue = nullptr;
-  vkGetDeviceQueue(
-      device,
-      // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
-      physicalDevice->queueFamilies.presentFamily.value(),
-      0,
-      &presentQueue);
+  if (physicalDevice->queueFamilies.presentFamily.has_value()) {
+    vkGetDeviceQueue(
+        device,
+        *physicalDevice->queueFamilies.presentFamily,
+        0,
+        &presentQueue);
+  }
+
+  vulkan::UniqueHandle<VkDevice> deviceHandle{device};
+  auto allocator =
+      std::make_unique<VulkanMemoryAllocator>(device, physicalDevice->device);
 
   return {
-      vulkan::UniqueHandle<VkDevice>{device},
+      std::move(deviceHandle),
       graphicsQueue,
       graphicsLoadingQueue,
       presentQueue,
-      std::move(physicalDevice)};
+      std::move(physicalDevice),
+      std::move(allocator)};
 }
 
 } // namespace blocks::render
@@ -2,10 +2,12 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <vulkan/vulkan_core.h>
 
 #include "render/VulkanInstance.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
 
 namespace blocks::render {
@@ -15,18 +17,31 @@ class VulkanGraphicsDevice {
   struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    uint32_t graphicsQueueCount = 0;
+    // Zero if the graphics queue cannot write timestamps
+    uint32_t graphicsTimestampValidBits = 0;
+  };
+
+  struct OptionalFeatures {
+    bool bindlessTextures = false;
+    uint32_t maxBindlessTextures = 0;
+    bool timelineSemaphores = false;
   };
 
   struct PhysicalDeviceInfo {
-    explicit PhysicalDeviceInfo(VkInstance instance, VkPhysicalDevice device);
+    explicit PhysicalDeviceInfo(
+        VkInstance instance, VkPhysicalDevice device, bool headless);
 
     VkPhysicalDevice device;
     VkPhysicalDeviceProperties properties;
     VkPhysicalDeviceFeatures features;
     QueueFamilyIndices queueFamilies;
+    OptionalFeatures optionalFeatures;
   };
 
-  static VulkanGraphicsDevice make(VulkanInstance& instance);
+  // Headless devices need neither presentation support nor a swap chain
+  static VulkanGraphicsDevice make(
+      VulkanInstance& instance, bool headless = false);
 
   [[nodiscard]] const PhysicalDeviceInfo& physicalInfo() const {
     return *physicalInfo_;
@@ -36,6 +51,13 @@ class VulkanGraphicsDevice {
   VkQueue getGraphicsQueue() { return graphicsQueue_; }
   VkQueue getGraphicsLoadingQueue() { return graphicsLoadingQueue_; }
   VkQueue getPresentQueue() { return presentQueue_; }
+  VulkanMemoryAllocator& getAllocator() { return *allocator_; }
+
+  // The loading queue is the graphics queue on devices with only one, so all
+  // queue submission and presentation must hold this lock
+  [[nodiscard]] std::unique_lock<std::mutex> lockQueues() {
+    return std::unique_lock{*queueMutex_};
+  }
 
  private:
   VulkanGraphicsDevice(
@@ -43,13 +65,17 @@ class VulkanGraphicsDevice {
       VkQueue graphicsQueue,
       VkQueue graphicsLoadingQueue,
       VkQueue presentQueue,
-      std::unique_ptr<PhysicalDeviceInfo> physicalInfo);
+      std::unique_ptr<PhysicalDeviceInfo> physicalInfo,
+      std::unique_ptr<VulkanMemoryAllocator> allocator);
 
   vulkan::UniqueHandle<VkDevice> device_;
+  // Declared after device_ so that it is destroyed first
+  std::unique_ptr<VulkanMemoryAllocator> allocator_;
   VkQueue graphicsQueue_;
   VkQueue graphicsLoadingQueue_;
   VkQueue presentQueue_;
   std::unique_ptr<PhysicalDeviceInfo> physicalInfo_;
+  std::unique_ptr<std::mutex> queueMutex_;
 };
 
 } // namespace blocks::render
@@ -15,6 +15,7 @@ VulkanGraphicsPipeline::VulkanGraphicsPipeline(
     VulkanGraphicsDevice& device,
     VkFormat /* imageFormat */,
     VkRenderPass renderPass,
+    VkPipelineCache pipelineCache,
     VulkanVertexShader& vertexShader,
     VulkanShader& fragmentShader,
     VkDescriptorSetLayout descriptorLayout)
@@ -126,7 +127,7 @@ VulkanGraphicsPipeline::VulkanGraphicsPipeline(
   VkPipeline pipeline = nullptr;
   const VkResult result = vkCreateGraphicsPipelines(
       device.getRawDevice(),
-      VK_NULL_HANDLE,
+      pipelineCache,
       1,
       &pipelineInfo,
       nullptr,
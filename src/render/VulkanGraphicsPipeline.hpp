@@ -15,6 +15,7 @@ class VulkanGraphicsPipeline {
       VulkanGraphicsDevice& device,
       VkFormat imageFormat,
       VkRenderPass renderPass,
+      VkPipelineCache pipelineCache,
       VulkanVertexShader& vertexShader,
       VulkanShader& fragmentShader,
       VkDescriptorSetLayout descriptorLayout);
@@ -83,7 +83,7 @@ bool validateRequiredExtensions(
 
 } // namespace
 
-VulkanInstance::VulkanInstance() : instance_(nullptr) {
+VulkanInstance::VulkanInstance(bool headless) : instance_(nullptr) {
   log::LoggerSystem::logToDefault(log::LogLevel::INFO, "Initialising Vulkan");
   std::string availableExtensionsString = "Available Vulkan extensions:\n";
   const auto supportedExtensions = getSupportedExtensions();
@@ -102,7 +102,7 @@ VulkanInstance::VulkanInstance() : instance_(nullptr) {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo{};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -122,14 +122,16 @@ VulkanInstance::VulkanInstance() : instance_(nullptr) {
     }
   }
 
-  uint32_t glfwExtensionCount = 0;
-  const char** glfwExtensions =
-      glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char*> extensions{
-      glfwExtensions,
-      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-      glfwExtensions + glfwExtensionCount};
+  std::vector<const char*> extensions;
+  if (!headless) {
+    uint32_t glfwExtensionCount = 0;
+    const char** glfwExtensions =
+        glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(
+        glfwExtensions,
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        glfwExtensions + glfwExtensionCount);
+  }
   if (kEnableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
@@ -8,7 +8,8 @@ namespace blocks::render {
 
 class VulkanInstance {
  public:
-  VulkanInstance();
+  // Headless instances do not enable any window system extensions
+  explicit VulkanInstance(bool headless = false);
 
   VkInstance getRawInstance() { return instance_.get(); }
 
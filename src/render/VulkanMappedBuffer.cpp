@@ -3,25 +3,22 @@
 #include <cstddef>
 #include <vulkan/vulkan_core.h>
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 
 namespace blocks::render {
 
 VulkanMappedBuffer::VulkanMappedBuffer(
-    VulkanGraphicsDevice& device, size_t size, VkBufferUsageFlags usageFlags)
-    : rawBuffer_(device, size, usageFlags), memory_(device, rawBuffer_) {
-  vkBindBufferMemory(
-      device.getRawDevice(),
-      rawBuffer_.getRawBuffer(),
-      memory_.getRawMemory(),
-      0);
-
-  vkMapMemory(
-      device.getRawDevice(),
-      memory_.getRawMemory(),
-      0,
-      size,
-      0,
-      &mappedBuffer_);
-}
+    VulkanGraphicsDevice& device,
+    size_t size,
+    VkBufferUsageFlags usageFlags,
+    MemoryPool pool)
+    : rawBuffer_(device, size, usageFlags),
+      memory_(
+          device,
+          rawBuffer_,
+          // NOLINTNEXTLINE(hicpp-signed-bitwise)
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+          pool) {}
 
 } // namespace blocks::render
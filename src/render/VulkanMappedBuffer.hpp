@@ -4,6 +4,7 @@
 
 #include "render/VulkanDeviceMemory.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
 #include "render/VulkanRawBuffer.hpp"
 
 namespace blocks::render {
@@ -11,16 +12,18 @@ namespace blocks::render {
 class VulkanMappedBuffer {
  public:
   VulkanMappedBuffer(
-      VulkanGraphicsDevice& device, size_t size, VkBufferUsageFlags usageFlags);
+      VulkanGraphicsDevice& device,
+      size_t size,
+      VkBufferUsageFlags usageFlags,
+      MemoryPool pool = MemoryPool::GENERAL);
 
   VkBuffer getRawBuffer() { return rawBuffer_.getRawBuffer(); }
   VkDeviceMemory getRawMemory() { return memory_.getRawMemory(); }
-  void* getMappedBuffer() { return mappedBuffer_; }
+  void* getMappedBuffer() { return memory_.getMappedPtr(); }
 
  private:
   VulkanRawBuffer rawBuffer_;
   VulkanDeviceMemory memory_;
-  void* mappedBuffer_ = nullptr;
 };
 
 } // namespace blocks::render
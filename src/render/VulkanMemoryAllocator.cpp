@@ -0,0 +1,355 @@
+#include "render/VulkanMemoryAllocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "log/Logger.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+#include "util/BuddyAllocator.hpp"
+#include "util/debug.hpp"
+#include "util/string.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr VkDeviceSize kGeneralBlockSize = 64ull * 1024 * 1024;
+constexpr VkDeviceSize kStagingBlockSize = 32ull * 1024 * 1024;
+constexpr VkDeviceSize kPerFrameBlockSize = 4ull * 1024 * 1024;
+constexpr VkDeviceSize kMinBlockSize = 1ull * 1024 * 1024;
+constexpr VkDeviceSize kBuddyMinAllocation = 256;
+
+constexpr std::array<MemoryPool, 3> kAllPools{
+    MemoryPool::GENERAL, MemoryPool::STAGING, MemoryPool::PER_FRAME};
+
+std::string_view getPoolName(MemoryPool pool) {
+  switch (pool) {
+    case MemoryPool::GENERAL:
+      return "general";
+    case MemoryPool::STAGING:
+      return "staging";
+    case MemoryPool::PER_FRAME:
+      return "per-frame";
+  }
+  return "unknown";
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+float toMiB(VkDeviceSize bytes) {
+  return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+}
+
+} // namespace
+
+uint32_t findMemoryType(
+    const VkMemoryRequirements& requirements,
+    const VkPhysicalDeviceMemoryProperties& memProperties,
+    VkMemoryPropertyFlags properties) {
+  const uint32_t typeFilter = requirements.memoryTypeBits;
+
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1ull << i)) != 0 &&
+        (memProperties.memoryTypes[i].propertyFlags &
+         properties) == properties) {
+      return i;
+    }
+  }
+
+  throw std::runtime_error{"No suitable memory found"};
+}
+
+struct VulkanMemoryAllocator::Block {
+  vulkan::UniqueHandle<VkDeviceMemory> memory{nullptr, nullptr};
+  void* mapped = nullptr;
+  VkDeviceSize size = 0;
+  BlockListKey key;
+  bool dedicated = false;
+
+  // Only used by the general pool
+  std::optional<util::BuddyAllocator> buddy;
+  // Only used by the linear pools
+  VkDeviceSize linearOffset = 0;
+
+  size_t allocationCount = 0;
+  VkDeviceSize allocatedBytes = 0;
+};
+
+VulkanMemoryAllocator::Allocation::~Allocation() {
+  if (block_ != nullptr) {
+    allocator_->free(block_, offset_, size_);
+  }
+}
+
+VulkanMemoryAllocator::Allocation::Allocation(Allocation&& other) noexcept
+    : allocator_(other.allocator_),
+      block_(other.block_),
+      offset_(other.offset_),
+      size_(other.size_) {
+  other.block_ = nullptr;
+}
+
+VulkanMemoryAllocator::Allocation&
+VulkanMemoryAllocator::Allocation::operator=(Allocation&& other) noexcept {
+  std::swap(allocator_, other.allocator_);
+  std::swap(block_, other.block_);
+  std::swap(offset_, other.offset_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
+VkDeviceMemory VulkanMemoryAllocator::Allocation::getRawMemory() const {
+  DEBUG_ASSERT(block_ != nullptr);
+  return block_->memory.get();
+}
+
+void* VulkanMemoryAllocator::Allocation::getMappedPtr() const {
+  DEBUG_ASSERT(block_ != nullptr);
+  if (block_->mapped == nullptr) {
+    return nullptr;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return reinterpret_cast<std::byte*>(block_->mapped) + offset_;
+}
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(
+    VkDevice device, VkPhysicalDevice physicalDevice)
+    : device_(device) {
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties_);
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+  const auto blocks = blocks_.rlock();
+  for (const auto& [key, blockList] : *blocks) {
+    for ([[maybe_unused]] const auto& block : blockList) {
+      DEBUG_ASSERT(block->allocationCount == 0);
+    }
+  }
+}
+
+VulkanMemoryAllocator::Allocation VulkanMemoryAllocator::allocateForBuffer(
+    VkBuffer buffer, VkMemoryPropertyFlags properties, MemoryPool pool) {
+  VkMemoryRequirements requirements{};
+  vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+
+  Allocation allocation = allocate(requirements, properties, pool, false);
+  if (vkBindBufferMemory(
+          device_,
+          buffer,
+          allocation.getRawMemory(),
+          allocation.getOffset()) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to bind buffer memory"};
+  }
+  return allocation;
+}
+
+VulkanMemoryAllocator::Allocation VulkanMemoryAllocator::allocateForImage(
+    VkImage image, VkMemoryPropertyFlags properties, MemoryPool pool) {
+  VkMemoryRequirements requirements{};
+  vkGetImageMemoryRequirements(device_, image, &requirements);
+
+  Allocation allocation = allocate(requirements, properties, pool, true);
+  if (vkBindImageMemory(
+          device_, image, allocation.getRawMemory(), allocation.getOffset()) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to bind image memory"};
+  }
+  return allocation;
+}
+
+VulkanMemoryAllocator::PoolStatistics VulkanMemoryAllocator::getStatistics(
+    MemoryPool pool) const {
+  PoolStatistics result;
+  const auto blocks = blocks_.rlock();
+  for (const auto& [key, blockList] : *blocks) {
+    if (std::get<MemoryPool>(key) != pool) {
+      continue;
+    }
+    for (const auto& block : blockList) {
+      result.blockCount++;
+      result.reservedBytes += block->size;
+      result.allocationCount += block->allocationCount;
+      result.allocatedBytes += block->allocatedBytes;
+    }
+  }
+  return result;
+}
+
+void VulkanMemoryAllocator::logStatistics() const {
+  for (const MemoryPool pool : kAllPools) {
+    const PoolStatistics stats = getStatistics(pool);
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::INFO,
+        util::toString(
+            "Memory pool ",
+            getPoolName(pool),
+            ": ",
+            stats.allocationCount,
+            " allocations using ",
+            toMiB(stats.allocatedBytes),
+            "MiB of ",
+            toMiB(stats.reservedBytes),
+            "MiB in ",
+            stats.blockCount,
+            " blocks"));
+  }
+}
+
+VulkanMemoryAllocator::Allocation VulkanMemoryAllocator::allocate(
+    const VkMemoryRequirements& requirements,
+    VkMemoryPropertyFlags properties,
+    MemoryPool pool,
+    bool optimalImage) {
+  const uint32_t memoryTypeIndex =
+      findMemoryType(requirements, memProperties_, properties);
+  const BlockListKey key{pool, memoryTypeIndex, optimalImage};
+  const VkDeviceSize blockSize = getBlockSize(pool, memoryTypeIndex);
+
+  auto blocks = blocks_.wlock();
+  std::vector<std::unique_ptr<Block>>& blockList = (*blocks)[key];
+
+  // Large resources would waste most of a block, so get their own
+  if (requirements.size > blockSize / 2) {
+    Block& block = *blockList.emplace_back(makeBlock(
+        requirements.size, memoryTypeIndex, pool, optimalImage, true));
+    block.allocationCount = 1;
+    block.allocatedBytes = requirements.size;
+    return {this, &block, 0, requirements.size};
+  }
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    for (const auto& block : blockList) {
+      if (block->dedicated) {
+        continue;
+      }
+
+      std::optional<VkDeviceSize> offset;
+      VkDeviceSize allocatedSize = requirements.size;
+      if (block->buddy.has_value()) {
+        offset = block->buddy->allocate(
+            requirements.size, requirements.alignment);
+        allocatedSize = std::bit_ceil(std::max(
+            {requirements.size, requirements.alignment, kBuddyMinAllocation}));
+      } else {
+        const VkDeviceSize aligned =
+            alignUp(block->linearOffset, requirements.alignment);
+        if (aligned + requirements.size <= block->size) {
+          offset = aligned;
+          block->linearOffset = aligned + requirements.size;
+        }
+      }
+
+      if (offset.has_value()) {
+        block->allocationCount++;
+        block->allocatedBytes += allocatedSize;
+        return {this, block.get(), *offset, allocatedSize};
+      }
+    }
+
+    blockList.emplace_back(
+        makeBlock(blockSize, memoryTypeIndex, pool, optimalImage, false));
+  }
+
+  throw std::runtime_error{"Failed to sub-allocate device memory"};
+}
+
+std::unique_ptr<VulkanMemoryAllocator::Block> VulkanMemoryAllocator::makeBlock(
+    VkDeviceSize size,
+    uint32_t memoryTypeIndex,
+    MemoryPool pool,
+    bool optimalImage,
+    bool dedicated) {
+  VkMemoryAllocateInfo allocInfo{};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+  VkDeviceMemory memory = nullptr;
+  if (vkAllocateMemory(device_, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to allocate memory"};
+  }
+
+  auto block = std::make_unique<Block>();
+  block->memory = vulkan::UniqueHandle<VkDeviceMemory>{memory, device_};
+  block->size = size;
+  block->key = {pool, memoryTypeIndex, optimalImage};
+  block->dedicated = dedicated;
+  if (!dedicated && pool == MemoryPool::GENERAL) {
+    block->buddy.emplace(size, kBuddyMinAllocation);
+  }
+
+  // Host visible blocks stay mapped for their whole lifetime, as a memory
+  // object may only be mapped once at a time
+  // NOLINTNEXTLINE(hicpp-signed-bitwise)
+  if ((memProperties_.memoryTypes[memoryTypeIndex].propertyFlags &
+       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+    if (vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) !=
+        VK_SUCCESS) {
+      throw std::runtime_error{"Failed to map memory"};
+    }
+  }
+
+  return block;
+}
+
+VkDeviceSize VulkanMemoryAllocator::getBlockSize(
+    MemoryPool pool, uint32_t memoryTypeIndex) const {
+  VkDeviceSize preferred = kGeneralBlockSize;
+  if (pool == MemoryPool::STAGING) {
+    preferred = kStagingBlockSize;
+  } else if (pool == MemoryPool::PER_FRAME) {
+    preferred = kPerFrameBlockSize;
+  }
+
+  // Small heaps, such as host visible device memory, should not be taken up
+  // by one block
+  const uint32_t heapIndex =
+      memProperties_.memoryTypes[memoryTypeIndex].heapIndex;
+  const VkDeviceSize heapSize = memProperties_.memoryHeaps[heapIndex].size;
+  return std::max(
+      kMinBlockSize, std::min(preferred, std::bit_floor(heapSize / 8)));
+}
+
+void VulkanMemoryAllocator::free(
+    Block* block, VkDeviceSize offset, VkDeviceSize size) {
+  auto blocks = blocks_.wlock();
+
+  DEBUG_ASSERT(block->allocationCount > 0);
+  block->allocationCount--;
+  block->allocatedBytes -= size;
+  if (block->buddy.has_value()) {
+    block->buddy->free(offset);
+  } else if (block->allocationCount == 0) {
+    // Linear blocks can only be reused once everything in them is released
+    block->linearOffset = 0;
+  }
+
+  if (block->allocationCount > 0) {
+    return;
+  }
+
+  // Keep one empty block around for reuse, unless it was a dedicated block
+  std::vector<std::unique_ptr<Block>>& blockList = (*blocks)[block->key];
+  const bool hasOtherEmptyBlock =
+      std::any_of(blockList.begin(), blockList.end(), [&](const auto& other) {
+        return other.get() != block && !other->dedicated &&
+            other->allocationCount == 0;
+      });
+  if (block->dedicated || hasOtherEmptyBlock) {
+    std::erase_if(
+        blockList, [&](const auto& other) { return other.get() == block; });
+  }
+}
+
+} // namespace blocks::render
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "util/Synchronized.hpp"
+
+namespace blocks::render {
+
+uint32_t findMemoryType(
+    const VkMemoryRequirements& requirements,
+    const VkPhysicalDeviceMemoryProperties& memProperties,
+    VkMemoryPropertyFlags properties);
+
+enum class MemoryPool : uint8_t {
+  // Long lived resources, sub-allocated from a buddy allocator
+  GENERAL,
+  // Short lived upload sources, bump allocated and recycled once empty
+  STAGING,
+  // Buffers rewritten every frame, bump allocated and recycled once empty
+  PER_FRAME,
+};
+
+class VulkanMemoryAllocator {
+ private:
+  struct Block;
+
+ public:
+  class Allocation {
+   public:
+    Allocation() = default;
+    ~Allocation();
+
+    Allocation(const Allocation& other) = delete;
+    Allocation& operator=(const Allocation& other) = delete;
+
+    Allocation(Allocation&& other) noexcept;
+    Allocation& operator=(Allocation&& other) noexcept;
+
+    [[nodiscard]] VkDeviceMemory getRawMemory() const;
+    [[nodiscard]] VkDeviceSize getOffset() const { return offset_; }
+    [[nodiscard]] VkDeviceSize size() const { return size_; }
+    // nullptr unless the memory is host visible
+    [[nodiscard]] void* getMappedPtr() const;
+
+   private:
+    Allocation(
+        VulkanMemoryAllocator* allocator,
+        Block* block,
+        VkDeviceSize offset,
+        VkDeviceSize size)
+        : allocator_(allocator), block_(block), offset_(offset), size_(size) {}
+
+    VulkanMemoryAllocator* allocator_ = nullptr;
+    Block* block_ = nullptr;
+    VkDeviceSize offset_ = 0;
+    VkDeviceSize size_ = 0;
+
+    friend class VulkanMemoryAllocator;
+  };
+
+  struct PoolStatistics {
+    size_t blockCount = 0;
+    VkDeviceSize reservedBytes = 0;
+    size_t allocationCount = 0;
+    VkDeviceSize allocatedBytes = 0;
+  };
+
+  VulkanMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+  ~VulkanMemoryAllocator();
+
+  VulkanMemoryAllocator(const VulkanMemoryAllocator& other) = delete;
+  VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator& other) = delete;
+
+  VulkanMemoryAllocator(VulkanMemoryAllocator&& other) = delete;
+  VulkanMemoryAllocator& operator=(VulkanMemoryAllocator&& other) = delete;
+
+  // Allocates and binds memory for the resource
+  Allocation allocateForBuffer(
+      VkBuffer buffer, VkMemoryPropertyFlags properties, MemoryPool pool);
+  Allocation allocateForImage(
+      VkImage image, VkMemoryPropertyFlags properties, MemoryPool pool);
+
+  [[nodiscard]] PoolStatistics getStatistics(MemoryPool pool) const;
+  void logStatistics() const;
+
+ private:
+  // Buffers and optimally tiled images never share blocks, so we do not have
+  // to deal with bufferImageGranularity
+  using BlockListKey = std::tuple<MemoryPool, uint32_t, bool>;
+  using BlockLists =
+      std::map<BlockListKey, std::vector<std::unique_ptr<Block>>>;
+
+  Allocation allocate(
+      const VkMemoryRequirements& requirements,
+      VkMemoryPropertyFlags properties,
+      MemoryPool pool,
+      bool optimalImage);
+  std::unique_ptr<Block> makeBlock(
+      VkDeviceSize size,
+      uint32_t memoryTypeIndex,
+      MemoryPool pool,
+      bool optimalImage,
+      bool dedicated);
+  [[nodiscard]] VkDeviceSize getBlockSize(
+      MemoryPool pool, uint32_t memoryTypeIndex) const;
+  void free(Block* block, VkDeviceSize offset, VkDeviceSize size);
+
+  VkDevice device_;
+  VkPhysicalDeviceMemoryProperties memProperties_{};
+  util::Synchronized<BlockLists> blocks_;
+};
+
+} // namespace blocks::render
@@ -0,0 +1,19 @@
+#include "render/VulkanMesh.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vulkan/vulkan_core.h>
+#include "render/VulkanBuffer.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+
+namespace blocks::render {
+
+VulkanMesh::VulkanMesh(
+    VulkanGraphicsDevice& device,
+    std::span<const std::byte> vertexData,
+    uint32_t vertexCount)
+    : vertexBuffer_(device, vertexData, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT),
+      vertexCount_(vertexCount) {}
+
+} // namespace blocks::render
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vulkan/vulkan_core.h>
+#include "render/VulkanBuffer.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+
+namespace blocks::render {
+
+class VulkanMesh {
+ public:
+  VulkanMesh(
+      VulkanGraphicsDevice& device,
+      std::span<const std::byte> vertexData,
+      uint32_t vertexCount);
+
+  VkBuffer getRawBuffer() { return vertexBuffer_.getRawBuffer(); }
+  [[nodiscard]] uint32_t getVertexCount() const { return vertexCount_; }
+
+ private:
+  VulkanBuffer vertexBuffer_;
+  uint32_t vertexCount_;
+};
+
+} // namespace blocks::render
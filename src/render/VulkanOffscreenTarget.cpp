@@ -0,0 +1,174 @@
+#include "render/VulkanOffscreenTarget.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "loader/Image.hpp"
+#include "render/VulkanDeviceMemory.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMappedBuffer.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
+#include "render/vulkan/FrameBufferBuilder.hpp"
+#include "render/vulkan/ImageViewBuilder.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr size_t kBytesPerPixel = 4;
+
+vulkan::UniqueHandle<VkImage> makeImage(
+    VulkanGraphicsDevice& device, VkExtent2D extent) {
+  VkImageCreateInfo imageInfo{};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = extent.width;
+  imageInfo.extent.height = extent.height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = 1;
+  imageInfo.format = VulkanOffscreenTarget::kFormat;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  // NOLINTNEXTLINE(hicpp-signed-bitwise)
+  imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+      VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+
+  VkImage image = nullptr;
+  if (vkCreateImage(device.getRawDevice(), &imageInfo, nullptr, &image) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create offscreen image"};
+  }
+  return vulkan::UniqueHandle<VkImage>{image, device.getRawDevice()};
+}
+
+} // namespace
+
+VulkanOffscreenTarget::VulkanOffscreenTarget(
+    VulkanGraphicsDevice& device,
+    VkRenderPass renderPass,
+    uint32_t width,
+    uint32_t height)
+    : extent_{.width = width, .height = height},
+      image_(makeImage(device, extent_)),
+      memory_(
+          device,
+          image_.get(),
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+          MemoryPool::GENERAL),
+      imageView_(vulkan::ImageViewBuilder(image_.get(), kFormat)
+                     .build(device.getRawDevice())),
+      frameBuffer_(
+          vulkan::FrameBufferBuilder(
+              renderPass, {&imageView_.get(), 1}, extent_, 1)
+              .build(device.getRawDevice())),
+      readbackBuffer_(
+          device,
+          static_cast<size_t>(width) * height * kBytesPerPixel,
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          MemoryPool::GENERAL) {}
+
+void VulkanOffscreenTarget::recordBeginFrame(VkCommandBuffer commandBuffer) {
+  // Execution dependency only, the render pass discards the old contents
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      0,
+      nullptr);
+}
+
+void VulkanOffscreenTarget::recordReadback(VkCommandBuffer commandBuffer) {
+  VkImageMemoryBarrier imageBarrier{};
+  imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  imageBarrier.image = image_.get();
+  imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  imageBarrier.subresourceRange.baseMipLevel = 0;
+  imageBarrier.subresourceRange.levelCount = 1;
+  imageBarrier.subresourceRange.baseArrayLayer = 0;
+  imageBarrier.subresourceRange.layerCount = 1;
+
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      0,
+      nullptr,
+      0,
+      nullptr,
+      1,
+      &imageBarrier);
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = 0;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {.x = 0, .y = 0, .z = 0};
+  region.imageExtent = {
+      .width = extent_.width, .height = extent_.height, .depth = 1};
+  vkCmdCopyImageToBuffer(
+      commandBuffer,
+      image_.get(),
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      readbackBuffer_.getRawBuffer(),
+      1,
+      &region);
+
+  VkBufferMemoryBarrier bufferBarrier{};
+  bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  bufferBarrier.buffer = readbackBuffer_.getRawBuffer();
+  bufferBarrier.offset = 0;
+  bufferBarrier.size = VK_WHOLE_SIZE;
+
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      0,
+      0,
+      nullptr,
+      1,
+      &bufferBarrier,
+      0,
+      nullptr);
+}
+
+loader::Image VulkanOffscreenTarget::readback() {
+  const size_t size =
+      static_cast<size_t>(extent_.width) * extent_.height * kBytesPerPixel;
+  std::vector<std::byte> pixelData(size);
+  std::memcpy(pixelData.data(), readbackBuffer_.getMappedBuffer(), size);
+  return loader::Image{
+      .width = extent_.width,
+      .height = extent_.height,
+      .pixelData = std::move(pixelData)};
+}
+
+} // namespace blocks::render
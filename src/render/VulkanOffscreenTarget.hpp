@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+#include "loader/Image.hpp"
+#include "render/VulkanDeviceMemory.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMappedBuffer.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+
+namespace blocks::render {
+
+// A render target backed by a plain image rather than a swap chain, for
+// rendering without a display. Each frame is copied into host visible memory
+// so it can be read back.
+class VulkanOffscreenTarget {
+ public:
+  static constexpr VkFormat kFormat = VK_FORMAT_B8G8R8A8_SRGB;
+
+  // The render pass must leave the image in TRANSFER_SRC_OPTIMAL layout
+  VulkanOffscreenTarget(
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      uint32_t width,
+      uint32_t height);
+
+  VkFramebuffer getFrameBuffer() { return frameBuffer_.get(); }
+  [[nodiscard]] VkExtent2D extent() const { return extent_; }
+
+  // Recorded before the render pass begins, as the previous frame's copy may
+  // still be reading the image
+  void recordBeginFrame(VkCommandBuffer commandBuffer);
+  // Recorded after the render pass ends
+  void recordReadback(VkCommandBuffer commandBuffer);
+
+  // The caller must ensure the most recent readback commands have completed
+  [[nodiscard]] loader::Image readback();
+
+ private:
+  VkExtent2D extent_;
+  vulkan::UniqueHandle<VkImage> image_;
+  VulkanDeviceMemory memory_;
+  vulkan::UniqueHandle<VkImageView> imageView_;
+  vulkan::UniqueHandle<VkFramebuffer> frameBuffer_;
+  VulkanMappedBuffer readbackBuffer_;
+};
+
+} // namespace blocks::render
@@ -0,0 +1,181 @@
+#include "render/VulkanPipelineCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "log/Logger.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+#include "util/file.hpp"
+#include "util/string.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr uint32_t kCacheFileMagic = 0x43504c42; // "BLPC"
+
+struct CacheFileHeader {
+  uint32_t magic;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  uint32_t driverVersion;
+  std::array<uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+  uint64_t dataSize;
+};
+
+CacheFileHeader makeHeader(
+    const VkPhysicalDeviceProperties& properties, uint64_t dataSize) {
+  CacheFileHeader header{
+      .magic = kCacheFileMagic,
+      .vendorID = properties.vendorID,
+      .deviceID = properties.deviceID,
+      .driverVersion = properties.driverVersion,
+      .pipelineCacheUUID = {},
+      .dataSize = dataSize};
+  std::copy(
+      std::begin(properties.pipelineCacheUUID),
+      std::end(properties.pipelineCacheUUID),
+      header.pipelineCacheUUID.begin());
+  return header;
+}
+
+std::vector<std::byte> loadCacheData(
+    const VkPhysicalDeviceProperties& properties,
+    const std::filesystem::path& cachePath) {
+  if (!std::filesystem::exists(cachePath)) {
+    return {};
+  }
+
+  std::vector<std::byte> contents;
+  try {
+    contents = util::readFileBytes(cachePath);
+  } catch (...) {
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::WARNING,
+        util::toString(
+            "Failed to read pipeline cache ", cachePath.generic_string()));
+    return {};
+  }
+
+  if (contents.size() < sizeof(CacheFileHeader)) {
+    return {};
+  }
+
+  CacheFileHeader header{};
+  std::memcpy(&header, contents.data(), sizeof(CacheFileHeader));
+  const CacheFileHeader expected = makeHeader(
+      properties, contents.size() - sizeof(CacheFileHeader));
+  if (header.magic != expected.magic || header.vendorID != expected.vendorID ||
+      header.deviceID != expected.deviceID ||
+      header.driverVersion != expected.driverVersion ||
+      header.pipelineCacheUUID != expected.pipelineCacheUUID ||
+      header.dataSize != expected.dataSize) {
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::INFO,
+        "Discarding pipeline cache from a different device or driver");
+    return {};
+  }
+
+  contents.erase(
+      contents.begin(),
+      contents.begin() + static_cast<std::ptrdiff_t>(sizeof(CacheFileHeader)));
+  return contents;
+}
+
+vulkan::UniqueHandle<VkPipelineCache> makeCache(
+    VkDevice device, std::span<const std::byte> initialData) {
+  VkPipelineCacheCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  createInfo.initialDataSize = initialData.size();
+  createInfo.pInitialData = initialData.data();
+
+  VkPipelineCache cache = nullptr;
+  if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to create pipeline cache"};
+  }
+  return vulkan::UniqueHandle<VkPipelineCache>{cache, device};
+}
+
+} // namespace
+
+VulkanPipelineCache::VulkanPipelineCache(
+    VulkanGraphicsDevice& device, std::filesystem::path cachePath)
+    : device_(&device),
+      cachePath_(std::move(cachePath)),
+      cache_(nullptr, nullptr) {
+  const std::vector<std::byte> initialData =
+      loadCacheData(device.physicalInfo().properties, cachePath_);
+  try {
+    cache_ = makeCache(device.getRawDevice(), initialData);
+  } catch (...) {
+    if (initialData.empty()) {
+      throw;
+    }
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::WARNING, "Pipeline cache rejected by driver");
+    cache_ = makeCache(device.getRawDevice(), {});
+  }
+}
+
+VulkanPipelineCache::~VulkanPipelineCache() {
+  save();
+}
+
+void VulkanPipelineCache::save() {
+  try {
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(
+            device_->getRawDevice(), cache_.get(), &dataSize, nullptr) !=
+        VK_SUCCESS) {
+      throw std::runtime_error{"Failed to get pipeline cache size"};
+    }
+
+    std::vector<std::byte> contents(sizeof(CacheFileHeader) + dataSize);
+    if (vkGetPipelineCacheData(
+            device_->getRawDevice(),
+            cache_.get(),
+            &dataSize,
+            contents.data() + sizeof(CacheFileHeader)) != VK_SUCCESS) {
+      throw std::runtime_error{"Failed to get pipeline cache data"};
+    }
+    contents.resize(sizeof(CacheFileHeader) + dataSize);
+
+    const CacheFileHeader header =
+        makeHeader(device_->physicalInfo().properties, dataSize);
+    std::memcpy(contents.data(), &header, sizeof(CacheFileHeader));
+
+    // Write to a temporary file first so a crash never leaves a torn cache
+    std::filesystem::create_directories(cachePath_.parent_path());
+    std::filesystem::path tempPath = cachePath_;
+    tempPath += ".tmp";
+    {
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      std::ofstream outStream{tempPath, std::ios::binary | std::ios::trunc};
+      outStream.write(
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+          reinterpret_cast<const char*>(contents.data()),
+          static_cast<std::streamsize>(contents.size()));
+      if (!outStream) {
+        throw std::runtime_error{"Failed to write pipeline cache"};
+      }
+    }
+    std::filesystem::rename(tempPath, cachePath_);
+  } catch (...) {
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::WARNING, "Failed to save pipeline cache");
+  }
+}
+
+} // namespace blocks::render
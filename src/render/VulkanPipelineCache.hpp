@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <vulkan/vulkan_core.h>
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+
+namespace blocks::render {
+
+// A VkPipelineCache persisted to disk between runs. Cache files written by a
+// different device or driver version are discarded.
+class VulkanPipelineCache {
+ public:
+  VulkanPipelineCache(
+      VulkanGraphicsDevice& device, std::filesystem::path cachePath);
+  ~VulkanPipelineCache();
+
+  VulkanPipelineCache(const VulkanPipelineCache& other) = delete;
+  VulkanPipelineCache& operator=(const VulkanPipelineCache& other) = delete;
+
+  VulkanPipelineCache(VulkanPipelineCache&& other) = delete;
+  VulkanPipelineCache& operator=(VulkanPipelineCache&& other) = delete;
+
+  VkPipelineCache getRawCache() { return cache_.get(); }
+
+  void save();
+
+ private:
+  VulkanGraphicsDevice* device_;
+  std::filesystem::path cachePath_;
+  vulkan::UniqueHandle<VkPipelineCache> cache_;
+};
+
+} // namespace blocks::render
@@ -43,21 +43,28 @@ VulkanPresentStack::VulkanPresentStack(
     VkInstance instance,
     VulkanGraphicsDevice& device,
     glfw::Window window,
-    VkRenderPass renderPass)
+    VkRenderPass renderPass,
+    PresentMode presentMode)
     : window_(std::move(window)),
       surface_(
           vulkan::createSurfaceForWindow(instance, window_.getRawWindow())),
       renderPass_(renderPass),
+      presentMode_(presentMode),
       swapChainData_(
-          device, window_.getRawWindow(), surface_.get(), renderPass),
+          device,
+          window_.getRawWindow(),
+          surface_.get(),
+          renderPass,
+          presentMode),
       device_(&device) {}
 
 VulkanPresentStack::SwapChainData::SwapChainData(
     VulkanGraphicsDevice& device,
     GLFWwindow* window,
     VkSurfaceKHR surface,
-    VkRenderPass renderPass)
-    : swapChain(window, surface, device),
+    VkRenderPass renderPass,
+    PresentMode presentMode)
+    : swapChain(window, surface, device, presentMode),
       imageViews(swapChain.getImageViews()),
       frameBuffer(makeFrameBuffers(
           device, renderPass, imageViews, swapChain.getSwapchainExtent())) {}
@@ -77,7 +84,11 @@ void VulkanPresentStack::reset() {
   log::LoggerSystem::logToDefault(log::LogLevel::INFO, "Resetting swap chain");
   vkDeviceWaitIdle(device_->getRawDevice());
   swapChainData_.reset(
-      *device_, window_.getRawWindow(), surface_.get(), renderPass_);
+      *device_,
+      window_.getRawWindow(),
+      surface_.get(),
+      renderPass_,
+      presentMode_);
 }
 
 VulkanPresentStack::FrameData::FrameData(
@@ -50,7 +50,8 @@ class VulkanPresentStack {
       VkInstance instance,
       VulkanGraphicsDevice& device,
       glfw::Window window,
-      VkRenderPass renderPass);
+      VkRenderPass renderPass,
+      PresentMode presentMode);
 
   FrameData getNextImageIndex(VkSemaphore semaphore, VkFence fence);
 
@@ -77,7 +78,8 @@ class VulkanPresentStack {
         VulkanGraphicsDevice& device,
         GLFWwindow* window,
         VkSurfaceKHR surface,
-        VkRenderPass renderPass);
+        VkRenderPass renderPass,
+        PresentMode presentMode);
 
     VulkanSwapChain swapChain;
     std::vector<vulkan::UniqueHandle<VkImageView>> imageViews;
@@ -87,6 +89,7 @@ class VulkanPresentStack {
   glfw::Window window_;
   vulkan::UniqueHandle<VkSurfaceKHR> surface_;
   VkRenderPass renderPass_;
+  PresentMode presentMode_;
   util::Resettable<SwapChainData> swapChainData_;
   VulkanGraphicsDevice* device_;
 };
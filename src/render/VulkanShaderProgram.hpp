@@ -1,6 +1,8 @@
 #pragma once
 
+#include <string>
 #include <type_traits>
+#include <utility>
 #include <GLFW/glfw3.h>
 #include "render/VulkanGraphicsDevice.hpp"
 #include "render/VulkanGraphicsPipeline.hpp"
@@ -14,6 +16,7 @@ class VulkanShaderProgram {
   VulkanShaderProgram(
       VulkanGraphicsDevice& device,
       VkRenderPass renderPass,
+      VkPipelineCache pipelineCache,
       VulkanVertexShader vertexShader,
       VulkanShader fragmentShader,
       vulkan::UniqueHandle<VkDescriptorSetLayout> descriptorSetLayout)
@@ -24,6 +27,7 @@ class VulkanShaderProgram {
             device,
             VK_FORMAT_B8G8R8A8_SRGB,
             renderPass,
+            pipelineCache,
             vertexShader_,
             fragmentShader_,
             descriptorSetLayout_.get()) {}
@@ -32,7 +36,12 @@ class VulkanShaderProgram {
     return descriptorSetLayout_.get();
   }
 
+  // Used to label the program in profiling output
+  [[nodiscard]] const std::string& getName() const { return name_; }
+  void setName(std::string name) { name_ = std::move(name); }
+
  private:
+  std::string name_;
   VulkanVertexShader vertexShader_;
   VulkanShader fragmentShader_;
   vulkan::UniqueHandle<VkDescriptorSetLayout> descriptorSetLayout_;
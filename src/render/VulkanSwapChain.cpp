@@ -9,6 +9,7 @@
 #include <vector>
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_core.h>
+#include "log/Logger.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
 #include "render/vulkan/ImageViewBuilder.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
@@ -25,14 +26,36 @@ struct SwapChainSupportDetails {
   VkSurfaceFormatKHR preferredFormat{};
 };
 
+VkPresentModeKHR toVulkanPresentMode(PresentMode presentMode) {
+  switch (presentMode) {
+    case PresentMode::FIFO:
+      return VK_PRESENT_MODE_FIFO_KHR;
+    case PresentMode::FIFO_RELAXED:
+      return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    case PresentMode::MAILBOX:
+      return VK_PRESENT_MODE_MAILBOX_KHR;
+    case PresentMode::IMMEDIATE:
+      return VK_PRESENT_MODE_IMMEDIATE_KHR;
+  }
+  return VK_PRESENT_MODE_FIFO_KHR;
+}
+
 VkPresentModeKHR chooseSwapPresentMode(
-    const std::vector<VkPresentModeKHR>& availablePresentModes) {
-  for (const auto& availablePresentMode : availablePresentModes) {
-    if (availablePresentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR) {
-      return availablePresentMode;
-    }
+    const std::vector<VkPresentModeKHR>& availablePresentModes,
+    PresentMode requestedPresentMode) {
+  const VkPresentModeKHR requested = toVulkanPresentMode(requestedPresentMode);
+  if (std::find(
+          availablePresentModes.begin(),
+          availablePresentModes.end(),
+          requested) != availablePresentModes.end()) {
+    return requested;
   }
 
+  if (requestedPresentMode != PresentMode::FIFO_RELAXED) {
+    log::LoggerSystem::logToDefault(
+        log::LogLevel::WARNING,
+        "Requested present mode not supported, falling back to FIFO");
+  }
   // Guaranteed to always be availabe
   return VK_PRESENT_MODE_FIFO_KHR;
 }
@@ -117,7 +140,8 @@ SwapChainSupportDetails getSwapChainSupportDetails(
 VulkanSwapChain::VulkanSwapChain(
     GLFWwindow* window,
     VkSurfaceKHR surface,
-    VulkanGraphicsDevice& graphicsDevice)
+    VulkanGraphicsDevice& graphicsDevice,
+    PresentMode presentMode)
     : graphicsDevice_(&graphicsDevice),
       swapChain_(nullptr, nullptr),
       extent_(0, 0),
@@ -126,8 +150,8 @@ VulkanSwapChain::VulkanSwapChain(
       getSwapChainSupportDetails(graphicsDevice.physicalInfo().device, surface);
 
   const VkSurfaceFormatKHR surfaceFormat = swapChainSupport.preferredFormat;
-  const VkPresentModeKHR presentMode =
-      chooseSwapPresentMode(swapChainSupport.presentModes);
+  const VkPresentModeKHR chosenPresentMode =
+      chooseSwapPresentMode(swapChainSupport.presentModes, presentMode);
   const VkExtent2D extent =
       chooseSwapExtent(window, swapChainSupport.capabilities);
 
@@ -170,7 +194,7 @@ VulkanSwapChain::VulkanSwapChain(
 
   createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
   createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-  createInfo.presentMode = presentMode;
+  createInfo.presentMode = chosenPresentMode;
   createInfo.clipped = VK_TRUE;
   createInfo.oldSwapchain = VK_NULL_HANDLE;
 
@@ -243,6 +267,7 @@ void VulkanSwapChain::present(uint32_t imageIndex, VkSemaphore waitSemaphore) {
   presentInfo.pImageIndices = &imageIndex;
   presentInfo.pResults = nullptr;
 
+  const auto queueLock = graphicsDevice_->lockQueues();
   vkQueuePresentKHR(queue_, &presentInfo);
 }
 
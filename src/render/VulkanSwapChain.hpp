@@ -10,12 +10,23 @@
 #include "render/vulkan/UniqueHandle.hpp"
 
 namespace blocks::render {
+
+// Modes other than FIFO fall back to FIFO if the surface does not support
+// them
+enum class PresentMode : uint8_t {
+  FIFO,
+  FIFO_RELAXED,
+  MAILBOX,
+  IMMEDIATE,
+};
+
 class VulkanSwapChain {
  public:
   VulkanSwapChain(
       GLFWwindow* window,
       VkSurfaceKHR surface,
-      VulkanGraphicsDevice& graphicsDevice);
+      VulkanGraphicsDevice& graphicsDevice,
+      PresentMode presentMode);
 
   [[nodiscard]] std::vector<vulkan::UniqueHandle<VkImageView>> getImageViews()
       const;
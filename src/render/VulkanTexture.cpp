@@ -2,18 +2,22 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <span>
 #include <stdexcept>
+#include <variant>
+#include <vector>
 #include <vulkan/vulkan_core.h>
+#include "loader/CompressedImage.hpp"
 #include "loader/Image.hpp"
+#include "loader/ImageCache.hpp"
 #include "loader/LoadImage.hpp"
-#include "render/VulkanBuffer.hpp"
-#include "render/VulkanCommandPool.hpp"
 #include "render/VulkanDeviceMemory.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
-#include "render/vulkan/CommandBufferBuilder.hpp"
-#include "render/vulkan/FenceBuilder.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
+#include "render/VulkanUploadManager.hpp"
 #include "render/vulkan/ImageViewBuilder.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
 
@@ -185,37 +189,46 @@ void generateMipMaps(
       &barrier);
 }
 
-} // namespace
-
-VulkanTexture::VulkanTexture(
-    VulkanGraphicsDevice& device,
-    VulkanCommandPool& commandPool,
-    const std::filesystem::path& source)
-    : deviceMemory_(nullptr, nullptr),
-      buffer_(nullptr, nullptr),
-      image_(nullptr, nullptr),
-      imageView_(nullptr, nullptr),
-      sampler_(nullptr, nullptr) {
-  loader::Image tex = loader::loadImage(source);
-  const auto mipLevels =
-      static_cast<uint32_t>(
-          std::floor(std::log2(std::max(tex.width, tex.height)))) +
+uint32_t getMipLevels(size_t width, size_t height) {
+  return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) +
       1;
+}
 
-  VulkanBuffer stagingBuffer(
-      device, tex.pixelData, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+VkFormat getVkFormat(loader::CompressedFormat format) {
+  switch (format) {
+    case loader::CompressedFormat::BC1:
+      return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    case loader::CompressedFormat::BC3:
+      return VK_FORMAT_BC3_SRGB_BLOCK;
+    case loader::CompressedFormat::BC7:
+      return VK_FORMAT_BC7_SRGB_BLOCK;
+  }
+  throw std::runtime_error{"Unknown compressed format"};
+}
 
-  VkImage textureImage = nullptr;
+vulkan::UniqueHandle<VkImage> makeImage(
+    VulkanGraphicsDevice& device,
+    VkFormat format,
+    uint32_t width,
+    uint32_t height,
+    uint32_t mipLevels) {
+  VkFormatProperties formatProperties{};
+  vkGetPhysicalDeviceFormatProperties(
+      device.physicalInfo().device, format, &formatProperties);
+  if ((formatProperties.optimalTilingFeatures &
+       VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0) {
+    throw std::runtime_error{"Texture format is not supported"};
+  }
 
   VkImageCreateInfo imageInfo{};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
-  imageInfo.extent.width = static_cast<uint32_t>(tex.width);
-  imageInfo.extent.height = static_cast<uint32_t>(tex.height);
+  imageInfo.extent.width = width;
+  imageInfo.extent.height = height;
   imageInfo.extent.depth = 1;
   imageInfo.mipLevels = mipLevels;
   imageInfo.arrayLayers = 1;
-  imageInfo.format = VK_FORMAT_B8G8R8A8_SRGB;
+  imageInfo.format = format;
   imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   // NOLINTNEXTLINE(hicpp-signed-bitwise)
@@ -225,107 +238,69 @@ VulkanTexture::VulkanTexture(
   imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
   imageInfo.flags = 0;
 
-  if (vkCreateImage(
-          device.getRawDevice(), &imageInfo, nullptr, &textureImage) !=
+  VkImage image = nullptr;
+  if (vkCreateImage(device.getRawDevice(), &imageInfo, nullptr, &image) !=
       VK_SUCCESS) {
     throw std::runtime_error{"Failed to allocate image memory"};
   }
-  image_ = vulkan::UniqueHandle<VkImage>{textureImage, device.getRawDevice()};
-
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(
-      device.getRawDevice(), textureImage, &memRequirements);
-  VkPhysicalDeviceMemoryProperties memProperties{};
-  vkGetPhysicalDeviceMemoryProperties(
-      device.physicalInfo().device, &memProperties);
-
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(
-      memRequirements, memProperties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-  VkDeviceMemory deviceMemory = nullptr;
-  if (vkAllocateMemory(
-          device.getRawDevice(), &allocInfo, nullptr, &deviceMemory) !=
-      VK_SUCCESS) {
-    throw std::runtime_error{"Failed to allocate image memory"};
-  }
-  deviceMemory_ =
-      vulkan::UniqueHandle<VkDeviceMemory>(deviceMemory, device.getRawDevice());
-
-  VkBufferCreateInfo bufferInfo{};
-  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  bufferInfo.size = tex.pixelData.size();
-  bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-  VkBuffer buffer = nullptr;
-  const VkResult result =
-      vkCreateBuffer(device.getRawDevice(), &bufferInfo, nullptr, &buffer);
-  if (result != VK_SUCCESS) {
-    throw std::runtime_error{"Failed to create buffer"};
-  }
+  return vulkan::UniqueHandle<VkImage>{image, device.getRawDevice()};
+}
 
-  buffer_ = vulkan::UniqueHandle<VkBuffer>{buffer, device.getRawDevice()};
-  vkBindBufferMemory(device.getRawDevice(), buffer, deviceMemory, 0);
-
-  vkBindImageMemory(
-      device.getRawDevice(), textureImage, deviceMemory_.get(), 0);
-
-  const vulkan::UniqueHandle<VkCommandBuffer> commandBuffer =
-      vulkan::CommandBufferBuilder(
-          commandPool.getRawCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY)
-          .build(device.getRawDevice());
-
-  vulkan::beginSingleTimeCommandBuffer(commandBuffer.get());
-
-  transitionImageLayout(
-      commandBuffer.get(),
-      textureImage,
-      VK_FORMAT_B8G8R8A8_SRGB,
-      VK_IMAGE_LAYOUT_UNDEFINED,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      mipLevels);
-
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset = {.x = 0, .y = 0, .z = 0};
-  region.imageExtent = {
-      .width = static_cast<uint32_t>(tex.width),
-      .height = static_cast<uint32_t>(tex.height),
-      .depth = 1};
-  vkCmdCopyBufferToImage(
-      commandBuffer.get(),
-      stagingBuffer.getRawBuffer(),
-      textureImage,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      1,
-      &region);
-
-  generateMipMaps(
-      commandBuffer.get(),
-      image_.get(),
-      mipLevels,
-      static_cast<int32_t>(tex.width),
-      static_cast<int32_t>(tex.height));
-
-  const vulkan::UniqueHandle<VkFence> fence =
-      vulkan::FenceBuilder().build(device.getRawDevice());
-  vulkan::endSingleTimeCommandBuffer(
-      commandBuffer.get(), commandPool.getQueue(), {}, {}, fence.get());
-  vkWaitForFences(device.getRawDevice(), 1, &fence.get(), VK_TRUE, UINT32_MAX);
-  imageView_ =
-      vulkan::ImageViewBuilder(textureImage, VK_FORMAT_B8G8R8A8_SRGB)
-          .setMipLevels(mipLevels)
-          .build(device.getRawDevice());
+} // namespace
+
+VulkanTexture::VulkanTexture(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    const std::filesystem::path& source)
+    : VulkanTexture(device, uploadManager, loader::loadTexture(source)) {}
 
+VulkanTexture::VulkanTexture(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    const loader::Image& tex)
+    : VulkanTexture(device, getShape(tex.width, tex.height)) {
+  upload(uploadManager, tex.width, tex.height, tex.pixelData);
+}
+
+VulkanTexture::VulkanTexture(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    const loader::CachedImage& tex)
+    : VulkanTexture(device, getShape(tex.width, tex.height)) {
+  upload(uploadManager, tex.width, tex.height, tex.pixelData);
+}
+
+VulkanTexture::VulkanTexture(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    const loader::CompressedImage& tex)
+    : VulkanTexture(device, getShape(tex)) {
+  upload(uploadManager, tex);
+}
+
+VulkanTexture::VulkanTexture(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    const loader::TextureData& tex)
+    : VulkanTexture(std::visit(
+          [&](const auto& data) {
+            return VulkanTexture{device, uploadManager, data};
+          },
+          tex)) {}
+
+VulkanTexture::VulkanTexture(VulkanGraphicsDevice& device, const Shape& shape)
+    : image_(makeImage(
+          device, shape.format, shape.width, shape.height, shape.mipLevels)),
+      memory_(
+          device,
+          image_.get(),
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+          MemoryPool::GENERAL),
+      imageView_(
+          vulkan::ImageViewBuilder(image_.get(), shape.format)
+              .setMipLevels(shape.mipLevels)
+              .build(device.getRawDevice())),
+      sampler_(nullptr, nullptr) {
   VkSamplerCreateInfo samplerInfo{};
   samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
   samplerInfo.magFilter = VK_FILTER_LINEAR;
@@ -351,4 +326,125 @@ VulkanTexture::VulkanTexture(
   sampler_ = vulkan::UniqueHandle<VkSampler>{sampler, device.getRawDevice()};
 }
 
+VulkanTexture::Shape VulkanTexture::getShape(size_t width, size_t height) {
+  return Shape{
+      .format = VK_FORMAT_B8G8R8A8_SRGB,
+      .width = static_cast<uint32_t>(width),
+      .height = static_cast<uint32_t>(height),
+      .mipLevels = getMipLevels(width, height)};
+}
+
+VulkanTexture::Shape VulkanTexture::getShape(
+    const loader::CompressedImage& tex) {
+  return Shape{
+      .format = getVkFormat(tex.format),
+      .width = static_cast<uint32_t>(tex.width),
+      .height = static_cast<uint32_t>(tex.height),
+      .mipLevels = static_cast<uint32_t>(tex.mipLevels.size())};
+}
+
+void VulkanTexture::upload(
+    VulkanUploadManager& uploadManager,
+    size_t width,
+    size_t height,
+    std::span<const std::byte> pixelData) {
+  const uint32_t mipLevels = getMipLevels(width, height);
+  VkImage textureImage = image_.get();
+
+  uploadManager.upload(
+      pixelData,
+      [&](VkCommandBuffer commandBuffer,
+          VkBuffer stagingBuffer,
+          VkDeviceSize stagingOffset) {
+        transitionImageLayout(
+            commandBuffer,
+            textureImage,
+            VK_FORMAT_B8G8R8A8_SRGB,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            mipLevels);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {.x = 0, .y = 0, .z = 0};
+        region.imageExtent = {
+            .width = static_cast<uint32_t>(width),
+            .height = static_cast<uint32_t>(height),
+            .depth = 1};
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            stagingBuffer,
+            textureImage,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1,
+            &region);
+
+        generateMipMaps(
+            commandBuffer,
+            textureImage,
+            mipLevels,
+            static_cast<int32_t>(width),
+            static_cast<int32_t>(height));
+      });
+}
+
+void VulkanTexture::upload(
+    VulkanUploadManager& uploadManager, const loader::CompressedImage& tex) {
+  const auto mipLevels = static_cast<uint32_t>(tex.mipLevels.size());
+  const VkFormat format = getVkFormat(tex.format);
+  VkImage textureImage = image_.get();
+
+  uploadManager.upload(
+      tex.data,
+      [&](VkCommandBuffer commandBuffer,
+          VkBuffer stagingBuffer,
+          VkDeviceSize stagingOffset) {
+        transitionImageLayout(
+            commandBuffer,
+            textureImage,
+            format,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            mipLevels);
+
+        std::vector<VkBufferImageCopy> regions(mipLevels);
+        for (uint32_t i = 0; i < mipLevels; i++) {
+          VkBufferImageCopy& region = regions[i];
+          region.bufferOffset = stagingOffset + tex.mipLevels[i].offset;
+          region.bufferRowLength = 0;
+          region.bufferImageHeight = 0;
+          region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+          region.imageSubresource.mipLevel = i;
+          region.imageSubresource.baseArrayLayer = 0;
+          region.imageSubresource.layerCount = 1;
+          region.imageOffset = {.x = 0, .y = 0, .z = 0};
+          region.imageExtent = {
+              .width = std::max(static_cast<uint32_t>(tex.width) >> i, 1u),
+              .height = std::max(static_cast<uint32_t>(tex.height) >> i, 1u),
+              .depth = 1};
+        }
+        vkCmdCopyBufferToImage(
+            commandBuffer,
+            stagingBuffer,
+            textureImage,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            mipLevels,
+            regions.data());
+
+        transitionImageLayout(
+            commandBuffer,
+            textureImage,
+            format,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            mipLevels);
+      });
+}
+
 } // namespace blocks::render
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <span>
 #include <vulkan/vulkan_core.h>
-#include "render/VulkanCommandPool.hpp"
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+#include "loader/ImageCache.hpp"
+#include "loader/LoadImage.hpp"
+#include "render/VulkanDeviceMemory.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanUploadManager.hpp"
 #include "render/vulkan/UniqueHandle.hpp"
 
 namespace blocks::render {
@@ -12,16 +20,56 @@ class VulkanTexture {
  public:
   VulkanTexture(
       VulkanGraphicsDevice& device,
-      VulkanCommandPool& commandPool,
+      VulkanUploadManager& uploadManager,
       const std::filesystem::path& source);
+  VulkanTexture(
+      VulkanGraphicsDevice& device,
+      VulkanUploadManager& uploadManager,
+      const loader::Image& tex);
+  VulkanTexture(
+      VulkanGraphicsDevice& device,
+      VulkanUploadManager& uploadManager,
+      const loader::CachedImage& tex);
+  // Uploads the blocks and mip levels as they are
+  VulkanTexture(
+      VulkanGraphicsDevice& device,
+      VulkanUploadManager& uploadManager,
+      const loader::CompressedImage& tex);
+  VulkanTexture(
+      VulkanGraphicsDevice& device,
+      VulkanUploadManager& uploadManager,
+      const loader::TextureData& tex);
 
-  VkImageView getImageView() { return imageView_.get(); }
-  VkSampler getSampler() { return sampler_.get(); }
+  [[nodiscard]] VkImageView getImageView() const { return imageView_.get(); }
+  [[nodiscard]] VkSampler getSampler() const { return sampler_.get(); }
+  [[nodiscard]] VkDeviceSize getMemorySize() const {
+    return memory_.getSize();
+  }
 
  private:
-  vulkan::UniqueHandle<VkDeviceMemory> deviceMemory_;
-  vulkan::UniqueHandle<VkBuffer> buffer_;
+  struct Shape {
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+  };
+
+  VulkanTexture(VulkanGraphicsDevice& device, const Shape& shape);
+
+  static Shape getShape(size_t width, size_t height);
+  static Shape getShape(const loader::CompressedImage& tex);
+
+  // Level 0 of a BGRA image, the rest of the mip chain is blitted from it
+  void upload(
+      VulkanUploadManager& uploadManager,
+      size_t width,
+      size_t height,
+      std::span<const std::byte> pixelData);
+  void upload(
+      VulkanUploadManager& uploadManager, const loader::CompressedImage& tex);
+
   vulkan::UniqueHandle<VkImage> image_;
+  VulkanDeviceMemory memory_;
   vulkan::UniqueHandle<VkImageView> imageView_;
   vulkan::UniqueHandle<VkSampler> sampler_;
 };
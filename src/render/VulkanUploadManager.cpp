@@ -0,0 +1,260 @@
+#include "render/VulkanUploadManager.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vulkan/vulkan_core.h>
+#include "render/VulkanCommandPool.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMappedBuffer.hpp"
+#include "render/VulkanMemoryAllocator.hpp"
+#include "render/vulkan/CommandBufferBuilder.hpp"
+#include "render/vulkan/FenceBuilder.hpp"
+#include "render/vulkan/SemaphoreBuilder.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+#include "util/debug.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+constexpr VkDeviceSize kStagingRingSize = 16 * 1024 * 1024;
+
+vulkan::UniqueHandle<VkSemaphore> makeTimelineSemaphore(
+    VulkanGraphicsDevice& device) {
+  if (!device.physicalInfo().optionalFeatures.timelineSemaphores) {
+    return vulkan::UniqueHandle<VkSemaphore>{nullptr, nullptr};
+  }
+  return vulkan::SemaphoreBuilder().setTimeline(0).build(
+      device.getRawDevice());
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+VulkanUploadManager::VulkanUploadManager(
+    VulkanGraphicsDevice& device, VulkanCommandPool commandPool)
+    : device_(&device),
+      commandPool_(std::move(commandPool)),
+      timelineSemaphore_(makeTimelineSemaphore(device)),
+      stagingRing_(
+          device,
+          kStagingRingSize,
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+          MemoryPool::STAGING),
+      // Also satisfies the texel size requirement of any format we upload
+      alignment_(std::max<VkDeviceSize>(
+          16,
+          device.physicalInfo()
+              .properties.limits.optimalBufferCopyOffsetAlignment)) {
+  DEBUG_ASSERT(kStagingRingSize % alignment_ == 0);
+}
+
+VulkanUploadManager::~VulkanUploadManager() {
+  auto state = state_.wlock();
+  while (!state->inFlight.empty()) {
+    waitForBatch(state->inFlight.front());
+    state->inFlight.pop_front();
+  }
+}
+
+void VulkanUploadManager::upload(
+    std::span<const std::byte> data, const RecordCopyFn& recordCopy) {
+  auto state = state_.wlock();
+  retireBatches(*state, std::nullopt);
+
+  const std::optional<VkDeviceSize> ringOffset =
+      allocateFromRing(*state, data.size());
+  Batch& batch = getRecordingBatch(*state);
+
+  if (ringOffset.has_value()) {
+    std::memcpy(
+        static_cast<std::byte*>(stagingRing_.getMappedBuffer()) + *ringOffset,
+        data.data(),
+        data.size());
+    recordCopy(
+        batch.commandBuffer.get(), stagingRing_.getRawBuffer(), *ringOffset);
+    return;
+  }
+
+  // Too large for the ring, stage through a buffer owned by the batch
+  VulkanMappedBuffer& overflow = batch.overflowBuffers.emplace_back(
+      *device_,
+      data.size(),
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      MemoryPool::STAGING);
+  std::memcpy(overflow.getMappedBuffer(), data.data(), data.size());
+  recordCopy(batch.commandBuffer.get(), overflow.getRawBuffer(), 0);
+}
+
+void VulkanUploadManager::uploadToBuffer(
+    std::span<const std::byte> data,
+    VkBuffer destination,
+    VkDeviceSize destinationOffset) {
+  upload(
+      data,
+      [&](VkCommandBuffer commandBuffer,
+          VkBuffer source,
+          VkDeviceSize offset) {
+        VkBufferCopy region{};
+        region.srcOffset = offset;
+        region.dstOffset = destinationOffset;
+        region.size = data.size();
+        vkCmdCopyBuffer(commandBuffer, source, destination, 1, &region);
+      });
+}
+
+uint64_t VulkanUploadManager::flush() {
+  auto state = state_.wlock();
+  return submit(*state);
+}
+
+void VulkanUploadManager::wait(uint64_t value) {
+  auto state = state_.wlock();
+  retireBatches(*state, value);
+}
+
+VulkanUploadManager::Batch& VulkanUploadManager::getRecordingBatch(
+    State& state) {
+  if (state.recording.has_value()) {
+    return *state.recording;
+  }
+
+  Batch& batch = state.recording.emplace(Batch{
+      .commandBuffer = vulkan::CommandBufferBuilder(
+                           commandPool_.getRawCommandPool(),
+                           VK_COMMAND_BUFFER_LEVEL_PRIMARY)
+                           .build(device_->getRawDevice()),
+      .fence = hasTimelineSemaphore()
+          ? vulkan::UniqueHandle<VkFence>{nullptr, nullptr}
+          : vulkan::FenceBuilder().build(device_->getRawDevice()),
+      .overflowBuffers = {},
+      .ringEnd = 0,
+      .value = 0});
+  vulkan::beginSingleTimeCommandBuffer(batch.commandBuffer.get());
+  return batch;
+}
+
+std::optional<VkDeviceSize> VulkanUploadManager::allocateFromRing(
+    State& state, VkDeviceSize size) {
+  if (size > kStagingRingSize) {
+    return std::nullopt;
+  }
+
+  while (true) {
+    if (state.inFlight.empty() && !state.recording.has_value()) {
+      state.ringHead = 0;
+      state.ringTail = 0;
+    }
+
+    uint64_t start = alignUp(state.ringHead, alignment_);
+    const uint64_t position = start % kStagingRingSize;
+    if (position + size > kStagingRingSize) {
+      // Never split an allocation across the end of the ring
+      start += kStagingRingSize - position;
+    }
+
+    if (start + size - state.ringTail <= kStagingRingSize) {
+      state.ringHead = start + size;
+      return start % kStagingRingSize;
+    }
+
+    // Out of space, so block until the oldest copies have completed
+    if (state.inFlight.empty()) {
+      submit(state);
+    }
+    retireBatches(state, state.inFlight.front().value);
+  }
+}
+
+uint64_t VulkanUploadManager::submit(State& state) {
+  if (!state.recording.has_value()) {
+    return state.nextValue - 1;
+  }
+
+  Batch batch = std::move(*state.recording);
+  state.recording.reset();
+  batch.ringEnd = state.ringHead;
+  batch.value = state.nextValue++;
+
+  VkCommandBuffer commandBuffer = batch.commandBuffer.get();
+  if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+    throw std::runtime_error{"Failed to end recording command buffer"};
+  }
+
+  VkSubmitInfo submitInfo{};
+  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &commandBuffer;
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues = &batch.value;
+  if (hasTimelineSemaphore()) {
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timelineSemaphore_.get();
+  }
+
+  const auto queueLock = device_->lockQueues();
+  if (vkQueueSubmit(
+          commandPool_.getQueue(), 1, &submitInfo, batch.fence.get()) !=
+      VK_SUCCESS) {
+    throw std::runtime_error{"Failed to submit upload command buffer"};
+  }
+
+  const uint64_t value = batch.value;
+  state.inFlight.emplace_back(std::move(batch));
+  return value;
+}
+
+bool VulkanUploadManager::isComplete(const Batch& batch) const {
+  if (hasTimelineSemaphore()) {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(
+        device_->getRawDevice(), timelineSemaphore_.get(), &value);
+    return value >= batch.value;
+  }
+  return vkGetFenceStatus(device_->getRawDevice(), batch.fence.get()) ==
+      VK_SUCCESS;
+}
+
+void VulkanUploadManager::waitForBatch(const Batch& batch) const {
+  if (hasTimelineSemaphore()) {
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timelineSemaphore_.get();
+    waitInfo.pValues = &batch.value;
+    vkWaitSemaphores(device_->getRawDevice(), &waitInfo, UINT64_MAX);
+    return;
+  }
+  vkWaitForFences(
+      device_->getRawDevice(), 1, &batch.fence.get(), VK_TRUE, UINT64_MAX);
+}
+
+void VulkanUploadManager::retireBatches(
+    State& state, std::optional<uint64_t> waitValue) {
+  while (!state.inFlight.empty()) {
+    const Batch& batch = state.inFlight.front();
+    if (waitValue.has_value() && batch.value <= *waitValue) {
+      waitForBatch(batch);
+    } else if (!isComplete(batch)) {
+      return;
+    }
+
+    state.ringTail = batch.ringEnd;
+    state.inFlight.pop_front();
+  }
+}
+
+} // namespace blocks::render
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "render/VulkanCommandPool.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMappedBuffer.hpp"
+#include "render/vulkan/UniqueHandle.hpp"
+#include "util/Synchronized.hpp"
+
+namespace blocks::render {
+
+// Copies host data into device resources via a persistent staging ring.
+// Copies are recorded into a shared batch which is only submitted to the
+// loading queue on flush(), so loading many assets costs one submission
+// rather than one round trip each.
+class VulkanUploadManager {
+ public:
+  using RecordCopyFn = std::function<void(
+      VkCommandBuffer commandBuffer, VkBuffer source, VkDeviceSize offset)>;
+
+  VulkanUploadManager(
+      VulkanGraphicsDevice& device, VulkanCommandPool commandPool);
+  ~VulkanUploadManager();
+
+  VulkanUploadManager(const VulkanUploadManager& other) = delete;
+  VulkanUploadManager& operator=(const VulkanUploadManager& other) = delete;
+
+  VulkanUploadManager(VulkanUploadManager&& other) = delete;
+  VulkanUploadManager& operator=(VulkanUploadManager&& other) = delete;
+
+  // Stages the data and invokes recordCopy to record the commands consuming it
+  void upload(std::span<const std::byte> data, const RecordCopyFn& recordCopy);
+  void uploadToBuffer(
+      std::span<const std::byte> data,
+      VkBuffer destination,
+      VkDeviceSize destinationOffset = 0);
+
+  // Submits all pending copies and returns the value signalled on completion
+  uint64_t flush();
+  void wait(uint64_t value);
+
+  // Without timeline semaphores, other submissions cannot wait on uploads and
+  // wait() must be used instead
+  [[nodiscard]] bool hasTimelineSemaphore() const {
+    return timelineSemaphore_.get() != nullptr;
+  }
+  VkSemaphore getTimelineSemaphore() { return timelineSemaphore_.get(); }
+
+ private:
+  struct Batch {
+    vulkan::UniqueHandle<VkCommandBuffer> commandBuffer;
+    // Only used without timeline semaphores
+    vulkan::UniqueHandle<VkFence> fence;
+    std::vector<VulkanMappedBuffer> overflowBuffers;
+    uint64_t ringEnd = 0;
+    uint64_t value = 0;
+  };
+
+  struct State {
+    std::optional<Batch> recording;
+    std::deque<Batch> inFlight;
+    // Byte counters only ever increase, positions are taken modulo ring size
+    uint64_t ringHead = 0;
+    uint64_t ringTail = 0;
+    uint64_t nextValue = 1;
+  };
+
+  Batch& getRecordingBatch(State& state);
+  std::optional<VkDeviceSize> allocateFromRing(State& state, VkDeviceSize size);
+  uint64_t submit(State& state);
+  [[nodiscard]] bool isComplete(const Batch& batch) const;
+  void waitForBatch(const Batch& batch) const;
+  void retireBatches(State& state, std::optional<uint64_t> waitValue);
+
+  VulkanGraphicsDevice* device_;
+  VulkanCommandPool commandPool_;
+  vulkan::UniqueHandle<VkSemaphore> timelineSemaphore_;
+  VulkanMappedBuffer stagingRing_;
+  VkDeviceSize alignment_;
+  util::Synchronized<State> state_;
+};
+
+} // namespace blocks::render
@@ -44,12 +44,14 @@ Window::Window(
     VkRenderPass renderPass,
     int width,
     int height,
-    const char* title)
+    const char* title,
+    PresentMode presentMode)
     : presentStack_(
           instance.getRawInstance(),
           device,
           makeWindow(width, height, title, [&](int, int) { onResize(); }),
-          renderPass) {}
+          renderPass,
+          presentMode) {}
 
 void Window::close() {
   glfwSetWindowShouldClose(presentStack_.getWindow().getRawWindow(), GLFW_TRUE);
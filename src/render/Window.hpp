@@ -6,6 +6,7 @@
 #include "render/VulkanGraphicsDevice.hpp"
 #include "render/VulkanInstance.hpp"
 #include "render/VulkanPresentStack.hpp"
+#include "render/VulkanSwapChain.hpp"
 
 namespace blocks::render {
 
@@ -19,7 +20,8 @@ class Window {
       VkRenderPass renderPass,
       int width,
       int height,
-      const char* title);
+      const char* title,
+      PresentMode presentMode);
 
   Window(const Window& other) = delete;
   Window& operator=(const Window& other) = delete;
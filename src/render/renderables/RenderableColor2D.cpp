@@ -6,10 +6,11 @@
 #include <vulkan/vulkan_core.h>
 #include "render/Quad.hpp"
 #include "render/RenderableObject.hpp"
-#include "render/VulkanBuffer.hpp"
 #include "render/VulkanDescriptorPool.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMesh.hpp"
 #include "render/VulkanShaderProgram.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
 #include "render/shaders/Col2DShader.hpp"
@@ -20,12 +21,13 @@ RenderableObject RenderableColor2D::create(
     VulkanGraphicsDevice& device,
     ShaderProgramManager& programManager,
     TextureManager& /* textureManager */,
+    GeometryManager& geometryManager,
     int maxFramesInFlight) {
   VulkanShaderProgram* shaderProgram =
       &programManager.getOrCreate<Col2DShader>();
   VulkanDescriptorPool descriptorPool{
       device, shaderProgram->getDescriptorSetLayout(), maxFramesInFlight};
-  VulkanBuffer vertexAttributes = getQuadVertexAttributesBuffer(device);
+  VulkanMesh* mesh = &geometryManager.getOrCreate<UVQuad>();
 
   const auto& descriptorSets = descriptorPool.getDescriptorSets();
   std::vector<VkWriteDescriptorSet> descriptorWrites;
@@ -41,7 +43,7 @@ RenderableObject RenderableColor2D::create(
   return RenderableObject{
       shaderProgram,
       std::move(descriptorPool),
-      std::move(vertexAttributes),
+      mesh,
       sizeof(InstanceData)};
 }
 
@@ -2,6 +2,7 @@
 
 #include "render/RenderableObject.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
 #include "render/shaders/Col2DShader.hpp"
@@ -18,6 +19,7 @@ class RenderableColor2D {
       VulkanGraphicsDevice& device,
       ShaderProgramManager& programManager,
       TextureManager& textureManager,
+      GeometryManager& geometryManager,
       int maxFramesInFlight);
 };
 
@@ -1,5 +1,6 @@
 #include "render/renderables/RenderableFont.hpp"
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <utility>
@@ -10,7 +11,9 @@
 #include "render/VulkanBuffer.hpp"
 #include "render/VulkanDescriptorPool.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMesh.hpp"
 #include "render/VulkanShaderProgram.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
 #include "render/shaders/FontShader.hpp"
@@ -21,46 +24,57 @@ namespace {
 
 class ExtraFontResources : public RenderableObject::ResourceHolder {
  public:
-  explicit ExtraFontResources(VulkanBuffer fontBuffer)
-      : fontBuffer_(std::move(fontBuffer)) {}
+  ExtraFontResources(VulkanBuffer curveBuffer, VulkanBuffer bandBuffer)
+      : curveBuffer_(std::move(curveBuffer)),
+        bandBuffer_(std::move(bandBuffer)) {}
 
  private:
-  VulkanBuffer fontBuffer_;
+  VulkanBuffer curveBuffer_;
+  VulkanBuffer bandBuffer_;
 };
 
 } // namespace
 
 RenderableObject RenderableFont::create(
-    VulkanBuffer fontBuffer,
+    VulkanBuffer curveBuffer,
+    VulkanBuffer bandBuffer,
     VulkanGraphicsDevice& device,
     ShaderProgramManager& programManager,
     TextureManager& /* textureManager */,
+    GeometryManager& geometryManager,
     int maxFramesInFlight) {
   VulkanShaderProgram* shaderProgram =
       &programManager.getOrCreate<FontShader>();
   VulkanDescriptorPool descriptorPool{
       device, shaderProgram->getDescriptorSetLayout(), maxFramesInFlight};
-  VulkanBuffer vertexAttributes = getQuadVertexAttributesBuffer(device);
+  VulkanMesh* mesh = &geometryManager.getOrCreate<UVQuad>();
 
   const auto& descriptorSets = descriptorPool.getDescriptorSets();
   std::vector<VkWriteDescriptorSet> descriptorWrites;
-  descriptorWrites.reserve(descriptorSets.size());
+  descriptorWrites.reserve(descriptorSets.size() * 2);
 
-  const VkDescriptorBufferInfo bufferInfo{
-      .buffer = fontBuffer.getRawBuffer(),
-      .offset = 0,
-      .range = fontBuffer.size()};
+  const std::array<VkDescriptorBufferInfo, 2> bufferInfos{
+      VkDescriptorBufferInfo{
+          .buffer = curveBuffer.getRawBuffer(),
+          .offset = 0,
+          .range = curveBuffer.size()},
+      VkDescriptorBufferInfo{
+          .buffer = bandBuffer.getRawBuffer(),
+          .offset = 0,
+          .range = bandBuffer.size()}};
 
   for (const auto& set : descriptorSets) {
-    auto& curWrite = descriptorWrites.emplace_back();
+    for (uint32_t binding = 0; binding < bufferInfos.size(); binding++) {
+      auto& curWrite = descriptorWrites.emplace_back();
 
-    curWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    curWrite.dstSet = set;
-    curWrite.dstBinding = 0;
-    curWrite.dstArrayElement = 0;
-    curWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    curWrite.descriptorCount = 1;
-    curWrite.pBufferInfo = &bufferInfo;
+      curWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      curWrite.dstSet = set;
+      curWrite.dstBinding = binding;
+      curWrite.dstArrayElement = 0;
+      curWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      curWrite.descriptorCount = 1;
+      curWrite.pBufferInfo = &bufferInfos[binding];
+    }
   }
 
   vkUpdateDescriptorSets(
@@ -73,9 +87,10 @@ RenderableObject RenderableFont::create(
   return RenderableObject{
       shaderProgram,
       std::move(descriptorPool),
-      std::move(vertexAttributes),
+      mesh,
       sizeof(InstanceData),
-      std::make_unique<ExtraFontResources>(std::move(fontBuffer))};
+      std::make_unique<ExtraFontResources>(
+          std::move(curveBuffer), std::move(bandBuffer))};
 }
 
 } // namespace blocks::render
@@ -3,6 +3,7 @@
 #include "render/RenderableObject.hpp"
 #include "render/VulkanBuffer.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
 #include "render/shaders/FontShader.hpp"
@@ -16,10 +17,12 @@ class RenderableFont {
   using InstanceData = FontShader::InstanceData;
 
   static RenderableObject create(
-      VulkanBuffer fontBuffer,
+      VulkanBuffer curveBuffer,
+      VulkanBuffer bandBuffer,
       VulkanGraphicsDevice& device,
       ShaderProgramManager& programManager,
       TextureManager& textureManager,
+      GeometryManager& geometryManager,
       int maxFramesInFlight);
 };
 
@@ -0,0 +1,83 @@
+#include "render/renderables/RenderableFontAtlas.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "render/Quad.hpp"
+#include "render/RenderableObject.hpp"
+#include "render/VulkanDescriptorPool.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMesh.hpp"
+#include "render/VulkanShaderProgram.hpp"
+#include "render/VulkanTexture.hpp"
+#include "render/resource/GeometryManager.hpp"
+#include "render/resource/ShaderProgramManager.hpp"
+#include "render/resource/TextureManager.hpp"
+#include "render/shaders/FontAtlasShader.hpp"
+
+namespace blocks::render {
+
+namespace {
+
+class ExtraFontAtlasResources : public RenderableObject::ResourceHolder {
+ public:
+  explicit ExtraFontAtlasResources(VulkanTexture atlasTexture)
+      : atlasTexture_(std::move(atlasTexture)) {}
+
+ private:
+  VulkanTexture atlasTexture_;
+};
+
+} // namespace
+
+RenderableObject RenderableFontAtlas::create(
+    VulkanTexture atlasTexture,
+    VulkanGraphicsDevice& device,
+    ShaderProgramManager& programManager,
+    TextureManager& /* textureManager */,
+    GeometryManager& geometryManager,
+    int maxFramesInFlight) {
+  VulkanShaderProgram* shaderProgram =
+      &programManager.getOrCreate<FontAtlasShader>();
+  VulkanDescriptorPool descriptorPool{
+      device, shaderProgram->getDescriptorSetLayout(), maxFramesInFlight};
+  VulkanMesh* mesh = &geometryManager.getOrCreate<UVQuad>();
+
+  const auto& descriptorSets = descriptorPool.getDescriptorSets();
+  std::vector<VkWriteDescriptorSet> descriptorWrites;
+  descriptorWrites.reserve(descriptorSets.size());
+
+  VkDescriptorImageInfo imageInfo{};
+  imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  imageInfo.imageView = atlasTexture.getImageView();
+  imageInfo.sampler = atlasTexture.getSampler();
+
+  for (const auto& set : descriptorSets) {
+    auto& curWrite = descriptorWrites.emplace_back();
+    curWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    curWrite.dstSet = set;
+    curWrite.dstBinding = 0;
+    curWrite.dstArrayElement = 0;
+    curWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    curWrite.descriptorCount = 1;
+    curWrite.pImageInfo = &imageInfo;
+  }
+
+  vkUpdateDescriptorSets(
+      device.getRawDevice(),
+      static_cast<uint32_t>(descriptorWrites.size()),
+      descriptorWrites.data(),
+      0,
+      nullptr);
+
+  return RenderableObject{
+      shaderProgram,
+      std::move(descriptorPool),
+      mesh,
+      sizeof(InstanceData),
+      std::make_unique<ExtraFontAtlasResources>(std::move(atlasTexture))};
+}
+
+} // namespace blocks::render
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "render/RenderableObject.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanTexture.hpp"
+#include "render/resource/GeometryManager.hpp"
+#include "render/resource/ShaderProgramManager.hpp"
+#include "render/resource/TextureManager.hpp"
+#include "render/shaders/FontAtlasShader.hpp"
+
+namespace blocks::render {
+
+class RenderableFontAtlas {
+ public:
+  RenderableFontAtlas() = delete;
+
+  using InstanceData = FontAtlasShader::InstanceData;
+
+  static RenderableObject create(
+      VulkanTexture atlasTexture,
+      VulkanGraphicsDevice& device,
+      ShaderProgramManager& programManager,
+      TextureManager& textureManager,
+      GeometryManager& geometryManager,
+      int maxFramesInFlight);
+};
+
+} // namespace blocks::render
@@ -1,35 +1,90 @@
 #include "render/renderables/RenderableTex2D.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 #include "render/Quad.hpp"
 #include "render/RenderableObject.hpp"
-#include "render/VulkanBuffer.hpp"
 #include "render/VulkanDescriptorPool.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMesh.hpp"
 #include "render/VulkanShaderProgram.hpp"
 #include "render/VulkanTexture.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
+#include "render/shaders/Tex2DBindlessShader.hpp"
 #include "render/shaders/Tex2DShader.hpp"
 
 namespace blocks::render {
 
+namespace {
+
+static_assert(
+    offsetof(Tex2DBindlessShader::InstanceData, textureIndex) ==
+    sizeof(RenderableTex2D::InstanceData));
+
+// Keeps the texture loaded for as long as the renderable exists
+class TextureLeaseHolder : public RenderableObject::ResourceHolder {
+ public:
+  explicit TextureLeaseHolder(TextureManager::Lease lease)
+      : lease_(std::move(lease)) {}
+
+ private:
+  TextureManager::Lease lease_;
+};
+
+RenderableObject createBindless(
+    const std::filesystem::path& texturePath,
+    ShaderProgramManager& programManager,
+    TextureManager& textureManager,
+    GeometryManager& geometryManager) {
+  VulkanShaderProgram* shaderProgram =
+      &programManager.getOrCreate<Tex2DBindlessShader>();
+  VulkanMesh* mesh = &geometryManager.getOrCreate<UVQuad>();
+  TextureManager::Lease lease = textureManager.acquire(texturePath);
+  const uint32_t textureIndex = lease.getBindlessIndex();
+
+  std::vector<std::byte> constantInstanceData(sizeof(textureIndex));
+  std::memcpy(
+      constantInstanceData.data(), &textureIndex, sizeof(textureIndex));
+
+  return RenderableObject{
+      shaderProgram,
+      textureManager.getBindlessDescriptorSets(),
+      mesh,
+      sizeof(RenderableTex2D::InstanceData),
+      sizeof(Tex2DBindlessShader::InstanceData),
+      std::move(constantInstanceData),
+      std::make_unique<TextureLeaseHolder>(std::move(lease))};
+}
+
+} // namespace
+
 RenderableObject RenderableTex2D::create(
     const std::filesystem::path& texturePath,
     VulkanGraphicsDevice& device,
     ShaderProgramManager& programManager,
     TextureManager& textureManager,
+    GeometryManager& geometryManager,
     int maxFramesInFlight) {
+  if (textureManager.supportsBindless()) {
+    return createBindless(
+        texturePath, programManager, textureManager, geometryManager);
+  }
+
   VulkanShaderProgram* shaderProgram =
       &programManager.getOrCreate<Tex2DShader>();
   VulkanDescriptorPool descriptorPool{
       device, shaderProgram->getDescriptorSetLayout(), maxFramesInFlight};
-  VulkanBuffer vertexAttributes = getQuadVertexAttributesBuffer(device);
-  VulkanTexture* texture = &textureManager.getOrCreate(texturePath);
+  VulkanMesh* mesh = &geometryManager.getOrCreate<UVQuad>();
+  TextureManager::Lease lease = textureManager.acquire(texturePath);
+  const VulkanTexture* texture = &lease.getTexture();
 
   const auto& descriptorSets = descriptorPool.getDescriptorSets();
   std::vector<VkWriteDescriptorSet> descriptorWrites;
@@ -61,8 +116,9 @@ RenderableObject RenderableTex2D::create(
   return RenderableObject{
       shaderProgram,
       std::move(descriptorPool),
-      std::move(vertexAttributes),
-      sizeof(InstanceData)};
+      mesh,
+      sizeof(InstanceData),
+      std::make_unique<TextureLeaseHolder>(std::move(lease))};
 }
 
 } // namespace blocks::render
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include "render/RenderableObject.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
+#include "render/resource/GeometryManager.hpp"
 #include "render/resource/ShaderProgramManager.hpp"
 #include "render/resource/TextureManager.hpp"
 #include "render/shaders/Tex2DShader.hpp"
@@ -20,6 +21,7 @@ class RenderableTex2D {
       VulkanGraphicsDevice& device,
       ShaderProgramManager& programManager,
       TextureManager& textureManager,
+      GeometryManager& geometryManager,
       int maxFramesInFlight);
 };
 
@@ -0,0 +1,24 @@
+#include "render/resource/GeometryManager.hpp"
+
+#include <typeindex>
+#include <utility>
+#include "render/VulkanMesh.hpp"
+#include "util/debug.hpp"
+
+namespace blocks::render {
+
+VulkanMesh* GeometryManager::get(std::type_index index) {
+  auto it = meshes_.find(index);
+  if (it != meshes_.end()) {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+VulkanMesh& GeometryManager::insert(std::type_index index, VulkanMesh&& mesh) {
+  DEBUG_ASSERT(meshes_.find(index) == meshes_.end());
+  auto inserted = meshes_.emplace(index, std::move(mesh));
+  return inserted.first->second;
+}
+
+} // namespace blocks::render
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <typeindex>
+#include <unordered_map>
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanMesh.hpp"
+
+namespace blocks::render {
+
+template <typename T>
+concept MeshDefinition = requires {
+  typename T::Vertex;
+  {
+    T::getVertices()
+  } -> std::convertible_to<std::span<const typename T::Vertex>>;
+};
+
+// Vertex data shared between every renderable drawing the same mesh
+class GeometryManager {
+ public:
+  explicit GeometryManager(VulkanGraphicsDevice& device) : device_(&device) {}
+
+  template <MeshDefinition Mesh>
+  VulkanMesh& getOrCreate() {
+    const std::type_index index{typeid(Mesh)};
+    VulkanMesh* mesh = get(index);
+    if (mesh != nullptr) {
+      return *mesh;
+    }
+    const std::span<const typename Mesh::Vertex> vertices =
+        Mesh::getVertices();
+    return insert(
+        index,
+        VulkanMesh{
+            *device_,
+            std::as_bytes(vertices),
+            static_cast<uint32_t>(vertices.size())});
+  }
+
+ private:
+  VulkanMesh* get(std::type_index index);
+  VulkanMesh& insert(std::type_index index, VulkanMesh&& mesh);
+
+  std::unordered_map<std::type_index, VulkanMesh> meshes_;
+  VulkanGraphicsDevice* device_;
+};
+
+} // namespace blocks::render
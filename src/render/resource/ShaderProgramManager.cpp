@@ -1,5 +1,7 @@
 #include "render/resource/ShaderProgramManager.hpp"
 
+#include <string>
+#include <string_view>
 #include <typeindex>
 #include <utility>
 #include "render/VulkanShaderProgram.hpp"
@@ -7,6 +9,18 @@
 
 namespace blocks::render {
 
+namespace {
+
+// Strips any namespaces from the implementation defined type name
+std::string getShortTypeName(std::type_index index) {
+  const std::string_view name{index.name()};
+  const size_t separator = name.find_last_of(": ");
+  return std::string{
+      separator == std::string_view::npos ? name : name.substr(separator + 1)};
+}
+
+} // namespace
+
 VulkanShaderProgram* ShaderProgramManager::get(std::type_index index) {
   auto it = programs_.find(index);
   if (it != programs_.end()) {
@@ -19,6 +33,7 @@ VulkanShaderProgram& ShaderProgramManager::insert(
     std::type_index index, VulkanShaderProgram&& program) {
   DEBUG_ASSERT(programs_.find(index) == programs_.end());
   auto inserted = programs_.emplace(index, std::move(program));
+  inserted.first->second.setName(getShortTypeName(index));
   return inserted.first->second;
 }
 
@@ -11,14 +11,23 @@ namespace blocks::render {
 
 template <typename T>
 concept ShaderProgramDefinition = requires(
-    VulkanGraphicsDevice& device, VkRenderPass renderPass) {
-  { T::makeProgram(device, renderPass) } -> std::same_as<VulkanShaderProgram>;
+    VulkanGraphicsDevice& device,
+    VkRenderPass renderPass,
+    VkPipelineCache pipelineCache) {
+  {
+    T::makeProgram(device, renderPass, pipelineCache)
+  } -> std::same_as<VulkanShaderProgram>;
 };
 
 class ShaderProgramManager {
  public:
-  ShaderProgramManager(VulkanGraphicsDevice& device, VkRenderPass renderPass)
-      : device_(&device), renderPass_(renderPass) {}
+  ShaderProgramManager(
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      VkPipelineCache pipelineCache)
+      : device_(&device),
+        renderPass_(renderPass),
+        pipelineCache_(pipelineCache) {}
 
   template <ShaderProgramDefinition Shader>
   VulkanShaderProgram& getOrCreate() {
@@ -27,7 +36,8 @@ class ShaderProgramManager {
     if (program != nullptr) {
       return *program;
     }
-    return insert(index, Shader::makeProgram(*device_, renderPass_));
+    return insert(
+        index, Shader::makeProgram(*device_, renderPass_, pipelineCache_));
   }
 
  private:
@@ -38,6 +48,7 @@ class ShaderProgramManager {
   std::unordered_map<std::type_index, VulkanShaderProgram> programs_;
   VulkanGraphicsDevice* device_;
   VkRenderPass renderPass_;
+  VkPipelineCache pipelineCache_;
 };
 
 } // namespace blocks::render
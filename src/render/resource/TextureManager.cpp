@@ -1,26 +1,540 @@
 #include "render/resource/TextureManager.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+#include "loader/ImageCache.hpp"
+#include "loader/LoadImage.hpp"
+#include "log/Logger.hpp"
+#include "render/VulkanBindlessTextureArray.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
 #include "render/VulkanTexture.hpp"
+#include "render/VulkanUploadManager.hpp"
+#include "util/debug.hpp"
+#include "util/string.hpp"
 
 namespace blocks::render {
 
-VulkanTexture& TextureManager::getOrCreate(
+namespace {
+
+using LoadedTexture = std::
+    variant<loader::Image, loader::CompressedImage, loader::CachedImage>;
+
+// Streamed textures larger than this are first drawn from a preview this size
+constexpr size_t kPreviewSize = 64;
+// Limits how much of each frame is spent staging full textures
+constexpr size_t kRefinementBytesPerFrame = 16 * 1024 * 1024;
+
+struct DecodedImage {
+  size_t index = 0;
+  std::optional<LoadedTexture> texture;
+  std::exception_ptr error;
+};
+
+LoadedTexture loadTexture(
+    const loader::ImageCache& imageCache,
     const std::filesystem::path& resourceLocation) {
-  std::string locationString = resourceLocation.generic_string();
+  std::optional<loader::CachedImage> cached = imageCache.find(resourceLocation);
+  if (cached.has_value()) {
+    return std::move(*cached);
+  }
+
+  loader::TextureData texture = loader::loadTexture(resourceLocation);
+  if (const auto* image = std::get_if<loader::Image>(&texture)) {
+    // The cache is only an optimisation, so failing to write it is fine
+    try {
+      imageCache.store(resourceLocation, *image);
+    } catch (...) {
+      log::LoggerSystem::logToDefault(
+          log::LogLevel::WARNING,
+          util::toString(
+              "Failed to cache texture ", resourceLocation.generic_string()));
+    }
+  }
+  return std::visit(
+      [](auto&& data) {
+        return LoadedTexture{std::forward<decltype(data)>(data)};
+      },
+      std::move(texture));
+}
+
+VulkanTexture makeTexture(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    const LoadedTexture& texture) {
+  return std::visit(
+      [&](const auto& data) {
+        return VulkanTexture{device, uploadManager, data};
+      },
+      texture);
+}
+
+size_t getDataSize(const LoadedTexture& texture) {
+  return std::visit(
+      [](const auto& data) {
+        if constexpr (std::is_same_v<
+                          std::remove_cvref_t<decltype(data)>,
+                          loader::CompressedImage>) {
+          return data.data.size();
+        } else {
+          return data.pixelData.size();
+        }
+      },
+      texture);
+}
+
+// Averages each factor by factor block of a BGRA image
+loader::Image downsample(
+    size_t width,
+    size_t height,
+    std::span<const std::byte> pixelData,
+    size_t factor) {
+  loader::Image result{
+      .width = (width + factor - 1) / factor,
+      .height = (height + factor - 1) / factor,
+      .pixelData = {}};
+  result.pixelData.resize(result.width * result.height * 4);
+
+  for (size_t y = 0; y < result.height; y++) {
+    const size_t yEnd = std::min((y + 1) * factor, height);
+    for (size_t x = 0; x < result.width; x++) {
+      const size_t xEnd = std::min((x + 1) * factor, width);
+      std::array<uint32_t, 4> sum{};
+      for (size_t srcY = y * factor; srcY < yEnd; srcY++) {
+        for (size_t srcX = x * factor; srcX < xEnd; srcX++) {
+          for (size_t c = 0; c < 4; c++) {
+            sum[c] += static_cast<uint32_t>(
+                pixelData[(((srcY * width) + srcX) * 4) + c]);
+          }
+        }
+      }
+
+      const auto count =
+          static_cast<uint32_t>((yEnd - (y * factor)) * (xEnd - (x * factor)));
+      for (size_t c = 0; c < 4; c++) {
+        result.pixelData[(((y * result.width) + x) * 4) + c] =
+            static_cast<std::byte>(sum[c] / count);
+      }
+    }
+  }
+  return result;
+}
+
+// The smallest mip levels, from the first no larger than the preview size
+std::optional<loader::CompressedImage> getMipTail(
+    const loader::CompressedImage& image) {
+  size_t firstLevel = 0;
+  while (firstLevel < image.mipLevels.size() &&
+         std::max(image.width, image.height) >> firstLevel > kPreviewSize) {
+    firstLevel++;
+  }
+  if (firstLevel == 0 || firstLevel == image.mipLevels.size()) {
+    return std::nullopt;
+  }
+
+  loader::CompressedImage result{
+      .format = image.format,
+      .width = std::max<size_t>(image.width >> firstLevel, 1),
+      .height = std::max<size_t>(image.height >> firstLevel, 1),
+      .mipLevels = {},
+      .data = {}};
+  for (size_t i = firstLevel; i < image.mipLevels.size(); i++) {
+    const auto& level = image.mipLevels[i];
+    result.mipLevels.emplace_back(
+        loader::CompressedImage::MipLevel{
+            .offset = result.data.size(), .size = level.size});
+    const auto levelData =
+        std::span{image.data}.subspan(level.offset, level.size);
+    result.data.insert(result.data.end(), levelData.begin(), levelData.end());
+  }
+  return result;
+}
+
+// Nothing when the texture is already small enough to load in full
+std::optional<LoadedTexture> makePreview(const LoadedTexture& texture) {
+  return std::visit(
+      [](const auto& data) -> std::optional<LoadedTexture> {
+        if constexpr (std::is_same_v<
+                          std::remove_cvref_t<decltype(data)>,
+                          loader::CompressedImage>) {
+          return getMipTail(data);
+        } else {
+          size_t factor = 1;
+          while (std::max(data.width, data.height) > kPreviewSize * factor) {
+            factor *= 2;
+          }
+          if (factor == 1) {
+            return std::nullopt;
+          }
+          return downsample(data.width, data.height, data.pixelData, factor);
+        }
+      },
+      texture);
+}
+
+} // namespace
+
+TextureManager::Lease::Lease(TextureManager& manager, std::string location)
+    : manager_(&manager), location_(std::move(location)) {}
+
+TextureManager::Lease::~Lease() {
+  if (manager_ != nullptr) {
+    manager_->release(location_);
+  }
+}
+
+TextureManager::Lease::Lease(Lease&& other) noexcept
+    : manager_(std::exchange(other.manager_, nullptr)),
+      location_(std::move(other.location_)) {}
+
+TextureManager::Lease& TextureManager::Lease::operator=(
+    Lease&& other) noexcept {
+  std::swap(manager_, other.manager_);
+  std::swap(location_, other.location_);
+  return *this;
+}
+
+const VulkanTexture& TextureManager::Lease::getTexture() const {
+  DEBUG_ASSERT(!manager_->supportsBindless());
+  // Without bindless textures nothing is refined, so the texture is not
+  // replaced while leased
+  return manager_->state_.rlock()->textures.at(location_).texture;
+}
+
+uint32_t TextureManager::Lease::getBindlessIndex() const {
+  DEBUG_ASSERT(manager_->supportsBindless());
+  // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+  return *manager_->state_.rlock()->textures.at(location_).bindlessIndex;
+}
+
+TextureManager::TextureManager(
+    VulkanGraphicsDevice& device,
+    VulkanUploadManager& uploadManager,
+    std::filesystem::path cacheDirectory,
+    VkDeviceSize memoryBudget,
+    int framesInFlight)
+    : device_(&device),
+      uploadManager_(&uploadManager),
+      imageCache_(std::move(cacheDirectory)),
+      memoryBudget_(memoryBudget),
+      framesInFlight_(framesInFlight),
+      supportsBindless_(VulkanBindlessTextureArray::isSupported(device)) {
+  if (supportsBindless_) {
+    state_.wlock()->bindlessTextures.emplace(device, framesInFlight);
+  }
+}
+
+TextureManager::Lease TextureManager::acquire(
+    const std::filesystem::path& resourceLocation) {
+  std::string location = resourceLocation.generic_string();
+  {
+    auto state = state_.wlock();
+    auto it = state->textures.find(location);
+    if (it != state->textures.end()) {
+      return addLease(*state, it->second, std::move(location));
+    }
+  }
+
+  // Loaded without the lock so the render thread is not held up
+  PendingTexture texture =
+      createTexture(loadTexture(imageCache_, resourceLocation));
+
+  auto state = state_.wlock();
+  Entry& entry = findOrInsert(*state, location, std::move(texture));
+  return addLease(*state, entry, std::move(location));
+}
+
+std::vector<TextureManager::Lease> TextureManager::preload(
+    std::span<const std::filesystem::path> resourceLocations) {
+  std::vector<Lease> leases;
+  std::vector<std::filesystem::path> pending;
+  {
+    auto state = state_.wlock();
+    std::unordered_set<std::string> seen;
+    for (const auto& location : resourceLocations) {
+      std::string locationString = location.generic_string();
+      if (!seen.insert(locationString).second) {
+        continue;
+      }
+      auto it = state->textures.find(locationString);
+      if (it != state->textures.end()) {
+        leases.emplace_back(
+            addLease(*state, it->second, std::move(locationString)));
+      } else {
+        pending.emplace_back(location);
+      }
+    }
+  }
+  if (pending.empty()) {
+    return leases;
+  }
+
+  std::atomic<size_t> nextIndex = 0;
+  std::mutex resultsMutex;
+  std::condition_variable resultsAvailable;
+  std::deque<DecodedImage> results;
+
+  auto decode = [&](const std::stop_token& stopToken) {
+    while (!stopToken.stop_requested()) {
+      const size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+      if (index >= pending.size()) {
+        return;
+      }
+
+      DecodedImage result{.index = index, .texture = {}, .error = {}};
+      try {
+        result.texture = loadTexture(imageCache_, pending[index]);
+      } catch (...) {
+        result.error = std::current_exception();
+      }
+      {
+        const std::lock_guard lock{resultsMutex};
+        results.emplace_back(std::move(result));
+      }
+      resultsAvailable.notify_one();
+    }
+  };
+
+  // Joined before the state above goes out of scope, including when an upload
+  // throws, in which case the remaining decodes are abandoned
+  std::vector<std::jthread> workers;
+  const size_t workerCount = std::clamp<size_t>(
+      std::thread::hardware_concurrency(), 1, pending.size());
+  workers.reserve(workerCount);
+  for (size_t i = 0; i < workerCount; i++) {
+    workers.emplace_back(decode);
+  }
+
+  for (size_t remaining = pending.size(); remaining > 0; remaining--) {
+    DecodedImage result;
+    {
+      std::unique_lock lock{resultsMutex};
+      resultsAvailable.wait(lock, [&]() { return !results.empty(); });
+      result = std::move(results.front());
+      results.pop_front();
+    }
+    if (result.error != nullptr) {
+      std::rethrow_exception(result.error);
+    }
+
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    PendingTexture texture = createTexture(std::move(*result.texture));
+    std::string location = pending[result.index].generic_string();
+    auto state = state_.wlock();
+    Entry& entry = findOrInsert(*state, location, std::move(texture));
+    leases.emplace_back(addLease(*state, entry, std::move(location)));
+  }
+  return leases;
+}
+
+void TextureManager::beginFrame(uint32_t frame) {
+  std::vector<Refinement> refinements;
+  {
+    auto state = state_.wlock();
+    const uint64_t frameCount = ++state->frameCount;
+    std::erase_if(state->retiredTextures, [&](const RetiredTexture& retired) {
+      return retired.destroyFrame <= frameCount;
+    });
 
-  auto it = textures_.find(locationString);
+    size_t refinedBytes = 0;
+    while (!state->refinements.empty() &&
+           refinedBytes < kRefinementBytesPerFrame) {
+      Refinement& refinement = state->refinements.front();
+      auto it = state->textures.find(refinement.location);
+      // Skip any unloaded in the meantime
+      if (it != state->textures.end() && it->second.isPreview) {
+        refinedBytes += getDataSize(refinement.texture);
+        refinements.emplace_back(std::move(refinement));
+      }
+      state->refinements.pop_front();
+    }
+  }
+
+  // Staged without the lock, so the loading thread is not held up
+  std::vector<VulkanTexture> textures;
+  textures.reserve(refinements.size());
+  for (const Refinement& refinement : refinements) {
+    textures.emplace_back(
+        makeTexture(*device_, *uploadManager_, refinement.texture));
+  }
+
+  auto state = state_.wlock();
+  for (size_t i = 0; i < refinements.size(); i++) {
+    refine(*state, refinements[i].location, std::move(textures[i]));
+  }
+
+  evict(*state);
 
-  if (it != textures_.end()) {
-    return it->second;
+  if (state->bindlessTextures.has_value()) {
+    state->bindlessTextures->beginFrame(frame);
   }
+}
+
+std::vector<VkDescriptorSet> TextureManager::getBindlessDescriptorSets()
+    const {
+  DEBUG_ASSERT(supportsBindless_);
+  auto state = state_.rlock();
+  // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+  return state->bindlessTextures->getDescriptorSets();
+}
+
+TextureManager::PendingTexture TextureManager::createTexture(
+    LoadedTexture texture) {
+  std::optional<LoadedTexture> preview =
+      supportsBindless_ ? makePreview(texture) : std::nullopt;
+  if (!preview.has_value()) {
+    return PendingTexture{
+        .texture = makeTexture(*device_, *uploadManager_, texture),
+        .refinement = std::nullopt};
+  }
+  return PendingTexture{
+      .texture = makeTexture(*device_, *uploadManager_, *preview),
+      .refinement = std::move(texture)};
+}
+
+TextureManager::Entry& TextureManager::insert(
+    State& state, std::string location, PendingTexture texture) {
+  std::optional<uint32_t> bindlessIndex;
+  if (state.bindlessTextures.has_value()) {
+    bindlessIndex = state.bindlessTextures->add(texture.texture);
+  }
+  const bool isPreview = texture.refinement.has_value();
+  if (isPreview) {
+    state.refinements.emplace_back(
+        Refinement{
+            .location = location,
+            // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+            .texture = std::move(*texture.refinement)});
+  }
+
+  state.residentBytes += texture.texture.getMemorySize();
+  return state.textures
+      .emplace(
+          std::move(location),
+          Entry{
+              .texture = std::move(texture.texture),
+              .bindlessIndex = bindlessIndex,
+              .leaseCount = 0,
+              .lastUsedFrame = state.frameCount,
+              .isPreview = isPreview})
+      .first->second;
+}
+
+TextureManager::Entry& TextureManager::findOrInsert(
+    State& state, const std::string& location, PendingTexture texture) {
+  auto it = state.textures.find(location);
+  if (it == state.textures.end()) {
+    return insert(state, location, std::move(texture));
+  }
+  // Loaded by another thread in the meantime. This copy's upload is already
+  // staged, so it cannot be destroyed straight away.
+  state.retiredTextures.emplace_back(
+      RetiredTexture{
+          .texture = std::move(texture.texture),
+          .destroyFrame = state.frameCount + framesInFlight_});
+  return it->second;
+}
+
+void TextureManager::refine(
+    State& state, const std::string& location, VulkanTexture texture) {
+  auto it = state.textures.find(location);
+  // Only reachable when the same texture was queued twice. The upload is
+  // already staged, so it cannot be destroyed straight away.
+  if (it == state.textures.end() || !it->second.isPreview) {
+    state.retiredTextures.emplace_back(
+        RetiredTexture{
+            .texture = std::move(texture),
+            .destroyFrame = state.frameCount + framesInFlight_});
+    return;
+  }
+  Entry& entry = it->second;
+
+  state.residentBytes += texture.getMemorySize();
+  state.residentBytes -= entry.texture.getMemorySize();
+  // Frames already submitted may still draw the preview, the last of them
+  // finishes before this frame's slot comes round again
+  state.retiredTextures.emplace_back(
+      RetiredTexture{
+          .texture = std::exchange(entry.texture, std::move(texture)),
+          .destroyFrame = state.frameCount + framesInFlight_ - 1});
+  entry.isPreview = false;
+
+  if (entry.bindlessIndex.has_value()) {
+    // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+    state.bindlessTextures->replace(*entry.bindlessIndex, entry.texture);
+  }
+}
+
+void TextureManager::evict(State& state) {
+  if (state.residentBytes <= memoryBudget_) {
+    return;
+  }
+
+  // Renderables release their leases once the frames drawing them have
+  // finished, so these are no longer drawn
+  std::vector<std::unordered_map<std::string, Entry>::iterator> unused;
+  for (auto it = state.textures.begin(); it != state.textures.end(); ++it) {
+    if (it->second.leaseCount == 0) {
+      unused.emplace_back(it);
+    }
+  }
+  std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) {
+    return a->second.lastUsedFrame < b->second.lastUsedFrame;
+  });
+
+  for (const auto& it : unused) {
+    if (state.residentBytes <= memoryBudget_) {
+      break;
+    }
+    if (it->second.bindlessIndex.has_value()) {
+      // NOLINTNEXTLINE(bugprone-unchecked-optional-access)
+      state.bindlessTextures->remove(*it->second.bindlessIndex);
+    }
+    state.residentBytes -= it->second.texture.getMemorySize();
+    // Its upload may not have been submitted yet, which happens after this
+    // within the same frame
+    state.retiredTextures.emplace_back(
+        RetiredTexture{
+            .texture = std::move(it->second.texture),
+            .destroyFrame = state.frameCount + framesInFlight_});
+    state.textures.erase(it);
+  }
+}
+
+TextureManager::Lease TextureManager::addLease(
+    State& state, Entry& entry, std::string location) {
+  entry.leaseCount++;
+  entry.lastUsedFrame = state.frameCount;
+  return Lease{*this, std::move(location)};
+}
 
-  auto insertResult = textures_.emplace(
-      std::move(locationString),
-      VulkanTexture{*device_, commandPool_, resourceLocation});
-  return insertResult.first->second;
+void TextureManager::release(const std::string& location) {
+  auto state = state_.wlock();
+  Entry& entry = state->textures.at(location);
+  DEBUG_ASSERT(entry.leaseCount > 0);
+  entry.leaseCount--;
+  entry.lastUsedFrame = state->frameCount;
 }
 
 } // namespace blocks::render
@@ -1,26 +1,139 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <filesystem>
+#include <optional>
+#include <shared_mutex>
+#include <span>
 #include <string>
-#include <type_traits>
 #include <unordered_map>
-#include "render/VulkanCommandPool.hpp"
+#include <variant>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+#include "loader/ImageCache.hpp"
+#include "render/VulkanBindlessTextureArray.hpp"
 #include "render/VulkanGraphicsDevice.hpp"
 #include "render/VulkanTexture.hpp"
+#include "render/VulkanUploadManager.hpp"
+#include "util/Synchronized.hpp"
 
 namespace blocks::render {
 
+// Textures stay loaded while anything holds a Lease on them. Once more than
+// the memory budget is loaded, those without leases are unloaded, least
+// recently used first. With bindless textures, large textures are first drawn
+// from a small preview while the full texture is uploaded over later frames.
 class TextureManager {
  public:
-  TextureManager(VulkanGraphicsDevice& device, VulkanCommandPool commandPool)
-      : device_(&device), commandPool_(std::move(commandPool)) {}
+  class Lease {
+   public:
+    ~Lease();
 
-  VulkanTexture& getOrCreate(const std::filesystem::path& resourceLocation);
+    Lease(const Lease& other) = delete;
+    Lease& operator=(const Lease& other) = delete;
+
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(Lease&& other) noexcept;
+
+    // Only available without bindless textures
+    [[nodiscard]] const VulkanTexture& getTexture() const;
+    // Only available with bindless textures
+    [[nodiscard]] uint32_t getBindlessIndex() const;
+
+   private:
+    Lease(TextureManager& manager, std::string location);
+
+    TextureManager* manager_;
+    std::string location_;
+
+    friend class TextureManager;
+  };
+
+  // Decoded images are kept in cacheDirectory between runs
+  TextureManager(
+      VulkanGraphicsDevice& device,
+      VulkanUploadManager& uploadManager,
+      std::filesystem::path cacheDirectory,
+      VkDeviceSize memoryBudget,
+      int framesInFlight);
+
+  // Safe to call from any thread
+  Lease acquire(const std::filesystem::path& resourceLocation);
+  // Decodes any textures not yet loaded on a pool of worker threads, creating
+  // each one on the calling thread as soon as its decode finishes. Hold the
+  // leases until whatever uses the textures has acquired its own, or they may
+  // be unloaded in between.
+  [[nodiscard]] std::vector<Lease> preload(
+      std::span<const std::filesystem::path> resourceLocations);
+
+  // Called on the render thread once the frame's previous use has finished
+  // rendering, and before its uploads are flushed
+  void beginFrame(uint32_t frame);
+
+  [[nodiscard]] bool supportsBindless() const { return supportsBindless_; }
+  // Only available when supportsBindless() is true, one per frame in flight
+  [[nodiscard]] std::vector<VkDescriptorSet> getBindlessDescriptorSets() const;
 
  private:
-  std::unordered_map<std::string, VulkanTexture> textures_;
+  using LoadedTexture = std::
+      variant<loader::Image, loader::CompressedImage, loader::CachedImage>;
+
+  struct Entry {
+    VulkanTexture texture;
+    std::optional<uint32_t> bindlessIndex;
+    size_t leaseCount = 0;
+    uint64_t lastUsedFrame = 0;
+    bool isPreview = false;
+  };
+
+  struct PendingTexture {
+    VulkanTexture texture;
+    // The full texture, when texture is only a preview of it
+    std::optional<LoadedTexture> refinement;
+  };
+
+  // Full textures waiting to replace their previews
+  struct Refinement {
+    std::string location;
+    LoadedTexture texture;
+  };
+
+  // Textures which may still be in use by frames in flight
+  struct RetiredTexture {
+    VulkanTexture texture;
+    uint64_t destroyFrame;
+  };
+
+  struct State {
+    std::unordered_map<std::string, Entry> textures;
+    std::optional<VulkanBindlessTextureArray> bindlessTextures;
+    std::deque<Refinement> refinements;
+    std::vector<RetiredTexture> retiredTextures;
+    VkDeviceSize residentBytes = 0;
+    uint64_t frameCount = 0;
+  };
+
+  // Called without the lock, as this is where the upload is staged
+  PendingTexture createTexture(LoadedTexture texture);
+  Entry& insert(State& state, std::string location, PendingTexture texture);
+  // Keeps any entry already loaded, retiring the new texture
+  Entry& findOrInsert(
+      State& state, const std::string& location, PendingTexture texture);
+  void refine(State& state, const std::string& location, VulkanTexture texture);
+  void evict(State& state);
+  Lease addLease(State& state, Entry& entry, std::string location);
+  void release(const std::string& location);
+
   VulkanGraphicsDevice* device_;
-  VulkanCommandPool commandPool_;
+  VulkanUploadManager* uploadManager_;
+  loader::ImageCache imageCache_;
+  VkDeviceSize memoryBudget_;
+  int framesInFlight_;
+  bool supportsBindless_;
+  util::Synchronized<State, std::shared_mutex> state_;
 };
 
 } // namespace blocks::render
@@ -83,10 +83,13 @@ VulkanVertexShader getVertexShader(VulkanGraphicsDevice& device) {
 } // namespace
 
 VulkanShaderProgram Col2DShader::makeProgram(
-    VulkanGraphicsDevice& device, VkRenderPass renderPass) {
+    VulkanGraphicsDevice& device,
+    VkRenderPass renderPass,
+    VkPipelineCache pipelineCache) {
   return {
       device,
       renderPass,
+      pipelineCache,
       getVertexShader(device),
       VulkanShader{device, "shaders/colFragment.spv"},
       vulkan::DescriptorSetLayoutBuilder().build(device.getRawDevice())};
@@ -17,7 +17,9 @@ class Col2DShader {
   };
 
   static VulkanShaderProgram makeProgram(
-      VulkanGraphicsDevice& device, VkRenderPass renderPass);
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      VkPipelineCache pipelineCache);
 };
 
 } // namespace blocks::render
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+#include "math/vec.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanShaderProgram.hpp"
+
+namespace blocks::render {
+
+class FontAtlasShader {
+ public:
+  FontAtlasShader() = delete;
+
+  struct InstanceData {
+    math::Mat3 modelMatrix;
+    math::Mat3 uvTransform;
+  };
+
+  static VulkanShaderProgram makeProgram(
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      VkPipelineCache pipelineCache);
+};
+
+} // namespace blocks::render
@@ -47,14 +47,14 @@ void appendInstanceInputVertexAttributeDescriptors(
           .location = locationOffset + 3,
           .binding = binding,
           .format = VK_FORMAT_R32_SINT,
-          .offset = offsetof(FontShader::InstanceData, glyphStart)});
+          .offset = offsetof(FontShader::InstanceData, bandStart)});
 
   descriptor.emplace_back(
       VkVertexInputAttributeDescription{
           .location = locationOffset + 4,
           .binding = binding,
           .format = VK_FORMAT_R32_SINT,
-          .offset = offsetof(FontShader::InstanceData, glyphEnd)});
+          .offset = offsetof(FontShader::InstanceData, bandCount)});
 
   descriptor.emplace_back(
       VkVertexInputAttributeDescription{
@@ -113,10 +113,13 @@ VulkanVertexShader getVertexShader(VulkanGraphicsDevice& device) {
 } // namespace
 
 VulkanShaderProgram FontShader::makeProgram(
-    VulkanGraphicsDevice& device, VkRenderPass renderPass) {
+    VulkanGraphicsDevice& device,
+    VkRenderPass renderPass,
+    VkPipelineCache pipelineCache) {
   return {
       device,
       renderPass,
+      pipelineCache,
       getVertexShader(device),
       VulkanShader{device, "shaders/fontFragment.spv"},
       vulkan::DescriptorSetLayoutBuilder()
@@ -125,6 +128,11 @@ VulkanShaderProgram FontShader::makeProgram(
               VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
               1,
               VK_SHADER_STAGE_FRAGMENT_BIT)
+          .addBinding(
+              1,
+              VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+              1,
+              VK_SHADER_STAGE_FRAGMENT_BIT)
           .build(device.getRawDevice())};
 }
 
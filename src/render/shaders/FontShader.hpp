@@ -14,13 +14,15 @@ class FontShader {
 
   struct InstanceData {
     math::Mat3 modelMatrix;
-    int32_t glyphStart;
-    int32_t glyphEnd;
+    int32_t bandStart;
+    int32_t bandCount;
     math::Mat3 uvToGlyphSpace;
   };
 
   static VulkanShaderProgram makeProgram(
-      VulkanGraphicsDevice& device, VkRenderPass renderPass);
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      VkPipelineCache pipelineCache);
 };
 
 } // namespace blocks::render
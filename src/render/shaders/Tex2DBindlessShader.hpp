@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+#include "math/vec.hpp"
+#include "render/VulkanGraphicsDevice.hpp"
+#include "render/VulkanShaderProgram.hpp"
+
+namespace blocks::render {
+
+class Tex2DBindlessShader {
+ public:
+  Tex2DBindlessShader() = delete;
+
+  struct InstanceData {
+    math::Mat3 modelMatrix;
+    uint32_t textureIndex;
+  };
+
+  static VulkanShaderProgram makeProgram(
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      VkPipelineCache pipelineCache);
+};
+
+} // namespace blocks::render
@@ -73,10 +73,13 @@ VulkanVertexShader getVertexShader(VulkanGraphicsDevice& device) {
 } // namespace
 
 VulkanShaderProgram Tex2DShader::makeProgram(
-    VulkanGraphicsDevice& device, VkRenderPass renderPass) {
+    VulkanGraphicsDevice& device,
+    VkRenderPass renderPass,
+    VkPipelineCache pipelineCache) {
   return {
       device,
       renderPass,
+      pipelineCache,
       getVertexShader(device),
       VulkanShader{device, "shaders/fragment.spv"},
       vulkan::DescriptorSetLayoutBuilder()
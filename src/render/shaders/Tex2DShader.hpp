@@ -16,7 +16,9 @@ class Tex2DShader {
   };
 
   static VulkanShaderProgram makeProgram(
-      VulkanGraphicsDevice& device, VkRenderPass renderPass);
+      VulkanGraphicsDevice& device,
+      VkRenderPass renderPass,
+      VkPipelineCache pipelineCache);
 };
 
 } // namespace blocks::render
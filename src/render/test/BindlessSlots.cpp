@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "render/BindlessSlots.hpp"
+
+using blocks::render::BindlessSlots;
+
+namespace {
+
+std::vector<uint32_t> getIndices(
+    const std::vector<BindlessSlots<int>::Write>& writes) {
+  std::vector<uint32_t> result;
+  for (const auto& write : writes) {
+    result.emplace_back(write.index);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(BindlessSlots, AllocatesInOrderUntilFull) {
+  BindlessSlots<int> slots{3, 1};
+  EXPECT_EQ(slots.allocate(), 0);
+  EXPECT_EQ(slots.allocate(), 1);
+  EXPECT_EQ(slots.allocate(), 2);
+  EXPECT_THROW(slots.allocate(), std::runtime_error);
+}
+
+TEST(BindlessSlots, ReusesFreedIndices) {
+  BindlessSlots<int> slots{3, 1};
+  slots.allocate();
+  const uint32_t freed = slots.allocate();
+  slots.allocate();
+
+  slots.free(freed);
+  EXPECT_EQ(slots.allocate(), freed);
+  EXPECT_THROW(slots.allocate(), std::runtime_error);
+}
+
+TEST(BindlessSlots, WritesAreTakenOncePerFrame) {
+  BindlessSlots<int> slots{4, 2};
+  const uint32_t index = slots.allocate();
+  slots.write(index, 5);
+
+  for (uint32_t frame = 0; frame < 2; frame++) {
+    const auto writes = slots.takeWrites(frame);
+    ASSERT_EQ(writes.size(), 1);
+    EXPECT_EQ(writes[0].index, index);
+    EXPECT_EQ(writes[0].value, 5);
+    EXPECT_TRUE(slots.takeWrites(frame).empty());
+  }
+}
+
+TEST(BindlessSlots, LatestWriteToASlotWins) {
+  BindlessSlots<int> slots{4, 2};
+  const uint32_t index = slots.allocate();
+  slots.write(index, 5);
+  EXPECT_EQ(slots.takeWrites(0).size(), 1);
+
+  // Frame 1 has not applied the first write yet, so it is replaced there
+  slots.write(index, 6);
+  for (uint32_t frame = 0; frame < 2; frame++) {
+    const auto writes = slots.takeWrites(frame);
+    ASSERT_EQ(writes.size(), 1);
+    EXPECT_EQ(writes[0].value, 6);
+  }
+}
+
+TEST(BindlessSlots, FreeDropsPendingWrites) {
+  BindlessSlots<int> slots{4, 2};
+  const uint32_t kept = slots.allocate();
+  const uint32_t freed = slots.allocate();
+  slots.write(kept, 1);
+  slots.write(freed, 2);
+  EXPECT_EQ(getIndices(slots.takeWrites(0)), (std::vector<uint32_t>{0, 1}));
+
+  slots.free(freed);
+  EXPECT_EQ(getIndices(slots.takeWrites(1)), std::vector<uint32_t>{kept});
+}
+
+TEST(BindlessSlots, ReusedSlotOnlyGetsItsNewWrite) {
+  BindlessSlots<int> slots{4, 2};
+  const uint32_t index = slots.allocate();
+  slots.write(index, 1);
+  slots.free(index);
+
+  EXPECT_EQ(slots.allocate(), index);
+  slots.write(index, 2);
+  for (uint32_t frame = 0; frame < 2; frame++) {
+    const auto writes = slots.takeWrites(frame);
+    ASSERT_EQ(writes.size(), 1);
+    EXPECT_EQ(writes[0].value, 2);
+  }
+}
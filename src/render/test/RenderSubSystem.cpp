@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+#include "loader/Image.hpp"
+#include "math/vec.hpp"
+#include "render/RenderSubSystem.hpp"
+#include "render/Simple2DCamera.hpp"
+#include "render/renderables/RenderableTex2D.hpp"
+
+using blocks::render::RenderableTex2D;
+using blocks::render::RenderSubSystem;
+using blocks::render::Simple2DCamera;
+using blocks::render::UniqueWindowHandle;
+
+namespace {
+
+constexpr uint32_t kTargetSize = 64;
+constexpr uint32_t kSpriteSize = 4;
+
+// Checks for a driver without going through RenderSubSystem, so other
+// failures to create it are still reported
+bool hasVulkanDevice() {
+  VkApplicationInfo appInfo{};
+  appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+  appInfo.apiVersion = VK_API_VERSION_1_2;
+
+  VkInstanceCreateInfo createInfo{};
+  createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+  createInfo.pApplicationInfo = &appInfo;
+
+  VkInstance instance = nullptr;
+  if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+    return false;
+  }
+  uint32_t deviceCount = 0;
+  vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+  vkDestroyInstance(instance, nullptr);
+  return deviceCount > 0;
+}
+
+void appendLittleEndian(
+    std::vector<char>& out, uint32_t value, size_t size = 4) {
+  for (size_t i = 0; i < size; i++) {
+    out.emplace_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+// A 24 bit bitmap filled with a single colour
+void writeBitmap(
+    const std::filesystem::path& path,
+    uint8_t blue,
+    uint8_t green,
+    uint8_t red) {
+  const uint32_t rowSize = ((kSpriteSize * 24 + 31) / 32) * 4;
+  const uint32_t pixelOffset = 14 + 40;
+
+  std::vector<char> data{'B', 'M'};
+  appendLittleEndian(data, pixelOffset + (rowSize * kSpriteSize));
+  appendLittleEndian(data, 0);
+  appendLittleEndian(data, pixelOffset);
+  appendLittleEndian(data, 40);
+  appendLittleEndian(data, kSpriteSize);
+  appendLittleEndian(data, kSpriteSize);
+  appendLittleEndian(data, 1, 2);
+  appendLittleEndian(data, 24, 2);
+  for (int i = 0; i < 6; i++) {
+    appendLittleEndian(data, 0);
+  }
+  for (uint32_t y = 0; y < kSpriteSize; y++) {
+    for (uint32_t x = 0; x < kSpriteSize; x++) {
+      data.insert(
+          data.end(),
+          {static_cast<char>(blue),
+           static_cast<char>(green),
+           static_cast<char>(red)});
+    }
+    data.resize(data.size() + rowSize - (kSpriteSize * 3));
+  }
+
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+// Offscreen targets read back as BGRA
+std::vector<uint8_t> getPixel(
+    const blocks::loader::Image& image, size_t x, size_t y) {
+  const size_t offset = ((y * image.width) + x) * 4;
+  std::vector<uint8_t> result;
+  for (size_t i = 0; i < 4; i++) {
+    result.emplace_back(static_cast<uint8_t>(image.pixelData[offset + i]));
+  }
+  return result;
+}
+
+class RenderSubSystemTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!hasVulkanDevice()) {
+      GTEST_SKIP() << "No Vulkan driver is available";
+    }
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  std::filesystem::path directory_ =
+      std::filesystem::temp_directory_path() / "render_test_render_subsystem";
+};
+
+} // namespace
+
+TEST_F(RenderSubSystemTest, DrawsSpriteToOffscreenTarget) {
+  const std::filesystem::path spritePath = directory_ / "sprite.bmp";
+  writeBitmap(spritePath, 0, 0, 255);
+
+  RenderSubSystem render{true};
+  blocks::loader::Image image{};
+  {
+    UniqueWindowHandle target =
+        render.createOffscreenTarget(kTargetSize, kTargetSize);
+    auto sprite = render.createRenderable<RenderableTex2D>(spritePath);
+
+    // The default camera shows -1 to 1 on both axes, so this covers the left
+    // half of the target
+    render.drawObject<RenderableTex2D::InstanceData>(
+        target.get(),
+        0,
+        sprite.get(),
+        {math::modelMatrixFromBounds(
+            math::Vec2{-1.0f, -1.0f}, math::Vec2{0.0f, 1.0f})});
+    render.commitFrame();
+
+    image = render.readOffscreenTarget(target.get());
+    render.waitIdle();
+  }
+
+  ASSERT_EQ(image.width, kTargetSize);
+  ASSERT_EQ(image.height, kTargetSize);
+  EXPECT_EQ(
+      getPixel(image, kTargetSize / 4, kTargetSize / 2),
+      (std::vector<uint8_t>{0, 0, 255, 255}));
+  EXPECT_EQ(
+      getPixel(image, 3 * kTargetSize / 4, kTargetSize / 2),
+      (std::vector<uint8_t>{0, 0, 0, 255}));
+}
+
+TEST_F(RenderSubSystemTest, DrawsOverlappingSpritesInZOrder) {
+  // With bindless textures these all share one batch
+  const std::vector<std::vector<uint8_t>> colours{
+      {255, 0, 0, 255}, {0, 255, 0, 255}, {0, 0, 255, 255}, {255, 255, 0, 255}};
+
+  RenderSubSystem render{true};
+  // Views the same area as the default camera, but is a different camera
+  Simple2DCamera camera{
+      math::Vec2{-1.0f, -1.0f},
+      math::Vec2{1.0f, 1.0f},
+      Simple2DCamera::AspectRatioHandling::FIT};
+  blocks::loader::Image image{};
+  {
+    UniqueWindowHandle target =
+        render.createOffscreenTarget(kTargetSize, kTargetSize);
+    std::vector<blocks::render::UniqueRenderableHandle<
+        RenderableTex2D::InstanceData>>
+        sprites;
+    for (size_t i = 0; i < colours.size(); i++) {
+      const std::filesystem::path spritePath =
+          directory_ / ("sprite" + std::to_string(i) + ".bmp");
+      writeBitmap(spritePath, colours[i][0], colours[i][1], colours[i][2]);
+      sprites.emplace_back(
+          render.createRenderable<RenderableTex2D>(spritePath));
+    }
+
+    // Submitted from the top down with alternating cameras. The top sprite
+    // only covers the left half, so the one below shows on the right.
+    for (size_t i = colours.size(); i-- > 0;) {
+      const math::Vec2 max = i == colours.size() - 1
+          ? math::Vec2{0.0f, 1.0f}
+          : math::Vec2{1.0f, 1.0f};
+      render.drawObject<RenderableTex2D::InstanceData>(
+          target.get(),
+          i % 2 == 0 ? &camera : nullptr,
+          static_cast<long>(i),
+          sprites[i].get(),
+          {math::modelMatrixFromBounds(math::Vec2{-1.0f, -1.0f}, max)});
+    }
+    render.commitFrame();
+
+    image = render.readOffscreenTarget(target.get());
+    render.waitIdle();
+  }
+
+  EXPECT_EQ(getPixel(image, kTargetSize / 4, kTargetSize / 2), colours[3]);
+  EXPECT_EQ(
+      getPixel(image, 3 * kTargetSize / 4, kTargetSize / 2), colours[2]);
+}
@@ -1,5 +1,6 @@
 #include "render/vulkan/DescriptorSetLayoutBuilder.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
@@ -14,6 +15,15 @@ DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::addBinding(
     VkDescriptorType descriptorType,
     uint32_t descriptorCount,
     VkShaderStageFlags stageFlags) {
+  return addBinding(binding, descriptorType, descriptorCount, stageFlags, 0);
+}
+
+DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::addBinding(
+    uint32_t binding,
+    VkDescriptorType descriptorType,
+    uint32_t descriptorCount,
+    VkShaderStageFlags stageFlags,
+    VkDescriptorBindingFlags bindingFlags) {
   bindings_.emplace_back(
       VkDescriptorSetLayoutBinding{
           .binding = binding,
@@ -21,13 +31,32 @@ DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::addBinding(
           .descriptorCount = descriptorCount,
           .stageFlags = stageFlags,
           .pImmutableSamplers = nullptr});
+  bindingFlags_.emplace_back(bindingFlags);
+  return *this;
+}
+
+DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::setFlags(
+    VkDescriptorSetLayoutCreateFlags flags) {
+  flags_ = flags;
   return *this;
 }
 
 UniqueHandle<VkDescriptorSetLayout> DescriptorSetLayoutBuilder::build(
     VkDevice device) {
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+  bindingFlagsInfo.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags_.size());
+  bindingFlagsInfo.pBindingFlags = bindingFlags_.data();
+
   VkDescriptorSetLayoutCreateInfo layoutInfo{};
   layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  // Binding flags require Vulkan 1.2, so only chain them when actually used
+  if (std::ranges::any_of(
+          bindingFlags_, [](VkDescriptorBindingFlags f) { return f != 0; })) {
+    layoutInfo.pNext = &bindingFlagsInfo;
+  }
+  layoutInfo.flags = flags_;
   layoutInfo.bindingCount = static_cast<uint32_t>(bindings_.size());
   layoutInfo.pBindings = bindings_.data();
 
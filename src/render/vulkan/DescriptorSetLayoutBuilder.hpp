@@ -16,11 +16,21 @@ class DescriptorSetLayoutBuilder {
       VkDescriptorType descriptorType,
       uint32_t descriptorCount,
       VkShaderStageFlags stageFlags);
+  DescriptorSetLayoutBuilder& addBinding(
+      uint32_t binding,
+      VkDescriptorType descriptorType,
+      uint32_t descriptorCount,
+      VkShaderStageFlags stageFlags,
+      VkDescriptorBindingFlags bindingFlags);
+
+  DescriptorSetLayoutBuilder& setFlags(VkDescriptorSetLayoutCreateFlags flags);
 
   UniqueHandle<VkDescriptorSetLayout> build(VkDevice device);
 
  private:
   std::vector<VkDescriptorSetLayoutBinding> bindings_;
+  std::vector<VkDescriptorBindingFlags> bindingFlags_;
+  VkDescriptorSetLayoutCreateFlags flags_ = 0;
 };
 
 } // namespace blocks::render::vulkan
@@ -1,18 +1,32 @@
 #include "render/vulkan/SemaphoreBuilder.hpp"
 
+#include <cstdint>
 #include <stdexcept>
 #include <vulkan/vulkan_core.h>
 #include "render/vulkan/UniqueHandle.hpp"
 
 namespace blocks::render::vulkan {
 
-SemaphoreBuilder::SemaphoreBuilder() : createInfo_() {
+SemaphoreBuilder::SemaphoreBuilder() : createInfo_(), typeInfo_() {
   createInfo_.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  typeInfo_.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo_.semaphoreType = VK_SEMAPHORE_TYPE_BINARY;
+}
+
+SemaphoreBuilder& SemaphoreBuilder::setTimeline(uint64_t initialValue) {
+  typeInfo_.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo_.initialValue = initialValue;
+  return *this;
 }
 
 UniqueHandle<VkSemaphore> SemaphoreBuilder::build(VkDevice device) const {
+  VkSemaphoreCreateInfo createInfo = createInfo_;
+  if (typeInfo_.semaphoreType == VK_SEMAPHORE_TYPE_TIMELINE) {
+    createInfo.pNext = &typeInfo_;
+  }
+
   VkSemaphore semaphore{};
-  if (vkCreateSemaphore(device, &createInfo_, nullptr, &semaphore) !=
+  if (vkCreateSemaphore(device, &createInfo, nullptr, &semaphore) !=
       VK_SUCCESS) {
     throw std::runtime_error{"Failed to create semaphore"};
   }
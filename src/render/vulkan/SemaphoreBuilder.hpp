@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vulkan/vulkan_core.h>
 #include "render/vulkan/UniqueHandle.hpp"
 
@@ -9,10 +10,14 @@ class SemaphoreBuilder {
  public:
   explicit SemaphoreBuilder();
 
+  // Requires the timelineSemaphore device feature
+  SemaphoreBuilder& setTimeline(uint64_t initialValue);
+
   UniqueHandle<VkSemaphore> build(VkDevice device) const;
 
  private:
   VkSemaphoreCreateInfo createInfo_;
+  VkSemaphoreTypeCreateInfo typeInfo_;
 };
 
 } // namespace blocks::render::vulkan
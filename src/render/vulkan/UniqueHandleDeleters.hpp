@@ -182,6 +182,19 @@ class HandleDeleter<VkPipeline> {
   VkDevice device_;
 };
 
+template <>
+class HandleDeleter<VkPipelineCache> {
+ public:
+  // NOLINTNEXTLINE(hicpp-explicit-conversions)
+  HandleDeleter(VkDevice device) : device_(device) {}
+  void destroy(VkPipelineCache handle) {
+    vkDestroyPipelineCache(device_, handle, nullptr);
+  }
+
+ private:
+  VkDevice device_;
+};
+
 template <>
 class HandleDeleter<VkPipelineLayout> {
  public:
@@ -195,6 +208,19 @@ class HandleDeleter<VkPipelineLayout> {
   VkDevice device_;
 };
 
+template <>
+class HandleDeleter<VkQueryPool> {
+ public:
+  // NOLINTNEXTLINE(hicpp-explicit-conversions)
+  HandleDeleter(VkDevice device) : device_(device) {}
+  void destroy(VkQueryPool handle) {
+    vkDestroyQueryPool(device_, handle, nullptr);
+  }
+
+ private:
+  VkDevice device_;
+};
+
 template <>
 class HandleDeleter<VkRenderPass> {
  public:
@@ -228,13 +228,23 @@ struct serializeArbitrary<T> {
       const T& value) {
     static_assert(T::Fields::size > 0);
     T::Fields::visitIndexed([&](auto index, auto tholder) {
+      using FieldType = typename decltype(tholder)::Value::Second;
+      const auto& fieldValue = value.template get<decltype(index)::value>();
+
       typename SerializationProvider::TObject fieldValueObject =
           provider.makeSubObject();
-      // Recurse
-      serializeArbitrary<typename decltype(tholder)::Value::Second>{}(
-          provider,
-          fieldValueObject,
-          value.template get<decltype(index)::value>());
+      // Recurse, leaving out unset optional fields entirely
+      if constexpr (OptionalTraits<FieldType>::isOptional) {
+        if (!fieldValue.has_value()) {
+          return;
+        }
+        using UnderlyingType =
+            typename OptionalTraits<FieldType>::UnderlyingType;
+        serializeArbitrary<UnderlyingType>{}(
+            provider, fieldValueObject, *fieldValue);
+      } else {
+        serializeArbitrary<FieldType>{}(provider, fieldValueObject, fieldValue);
+      }
 
       curObject.pushMappingEntry(
           std::string{decltype(tholder)::Value::First::value},
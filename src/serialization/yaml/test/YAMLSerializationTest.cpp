@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -34,6 +36,26 @@ struct PlayerDetails {
       util::TPair<util::TString<"avg">, std::string>>;
 };
 
+struct OptionalDetails {
+  bool operator==(const OptionalDetails& other) const = default;
+
+  std::string name;
+  std::optional<std::string> team;
+
+  using Fields = util::TArray<
+      util::TPair<util::TString<"name">, std::string>,
+      util::TPair<util::TString<"team">, std::optional<std::string>>>;
+
+  template <size_t i>
+  [[nodiscard]] const auto& get() const {
+    if constexpr (i == 0) {
+      return name;
+    } else {
+      return team;
+    }
+  }
+};
+
 TEST(YAMLSerializationTest, Sequence) {
   constexpr std::string_view inputYAML =
       "- Mark McGwire\n"
@@ -105,3 +127,39 @@ TEST(YAMLSerializationTest, SequenceToMapping) {
       {.name = "Sammy Sosa", .homeRuns = "63", .average = "0.288"}};
   EXPECT_EQ(expected, result);
 }
+
+TEST(YAMLSerializationTest, OptionalFields) {
+  const auto missing = blocks::serialization::deserialize<
+      OptionalDetails,
+      blocks::serialization::yaml::YAMLDeserializationProvider>(
+      "name: Mark McGwire");
+  EXPECT_EQ(
+      (OptionalDetails{.name = "Mark McGwire", .team = std::nullopt}),
+      missing);
+
+  const auto present = blocks::serialization::deserialize<
+      OptionalDetails,
+      blocks::serialization::yaml::YAMLDeserializationProvider>(
+      "name: Mark McGwire\n"
+      "team: Cardinals");
+  EXPECT_EQ(
+      (OptionalDetails{.name = "Mark McGwire", .team = "Cardinals"}), present);
+}
+
+TEST(YAMLSerializationTest, OptionalFieldsRoundTrip) {
+  for (const OptionalDetails& details :
+       {OptionalDetails{.name = "Sammy Sosa", .team = std::nullopt},
+        OptionalDetails{.name = "Sammy Sosa", .team = "Cubs"}}) {
+    const std::string serialized = blocks::serialization::serialize<
+        OptionalDetails,
+        blocks::serialization::yaml::YAMLSerializationProvider>(details);
+    EXPECT_EQ(
+        details.team.has_value(),
+        serialized.find("team") != std::string::npos);
+
+    const auto result = blocks::serialization::deserialize<
+        OptionalDetails,
+        blocks::serialization::yaml::YAMLDeserializationProvider>(serialized);
+    EXPECT_EQ(details, result);
+  }
+}
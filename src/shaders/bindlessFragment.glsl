@@ -0,0 +1,14 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#pragma shader_stage(fragment)
+
+layout(location = 0) in vec2 uv;
+layout(location = 1) flat in uint textureIndex;
+
+layout(binding = 0) uniform sampler2D textures[];
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  outColor = texture(textures[nonuniformEXT(textureIndex)], uv);
+}
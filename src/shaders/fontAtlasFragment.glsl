@@ -0,0 +1,16 @@
+#version 450
+#pragma shader_stage(fragment)
+
+layout(location = 0) in vec2 uv;
+
+layout(binding = 0) uniform sampler2D atlasSampler;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  // Alpha holds the signed distance, 0.5 on the outline
+  float distance = texture(atlasSampler, uv).a;
+  float smoothing = max(fwidth(distance) * 0.5, 1.0 / 255.0);
+  float coverage = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+  outColor = vec4(1.0, 1.0, 1.0, coverage);
+}
@@ -3,18 +3,27 @@
 
 layout(location = 0) in vec2 uv;
 
-layout(location = 1) flat in int glyphStart;
-layout(location = 2) flat in int glyphEnd;
-
-struct GlyphPoint {
-  ivec2 point;
-  bool onCurve;
-  bool contourEnd;
+layout(location = 1) in float bandCoord;
+layout(location = 2) flat in int bandStart;
+layout(location = 3) flat in int bandCount;
+
+struct GlyphCurve {
+  ivec2 start;
+  ivec2 control;
+  ivec2 end;
+  int isLine;
+  int padding;
 };
 
-layout(std140, binding = 0) readonly buffer FontData{
-	GlyphPoint glyphPoints[];
-} fontData;
+layout(std430, binding = 0) readonly buffer CurveData {
+  GlyphCurve curves[];
+} curveData;
+
+// Per glyph, a (first index, count) pair per band followed by the curve
+// indices for each band, sorted by decreasing max x
+layout(std430, binding = 1) readonly buffer BandData {
+  uint bands[];
+} bandData;
 
 layout(location = 0) out vec4 outColor;
 
@@ -76,31 +85,29 @@ int intersectsQuadratic(ivec2 a, ivec2 handle, ivec2 b) {
 }
 
 void main() {
-  GlyphPoint first = fontData.glyphPoints[glyphStart];
-  GlyphPoint second = fontData.glyphPoints[glyphStart + 1];
+  if (bandCount == 0) {
+    outColor = vec4(0.0, 0.0, 0.0, 0.0);
+    return;
+  }
 
-  int windingNumber = 0;
+  int band = clamp(int(bandCoord * bandCount), 0, bandCount - 1);
+  uint curveStart = bandData.bands[bandStart + 2 * band];
+  uint curveCount = bandData.bands[bandStart + 2 * band + 1];
 
-  int contourStart = glyphStart;
-  for (int glyphIndex = glyphStart; glyphIndex < glyphEnd; glyphIndex++) {
-	int nextIndex = glyphIndex + 1;
-	if (fontData.glyphPoints[glyphIndex].contourEnd) {
-	  nextIndex = contourStart;
-	  contourStart = glyphIndex + 1;
-	}
-
-	if (fontData.glyphPoints[nextIndex].onCurve) {
-	  windingNumber += intersectsStraight(fontData.glyphPoints[glyphIndex].point, fontData.glyphPoints[nextIndex].point);
-	}
-	else {
-	  int nextNextIndex = nextIndex + 1;
-	  if (fontData.glyphPoints[nextIndex].contourEnd) {
-	    nextNextIndex = contourStart;
-		contourStart = nextIndex + 1;
-	  }
-	  windingNumber += intersectsQuadratic(fontData.glyphPoints[glyphIndex].point, fontData.glyphPoints[nextIndex].point, fontData.glyphPoints[nextNextIndex].point);
-	  glyphIndex++;
-	}
+  int windingNumber = 0;
+  for (uint i = 0; i < curveCount; i++) {
+    GlyphCurve curve = curveData.curves[bandData.bands[curveStart + i]];
+    if (max(curve.start.x, max(curve.control.x, curve.end.x)) < uv.x) {
+      // Every remaining curve is to the left, so cannot cross the ray
+      break;
+    }
+
+    if (curve.isLine != 0) {
+      windingNumber += intersectsStraight(curve.start, curve.end);
+    }
+    else {
+      windingNumber += intersectsQuadratic(curve.start, curve.control, curve.end);
+    }
   }
 
   if (windingNumber == 0) {
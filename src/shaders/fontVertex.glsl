@@ -5,8 +5,8 @@ layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 inUV;
 
 layout(location = 2) in mat3 modelTransform;
-layout(location = 5) in int glyphStart;
-layout(location = 6) in int glyphEnd;
+layout(location = 5) in int bandStart;
+layout(location = 6) in int bandCount;
 layout(location = 7) in mat3 uvToGlyphSpace;
 
 layout(push_constant) uniform pc {
@@ -14,8 +14,9 @@ layout(push_constant) uniform pc {
 };
 
 layout(location = 0) out vec2 outUV;
-layout(location = 1) out flat int outGlyphStart;
-layout(location = 2) out flat int outGlyphEnd;
+layout(location = 1) out float outBandCoord;
+layout(location = 2) out flat int outBandStart;
+layout(location = 3) out flat int outBandCount;
 
 void main() {
   vec2 screenSpace = (viewMatrix * modelTransform * vec3(inPosition, 1.0)).xy;
@@ -23,6 +24,7 @@ void main() {
   vec2 adjInUV = inUV;
   adjInUV.y = 1.0 - adjInUV.y;
   outUV = (uvToGlyphSpace * vec3(adjInUV, 1.0)).xy;
-  outGlyphStart = glyphStart;
-  outGlyphEnd = glyphEnd;
+  outBandCoord = adjInUV.y;
+  outBandStart = bandStart;
+  outBandCount = bandCount;
 }
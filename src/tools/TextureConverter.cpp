@@ -0,0 +1,74 @@
+// Converts images to block compressed KTX2 files with a full mip chain, which
+// load without any decoding. Opaque images are stored as BC1, anything with
+// transparency as BC3. A texture resource can then point at the .ktx2 file in
+// place of the original.
+//
+// Usage: textureconverter <input image> <output.ktx2> [<input> <output> ...]
+
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "loader/CompressedImage.hpp"
+#include "loader/Image.hpp"
+#include "loader/LoadImage.hpp"
+#include "loader/image/BlockCompression.hpp"
+#include "loader/image/Ktx2.hpp"
+
+namespace {
+
+bool hasTransparency(const blocks::loader::Image& image) {
+  for (size_t i = 3; i < image.pixelData.size(); i += 4) {
+    if (image.pixelData[i] != std::byte{0xff}) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void convert(
+    const std::filesystem::path& input, const std::filesystem::path& output) {
+  const blocks::loader::Image image = blocks::loader::loadImage(input);
+  const blocks::loader::CompressedFormat format = hasTransparency(image)
+      ? blocks::loader::CompressedFormat::BC3
+      : blocks::loader::CompressedFormat::BC1;
+  const std::vector<std::byte> file = blocks::loader::writeKtx2(
+      blocks::loader::compressImage(image, format));
+
+  std::ofstream outStream{output, std::ios::binary | std::ios::trunc};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  outStream.write(reinterpret_cast<const char*>(file.data()), file.size());
+  if (!outStream) {
+    throw std::runtime_error{"Failed to write " + output.string()};
+  }
+
+  std::cout << input.string() << " -> " << output.string() << " ("
+            << (format == blocks::loader::CompressedFormat::BC1 ? "BC1" : "BC3")
+            << ", " << image.pixelData.size() << " -> " << file.size()
+            << " bytes)\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const std::span<char*> args{argv, static_cast<size_t>(argc)};
+  if (args.size() < 3 || args.size() % 2 == 0) {
+    std::cerr << "Usage: " << args[0]
+              << " <input image> <output.ktx2> [<input> <output> ...]\n";
+    return 1;
+  }
+
+  try {
+    for (size_t i = 1; i + 1 < args.size(); i += 2) {
+      convert(args[i], args[i + 1]);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
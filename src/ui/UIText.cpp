@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <string>
 #include <utility>
+#include "GlobalSubSystemStack.hpp"
 #include "math/vec.hpp"
 #include "render/Font.hpp"
 #include "render/Simple2DCamera.hpp"
@@ -23,6 +24,7 @@ int UIText::draw(
     render::Simple2DCamera& camera,
     int baseZ) {
   font_->drawStringUTF8(
+      GlobalSubSystemStack::get().window(),
       text_,
       math::Vec2{
           static_cast<float>(minPos.x() + maxPos.x()) / 2.f,
@@ -8,7 +8,7 @@ namespace util {
 
 namespace {
 
-constexpr size_t kBlockSize = 4ull * 1024ull;
+constexpr size_t kBlockSize = BlockForwardAllocatedArena::kMaxAllocationSize;
 
 } // namespace
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -8,6 +9,8 @@ namespace util {
 
 class BlockForwardAllocatedArena {
  public:
+  static constexpr size_t kMaxAllocationSize = 4ull * 1024ull;
+
   BlockForwardAllocatedArena();
 
   void* allocateRaw(size_t count, size_t align);
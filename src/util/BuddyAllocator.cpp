@@ -0,0 +1,81 @@
+#include "util/BuddyAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include "util/debug.hpp"
+
+namespace util {
+
+BuddyAllocator::BuddyAllocator(size_t size, size_t minBlockSize)
+    : size_(size), minBlockSize_(minBlockSize) {
+  if (!std::has_single_bit(size) || !std::has_single_bit(minBlockSize) ||
+      minBlockSize > size) {
+    throw std::runtime_error{"Invalid buddy allocator block sizes"};
+  }
+
+  const auto levels =
+      static_cast<uint32_t>(std::countr_zero(size / minBlockSize)) + 1;
+  freeBlocks_.resize(levels);
+  freeBlocks_.back().insert(0);
+}
+
+std::optional<size_t> BuddyAllocator::allocate(size_t size, size_t alignment) {
+  // Blocks are aligned to their own size, so rounding up also handles
+  // alignment
+  const size_t required =
+      std::bit_ceil(std::max({size, alignment, minBlockSize_}));
+  if (required > size_) {
+    return std::nullopt;
+  }
+  const auto level =
+      static_cast<uint32_t>(std::countr_zero(required / minBlockSize_));
+
+  uint32_t freeLevel = level;
+  while (freeLevel < freeBlocks_.size() && freeBlocks_[freeLevel].empty()) {
+    freeLevel++;
+  }
+  if (freeLevel == freeBlocks_.size()) {
+    return std::nullopt;
+  }
+
+  const size_t offset = *freeBlocks_[freeLevel].begin();
+  freeBlocks_[freeLevel].erase(freeBlocks_[freeLevel].begin());
+
+  // Split down to the requested size, keeping the lower half each time
+  while (freeLevel > level) {
+    freeLevel--;
+    freeBlocks_[freeLevel].insert(offset + blockSize(freeLevel));
+  }
+
+  allocated_.emplace(offset, level);
+  allocatedBytes_ += blockSize(level);
+  return offset;
+}
+
+void BuddyAllocator::free(size_t offset) {
+  auto it = allocated_.find(offset);
+  DEBUG_ASSERT(it != allocated_.end());
+  uint32_t level = it->second;
+  allocated_.erase(it);
+  allocatedBytes_ -= blockSize(level);
+
+  // Merge with the buddy for as long as it is also free
+  while (level + 1 < freeBlocks_.size()) {
+    const size_t buddy = offset ^ blockSize(level);
+    auto buddyIt = freeBlocks_[level].find(buddy);
+    if (buddyIt == freeBlocks_[level].end()) {
+      break;
+    }
+    freeBlocks_[level].erase(buddyIt);
+    offset = std::min(offset, buddy);
+    level++;
+  }
+
+  freeBlocks_[level].insert(offset);
+}
+
+} // namespace util
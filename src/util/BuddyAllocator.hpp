@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+
+// Hands out power-of-two sized, naturally aligned ranges of an abstract
+// address space. Backing memory is managed by the caller.
+class BuddyAllocator {
+ public:
+  BuddyAllocator(size_t size, size_t minBlockSize);
+
+  std::optional<size_t> allocate(size_t size, size_t alignment = 1);
+  void free(size_t offset);
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] size_t allocatedBytes() const { return allocatedBytes_; }
+  [[nodiscard]] size_t allocationCount() const { return allocated_.size(); }
+  [[nodiscard]] bool empty() const { return allocated_.empty(); }
+
+ private:
+  [[nodiscard]] size_t blockSize(uint32_t level) const {
+    return minBlockSize_ << level;
+  }
+
+  size_t size_;
+  size_t minBlockSize_;
+  // Free block offsets by level, level 0 being the smallest block size
+  std::vector<std::set<size_t>> freeBlocks_;
+  std::unordered_map<size_t, uint32_t> allocated_;
+  size_t allocatedBytes_ = 0;
+};
+
+} // namespace util
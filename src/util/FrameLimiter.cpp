@@ -0,0 +1,92 @@
+#include "util/FrameLimiter.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <ctime>
+#endif
+#include <chrono>
+#include <ratio>
+#include <stdexcept>
+
+namespace util {
+
+#ifdef _WIN32
+
+FrameLimiter::FrameLimiter(Clock::duration targetFrameTime)
+    : targetFrameTime_(targetFrameTime), nextFrame_(Clock::now()) {
+  // Plain waitable timers round up to the scheduler tick, the high resolution
+  // flag is only missing before Windows 10 1803
+  timer_ = CreateWaitableTimerExW(
+      nullptr,
+      nullptr,
+      CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+      TIMER_ALL_ACCESS);
+  if (timer_ == nullptr) {
+    timer_ = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+  }
+  if (timer_ == nullptr) {
+    throw std::runtime_error{"Failed to create frame timer"};
+  }
+}
+
+FrameLimiter::~FrameLimiter() {
+  CloseHandle(timer_);
+}
+
+void FrameLimiter::sleepUntil(Clock::time_point time) {
+  const auto remaining = std::chrono::duration_cast<
+      std::chrono::duration<LONGLONG, std::ratio<1, 10'000'000>>>(
+      time - Clock::now());
+  if (remaining.count() <= 0) {
+    return;
+  }
+
+  // Negative due times are relative, in 100ns units
+  LARGE_INTEGER dueTime{};
+  dueTime.QuadPart = -remaining.count();
+  if (SetWaitableTimer(timer_, &dueTime, 0, nullptr, nullptr, FALSE) == 0) {
+    throw std::runtime_error{"Failed to set frame timer"};
+  }
+  WaitForSingleObject(timer_, INFINITE);
+}
+
+#else
+
+FrameLimiter::FrameLimiter(Clock::duration targetFrameTime)
+    : targetFrameTime_(targetFrameTime), nextFrame_(Clock::now()) {}
+
+FrameLimiter::~FrameLimiter() = default;
+
+void FrameLimiter::sleepUntil(Clock::time_point time) {
+  const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      time - Clock::now());
+  if (remaining.count() <= 0) {
+    return;
+  }
+
+  // An absolute deadline, so being interrupted does not extend the sleep
+  timespec deadline{};
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  const long long nanoseconds = deadline.tv_nsec + remaining.count();
+  deadline.tv_sec += static_cast<time_t>(nanoseconds / 1'000'000'000);
+  deadline.tv_nsec = static_cast<long>(nanoseconds % 1'000'000'000);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) ==
+         EINTR) {
+  }
+}
+
+#endif
+
+void FrameLimiter::wait() {
+  sleepUntil(nextFrame_);
+
+  const Clock::time_point now = Clock::now();
+  nextFrame_ += targetFrameTime_;
+  if (nextFrame_ < now) {
+    nextFrame_ = now + targetFrameTime_;
+  }
+}
+
+} // namespace util
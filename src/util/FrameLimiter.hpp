@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+namespace util {
+
+// Paces a loop to a fixed period. The thread sleeps the whole wait on a high
+// resolution timer rather than spinning, so an idle frame costs no CPU.
+class FrameLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit FrameLimiter(Clock::duration targetFrameTime);
+  ~FrameLimiter();
+
+  FrameLimiter(const FrameLimiter& other) = delete;
+  FrameLimiter& operator=(const FrameLimiter& other) = delete;
+
+  FrameLimiter(FrameLimiter&& other) = delete;
+  FrameLimiter& operator=(FrameLimiter&& other) = delete;
+
+  // Returns at the start of the next frame period. If the caller has fallen
+  // more than a frame behind the schedule is reset, rather than running
+  // unlimited until it catches up.
+  void wait();
+
+ private:
+  void sleepUntil(Clock::time_point time);
+
+  Clock::duration targetFrameTime_;
+  Clock::time_point nextFrame_;
+  // Waitable timer handle, only used on Windows
+  void* timer_ = nullptr;
+};
+
+} // namespace util
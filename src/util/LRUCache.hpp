@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include "util/debug.hpp"
+
+namespace util {
+
+// Bounded map which evicts the least recently used entry once full. Lookups
+// may use any key type the hash and equality functions accept.
+template <
+    typename TKey,
+    typename TValue,
+    typename THash = std::hash<TKey>,
+    typename TKeyEqual = std::equal_to<TKey>>
+class LRUCache {
+ public:
+  explicit LRUCache(size_t capacity) : capacity_(capacity) {
+    DEBUG_ASSERT(capacity_ > 0);
+  }
+
+  LRUCache(const LRUCache& other) = delete;
+  LRUCache& operator=(const LRUCache& other) = delete;
+  LRUCache(LRUCache&& other) noexcept = default;
+  LRUCache& operator=(LRUCache&& other) noexcept = default;
+
+  ~LRUCache() = default;
+
+  // Marks the entry as most recently used
+  template <typename TLookup>
+  TValue* find(const TLookup& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  TValue& insert(TKey key, TValue value) {
+    if (auto it = index_.find(key); it != index_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->second;
+    }
+
+    if (entries_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+
+    entries_.emplace_front(std::move(key), std::move(value));
+    index_.emplace(entries_.front().first, entries_.begin());
+    return entries_.front().second;
+  }
+
+  void clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+  [[nodiscard]] size_t size() const { return entries_.size(); }
+  [[nodiscard]] size_t capacity() const { return capacity_; }
+
+ private:
+  using Entry = std::pair<TKey, TValue>;
+
+  size_t capacity_;
+  std::list<Entry> entries_;
+  std::unordered_map<
+      TKey,
+      typename std::list<Entry>::iterator,
+      THash,
+      TKeyEqual>
+      index_;
+};
+
+} // namespace util
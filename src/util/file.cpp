@@ -1,10 +1,19 @@
 #include "util/file.hpp"
 
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <ios>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace util {
@@ -46,4 +55,131 @@ std::vector<char> readFileChars(const std::filesystem::path& path) {
   return buffer;
 }
 
+#ifdef _WIN32
+
+MappedFile::MappedFile(
+    const std::filesystem::path& path, AccessPattern pattern) {
+  const HANDLE file = CreateFileW(
+      path.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      pattern == AccessPattern::SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN
+                                           : FILE_FLAG_RANDOM_ACCESS,
+      nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error{"Failed to open file"};
+  }
+
+  LARGE_INTEGER fileSize{};
+  if (GetFileSizeEx(file, &fileSize) == 0) {
+    CloseHandle(file);
+    throw std::runtime_error{"Failed to open file"};
+  }
+  size_ = static_cast<size_t>(fileSize.QuadPart);
+  // Empty files cannot be mapped
+  if (size_ == 0) {
+    CloseHandle(file);
+    return;
+  }
+
+  // The view keeps the mapping and file open
+  const HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    throw std::runtime_error{"Failed to map file"};
+  }
+  const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    throw std::runtime_error{"Failed to map file"};
+  }
+  data_ = static_cast<const std::byte*>(view);
+
+  advise(pattern);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+}
+
+void MappedFile::advise(AccessPattern pattern) const {
+  // Windows has no hint for random access beyond the file flag
+  if (data_ == nullptr || pattern != AccessPattern::SEQUENTIAL) {
+    return;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  WIN32_MEMORY_RANGE_ENTRY range{const_cast<std::byte*>(data_), size_};
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+#else
+
+MappedFile::MappedFile(
+    const std::filesystem::path& path, AccessPattern pattern) {
+  const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    throw std::runtime_error{"Failed to open file"};
+  }
+
+  struct stat fileStat {};
+  if (fstat(file, &fileStat) != 0) {
+    close(file);
+    throw std::runtime_error{"Failed to open file"};
+  }
+  size_ = static_cast<size_t>(fileStat.st_size);
+  // Empty files cannot be mapped
+  if (size_ == 0) {
+    close(file);
+    return;
+  }
+
+  // The mapping keeps the file open
+  void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error{"Failed to map file"};
+  }
+  data_ = static_cast<const std::byte*>(mapping);
+
+  advise(pattern);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    munmap(const_cast<std::byte*>(data_), size_);
+  }
+}
+
+void MappedFile::advise(AccessPattern pattern) const {
+  if (data_ == nullptr) {
+    return;
+  }
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+  auto* data = const_cast<std::byte*>(data_);
+  if (pattern == AccessPattern::SEQUENTIAL) {
+    madvise(data, size_, MADV_SEQUENTIAL);
+    madvise(data, size_, MADV_WILLNEED);
+  } else {
+    madvise(data, size_, MADV_RANDOM);
+  }
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
+
 } // namespace util
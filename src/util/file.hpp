@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <span>
 #include <vector>
 
 namespace util {
@@ -8,4 +11,34 @@ namespace util {
 std::vector<std::byte> readFileBytes(const std::filesystem::path& path);
 std::vector<char> readFileChars(const std::filesystem::path& path);
 
+// A read-only view of a whole file, paged in from the OS cache as it is
+// touched rather than copied up front. The view stays valid until the
+// MappedFile is destroyed, and moving it does not move the data.
+class MappedFile {
+ public:
+  // Passed to the OS as a read ahead hint
+  enum class AccessPattern : uint8_t { SEQUENTIAL, RANDOM };
+
+  explicit MappedFile(
+      const std::filesystem::path& path,
+      AccessPattern pattern = AccessPattern::SEQUENTIAL);
+  ~MappedFile();
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator=(const MappedFile& other) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  [[nodiscard]] std::span<const std::byte> bytes() const {
+    return {data_, size_};
+  }
+
+  void advise(AccessPattern pattern) const;
+
+ private:
+  const std::byte* data_ = nullptr;
+  size_t size_ = 0;
+};
+
 } // namespace util
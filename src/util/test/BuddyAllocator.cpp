@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+#include "util/BuddyAllocator.hpp"
+
+TEST(BuddyAllocator, RoundsUpToBlockSize) {
+  util::BuddyAllocator allocator{1024, 64};
+
+  const std::optional<size_t> a = allocator.allocate(10);
+  ASSERT_TRUE(a.has_value());
+  EXPECT_EQ(allocator.allocatedBytes(), 64);
+
+  const std::optional<size_t> b = allocator.allocate(100);
+  ASSERT_TRUE(b.has_value());
+  EXPECT_EQ(*b % 128, 0);
+  EXPECT_EQ(allocator.allocatedBytes(), 64 + 128);
+  EXPECT_EQ(allocator.allocationCount(), 2);
+}
+
+TEST(BuddyAllocator, RespectsAlignment) {
+  util::BuddyAllocator allocator{4096, 16};
+
+  ASSERT_TRUE(allocator.allocate(16).has_value());
+  const std::optional<size_t> aligned = allocator.allocate(16, 256);
+  ASSERT_TRUE(aligned.has_value());
+  EXPECT_EQ(*aligned % 256, 0);
+}
+
+TEST(BuddyAllocator, FillsAndReportsExhaustion) {
+  util::BuddyAllocator allocator{1024, 256};
+
+  std::vector<size_t> offsets;
+  for (int i = 0; i < 4; i++) {
+    const std::optional<size_t> offset = allocator.allocate(256);
+    ASSERT_TRUE(offset.has_value());
+    offsets.push_back(*offset);
+  }
+  EXPECT_EQ(allocator.allocate(1), std::nullopt);
+  EXPECT_EQ(allocator.allocate(2048), std::nullopt);
+
+  allocator.free(offsets[2]);
+  EXPECT_EQ(allocator.allocate(256), offsets[2]);
+}
+
+TEST(BuddyAllocator, MergesBuddiesOnFree) {
+  util::BuddyAllocator allocator{1024, 64};
+
+  std::vector<size_t> offsets;
+  for (int i = 0; i < 16; i++) {
+    const std::optional<size_t> offset = allocator.allocate(64);
+    ASSERT_TRUE(offset.has_value());
+    offsets.push_back(*offset);
+  }
+
+  for (const size_t offset : offsets) {
+    allocator.free(offset);
+  }
+  EXPECT_TRUE(allocator.empty());
+  EXPECT_EQ(allocator.allocatedBytes(), 0);
+
+  // Everything merged back into one block, so a full size allocation fits
+  EXPECT_EQ(allocator.allocate(1024), 0);
+}
+
+TEST(BuddyAllocator, RejectsInvalidSizes) {
+  EXPECT_THROW((util::BuddyAllocator{1000, 64}), std::runtime_error);
+  EXPECT_THROW((util::BuddyAllocator{1024, 48}), std::runtime_error);
+  EXPECT_THROW((util::BuddyAllocator{64, 128}), std::runtime_error);
+}
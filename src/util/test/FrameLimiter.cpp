@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include "util/FrameLimiter.hpp"
+
+using namespace std::chrono_literals;
+
+TEST(FrameLimiter, WaitsForTargetFrameTime) {
+  util::FrameLimiter limiter{5ms};
+  limiter.wait();
+
+  const auto start = util::FrameLimiter::Clock::now();
+  for (int i = 0; i < 10; i++) {
+    limiter.wait();
+  }
+  EXPECT_GE(util::FrameLimiter::Clock::now() - start, 45ms);
+}
+
+TEST(FrameLimiter, DoesNotWaitForTimeAlreadySpent) {
+  util::FrameLimiter limiter{20ms};
+  limiter.wait();
+
+  std::this_thread::sleep_for(15ms);
+  const auto start = util::FrameLimiter::Clock::now();
+  limiter.wait();
+  EXPECT_LT(util::FrameLimiter::Clock::now() - start, 15ms);
+}
+
+TEST(FrameLimiter, ResetsScheduleAfterFallingBehind) {
+  util::FrameLimiter limiter{5ms};
+  limiter.wait();
+
+  // Miss several frames, the next frame should not be returned immediately
+  // to catch up
+  std::this_thread::sleep_for(30ms);
+  limiter.wait();
+  const auto start = util::FrameLimiter::Clock::now();
+  limiter.wait();
+  EXPECT_GE(util::FrameLimiter::Clock::now() - start, 4ms);
+}
+
+TEST(FrameLimiter, SleepsRatherThanSpinning) {
+  util::FrameLimiter limiter{10ms};
+  limiter.wait();
+
+  const std::clock_t cpuStart = std::clock();
+  for (int i = 0; i < 10; i++) {
+    limiter.wait();
+  }
+  const double cpuSeconds =
+      static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+  EXPECT_LT(cpuSeconds, 0.005);
+}
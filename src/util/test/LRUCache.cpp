@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include "util/LRUCache.hpp"
+
+TEST(LRUCache, FindsInsertedValues) {
+  util::LRUCache<std::string, int> cache{4};
+  cache.insert("a", 1);
+  cache.insert("b", 2);
+
+  ASSERT_NE(cache.find(std::string{"a"}), nullptr);
+  EXPECT_EQ(*cache.find(std::string{"a"}), 1);
+  EXPECT_EQ(*cache.find(std::string{"b"}), 2);
+  EXPECT_EQ(cache.find(std::string{"c"}), nullptr);
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST(LRUCache, EvictsLeastRecentlyUsed) {
+  util::LRUCache<int, int> cache{2};
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+
+  // Touch 1 so 2 becomes the eviction candidate
+  EXPECT_NE(cache.find(1), nullptr);
+  cache.insert(3, 30);
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_NE(cache.find(1), nullptr);
+  EXPECT_EQ(cache.find(2), nullptr);
+  EXPECT_NE(cache.find(3), nullptr);
+}
+
+TEST(LRUCache, InsertReplacesExisting) {
+  util::LRUCache<int, int> cache{2};
+  cache.insert(1, 10);
+  cache.insert(2, 20);
+  cache.insert(1, 11);
+  cache.insert(3, 30);
+
+  EXPECT_EQ(*cache.find(1), 11);
+  EXPECT_EQ(cache.find(2), nullptr);
+}
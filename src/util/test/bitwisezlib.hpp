@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace util::test {
+
+// The decoder util::zlibDecompress replaced, which walks the Huffman tree a
+// bit at a time. Only kept as a baseline for the benchmark.
+std::vector<std::byte> bitwiseZlibDecompress(std::span<const std::byte> data);
+
+} // namespace util::test
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "util/file.hpp"
+
+namespace {
+
+std::filesystem::path writeTempFile(
+    const std::string& name, const std::string& contents) {
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() / name;
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  out << contents;
+  return path;
+}
+
+} // namespace
+
+TEST(MappedFileTest, MatchesReadFileBytes) {
+  std::string contents;
+  for (int i = 0; i < 10000; i++) {
+    contents += static_cast<char>(i * 7);
+  }
+  const auto path = writeTempFile("util_test_mapped_file.bin", contents);
+
+  util::MappedFile file{path};
+  const std::vector<std::byte> expected = util::readFileBytes(path);
+  ASSERT_EQ(expected.size(), file.bytes().size());
+  EXPECT_TRUE(std::equal(
+      expected.begin(), expected.end(), file.bytes().begin()));
+
+  // Moving keeps the view where it is
+  const auto* data = file.bytes().data();
+  util::MappedFile moved{std::move(file)};
+  EXPECT_EQ(data, moved.bytes().data());
+  moved.advise(util::MappedFile::AccessPattern::RANDOM);
+  EXPECT_EQ(static_cast<std::byte>(contents[9999]), moved.bytes()[9999]);
+}
+
+TEST(MappedFileTest, EmptyFile) {
+  const auto path = writeTempFile("util_test_mapped_file_empty.bin", "");
+  const util::MappedFile file{path};
+  EXPECT_TRUE(file.bytes().empty());
+}
+
+TEST(MappedFileTest, MissingFile) {
+  EXPECT_THROW(
+      util::MappedFile{
+          std::filesystem::temp_directory_path() / "util_test_missing.bin"},
+      std::runtime_error);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "util/Generator.hpp"
+#include "util/zlib.hpp"
+
+namespace {
+
+std::vector<std::byte> makeInput() {
+  std::string text;
+  for (int i = 0; text.size() < 4096; i++) {
+    text += "block " + std::to_string((i * i) % 97) +
+        ": the quick brown fox jumps over the lazy dog\n";
+  }
+  text.resize(4096);
+
+  std::vector<std::byte> result;
+  for (const char c : text) {
+    result.emplace_back(static_cast<std::byte>(c));
+  }
+  return result;
+}
+
+template <typename... TBytes>
+std::vector<std::byte> bytes(TBytes... values) {
+  return {static_cast<std::byte>(values)...};
+}
+
+// Compressed from makeInput() by zlib with the fixed code strategy
+const std::vector<std::byte> kFixedCodes = bytes(
+    0x78, 0x01, 0x4B, 0xCA, 0xC9, 0x4F, 0xCE, 0x56, 0x30, 0xB0, 0x52, 0x28,
+    0xC9, 0x48, 0x55, 0x28, 0x2C, 0xCD, 0x04, 0x72, 0x92, 0x8A, 0xF2, 0xCB,
+    0xF3, 0x14, 0xD2, 0xF2, 0x2B, 0x14, 0xB2, 0x4A, 0x73, 0x0B, 0x8A, 0x15,
+    0xF2, 0xCB, 0x52, 0x8B, 0xC0, 0xD2, 0x39, 0x89, 0x55, 0x95, 0x0A, 0x29,
+    0xF9, 0xE9, 0x5C, 0x49, 0x60, 0x4D, 0x86, 0xE4, 0x68, 0x32, 0x21, 0x47,
+    0x93, 0x25, 0x59, 0xCE, 0x33, 0x23, 0x47, 0x97, 0x91, 0x29, 0x39, 0xBA,
+    0x8C, 0xC9, 0xB2, 0xCB, 0x84, 0x2C, 0x7F, 0x99, 0x91, 0x15, 0x84, 0x16,
+    0x64, 0xC5, 0x96, 0x31, 0x59, 0x41, 0x48, 0x96, 0x03, 0x4D, 0xCC, 0xC9,
+    0xD1, 0x65, 0x6E, 0x44, 0x96, 0x0B, 0xC9, 0x0A, 0x0B, 0xB2, 0x42, 0xD0,
+    0x8C, 0x2C, 0xBB, 0x2C, 0xC9, 0x4B, 0x85, 0x64, 0x45, 0x97, 0x39, 0x79,
+    0x99, 0x9F, 0x2C, 0x7F, 0x99, 0x92, 0xE5, 0x42, 0x4B, 0xF2, 0x72, 0x17,
+    0x79, 0x45, 0x0D, 0x79, 0xA5, 0x1A, 0x79, 0xFE, 0x22, 0xCB, 0x85, 0xA6,
+    0x64, 0xC5, 0x97, 0x05, 0x59, 0x89, 0x97, 0xAC, 0x64, 0x68, 0x44, 0x56,
+    0x4E, 0xB6, 0x20, 0xCB, 0x85, 0xA6, 0x64, 0x05, 0xA1, 0x11, 0x59, 0x89,
+    0xD7, 0x82, 0xBC, 0xE2, 0x9A, 0xBC, 0x82, 0x97, 0xAC, 0x90, 0x37, 0x24,
+    0xCB, 0x2E, 0x0B, 0xB2, 0xB2, 0x97, 0x19, 0x79, 0x99, 0x92, 0xAC, 0x58,
+    0x36, 0x26, 0x2B, 0xBE, 0x0C, 0xC9, 0x4B, 0xF3, 0x64, 0xE5, 0x64, 0xB2,
+    0xF2, 0xBF, 0x05, 0x59, 0x91, 0x6C, 0x4E, 0x56, 0x32, 0x34, 0x27, 0xCF,
+    0x2E, 0x63, 0x3A, 0xEA, 0xA2, 0x63, 0x68, 0x90, 0x17, 0xF2, 0xE4, 0xC5,
+    0xB2, 0x19, 0xFD, 0xD2, 0x2E, 0x79, 0xF9, 0x84, 0xBC, 0x3C, 0x49, 0x5E,
+    0xFE, 0x27, 0xAF, 0xAC, 0x31, 0xA4, 0x63, 0x19, 0x4A, 0x5E, 0x79, 0x4D,
+    0x5E, 0xDD, 0x40, 0x5E, 0x3D, 0x44, 0x5E, 0x9D, 0x47, 0x5E, 0xFD, 0x4A,
+    0x5E, 0x5D, 0x4E, 0x5E, 0xBB, 0xC1, 0x82, 0x7E, 0xAD, 0x21, 0xF2, 0x5A,
+    0x5E, 0x64, 0xB6, 0xF2, 0x0C, 0xE9, 0xD8, 0x7A, 0x25, 0x39, 0x7B, 0x01,
+    0x00, 0x32, 0x25, 0x9E, 0xCC);
+
+// Compressed from makeInput() by zlib at level 9
+const std::vector<std::byte> kDynamicCodes = bytes(
+    0x78, 0xDA, 0xBD, 0xD6, 0x5B, 0x52, 0x02, 0x31, 0x10, 0x05, 0xD0, 0x7F,
+    0x57, 0x91, 0x25, 0x98, 0x79, 0x24, 0x19, 0x76, 0xE3, 0x20, 0xA8, 0x88,
+    0x06, 0x79, 0x09, 0xAC, 0x1E, 0x8B, 0x1D, 0x78, 0x3E, 0xF2, 0x39, 0x35,
+    0x75, 0xAB, 0x3B, 0xF7, 0xD1, 0xDD, 0xF3, 0xB6, 0x2E, 0x3F, 0xC3, 0xF3,
+    0x22, 0x1C, 0xDF, 0x57, 0xE1, 0xE7, 0xF4, 0xF1, 0xF7, 0x31, 0xEF, 0xEB,
+    0xEF, 0x77, 0x58, 0xD7, 0x4B, 0xD8, 0x9C, 0xBE, 0x76, 0x87, 0x50, 0xCF,
+    0xAB, 0xFD, 0xE3, 0xF7, 0xF6, 0xE5, 0x76, 0x0D, 0xAF, 0xF5, 0xED, 0x69,
+    0x7E, 0x80, 0xA2, 0x80, 0x06, 0x01, 0x4D, 0xD4, 0x5E, 0x12, 0x54, 0x37,
+    0x0A, 0xAA, 0xA7, 0x5A, 0x03, 0xBD, 0x2B, 0x11, 0x85, 0x85, 0xD4, 0xEA,
+    0x89, 0x42, 0x6A, 0x70, 0xC8, 0x82, 0xCA, 0x1D, 0x75, 0x48, 0x5C, 0x10,
+    0x83, 0x89, 0x6A, 0x4D, 0xE6, 0x42, 0x92, 0x2B, 0x5B, 0xF8, 0xE9, 0x5D,
+    0x23, 0x75, 0x38, 0x59, 0xBA, 0x6C, 0xD4, 0xD8, 0x54, 0xB3, 0x77, 0x51,
+    0x87, 0x23, 0xE9, 0x55, 0xC8, 0xBC, 0x64, 0xC3, 0x8E, 0x92, 0x5C, 0xA8,
+    0xC3, 0x91, 0x28, 0xEC, 0xC8, 0xBC, 0xC5, 0xC6, 0xB5, 0x0D, 0x5E, 0x62,
+    0x3E, 0x52, 0xAD, 0x42, 0xF1, 0x4A, 0x16, 0x4A, 0x52, 0xB9, 0x27, 0xBD,
+    0xA2, 0x79, 0x9E, 0x92, 0x4C, 0xF9, 0x2F, 0x24, 0x72, 0x26, 0x1B, 0x66,
+    0xAB, 0xD5, 0x37, 0x44, 0x35, 0x64, 0xC3, 0x98, 0x37, 0x95, 0x53, 0x3B,
+    0xEF, 0x5A, 0x4E, 0x2C, 0x93, 0x96, 0x7F, 0x9B, 0x35, 0xB1, 0xE1, 0x0C,
+    0xB5, 0x79, 0x6D, 0xBB, 0xC1, 0xF6, 0x90, 0xED, 0x3C, 0xDB, 0xAF, 0xB6,
+    0xCB, 0xED, 0x6E, 0x28, 0xED, 0xAE, 0x21, 0xBB, 0xBC, 0xF0, 0xCA, 0x8B,
+    0x0D, 0xAF, 0xD7, 0x7F, 0xC7, 0xEB, 0x0E, 0x32, 0x25, 0x9E, 0xCC);
+
+std::vector<std::byte> makeStored(const std::vector<std::byte>& data) {
+  std::vector<std::byte> result = bytes(0x78, 0x01);
+  size_t offset = 0;
+  do {
+    const size_t length = std::min<size_t>(data.size() - offset, 1000);
+    const bool isFinal = offset + length == data.size();
+    result.emplace_back(static_cast<std::byte>(isFinal ? 1 : 0));
+    const auto lengthBytes = bytes(
+        length & 0xFF, length >> 8, ~length & 0xFF, (~length >> 8) & 0xFF);
+    result.insert(result.end(), lengthBytes.begin(), lengthBytes.end());
+    result.insert(
+        result.end(), data.begin() + offset, data.begin() + offset + length);
+    offset += length;
+  } while (offset < data.size());
+  return result;
+}
+
+// Uneven chunks, including empty ones, so codes straddle the boundaries
+util::Generator<std::span<const std::byte>> splitChunks(
+    std::span<const std::byte> data) {
+  size_t chunkSize = 0;
+  while (!data.empty()) {
+    const size_t size = std::min(chunkSize, data.size());
+    co_yield data.first(size);
+    data = data.subspan(size);
+    chunkSize = (chunkSize * 3 + 1) % 37;
+  }
+}
+
+std::vector<std::byte> decompressChunked(std::span<const std::byte> data) {
+  util::Generator<std::span<const std::byte>> chunks = splitChunks(data);
+  std::vector<std::byte> result(makeInput().size());
+  EXPECT_EQ(result.size(), util::zlibDecompress(chunks, result));
+  return result;
+}
+
+} // namespace
+
+TEST(ZlibTest, FixedCodes) {
+  EXPECT_EQ(makeInput(), util::zlibDecompress(kFixedCodes));
+}
+
+TEST(ZlibTest, DynamicCodes) {
+  EXPECT_EQ(makeInput(), util::zlibDecompress(kDynamicCodes));
+}
+
+TEST(ZlibTest, StoredBlocks) {
+  const auto input = makeInput();
+  EXPECT_EQ(input, util::zlibDecompress(makeStored(input)));
+}
+
+TEST(ZlibTest, Truncated) {
+  const std::vector<std::byte> truncated{
+      kDynamicCodes.begin(), kDynamicCodes.begin() + 100};
+  EXPECT_THROW(util::zlibDecompress(truncated), std::runtime_error);
+}
+
+TEST(ZlibTest, CorruptStoredLength) {
+  auto stored = makeStored(makeInput());
+  stored[5] ^= std::byte{1};
+  EXPECT_THROW(util::zlibDecompress(stored), std::runtime_error);
+}
+
+TEST(ZlibTest, ChunkedDynamicCodes) {
+  EXPECT_EQ(makeInput(), decompressChunked(kDynamicCodes));
+}
+
+TEST(ZlibTest, ChunkedStoredBlocks) {
+  const auto input = makeInput();
+  EXPECT_EQ(input, decompressChunked(makeStored(input)));
+}
+
+TEST(ZlibTest, OutputTooSmall) {
+  util::Generator<std::span<const std::byte>> chunks =
+      splitChunks(kDynamicCodes);
+  std::vector<std::byte> output(makeInput().size() - 1);
+  EXPECT_THROW(util::zlibDecompress(chunks, output), std::runtime_error);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "util/Generator.hpp"
+#include "util/file.hpp"
+#include "util/test/bitwisezlib.hpp"
+#include "util/zlib.hpp"
+
+namespace {
+
+constexpr int kIterations = 20;
+
+uint32_t readBigEndian32(std::span<const std::byte> data) {
+  return (static_cast<uint32_t>(data[0]) << 24) |
+      (static_cast<uint32_t>(data[1]) << 16) |
+      (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+// The IDAT chunks, which together hold the zlib stream of the image data
+std::vector<std::span<const std::byte>> readIdatChunks(
+    std::span<const std::byte> png) {
+  constexpr uint32_t kIdatTag = 0x49444154;
+
+  std::vector<std::span<const std::byte>> result;
+  size_t offset = 8;
+  while (offset + 12 <= png.size()) {
+    const uint32_t length = readBigEndian32(png.subspan(offset));
+    const uint32_t tag = readBigEndian32(png.subspan(offset + 4));
+    if (offset + 12 + length > png.size()) {
+      throw std::runtime_error{"Corrupt png file"};
+    }
+    if (tag == kIdatTag) {
+      result.emplace_back(png.subspan(offset + 8, length));
+    }
+    offset += 12 + length;
+  }
+  return result;
+}
+
+std::vector<std::byte> concatenate(
+    std::span<const std::span<const std::byte>> chunks) {
+  std::vector<std::byte> result;
+  for (const auto& chunk : chunks) {
+    result.insert(result.end(), chunk.begin(), chunk.end());
+  }
+  return result;
+}
+
+util::Generator<std::span<const std::byte>> generateChunks(
+    std::span<const std::span<const std::byte>> chunks) {
+  for (const auto& chunk : chunks) {
+    co_yield chunk;
+  }
+}
+
+void printThroughput(
+    size_t inputSize,
+    size_t outputSize,
+    std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const double megabytes =
+      static_cast<double>(outputSize) * kIterations / (1024.0 * 1024.0);
+  std::cout << "compressed: " << inputSize << " bytes\n"
+            << "decompressed: " << outputSize << " bytes\n"
+            << "throughput: " << megabytes / elapsed.count()
+            << " MB/s of output\n";
+}
+
+} // namespace
+
+TEST(ZlibBenchmark, PngIdat) {
+  const std::vector<std::byte> png =
+      util::readFileBytes(RESOURCE_DIR "/mandelbrot set.png");
+  const auto chunks = readIdatChunks(png);
+  ASSERT_FALSE(chunks.empty());
+
+  const auto start = std::chrono::steady_clock::now();
+  size_t outputSize = 0;
+  for (int i = 0; i < kIterations; i++) {
+    // Includes gathering the chunks, as a loader would have to
+    outputSize = util::zlibDecompress(concatenate(chunks)).size();
+  }
+  printThroughput(png.size(), outputSize, start);
+}
+
+// The decoder before table driven Huffman decoding, for comparison with PngIdat
+TEST(ZlibBenchmark, PngIdatBitwiseBaseline) {
+  const std::vector<std::byte> png =
+      util::readFileBytes(RESOURCE_DIR "/mandelbrot set.png");
+  const auto chunks = readIdatChunks(png);
+  ASSERT_FALSE(chunks.empty());
+
+  const auto start = std::chrono::steady_clock::now();
+  size_t outputSize = 0;
+  for (int i = 0; i < kIterations; i++) {
+    outputSize = util::test::bitwiseZlibDecompress(concatenate(chunks)).size();
+  }
+  printThroughput(png.size(), outputSize, start);
+
+  EXPECT_EQ(
+      util::zlibDecompress(concatenate(chunks)),
+      util::test::bitwiseZlibDecompress(concatenate(chunks)));
+}
+
+TEST(ZlibBenchmark, PngIdatStreaming) {
+  const std::vector<std::byte> png =
+      util::readFileBytes(RESOURCE_DIR "/mandelbrot set.png");
+  const auto chunks = readIdatChunks(png);
+  ASSERT_FALSE(chunks.empty());
+
+  // A loader knows this from the image header
+  const size_t outputSize = util::zlibDecompress(concatenate(chunks)).size();
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; i++) {
+    std::vector<std::byte> output(outputSize);
+    util::Generator<std::span<const std::byte>> input = generateChunks(chunks);
+    ASSERT_EQ(outputSize, util::zlibDecompress(input, output));
+  }
+  printThroughput(png.size(), outputSize, start);
+}
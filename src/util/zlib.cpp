@@ -4,110 +4,184 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
-#include <limits>
+#include <cstring>
 #include <span>
 #include <stdexcept>
 #include <type_traits>
 #include <vector>
+#include "util/Generator.hpp"
 #include "util/debug.hpp"
 
 namespace util {
 
 namespace {
 
-class BitStream {
- public:
-  explicit BitStream(std::span<const std::byte> data) : data_(data) {}
+uint64_t loadLittleEndian64(const std::byte* data) {
+  uint64_t result = 0;
+  for (unsigned int i = 0; i < 8; i++) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    result |= static_cast<uint64_t>(data[i]) << (8 * i);
+  }
+  return result;
+}
 
-  [[nodiscard]] uint64_t peekBits(unsigned int bitCount) const {
-    if (bitCount == 0) {
-      return 0;
+// Decompressed bytes written either into a fixed buffer or a vector that grows
+// as needed. Back references read from the buffer itself, so it doubles as the
+// sliding window.
+class OutputBuffer {
+ public:
+  explicit OutputBuffer(std::span<std::byte> buffer) : buffer_(buffer) {}
+  explicit OutputBuffer(std::vector<std::byte>& growable)
+      : buffer_(growable), growable_(&growable) {}
+
+  // Returns space for count more bytes, only valid until the next call
+  [[nodiscard]] std::byte* extend(size_t count) {
+    if (count > buffer_.size() - size_) {
+      grow(size_ + count);
     }
-    DEBUG_ASSERT(bitCount <= 64);
+    std::byte* result = &buffer_[size_];
+    size_ += count;
+    return result;
+  }
 
-    const unsigned int maxDataOffset = (byteOffset_ + bitCount - 1) / 8;
-    if (maxDataOffset >= data_.size()) {
-      throw std::runtime_error{"Out-of-bounds bitstream read"};
-    }
+  [[nodiscard]] std::byte* data() { return buffer_.data(); }
+  [[nodiscard]] size_t size() const { return size_; }
 
-    unsigned int shift = 0;
-    uint64_t result = 0;
-    size_t dataOffset = 0;
-    unsigned int curByteOffset = byteOffset_;
-
-    while (bitCount > 0) {
-      const unsigned int curBitCount = std::min(8 - curByteOffset, bitCount);
-      const uint8_t mask = 0xFFull >> (8 - curBitCount - curByteOffset);
-      const uint64_t curParts =
-          static_cast<uint64_t>(
-              mask & static_cast<uint8_t>(data_[dataOffset])) >>
-          curByteOffset;
-
-      result |= curParts << shift;
-
-      shift += curBitCount;
-      bitCount -= curBitCount;
-      dataOffset++;
-      curByteOffset = 0;
+ private:
+  void grow(size_t minSize) {
+    if (growable_ == nullptr) {
+      throw std::runtime_error{"zlib output exceeds buffer"};
     }
+    growable_->resize(std::max(minSize, growable_->size() * 2));
+    buffer_ = *growable_;
+  }
 
-    DEBUG_ASSERT(bitCount == 0 || dataOffset - 1 == maxDataOffset);
+  std::span<std::byte> buffer_;
+  std::vector<std::byte>* growable_ = nullptr;
+  size_t size_ = 0;
+};
 
-    return result;
+// Reads bits least significant first through a 64 bit buffer, refilled a word
+// at a time while there is enough input left. Input may be split into several
+// chunks, which are pulled from a generator as the current one runs out.
+class BitStream {
+ public:
+  explicit BitStream(std::span<const std::byte> data) : data_(data) {}
+  explicit BitStream(Generator<std::span<const std::byte>>& chunks)
+      : chunks_(&chunks) {}
+
+  // Bits past the end of the data read as zero, consumeBits catches any
+  // attempt to actually use them
+  [[nodiscard]] uint64_t peekBits(unsigned int bitCount) {
+    DEBUG_ASSERT(bitCount <= kMaxPeekBits);
+    if (bitCount_ < bitCount) {
+      refill();
+    }
+    return bitBuffer_ & ((1ull << bitCount) - 1);
   }
 
-  uint64_t consumeBits(int bitCount) {
+  uint64_t consumeBits(unsigned int bitCount) {
     const uint64_t result = peekBits(bitCount);
+    if (bitCount_ < bitCount) {
+      throw std::runtime_error{"Out-of-bounds bitstream read"};
+    }
+    bitBuffer_ >>= bitCount;
+    bitCount_ -= bitCount;
+    return result;
+  }
 
-    byteOffset_ += bitCount;
-    data_ = data_.subspan(byteOffset_ / 8);
-    byteOffset_ %= 8;
+  void byteAlign() { consumeBits(bitCount_ % 8); }
 
-    return result;
+  // Must be byte aligned
+  void copyBytes(size_t count, OutputBuffer& out) {
+    DEBUG_ASSERT(bitCount_ % 8 == 0);
+    while (count > 0 && bitCount_ > 0) {
+      *out.extend(1) = static_cast<std::byte>(consumeBits(8));
+      count--;
+    }
+    while (count > 0) {
+      if (data_.empty() && !nextChunk()) {
+        throw std::runtime_error{"Out-of-bounds bitstream read"};
+      }
+      const size_t chunkCount = std::min(count, data_.size());
+      std::memcpy(out.extend(chunkCount), data_.data(), chunkCount);
+      data_ = data_.subspan(chunkCount);
+      count -= chunkCount;
+      // Whatever was left over from the last word refill is now stale
+      bitBuffer_ = 0;
+    }
   }
 
-  bool consumeBit() {
-    if (data_.empty()) {
-      throw std::runtime_error{"Out-of-bounds bitstream read"};
+  static constexpr unsigned int kMaxPeekBits = 32;
+
+ private:
+  void refill() {
+    if (data_.size() >= 8) {
+      bitBuffer_ |= loadLittleEndian64(data_.data()) << bitCount_;
+      // Only whole bytes are counted, the bits of the next byte loaded past
+      // them are reloaded by the following refill
+      const unsigned int byteCount = (63 - bitCount_) / 8;
+      data_ = data_.subspan(byteCount);
+      bitCount_ += byteCount * 8;
+    } else {
+      while (bitCount_ <= 56) {
+        if (data_.empty() && !nextChunk()) {
+          return;
+        }
+        bitBuffer_ |= static_cast<uint64_t>(data_[0]) << bitCount_;
+        data_ = data_.subspan(1);
+        bitCount_ += 8;
+      }
     }
-    const bool result =
-        ((static_cast<uint32_t>(data_[0]) >> byteOffset_) & 0b1ull) > 0;
-    byteOffset_ += 1;
-    data_ = data_.subspan(byteOffset_ / 8);
-    byteOffset_ %= 8;
-    return result;
   }
 
-  void byteAlign() {
-    if (byteOffset_ != 0) {
-      data_ = data_.subspan(1);
-      byteOffset_ = 0;
+  bool nextChunk() {
+    while (chunks_ != nullptr && *chunks_) {
+      data_ = (*chunks_)();
+      if (!data_.empty()) {
+        return true;
+      }
     }
+    return false;
   }
 
- private:
   std::span<const std::byte> data_;
-  unsigned int byteOffset_ = 0;
+  Generator<std::span<const std::byte>>* chunks_ = nullptr;
+  uint64_t bitBuffer_ = 0;
+  unsigned int bitCount_ = 0;
 };
 
 constexpr size_t kMaxHuffmanCodeLength = 15;
+constexpr unsigned int kPrimaryTableBits = 10;
+
+uint32_t reverseBits(uint32_t value, unsigned int bitCount) {
+  uint32_t result = 0;
+  for (unsigned int i = 0; i < bitCount; i++) {
+    result = (result << 1u) | ((value >> i) & 0b1u);
+  }
+  return result;
+}
 
-class HuffmanTree {
+// Decodes a whole symbol per lookup. Deflate packs codes starting from their
+// most significant bit, so tables are indexed by the bit reversed code. Codes
+// longer than the primary table continue in a secondary table indexed by the
+// remaining bits.
+class HuffmanTable {
  private:
-  struct Node {
-    bool isLeaf = false;
-    short leafValueIndex = std::numeric_limits<short>::max();
-    short l = std::numeric_limits<short>::max();
-    short r = std::numeric_limits<short>::max();
+  struct Entry {
+    // The symbol, or for links the offset of the secondary table
+    uint16_t value = 0;
+    // Zero for bit patterns that are not a valid code
+    uint8_t length = 0;
+    // Nonzero for links to a secondary table
+    uint8_t subtableBits = 0;
   };
 
  public:
   template <typename TIntegral>
-  explicit HuffmanTree(std::span<const TIntegral> codeLengths)
+  explicit HuffmanTable(std::span<const TIntegral> codeLengths)
     requires(std::is_integral_v<TIntegral>)
   {
-    nodes_.reserve((2 * codeLengths.size()) - 1);
-
 #ifndef NDEBUG
     for (const auto& l : codeLengths) {
       DEBUG_ASSERT(l <= kMaxHuffmanCodeLength);
@@ -115,9 +189,11 @@ class HuffmanTree {
 #endif
 
     std::array<unsigned int, kMaxHuffmanCodeLength + 1> blCount{};
+    unsigned int maxLength = 0;
     for (const auto& l : codeLengths) {
       if (l > 0) {
         blCount[l]++;
+        maxLength = std::max(maxLength, static_cast<unsigned int>(l));
       }
     }
 
@@ -131,54 +207,66 @@ class HuffmanTree {
       }
     }
 
-    nodes_.emplace_back();
+    primaryBits_ = std::clamp(maxLength, 1u, kPrimaryTableBits);
+    const unsigned int subtableBits =
+        maxLength > primaryBits_ ? maxLength - primaryBits_ : 0;
+    entries_.resize(1ull << primaryBits_);
+
     for (size_t i = 0; i < codeLengths.size(); i++) {
-      const size_t len = codeLengths[i];
-      const size_t c = nextCode[len];
+      const auto len = static_cast<unsigned int>(codeLengths[i]);
+      if (len == 0) {
+        continue;
+      }
+      const uint32_t reversed =
+          reverseBits(static_cast<uint32_t>(nextCode[len]), len);
       nextCode[len]++;
-
-      if (len != 0) {
-        Node* curNode = &nodes_[0];
-        for (int j = static_cast<int>(len) - 1; j >= 0; j--) {
-          const bool isRight =
-              ((c >> static_cast<unsigned int>(j)) & 0b1ull) > 0;
-          short& nextNodeIndexRef = isRight ? curNode->r : curNode->l;
-          short nextNodeIndex = nextNodeIndexRef;
-          if (nextNodeIndexRef == std::numeric_limits<short>::max()) {
-            DEBUG_ASSERT(!curNode->isLeaf);
-            nextNodeIndexRef = static_cast<short>(nodes_.size());
-            nextNodeIndex = nextNodeIndexRef;
-            nodes_.emplace_back();
-          }
-          curNode = &nodes_[nextNodeIndex];
+      const Entry entry{
+          .value = static_cast<uint16_t>(i),
+          .length = static_cast<uint8_t>(len),
+          .subtableBits = 0};
+
+      if (len <= primaryBits_) {
+        for (uint32_t j = reversed; j < (1u << primaryBits_); j += 1u << len) {
+          entries_[j] = entry;
         }
-        DEBUG_ASSERT(!curNode->isLeaf);
-        DEBUG_ASSERT(curNode->l == std::numeric_limits<short>::max());
-        DEBUG_ASSERT(curNode->r == std::numeric_limits<short>::max());
-        curNode->isLeaf = true;
-        curNode->leafValueIndex = static_cast<short>(i);
+        continue;
       }
-    }
-  }
-
-  short lookup(BitStream& stream) const {
-    DEBUG_ASSERT(nodes_.size() > 0);
-    const Node* curNode = &nodes_[0];
 
-    while (!curNode->isLeaf) {
-      const bool rightNext = stream.consumeBit();
-      const short nextNodeIndex = rightNext ? curNode->r : curNode->l;
-      if (nextNodeIndex == std::numeric_limits<short>::max()) {
-        throw std::runtime_error{"Corrupt zlib data"};
+      const uint32_t prefix = reversed & ((1u << primaryBits_) - 1);
+      if (entries_[prefix].subtableBits == 0) {
+        entries_[prefix] = Entry{
+            .value = static_cast<uint16_t>(entries_.size()),
+            .length = 0,
+            .subtableBits = static_cast<uint8_t>(subtableBits)};
+        entries_.resize(entries_.size() + (1ull << subtableBits));
+      }
+      const size_t subtable = entries_[prefix].value;
+      const unsigned int remainingLength = len - primaryBits_;
+      for (uint32_t j = reversed >> primaryBits_; j < (1u << subtableBits);
+           j += 1u << remainingLength) {
+        entries_[subtable + j] = entry;
       }
-      curNode = &nodes_[nextNodeIndex];
     }
+  }
 
-    return curNode->leafValueIndex;
+  uint16_t lookup(BitStream& stream) const {
+    const uint64_t bits = stream.peekBits(kMaxHuffmanCodeLength);
+    Entry entry = entries_[bits & ((1ull << primaryBits_) - 1)];
+    if (entry.subtableBits != 0) {
+      entry = entries_
+          [entry.value +
+           ((bits >> primaryBits_) & ((1ull << entry.subtableBits) - 1))];
+    }
+    if (entry.length == 0) {
+      throw std::runtime_error{"Corrupt zlib data"};
+    }
+    stream.consumeBits(entry.length);
+    return entry.value;
   }
 
  private:
-  std::vector<Node> nodes_;
+  std::vector<Entry> entries_;
+  unsigned int primaryBits_ = 1;
 };
 
 struct ExtraBitCode {
@@ -204,15 +292,15 @@ constexpr std::array<ExtraBitCode, 30> kDistanceCodes{
      {9, 1025},  {9, 1537},  {10, 2049},  {10, 3073},  {11, 4097},
      {11, 6145}, {12, 8193}, {12, 12289}, {13, 16385}, {13, 24577}}};
 
-struct CompressedBlockTrees {
-  HuffmanTree literalHuffmanEncoding;
-  HuffmanTree distanceHuffmanEncoding;
+struct CompressedBlockTables {
+  HuffmanTable literalTable;
+  HuffmanTable distanceTable;
 };
 
 // TODO: constexpr initialise this
 // NOLINTNEXTLINE(cert-err58-cpp)
-const CompressedBlockTrees fixedTrees = {
-    .literalHuffmanEncoding =
+const CompressedBlockTables fixedTables = {
+    .literalTable =
         []() {
           std::array<short, 288> lengths{};
           for (int i = 0; i <= 143; i++) {
@@ -227,15 +315,15 @@ const CompressedBlockTrees fixedTrees = {
           for (int i = 280; i <= 287; i++) {
             lengths[i] = 8;
           }
-          return HuffmanTree{std::span<const short>{lengths}};
+          return HuffmanTable{std::span<const short>{lengths}};
         }(),
-    .distanceHuffmanEncoding =
+    .distanceTable =
         []() {
           std::array<short, 32> lengths{};
           for (int i = 0; i < 32; i++) {
             lengths[i] = 5;
           }
-          return HuffmanTree{std::span<const short>{lengths}};
+          return HuffmanTable{std::span<const short>{lengths}};
         }()};
 
 struct ZlibHeader {
@@ -289,7 +377,7 @@ constexpr int kMaxLengthCodeCount = 4 + 0b1111;
 constexpr std::array<short, 19> kCodeLengthAlphabet{
     16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
 
-CompressedBlockTrees readDynamicCodesBlockHeader(BitStream& stream) {
+CompressedBlockTables readDynamicCodesBlockHeader(BitStream& stream) {
   const auto literalCodeCount = static_cast<short>(257 + stream.consumeBits(5));
   if (literalCodeCount > kMaxLiteralCount) {
     throw std::runtime_error{"Corrupt zlib data"};
@@ -309,7 +397,7 @@ CompressedBlockTrees readDynamicCodesBlockHeader(BitStream& stream) {
         static_cast<short>(stream.consumeBits(3));
   }
 
-  const HuffmanTree huffmanCodeLengths(
+  const HuffmanTable huffmanCodeLengths(
       std::span<const short>(lengthCodeLengths.begin(), kMaxLengthCodeCount));
 
   std::array<short, kMaxLiteralCount + kMaxDistanceCodeCount>
@@ -318,7 +406,8 @@ CompressedBlockTrees readDynamicCodesBlockHeader(BitStream& stream) {
   const int codeLengthCount = literalCodeCount + distanceCodeCount;
   short prevCode = -1;
   for (int i = 0; i < codeLengthCount; i++) {
-    const short alphabetSymbol = huffmanCodeLengths.lookup(stream);
+    const auto alphabetSymbol =
+        static_cast<short>(huffmanCodeLengths.lookup(stream));
     if (0 <= alphabetSymbol && alphabetSymbol <= 15) {
       literalCodeLengths[i] = alphabetSymbol;
       prevCode = alphabetSymbol;
@@ -353,30 +442,46 @@ CompressedBlockTrees readDynamicCodesBlockHeader(BitStream& stream) {
   }
 
   return {
-      .literalHuffmanEncoding = HuffmanTree(
+      .literalTable = HuffmanTable(
           std::span<const short>(literalCodeLengths.begin(), literalCodeCount)),
-      .distanceHuffmanEncoding = HuffmanTree(
+      .distanceTable = HuffmanTable(
           std::span<const short>(
               literalCodeLengths.begin() + literalCodeCount,
               distanceCodeCount))};
 }
 
+void copyStoredBlock(BitStream& stream, OutputBuffer& out) {
+  stream.byteAlign();
+  const auto length = static_cast<uint16_t>(stream.consumeBits(16));
+  const auto lengthComplement = static_cast<uint16_t>(stream.consumeBits(16));
+  if (static_cast<uint16_t>(~length) != lengthComplement) {
+    throw std::runtime_error{"Corrupt zlib data"};
+  }
+  stream.copyBytes(length, out);
+}
+
 void decodeBlock(
-    const CompressedBlockTrees& trees,
+    const CompressedBlockTables& tables,
     BitStream& stream,
-    std::vector<std::byte>& out) {
+    OutputBuffer& out) {
   while (true) {
-    const short symbol = trees.literalHuffmanEncoding.lookup(stream);
+    const uint16_t symbol = tables.literalTable.lookup(stream);
     if (symbol < 256) {
-      out.emplace_back(static_cast<std::byte>(symbol));
+      *out.extend(1) = static_cast<std::byte>(symbol);
     } else if (symbol == 256) {
       break;
-    } else if (symbol > 256) {
+    } else {
+      if (symbol - 257u >= kLengthCodes.size()) {
+        throw std::runtime_error{"Corrupt zlib data"};
+      }
       const ExtraBitCode lengthCode = kLengthCodes[symbol - 257];
       const unsigned short length = lengthCode.offset +
           static_cast<unsigned short>(stream.consumeBits(lengthCode.extraBits));
-      const ExtraBitCode distanceCode =
-          kDistanceCodes[trees.distanceHuffmanEncoding.lookup(stream)];
+      const uint16_t distanceSymbol = tables.distanceTable.lookup(stream);
+      if (distanceSymbol >= kDistanceCodes.size()) {
+        throw std::runtime_error{"Corrupt zlib data"};
+      }
+      const ExtraBitCode distanceCode = kDistanceCodes[distanceSymbol];
       const unsigned short distance = distanceCode.offset +
           static_cast<unsigned short>(stream.consumeBits(
               distanceCode.extraBits));
@@ -384,42 +489,43 @@ void decodeBlock(
       if (distance > out.size()) {
         throw std::runtime_error{"Corrupt zlib data"};
       }
-      const size_t readCursor = out.size() - distance;
-      for (unsigned int i = 0; i < length; i++) {
-        out.emplace_back(out[readCursor + i]);
+      std::byte* dst = out.extend(length);
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      const std::byte* src = dst - distance;
+      if (distance >= length) {
+        std::memcpy(dst, src, length);
+      } else {
+        // Overlapping copies repeat the last distance bytes
+        for (unsigned int i = 0; i < length; i++) {
+          // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          dst[i] = src[i];
+        }
       }
     }
   }
 }
 
-} // namespace
-
-std::vector<std::byte> zlibDecompress(std::span<const std::byte> data) {
-  if (data.size() < 2) {
-    throw std::runtime_error{"Corrupt zlib data"};
-  }
-  readZlibHeader(data[0], data[1]);
-
-  data = data.subspan(2);
-  BitStream stream(data);
-
-  std::vector<std::byte> result;
+void inflate(BitStream& stream, OutputBuffer& out) {
+  const auto compressionByte = static_cast<std::byte>(stream.consumeBits(8));
+  const auto additionalFlags = static_cast<std::byte>(stream.consumeBits(8));
+  readZlibHeader(compressionByte, additionalFlags);
 
   while (true) {
     const BlockHeader blockHead = readBlockHeader(stream);
 
     switch (blockHead.type) {
       case BlockHeader::BlockType::NO_COMPRESSION:
-        throw std::runtime_error{"Unsupported zlib format"};
+        copyStoredBlock(stream, out);
+        break;
 
       case BlockHeader::BlockType::FIXED_CODES:
-        decodeBlock(fixedTrees, stream, result);
+        decodeBlock(fixedTables, stream, out);
         break;
 
       case BlockHeader::BlockType::DYNAMIC_CODES:
-        const CompressedBlockTrees dcHeader =
+        const CompressedBlockTables dcHeader =
             readDynamicCodesBlockHeader(stream);
-        decodeBlock(dcHeader, stream, result);
+        decodeBlock(dcHeader, stream, out);
         break;
     }
 
@@ -427,8 +533,28 @@ std::vector<std::byte> zlibDecompress(std::span<const std::byte> data) {
       break;
     }
   }
+}
+
+} // namespace
 
+std::vector<std::byte> zlibDecompress(std::span<const std::byte> data) {
+  BitStream stream(data);
+
+  // Image data usually compresses a few times over
+  std::vector<std::byte> result(data.size() * 4);
+  OutputBuffer out{result};
+  inflate(stream, out);
+  result.resize(out.size());
   return result;
 }
 
+size_t zlibDecompress(
+    Generator<std::span<const std::byte>>& chunks,
+    std::span<std::byte> output) {
+  BitStream stream(chunks);
+  OutputBuffer out{output};
+  inflate(stream, out);
+  return out.size();
+}
+
 } // namespace util
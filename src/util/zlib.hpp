@@ -3,9 +3,16 @@
 #include <cstddef>
 #include <span>
 #include <vector>
+#include "util/Generator.hpp"
 
 namespace util {
 
 std::vector<std::byte> zlibDecompress(std::span<const std::byte> data);
 
-}
+// Decompresses a stream split across several chunks, such as the IDAT chunks
+// of a PNG, straight into output. Returns the number of bytes written, and
+// throws if the output does not fit.
+size_t zlibDecompress(
+    Generator<std::span<const std::byte>>& chunks, std::span<std::byte> output);
+
+} // namespace util